@@ -25,7 +25,7 @@
 #include <iomanip>
 #include <iostream>
 #include <map>
-#include <queue>
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -37,6 +37,7 @@
 #include "eventdescriptor.h"
 
 std::string Audit::hostname;
+std::atomic<uint64_t> Audit::next_filter_generation{0};
 void (*Audit::notify_io_complete)(gsl::not_null<const void*> cookie,
                                   ENGINE_ERROR_CODE status);
 
@@ -370,6 +371,8 @@ bool Audit::configure(void) {
         }
     }
 
+    publish_filter();
+
     if (is_enabled_before_reconfig != config.is_auditd_enabled()) {
         notify_event_state_changed(0, config.is_auditd_enabled());
     }
@@ -417,44 +420,59 @@ bool Audit::configure(void) {
 }
 
 
-bool Audit::add_to_filleventqueue(const uint32_t event_id,
-                                  const char *payload,
-                                  const size_t length) {
+bool Audit::add_to_eventqueue(const uint32_t event_id,
+                              const char *payload,
+                              const size_t length) {
     // @todo I think we should do full validation of the content
     //       in debug mode to ensure that developers actually fill
     //       in the correct fields.. if not we should add an
     //       event to the audit trail saying it is one in an illegal
     //       format (or missing fields)
-    bool res;
-    Event* new_event = new Event(event_id, payload, length);
-    cb_mutex_enter(&producer_consumer_lock);
-    if (filleventqueue->size() < max_audit_queue) {
-        filleventqueue->push(new_event);
-        cb_cond_broadcast(&events_arrived);
-        res = true;
-    } else {
+    if (queued_events.fetch_add(1) >= max_audit_queue) {
+        queued_events--;
         LOG_WARNING("Audit: Dropping audit event {}: {}",
-                    new_event->id,
-                    new_event->payload);
+                    event_id,
+                    cb::logtags::tagUserData(std::string(payload, length)));
         dropped_events++;
-        delete new_event;
-        res = false;
+        return false;
     }
-    cb_mutex_exit(&producer_consumer_lock);
-    return res;
+
+    eventqueue.push(std::make_unique<Event>(event_id, payload, length));
+    notify_consumer();
+    return true;
 }
 
 
 bool Audit::add_reconfigure_event(const char* configfile, const void *cookie) {
-    ConfigureEvent* new_event = new ConfigureEvent(configfile, cookie);
-    cb_mutex_enter(&producer_consumer_lock);
-    filleventqueue->push(new_event);
-    cb_cond_broadcast(&events_arrived);
-    cb_mutex_exit(&producer_consumer_lock);
+    queued_events++;
+    eventqueue.push(std::make_unique<ConfigureEvent>(configfile, cookie));
+    notify_consumer();
     return true;
 }
 
 
+void Audit::notify_consumer() {
+    // The consumer sets consumer_waiting before it checks if the queue is
+    // empty, and we check it after pushing the event (all sequentially
+    // consistent) so either we see that it is waiting, or it sees the event
+    if (consumer_waiting.load()) {
+        cb_mutex_enter(&producer_consumer_lock);
+        cb_cond_broadcast(&events_arrived);
+        cb_mutex_exit(&producer_consumer_lock);
+    }
+}
+
+
+void Audit::wait_for_events(uint32_t milliseconds) {
+    consumer_waiting.store(true);
+    if (eventqueue.empty()) {
+        cb_cond_timedwait(
+                &events_arrived, &producer_consumer_lock, milliseconds);
+    }
+    consumer_waiting.store(false);
+}
+
+
 void Audit::clear_events_map(void) {
     typedef std::map<uint32_t, EventDescriptor*>::iterator it_type;
     for(it_type iterator = events.begin(); iterator != events.end(); iterator++) {
@@ -464,17 +482,9 @@ void Audit::clear_events_map(void) {
 }
 
 
-void Audit::clear_events_queues(void) {
-    while(!processeventqueue->empty()) {
-        Event *event = processeventqueue->front();
-        processeventqueue->pop();
-        delete event;
-    }
-    while(!filleventqueue->empty()) {
-        Event *event = filleventqueue->front();
-        filleventqueue->pop();
-        delete event;
-    }
+void Audit::clear_events_queue(void) {
+    eventqueue.clear();
+    queued_events.store(0);
 }
 
 bool Audit::terminate_consumer_thread(void)
@@ -522,7 +532,7 @@ bool Audit::clean_up(void) {
             return false;
         }
         clear_events_map();
-        clear_events_queues();
+        clear_events_queue();
     }
     return true;
 }
@@ -534,6 +544,34 @@ void Audit::notify_all_event_states() {
     }
 }
 
+namespace {
+/// The filter snapshot the thread used last
+struct FilterCache {
+    uint64_t generation = 0;
+    std::shared_ptr<const AuditFilter> filter;
+};
+} // namespace
+
+const AuditFilter& Audit::get_filter() const {
+    // The shared_ptr is only loaded (which may take a lock) when a new
+    // snapshot has been published
+    static thread_local FilterCache cache;
+    const auto generation = filter_generation.load(std::memory_order_acquire);
+    if (cache.generation != generation) {
+        cache.filter = std::atomic_load(&filter);
+        cache.generation = generation;
+    }
+    return *cache.filter;
+}
+
+void Audit::publish_filter() {
+    std::atomic_store(&filter,
+                      std::shared_ptr<const AuditFilter>(
+                              std::make_shared<AuditFilter>(config, events)));
+    filter_generation.store(++next_filter_generation,
+                            std::memory_order_release);
+}
+
 void Audit::add_event_state_listener(cb::audit::EventStateListener listener) {
     std::lock_guard<std::mutex> guard(event_state_listener.mutex);
     event_state_listener.clients.push_back(listener);
@@ -20,7 +20,6 @@
 #include <inttypes.h>
 #include <map>
 #include <memory>
-#include <queue>
 #include <atomic>
 
 #include <cJSON.h>
@@ -28,28 +27,33 @@
 #include "auditconfig.h"
 #include "auditd.h"
 #include "auditfile.h"
+#include "auditfilter.h"
 #include "eventdescriptor.h"
+#include "eventqueue.h"
 #include "memcached/audit_interface.h"
 #include "memcached/types.h"
 
-class Event;
-
 class Audit {
 public:
     AuditConfig config;
     std::map<uint32_t,EventDescriptor*> events;
 
-    // We maintain two Event queues. At any one time one will be used to accept
-    // new events, and the other will be processed. The two queues are swapped
-    // periodically.
-    std::unique_ptr<std::queue<Event*>> processeventqueue;
-    std::unique_ptr<std::queue<Event*>> filleventqueue;
+    // The front-end threads push the events to the lock-free queue, and
+    // the consumer thread writes them to the audit trail in batches
+    EventQueue eventqueue;
+    // The number of events in the queue (bounded by max_audit_queue)
+    std::atomic<size_t> queued_events;
+    // Set by the consumer (while holding producer_consumer_lock) before
+    // it waits for events_arrived, so that the producers only need to
+    // signal the consumer when it is waiting
+    std::atomic_bool consumer_waiting;
+    // The buffer the consumer formats the events in
+    std::string event_buffer;
 
     bool terminate_audit_daemon;
     std::string configfile;
     cb_thread_t consumer_tid;
     std::atomic_bool consumer_thread_running;
-    cb_cond_t processeventqueue_empty;
     cb_cond_t events_arrived;
     cb_mutex_t producer_consumer_lock;
     static std::string hostname;
@@ -59,20 +63,20 @@ public:
     std::atomic<uint32_t> dropped_events;
 
     Audit()
-        : processeventqueue(new std::queue<Event*>()),
-          filleventqueue(new std::queue<Event*>()),
+        : queued_events(0),
+          consumer_waiting(false),
           terminate_audit_daemon(false),
           dropped_events(0),
+          filter(std::make_shared<const AuditFilter>()),
+          filter_generation(++next_filter_generation),
           max_audit_queue(50000) {
         consumer_thread_running.store(false);
-        cb_cond_initialize(&processeventqueue_empty);
         cb_cond_initialize(&events_arrived);
         cb_mutex_initialize(&producer_consumer_lock);
     }
 
     ~Audit(void) {
         clean_up();
-        cb_cond_destroy(&processeventqueue_empty);
         cb_cond_destroy(&events_arrived);
         cb_mutex_destroy(&producer_consumer_lock);
     }
@@ -81,20 +85,26 @@ public:
     bool process_module_data_structures(cJSON *module);
     bool process_module_descriptor(cJSON *module_descriptor);
     bool configure(void);
-    bool add_to_filleventqueue(const uint32_t event_id,
-                               const char *payload,
-                               const size_t length);
-    bool add_to_filleventqueue(const uint32_t event_id,
-                               const std::string& payload) {
-        return add_to_filleventqueue(event_id, payload.data(),
-                                     payload.length());
+    bool add_to_eventqueue(const uint32_t event_id,
+                           const char *payload,
+                           const size_t length);
+    bool add_to_eventqueue(const uint32_t event_id,
+                           const std::string& payload) {
+        return add_to_eventqueue(event_id, payload.data(), payload.length());
     }
 
+    /**
+     * Wait (up to the given number of milliseconds) for events to arrive
+     * in the queue. Must only be called by the consumer, holding the
+     * producer_consumer_lock.
+     */
+    void wait_for_events(uint32_t milliseconds);
+
     bool add_reconfigure_event(const char *configfile, const void *cookie);
     bool create_audit_event(uint32_t event_id, cJSON *payload);
     bool terminate_consumer_thread(void);
     void clear_events_map(void);
-    void clear_events_queues(void);
+    void clear_events_queue(void);
     bool clean_up(void);
 
     static void log_error(const AuditErrorCode return_code,
@@ -110,13 +120,34 @@ public:
 
     void notify_all_event_states();
 
+    /**
+     * Get the current snapshot of the filter. This is lock-free unless a
+     * new snapshot has been published since the calling thread last used
+     * it. The returned reference is valid until the next call from the
+     * same thread.
+     */
+    const AuditFilter& get_filter() const;
+
 protected:
+    /// Build a new filter snapshot from the configuration and publish it
+    void publish_filter();
+
     void notify_event_state_changed(uint32_t id, bool enabled) const;
+
+    /// Wake up the consumer if it is waiting for events
+    void notify_consumer();
     struct {
         mutable std::mutex mutex;
         std::vector<cb::audit::EventStateListener> clients;
     } event_state_listener;
 
+    // The current filter snapshot (accessed with std::atomic_load/store)
+    std::shared_ptr<const AuditFilter> filter;
+    // Changes every time a new filter is published (unique across all of
+    // the Audit instances)
+    std::atomic<uint64_t> filter_generation;
+    static std::atomic<uint64_t> next_filter_generation;
+
 private:
     size_t max_audit_queue;
 };
@@ -40,6 +40,7 @@ public:
         rotate_interval(900),
         rotate_size(20 * 1024 * 1024),
         buffered(true),
+        fsync_interval(0),
         filtering_enabled(false),
         version(0),
         uuid(""),
@@ -73,6 +74,8 @@ public:
     uint32_t get_rotate_interval(void) const;
     void set_buffered(bool enable);
     bool is_buffered(void) const;
+    void set_fsync_interval(uint32_t interval);
+    uint32_t get_fsync_interval(void) const;
     void set_log_directory(const std::string &directory);
     std::string get_log_directory(void) const;
     void set_descriptors_path(const std::string &directory);
@@ -85,6 +88,8 @@ public:
     AuditConfig::EventState get_event_state(uint32_t id) const;
     bool is_event_filtered(
             const std::pair<std::string, std::string>& userid) const;
+    std::vector<std::pair<std::string, std::string>> get_disabled_userids()
+            const;
     bool is_filtering_enabled() const;
     void set_filtering_enabled(bool value);
     void set_uuid(const std::string &uuid);
@@ -122,6 +127,7 @@ protected:
     void set_rotate_interval(cJSON *obj);
     void set_auditd_enabled(cJSON *obj);
     void set_buffered(cJSON *obj);
+    void set_fsync_interval(cJSON *obj);
     void set_log_directory(cJSON *obj);
     void set_descriptors_path(cJSON *obj);
     void set_version(cJSON *obj);
@@ -146,6 +152,8 @@ protected:
     Couchbase::RelaxedAtomic<uint32_t> rotate_interval;
     Couchbase::RelaxedAtomic<size_t> rotate_size;
     Couchbase::RelaxedAtomic<bool> buffered;
+    /// Seconds between fsync's of the audit trail (0 leaves it to the OS)
+    Couchbase::RelaxedAtomic<uint32_t> fsync_interval;
     Couchbase::RelaxedAtomic<bool> filtering_enabled;
     Couchbase::RelaxedAtomic<uint32_t> version;
 
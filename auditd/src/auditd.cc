@@ -46,11 +46,14 @@ static void consume_events(void* arg) {
 
     cb_mutex_enter(&audit.producer_consumer_lock);
     while (!audit.terminate_audit_daemon) {
-        if (audit.filleventqueue->empty()) {
-            cb_cond_timedwait(&audit.events_arrived,
-                              &audit.producer_consumer_lock,
-                              audit.auditfile.get_seconds_to_rotation() * 1000);
-            if (audit.filleventqueue->empty()) {
+        if (audit.eventqueue.empty()) {
+            // Wake up in time to rotate the files, or to fsync the events
+            // written since the last fsync (flush() below does that)
+            audit.wait_for_events(
+                    std::min(audit.auditfile.get_seconds_to_rotation(),
+                             audit.auditfile.get_seconds_to_fsync()) *
+                    1000);
+            if (audit.eventqueue.empty()) {
                 // We timed out, so just rotate the files
                 audit.auditfile.maybe_rotate_files();
             }
@@ -58,17 +61,17 @@ static void consume_events(void* arg) {
         /* now have producer_consumer lock!
          * event(s) have arrived or shutdown requested
          */
-        swap(audit.processeventqueue, audit.filleventqueue);
         cb_mutex_exit(&audit.producer_consumer_lock);
         // Now outside of the producer_consumer_lock
 
-        while (!audit.processeventqueue->empty()) {
-            Event* event = audit.processeventqueue->front();
+        // Drain the queue, letting the file buffer the events so that
+        // the whole batch is written (and flushed) at once
+        std::unique_ptr<Event> event;
+        while ((event = audit.eventqueue.pop())) {
+            audit.queued_events--;
             if (!event->process(audit)) {
                 audit.dropped_events++;
             }
-            audit.processeventqueue->pop();
-            delete event;
         }
         audit.auditfile.flush();
         cb_mutex_enter(&audit.producer_consumer_lock);
@@ -166,9 +169,9 @@ AUDIT_ERROR_CODE put_audit_event(Audit* handle,
         throw std::invalid_argument("put_audit_event: handle can't be nullptr");
     }
     if (handle->config.is_auditd_enabled()) {
-        if (!handle->add_to_filleventqueue(audit_eventid,
-                                           (const char*)payload,
-                                           length)) {
+        if (!handle->add_to_eventqueue(audit_eventid,
+                                       (const char*)payload,
+                                       length)) {
             return AUDIT_FAILED;
         }
     }
@@ -192,7 +195,7 @@ AUDIT_ERROR_CODE shutdown_auditdaemon(Audit* handle) {
         if ((payload.get() == nullptr) ||
             !handle->create_audit_event(AUDITD_AUDIT_SHUTTING_DOWN_AUDIT_DAEMON,
                                         payload.get()) ||
-            !handle->add_to_filleventqueue(
+            !handle->add_to_eventqueue(
                 AUDITD_AUDIT_SHUTTING_DOWN_AUDIT_DAEMON,
                 to_string(payload, false))) {
             handle->clean_up();
@@ -239,5 +242,13 @@ void notify_all_event_states(Audit* handle) {
     handle->notify_all_event_states();
 }
 
+MEMCACHED_PUBLIC_API
+bool is_event_filtered(Audit* handle,
+                       uint32_t id,
+                       cb::const_char_buffer source,
+                       cb::const_char_buffer user) {
+    return handle->get_filter().isFiltered(id, source, user);
+}
+
 } // namespace audit
 } // namespace cb
@@ -20,6 +20,11 @@
 #include <cJSON.h>
 #include <sys/stat.h>
 #include <cstring>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #include <platform/dirutils.h>
 #include <memcached/isotime.h>
 #include <JSON_checker.h>
@@ -102,14 +107,22 @@ bool AuditFile::open(void) {
         log_error(AuditErrorCode::FILE_OPEN_ERROR, open_file_name.c_str());
         return false;
     }
+    // Let the consumer write a batch of events with a single write
+    setvbuf(file, nullptr, _IOFBF, WriteBufferSize);
     current_size = 0;
     open_time = auditd_time();
+    last_fsync = open_time;
+    unsynced = false;
     return true;
 }
 
 
 void AuditFile::close_and_rotate_log(void) {
     cb_assert(file != NULL);
+    if (fsync_interval != 0) {
+        fflush(file);
+        sync();
+    }
     fclose(file);
     file = NULL;
     if (current_size == 0) {
@@ -249,16 +262,9 @@ void AuditFile::cleanup_old_logfile(const std::string& log_path) {
 
 bool AuditFile::write_event_to_disk(cJSON *output) {
     char *content = cJSON_PrintUnformatted(output);
-    bool ret = true;
+    bool ret = false;
     if (content) {
-        current_size += fprintf(file, "%s\n", content);
-        if (ferror(file)) {
-            log_error(AuditErrorCode::WRITING_TO_DISK_ERROR, strerror(errno));
-            ret = false;
-            close_and_rotate_log();
-        } else if (!buffered) {
-            ret = flush();
-        }
+        ret = write_event_to_disk(std::string(content));
         cJSON_Free(content);
     } else {
         log_error(AuditErrorCode::MEMORY_ALLOCATION_ERROR,
@@ -268,6 +274,22 @@ bool AuditFile::write_event_to_disk(cJSON *output) {
     return ret;
 }
 
+bool AuditFile::write_event_to_disk(const std::string& event) {
+    fwrite(event.data(), 1, event.size(), file);
+    fputc('\n', file);
+    if (ferror(file)) {
+        log_error(AuditErrorCode::WRITING_TO_DISK_ERROR, strerror(errno));
+        close_and_rotate_log();
+        return false;
+    }
+    current_size += event.size() + 1;
+    unsynced = true;
+    if (!buffered) {
+        return flush();
+    }
+    return true;
+}
+
 
 void AuditFile::set_log_directory(const std::string &new_directory) {
     if (log_directory == new_directory) {
@@ -296,6 +318,7 @@ void AuditFile::reconfigure(const AuditConfig &config) {
     set_log_directory(config.get_log_directory());
     max_log_size = config.get_rotate_size();
     buffered = config.is_buffered();
+    fsync_interval = config.get_fsync_interval();
 }
 
 bool AuditFile::flush(void) {
@@ -306,11 +329,33 @@ bool AuditFile::flush(void) {
             close_and_rotate_log();
             return false;
         }
+        if (fsync_interval != 0 && unsynced &&
+            difftime(auditd_time(), last_fsync) >= fsync_interval) {
+            return sync();
+        }
     }
 
     return true;
 }
 
+bool AuditFile::sync(void) {
+    last_fsync = auditd_time();
+    unsynced = false;
+#ifdef WIN32
+    const int ret = _commit(_fileno(file));
+#else
+    int ret;
+    while ((ret = fsync(fileno(file))) == -1 && errno == EINTR) {
+        // Retry
+    }
+#endif
+    if (ret != 0) {
+        log_error(AuditErrorCode::WRITING_TO_DISK_ERROR, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
 bool AuditFile::is_timestamp_format_correct(std::string& str) {
     const char *data = str.c_str();
     if (str.length() < 19) {
@@ -19,6 +19,7 @@
 
 #include <cstdio>
 #include <inttypes.h>
+#include <limits>
 #include <string>
 #include <cJSON.h>
 #include <time.h>
@@ -34,7 +35,10 @@ public:
         current_size(0),
         max_log_size(20 * 1024 * 1024),
         rotate_interval(900),
-        buffered(true)
+        buffered(true),
+        fsync_interval(0),
+        last_fsync(0),
+        unsynced(false)
     {
     }
 
@@ -97,6 +101,16 @@ public:
      */
     bool write_event_to_disk(cJSON *output);
 
+    /**
+     * Write a JSON formatted event (without a trailing newline) to the
+     * disk. The event is buffered (unless the audit trail is unbuffered)
+     * until flush() is called.
+     *
+     * @param event the event to write
+     * @return true if success, false otherwise
+     */
+    bool write_event_to_disk(const std::string& event);
+
     /**
      * Check for a file existence
      *
@@ -119,7 +133,8 @@ public:
     void reconfigure(const AuditConfig &config);
 
     /**
-     * Flush the buffers to the disk
+     * Flush the buffers to the disk (and fsync the file if fsync_interval
+     * seconds have passed since the last fsync)
      */
     bool flush(void);
 
@@ -135,8 +150,28 @@ public:
         }
     }
 
+    /**
+     * get the number of seconds until the events written since the last
+     * fsync should be synced to the disk (UINT32_MAX if there is nothing
+     * to sync, or fsync_interval is disabled)
+     */
+    uint32_t get_seconds_to_fsync(void) const {
+        if (!is_open() || fsync_interval == 0 || !unsynced) {
+            return std::numeric_limits<uint32_t>::max();
+        }
+        const auto elapsed = difftime(auditd_time(), last_fsync);
+        if (elapsed >= fsync_interval) {
+            return 0;
+        }
+        return fsync_interval - (uint32_t)elapsed;
+    }
+
+    /// The size of the stdio buffer used when writing the audit trail
+    static const size_t WriteBufferSize = 256 * 1024;
+
 private:
     bool open(void);
+    bool sync(void);
     bool time_to_rotate_log(void) const;
     void close_and_rotate_log(void);
     void set_log_directory(const std::string &new_directory);
@@ -152,6 +187,10 @@ private:
     size_t max_log_size;
     uint32_t rotate_interval;
     bool buffered;
+    uint32_t fsync_interval;
+    time_t last_fsync;
+    /// Have events been written since the last fsync?
+    bool unsynced;
 };
 
 #endif
@@ -0,0 +1,82 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include "auditfilter.h"
+#include "auditconfig.h"
+#include "eventdescriptor.h"
+
+#include <cstring>
+
+AuditFilter::AuditFilter(const AuditConfig& config,
+                         const std::map<uint32_t, EventDescriptor*>& events)
+    : filteringEnabled(config.is_filtering_enabled()) {
+    if (!filteringEnabled) {
+        return;
+    }
+
+    for (const auto& event : events) {
+        if (event.second->isFilteringPermitted()) {
+            filteringPermitted.insert(event.first);
+        }
+    }
+
+    for (const auto& userid : config.get_disabled_userids()) {
+        const auto key = hash({userid.first.data(), userid.first.size()},
+                              {userid.second.data(), userid.second.size()});
+        disabledUserids.emplace(key, userid);
+    }
+}
+
+bool AuditFilter::isFiltered(uint32_t id,
+                             cb::const_char_buffer source,
+                             cb::const_char_buffer user) const {
+    if (!filteringEnabled || disabledUserids.empty() ||
+        filteringPermitted.count(id) == 0) {
+        return false;
+    }
+
+    const auto range = disabledUserids.equal_range(hash(source, user));
+    for (auto iter = range.first; iter != range.second; ++iter) {
+        const auto& userid = iter->second;
+        if (userid.first.size() == source.size() &&
+            userid.second.size() == user.size() &&
+            std::memcmp(userid.first.data(), source.data(), source.size()) ==
+                    0 &&
+            std::memcmp(userid.second.data(), user.data(), user.size()) ==
+                    0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t AuditFilter::hash(cb::const_char_buffer source,
+                         cb::const_char_buffer user) {
+    // FNV-1a over the source, a separator and the user
+    uint64_t ret = 14695981039346656037ull;
+    auto add = [&ret](const char c) {
+        ret ^= uint8_t(c);
+        ret *= 1099511628211ull;
+    };
+    for (size_t ii = 0; ii < source.size(); ++ii) {
+        add(source.data()[ii]);
+    }
+    add('\0');
+    for (size_t ii = 0; ii < user.size(); ++ii) {
+        add(user.data()[ii]);
+    }
+    return size_t(ret);
+}
@@ -0,0 +1,76 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#pragma once
+
+#include <platform/sized_buffer.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+class AuditConfig;
+class EventDescriptor;
+
+/**
+ * The AuditFilter is an immutable snapshot of the parts of the audit
+ * configuration needed to tell if an event for a given user will be
+ * filtered out (see "disabled_userids" and "filtering_enabled").
+ *
+ * A new snapshot is built every time the audit daemon is reconfigured,
+ * so that the front-end threads may check it without locking before they
+ * build the payload of an event (see cb::audit::is_event_filtered()).
+ */
+class AuditFilter {
+public:
+    /// Create a filter which doesn't filter out anything
+    AuditFilter() = default;
+
+    AuditFilter(const AuditConfig& config,
+                const std::map<uint32_t, EventDescriptor*>& events);
+
+    /**
+     * Check if the event with the given id is filtered out for the user.
+     * This is O(1) and doesn't allocate any memory.
+     *
+     * @param id the event identifier
+     * @param source the domain of the user
+     * @param user the name of the user
+     * @return true if the event should be filtered out
+     */
+    bool isFiltered(uint32_t id,
+                    cb::const_char_buffer source,
+                    cb::const_char_buffer user) const;
+
+protected:
+    static size_t hash(cb::const_char_buffer source,
+                       cb::const_char_buffer user);
+
+    bool filteringEnabled = false;
+
+    /// The ids of the events which may be filtered
+    std::unordered_set<uint32_t> filteringPermitted;
+
+    /**
+     * The disabled userids (source, user) keyed by their hash, so that
+     * they may be looked up without creating strings for the key
+     */
+    std::unordered_multimap<size_t, std::pair<std::string, std::string>>
+            disabledUserids;
+};
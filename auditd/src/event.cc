@@ -18,6 +18,9 @@
 #include <sstream>
 #include <string>
 #include <cJSON.h>
+#include <cJSON_utils.h>
+#include <JSON_checker.h>
+#include <memcached/audit_event_writer.h>
 #include <memcached/isotime.h>
 #include "event.h"
 #include "audit.h"
@@ -67,28 +70,69 @@ bool Event::filterEvent(cJSON* json_payload, const AuditConfig& config) {
     }
 }
 
+/**
+ * Check if the (valid) JSON object contains the given key at the top
+ * level, without parsing it.
+ */
+static bool hasTopLevelKey(const std::string& json, const std::string& key) {
+    int depth = 0;
+    bool expectKey = false;
+    for (size_t ii = 0; ii < json.size(); ++ii) {
+        switch (json[ii]) {
+        case '{':
+            ++depth;
+            expectKey = (depth == 1);
+            break;
+        case '[':
+            ++depth;
+            break;
+        case '}':
+        case ']':
+            --depth;
+            break;
+        case ',':
+            expectKey = (depth == 1);
+            break;
+        case '"': {
+            // Skip to the end of the string
+            size_t end = ii + 1;
+            while (json[end] != '"') {
+                if (json[end] == '\\') {
+                    ++end;
+                }
+                ++end;
+            }
+            if (expectKey && (end - ii - 1) == key.size() &&
+                json.compare(ii + 1, key.size(), key) == 0) {
+                return true;
+            }
+            expectKey = false;
+            ii = end;
+            break;
+        }
+        }
+    }
+    return false;
+}
+
 bool Event::process(Audit& audit) {
     // Audit is disabled
     if (!audit.config.is_auditd_enabled()) {
         return true;
     }
 
-    // convert the event.payload into JSON
-    unique_cJSON_ptr json_payload(cJSON_Parse(payload.c_str()));
-    if (!json_payload) {
+    // The payload is validated and extended as text. It is only parsed
+    // if it needs to be checked against the filter
+    const auto first = payload.find_first_not_of(" \t\r\n");
+    const auto last = payload.find_last_not_of(" \t\r\n");
+    if (first == std::string::npos || payload[first] != '{' ||
+        payload[last] != '}' ||
+        !checkUTF8JSON(reinterpret_cast<const unsigned char*>(payload.data()),
+                       payload.size())) {
         Audit::log_error(AuditErrorCode::JSON_PARSING_ERROR, payload);
         return false;
     }
 
-    cJSON* timestamp_ptr = cJSON_GetObjectItem(json_payload.get(), "timestamp");
-    if (timestamp_ptr == nullptr) {
-        // the audit does not contain a timestamp, so the server
-        // needs to insert one
-        const auto timestamp = ISOTime::generatetimestamp();
-        cJSON_AddStringToObject(
-                json_payload.get(), "timestamp", timestamp.c_str());
-    }
-
     auto evt = audit.events.find(id);
     if (evt == audit.events.end()) {
         // it is an unknown event
@@ -102,28 +146,53 @@ bool Event::process(Audit& audit) {
     }
 
     if (audit.config.is_filtering_enabled() &&
-        evt->second->isFilteringPermitted() &&
-        filterEvent(json_payload.get(), audit.config)) {
-        return true;
+        evt->second->isFilteringPermitted()) {
+        unique_cJSON_ptr json_payload(cJSON_Parse(payload.c_str()));
+        if (!json_payload) {
+            Audit::log_error(AuditErrorCode::JSON_PARSING_ERROR, payload);
+            return false;
+        }
+        if (filterEvent(json_payload.get(), audit.config)) {
+            return true;
+        }
+    }
+
+    // Add the timestamp (unless the payload already contains one), the id,
+    // the name and the description before the closing brace
+    auto& event = audit.event_buffer;
+    event.assign(payload, 0, last);
+    const bool empty =
+            payload.find_first_not_of(" \t\r\n", first + 1) == last;
+    if (!empty) {
+        event.push_back(',');
+    }
+    if (!hasTopLevelKey(payload, "timestamp")) {
+        // the audit does not contain a timestamp, so the server
+        // needs to insert one
+        event.append(R"("timestamp":")");
+        event.append(ISOTime::generatetimestamp());
+        event.append(R"(",)");
     }
+    event.append(R"("id":)");
+    event.append(std::to_string(id));
+    event.append(R"(,"name":)");
+    const auto& name = evt->second->getName();
+    cb::audit::EventWriter::appendString(event, {name.data(), name.size()});
+    event.append(R"(,"description":)");
+    const auto& description = evt->second->getDescription();
+    cb::audit::EventWriter::appendString(
+            event, {description.data(), description.size()});
+    event.push_back('}');
 
     if (!audit.auditfile.ensure_open()) {
-        Audit::log_error(AuditErrorCode::OPEN_AUDITFILE_ERROR,
-                         to_string(json_payload, false));
+        Audit::log_error(AuditErrorCode::OPEN_AUDITFILE_ERROR, event);
         return false;
     }
-    cJSON_AddNumberToObject(json_payload.get(), "id", id);
-    cJSON_AddStringToObject(
-            json_payload.get(), "name", evt->second->getName().c_str());
-    cJSON_AddStringToObject(json_payload.get(),
-                            "description",
-                            evt->second->getDescription().c_str());
 
-    if (audit.auditfile.write_event_to_disk(json_payload.get())) {
+    if (audit.auditfile.write_event_to_disk(event)) {
         return true;
     }
 
-    Audit::log_error(AuditErrorCode::WRITE_EVENT_TO_DISK_ERROR,
-                     to_string(json_payload, false));
+    Audit::log_error(AuditErrorCode::WRITE_EVENT_TO_DISK_ERROR, event);
     return false;
 }
@@ -18,6 +18,7 @@
 #define EVENT_H
 
 #include <inttypes.h>
+#include <atomic>
 #include <string>
 
 class Audit;
@@ -28,6 +29,8 @@ class Event {
 public:
     const uint32_t id;
     const std::string payload;
+    /// The next event in the EventQueue
+    std::atomic<Event*> next{nullptr};
 
     // Constructor required for ConfigureEvent
     Event()
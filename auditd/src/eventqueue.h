@@ -0,0 +1,121 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#pragma once
+
+#include "event.h"
+
+#include <atomic>
+#include <memory>
+
+/**
+ * The EventQueue is a lock-free multiple producer, single consumer queue
+ * of audit events (the intrusive MPSC queue by Dmitry Vyukov). All of
+ * the front-end threads may push events to the queue without blocking
+ * each other, and the audit daemon's consumer thread pops them in the
+ * order they were pushed.
+ *
+ * The events are linked through Event::next, so pushing an event doesn't
+ * allocate any memory. The queue owns the events it contains.
+ *
+ * All of the atomic operations use sequential consistency so that a
+ * producer either sees that the consumer is about to sleep, or the
+ * consumer sees the new event (see Audit::add_to_eventqueue()).
+ */
+class EventQueue {
+public:
+    EventQueue() : head(&stub), tail(&stub) {
+    }
+
+    EventQueue(const EventQueue&) = delete;
+
+    ~EventQueue() {
+        clear();
+    }
+
+    /// Add an event to the queue. May be called by any thread.
+    void push(std::unique_ptr<Event> event) {
+        link(event.release());
+    }
+
+    /**
+     * Remove the oldest event from the queue. Must only be called by the
+     * consumer.
+     *
+     * @return the event, or nullptr if the queue is empty (or the producer
+     *         of the next event hasn't completed its push yet)
+     */
+    std::unique_ptr<Event> pop() {
+        Event* current = tail;
+        Event* next = current->next.load();
+        if (current == &stub) {
+            if (next == nullptr) {
+                return {};
+            }
+            tail = next;
+            current = next;
+            next = next->next.load();
+        }
+
+        if (next != nullptr) {
+            tail = next;
+            return std::unique_ptr<Event>(current);
+        }
+
+        if (current != head.load()) {
+            // A producer has taken the head, but not linked it yet
+            return {};
+        }
+
+        // current is the last event in the queue. Put the stub back so
+        // that we may remove it
+        link(&stub);
+        next = current->next.load();
+        if (next != nullptr) {
+            tail = next;
+            return std::unique_ptr<Event>(current);
+        }
+        return {};
+    }
+
+    /// Is the queue empty? Must only be called by the consumer (and has
+    /// the same caveat as pop())
+    bool empty() const {
+        return tail == &stub && stub.next.load() == nullptr;
+    }
+
+    /// Delete all of the events in the queue. Must only be called by the
+    /// consumer (or once the consumer is gone).
+    void clear() {
+        while (pop()) {
+            // Empty
+        }
+    }
+
+private:
+    void link(Event* event) {
+        event->next.store(nullptr);
+        Event* prev = head.exchange(event);
+        prev->next.store(event);
+    }
+
+    /// The most recently pushed event (written by the producers)
+    std::atomic<Event*> head;
+    /// The next event to pop (only used by the consumer)
+    Event* tail;
+    /// Placeholder which keeps the list non-empty
+    Event stub;
+};
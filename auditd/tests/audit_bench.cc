@@ -0,0 +1,201 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmarks for the audit daemon: the cost of creating the payload of an
+ * event on the front-end thread, and the throughput of the whole pipeline
+ * (queue, consumer and audit trail) with a number of front-end threads.
+ */
+
+#include "config.h"
+
+#include <benchmark/benchmark.h>
+#include <cJSON.h>
+#include <cJSON_utils.h>
+#include <logger/logger.h>
+#include <memcached/audit_event_writer.h>
+#include <memcached/audit_interface.h>
+#include <memcached/isotime.h>
+#include <platform/dirutils.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "auditd/src/audit.h"
+
+static const uint32_t BenchEventId = 0x10000;
+
+static Audit* auditHandle;
+static std::string testdir;
+
+/// Create the payload of a document read event the way memcached used to
+static void CreatePayloadCJSON(benchmark::State& state) {
+    while (state.KeepRunning()) {
+        unique_cJSON_ptr root(cJSON_CreateObject());
+        cJSON_AddStringToObject(root.get(),
+                                "timestamp",
+                                ISOTime::generatetimestamp().c_str());
+        cJSON_AddStringToObject(root.get(), "peername", "127.0.0.1:46566");
+        cJSON_AddStringToObject(root.get(), "sockname", "127.0.0.1:11210");
+        cJSON* source = cJSON_CreateObject();
+        cJSON_AddStringToObject(source, "source", "memcached");
+        cJSON_AddStringToObject(source, "user", "Administrator");
+        cJSON_AddItemToObject(root.get(), "real_userid", source);
+        cJSON_AddStringToObject(root.get(), "bucket", "default");
+        cJSON_AddStringToObject(root.get(), "key", "<ud>key_1234</ud>");
+        auto text = to_string(root, false);
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK(CreatePayloadCJSON);
+
+/// Create the payload of a document read event the way memcached does now
+static void CreatePayloadEventWriter(benchmark::State& state) {
+    std::string buffer;
+    while (state.KeepRunning()) {
+        cb::audit::EventWriter writer(buffer);
+        writer.add("timestamp", ISOTime::generatetimestamp());
+        writer.add("peername", "127.0.0.1:46566");
+        writer.add("sockname", "127.0.0.1:11210");
+        writer.beginObject("real_userid")
+                .add("source", "memcached")
+                .add("user", "Administrator")
+                .endObject();
+        writer.add("bucket", "default");
+        writer.add("key", "<ud>key_1234</ud>");
+        auto text = writer.finish();
+        benchmark::DoNotOptimize(text);
+    }
+}
+BENCHMARK(CreatePayloadEventWriter);
+
+/**
+ * Submit events from the given number of threads and wait for the consumer
+ * to write all of them to the audit trail.
+ */
+static void AuditThroughput(benchmark::State& state) {
+    const auto numThreads = size_t(state.range(0));
+    // Stay below the limit of the queue so that no events are dropped
+    const size_t eventsPerThread = 40000 / numThreads;
+    const auto droppedBefore = auditHandle->dropped_events.load();
+
+    while (state.KeepRunning()) {
+        std::vector<std::thread> threads;
+        for (size_t ii = 0; ii < numThreads; ++ii) {
+            threads.emplace_back([eventsPerThread]() {
+                std::string buffer;
+                for (size_t jj = 0; jj < eventsPerThread; ++jj) {
+                    cb::audit::EventWriter writer(buffer);
+                    writer.add("timestamp", ISOTime::generatetimestamp());
+                    writer.beginObject("real_userid")
+                            .add("source", "memcached")
+                            .add("user", "Administrator")
+                            .endObject();
+                    writer.add("bucket", "default");
+                    writer.add("key", "<ud>key_1234</ud>");
+                    const auto payload = writer.finish();
+                    put_audit_event(auditHandle,
+                                    BenchEventId,
+                                    payload.data(),
+                                    payload.size());
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        while (auditHandle->queued_events.load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * eventsPerThread *
+                            numThreads);
+    state.counters["dropped"] =
+            auditHandle->dropped_events.load() - droppedBefore;
+}
+BENCHMARK(AuditThroughput)
+        ->RangeMultiplier(2)
+        ->Range(1, 8)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+/// Write the event descriptors and the configuration to use
+static std::string createConfiguration() {
+    testdir = "audit-bench-" + std::to_string(cb_getpid());
+    cb::io::mkdirp(testdir);
+
+    const auto descriptors = testdir + "/audit_events.json";
+    FILE* fp = fopen(descriptors.c_str(), "w");
+    if (fp == nullptr) {
+        throw std::runtime_error("Failed to create " + descriptors);
+    }
+    fprintf(fp,
+            R"({"version":1,"modules":[{"module":"bench","startid":%u,)"
+            R"("events":[{"id":%u,"name":"bench","description":"bench",)"
+            R"("sync":false,"enabled":true,"filtering_permitted":true}]}]})",
+            BenchEventId,
+            BenchEventId);
+    fclose(fp);
+
+    AuditConfig config;
+    config.set_version(2);
+    config.set_auditd_enabled(true);
+    config.set_rotate_interval(config.get_max_file_rotation_time());
+    config.set_rotate_size(config.get_max_rotate_file_size());
+    config.set_log_directory(testdir);
+    config.set_descriptors_path(testdir);
+    config.set_uuid("bench");
+
+    const auto configfile = testdir + "/audit.json";
+    fp = fopen(configfile.c_str(), "w");
+    if (fp == nullptr) {
+        throw std::runtime_error("Failed to create " + configfile);
+    }
+    fprintf(fp, "%s\n", to_string(config.to_json()).c_str());
+    fclose(fp);
+    return configfile;
+}
+
+int main(int argc, char** argv) {
+    cb::logger::createBlackholeLogger();
+    // required for gethostname(); normally called by memcached's main()
+    cb_initialize_sockets();
+
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
+    const auto configfile = createConfiguration();
+    AUDIT_EXTENSION_DATA extension_data;
+    memset(&extension_data, 0, sizeof(extension_data));
+    extension_data.configfile = configfile.c_str();
+    if (start_auditdaemon(&extension_data, &auditHandle) != AUDIT_SUCCESS) {
+        std::cerr << "Failed to start the audit daemon" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ::benchmark::RunSpecifiedBenchmarks();
+
+    shutdown_auditdaemon(auditHandle);
+    cb::io::rmrf(testdir);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include <JSON_checker.h>
+#include <cJSON_utils.h>
+#include <gtest/gtest.h>
+#include <memcached/audit_event_writer.h>
+
+using cb::audit::EventWriter;
+
+static std::string escape(const std::string& value) {
+    std::string ret;
+    EventWriter::appendString(ret, {value.data(), value.size()});
+    return ret;
+}
+
+TEST(AuditEventWriterTest, PlainString) {
+    EXPECT_EQ(R"("")", escape(""));
+    EXPECT_EQ(R"("hello world")", escape("hello world"));
+}
+
+TEST(AuditEventWriterTest, EscapeQuotesAndBackslash) {
+    EXPECT_EQ(R"("a\"b\\c")", escape(R"(a"b\c)"));
+    EXPECT_EQ(R"("/")", escape("/"));
+}
+
+TEST(AuditEventWriterTest, EscapeControlCharacters) {
+    EXPECT_EQ(R"("\n\r\t")", escape("\n\r\t"));
+    EXPECT_EQ(R"("\u0001\u0008\u000c\u001f")",
+              escape("\x01\x08\x0c\x1f"));
+    EXPECT_EQ(R"("a\u0000b")", escape(std::string("a\0b", 3)));
+    // DEL isn't a control character in JSON
+    EXPECT_EQ("\"\x7f\"", escape("\x7f"));
+}
+
+TEST(AuditEventWriterTest, NonAsciiIsKept) {
+    // UTF-8 is copied as is (the audit daemon validates it)
+    const std::string utf8 =
+            "bl\xc3\xa5" "b\xc3\xa6" "r \xe2\x82\xac \xf0\x9f\x98\x80";
+    EXPECT_EQ("\"" + utf8 + "\"", escape(utf8));
+}
+
+TEST(AuditEventWriterTest, Event) {
+    std::string buffer("garbage from the previous event");
+    EventWriter writer(buffer);
+    writer.add("peername", "127.0.0.1:666")
+            .add("bucket", std::string("my\"bucket\n"))
+            .add("enabled", true)
+            .addNumber("opaque", 0xdeadbeef)
+            .beginObject("real_userid")
+            .add("source", "memcached")
+            .add("user", "\xc3\xa5\x01")
+            .endObject()
+            .add("last", false);
+    auto payload = writer.finish();
+
+    EXPECT_EQ(
+            "{\"peername\":\"127.0.0.1:666\","
+            "\"bucket\":\"my\\\"bucket\\n\","
+            "\"enabled\":true,"
+            "\"opaque\":3735928559,"
+            "\"real_userid\":{\"source\":\"memcached\","
+            "\"user\":\"\xc3\xa5\\u0001\"},"
+            "\"last\":false}",
+            std::string(payload.data(), payload.size()));
+
+    EXPECT_TRUE(checkUTF8JSON(
+            reinterpret_cast<const unsigned char*>(payload.data()),
+            payload.size()));
+
+    unique_cJSON_ptr json(cJSON_Parse(buffer.c_str()));
+    ASSERT_TRUE(json);
+    EXPECT_STREQ("my\"bucket\n",
+                 cJSON_GetObjectItem(json.get(), "bucket")->valuestring);
+    auto* userid = cJSON_GetObjectItem(json.get(), "real_userid");
+    ASSERT_NE(nullptr, userid);
+    EXPECT_STREQ("\xc3\xa5\x01",
+                 cJSON_GetObjectItem(userid, "user")->valuestring);
+}
+
+TEST(AuditEventWriterTest, EmptyEvent) {
+    std::string buffer;
+    EventWriter writer(buffer);
+    auto payload = writer.finish();
+    EXPECT_EQ("{}", std::string(payload.data(), payload.size()));
+}
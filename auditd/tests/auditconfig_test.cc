@@ -286,6 +286,25 @@ TEST_F(AuditConfigTest, TestLegalBuffered) {
     EXPECT_NO_THROW(config.initialize_config(json));
 }
 
+// fsync_interval
+
+TEST_F(AuditConfigTest, TestNoFsyncInterval) {
+    // fsync_interval is optional, and leaves the syncing to the OS
+    EXPECT_NO_THROW(config.initialize_config(json));
+    EXPECT_EQ(0, config.get_fsync_interval());
+}
+
+TEST_F(AuditConfigTest, TestLegalFsyncInterval) {
+    cJSON_AddNumberToObject(json, "fsync_interval", 10);
+    EXPECT_NO_THROW(config.initialize_config(json));
+    EXPECT_EQ(10, config.get_fsync_interval());
+}
+
+TEST_F(AuditConfigTest, TestIllegalDatatypeFsyncInterval) {
+    cJSON_AddStringToObject(json, "fsync_interval", "foobar");
+    EXPECT_THROW(config.initialize_config(json), std::string);
+}
+
 // log_path
 TEST_F(AuditConfigTest, TestNoLogPath) {
     cJSON *obj = cJSON_DetachItemFromObject(json, "log_path");
@@ -18,6 +18,7 @@
 
 #include "auditfile.h"
 #include <iostream>
+#include <limits>
 #include <map>
 #include <atomic>
 #include <cstring>
@@ -163,6 +164,36 @@ TEST_F(AuditFileTest, TestRollover) {
                 secs == (defaultvalue.get_min_file_rotation_time() - 11));
 }
 
+/**
+ * Test that the consumer is told when to fsync the events written since
+ * the last fsync, even if no more events arrive
+ */
+TEST_F(AuditFileTest, TestSecondsToFsync) {
+    config.set_rotate_interval(3600);
+    config.set_fsync_interval(10);
+    AuditFile auditfile;
+    auditfile.reconfigure(config);
+
+    // Nothing to sync
+    auditfile.ensure_open();
+    EXPECT_EQ(std::numeric_limits<uint32_t>::max(),
+              auditfile.get_seconds_to_fsync());
+
+    auditfile.write_event_to_disk(event);
+    auto secs = auditfile.get_seconds_to_fsync();
+    EXPECT_TRUE(secs == 10 || secs == 9);
+
+    cb_timeofday_timetravel(10);
+    EXPECT_EQ(0, auditfile.get_seconds_to_fsync());
+
+    // flush() syncs the file once the interval has passed
+    EXPECT_TRUE(auditfile.flush());
+    EXPECT_EQ(std::numeric_limits<uint32_t>::max(),
+              auditfile.get_seconds_to_fsync());
+
+    auditfile.close();
+}
+
 TEST_F(AuditFileTest, TestSuccessfulCrashRecovery) {
     FILE *fp = fopen((testdir + "/audit.log").c_str(), "w");
     EXPECT_TRUE(fp != nullptr);
@@ -0,0 +1,89 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include <gtest/gtest.h>
+#include <cJSON_utils.h>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+#include "auditfilter.h"
+#include "eventdescriptor.h"
+#include "mock_auditconfig.h"
+
+class AuditFilterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        addEvent(1, true);
+        addEvent(2, false);
+
+        unique_cJSON_ptr userids(cJSON_CreateArray());
+        cJSON* userid = cJSON_CreateObject();
+        cJSON_AddStringToObject(userid, "source", "memcached");
+        cJSON_AddStringToObject(userid, "user", "filtered");
+        cJSON_AddItemToArray(userids.get(), userid);
+        config.public_set_disabled_userids(userids.get());
+        config.set_filtering_enabled(true);
+    }
+
+    void addEvent(uint32_t id, bool filteringPermitted) {
+        unique_cJSON_ptr json(cJSON_CreateObject());
+        cJSON_AddNumberToObject(json.get(), "id", id);
+        cJSON_AddStringToObject(json.get(), "name", "name");
+        cJSON_AddStringToObject(json.get(), "description", "description");
+        cJSON_AddFalseToObject(json.get(), "sync");
+        cJSON_AddTrueToObject(json.get(), "enabled");
+        cJSON_AddBoolToObject(
+                json.get(), "filtering_permitted", filteringPermitted);
+        descriptors.emplace_back(new EventDescriptor(json.get()));
+        events[id] = descriptors.back().get();
+    }
+
+    static cb::const_char_buffer buf(const char* str) {
+        return {str, strlen(str)};
+    }
+
+    MockAuditConfig config;
+    std::vector<std::unique_ptr<EventDescriptor>> descriptors;
+    std::map<uint32_t, EventDescriptor*> events;
+};
+
+TEST_F(AuditFilterTest, DefaultFiltersNothing) {
+    AuditFilter filter;
+    EXPECT_FALSE(filter.isFiltered(1, buf("memcached"), buf("filtered")));
+}
+
+TEST_F(AuditFilterTest, DisabledUser) {
+    AuditFilter filter(config, events);
+    EXPECT_TRUE(filter.isFiltered(1, buf("memcached"), buf("filtered")));
+    EXPECT_FALSE(filter.isFiltered(1, buf("memcached"), buf("other")));
+    // Both the source and the user must match
+    EXPECT_FALSE(filter.isFiltered(1, buf("local"), buf("filtered")));
+    EXPECT_FALSE(filter.isFiltered(1, buf("memcachedf"), buf("iltered")));
+}
+
+TEST_F(AuditFilterTest, FilteringNotPermitted) {
+    AuditFilter filter(config, events);
+    EXPECT_FALSE(filter.isFiltered(2, buf("memcached"), buf("filtered")));
+    // Unknown events are left to the audit daemon
+    EXPECT_FALSE(filter.isFiltered(3, buf("memcached"), buf("filtered")));
+}
+
+TEST_F(AuditFilterTest, FilteringDisabled) {
+    config.set_filtering_enabled(false);
+    AuditFilter filter(config, events);
+    EXPECT_FALSE(filter.isFiltered(1, buf("memcached"), buf("filtered")));
+}
@@ -0,0 +1,124 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "eventqueue.h"
+
+static std::unique_ptr<Event> createEvent(uint32_t id, size_t sequence) {
+    const auto payload = std::to_string(sequence);
+    return std::unique_ptr<Event>(
+            new Event(id, payload.data(), payload.size()));
+}
+
+TEST(EventQueueTest, Empty) {
+    EventQueue queue;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop());
+}
+
+TEST(EventQueueTest, Fifo) {
+    EventQueue queue;
+    for (size_t ii = 0; ii < 10; ++ii) {
+        queue.push(createEvent(0, ii));
+    }
+    EXPECT_FALSE(queue.empty());
+
+    for (size_t ii = 0; ii < 10; ++ii) {
+        auto event = queue.pop();
+        ASSERT_TRUE(event);
+        EXPECT_EQ(std::to_string(ii), event->payload);
+    }
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop());
+
+    // The queue may be reused after it has been drained
+    queue.push(createEvent(0, 10));
+    auto event = queue.pop();
+    ASSERT_TRUE(event);
+    EXPECT_EQ("10", event->payload);
+}
+
+TEST(EventQueueTest, ClearDeletesEvents) {
+    EventQueue queue;
+    for (size_t ii = 0; ii < 10; ++ii) {
+        queue.push(createEvent(0, ii));
+    }
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    // The destructor deletes the remaining events (checked by ASan /
+    // valgrind)
+    queue.push(createEvent(0, 0));
+}
+
+/**
+ * Push the events from a number of producers while the consumer pops
+ * them. Every event must be popped exactly once, and the events from each
+ * producer must be popped in the order they were pushed.
+ */
+TEST(EventQueueTest, MultipleProducers) {
+    const size_t numProducers = 4;
+    const size_t numEvents = 50000;
+    EventQueue queue;
+
+    std::vector<std::thread> producers;
+    for (size_t ii = 0; ii < numProducers; ++ii) {
+        producers.emplace_back([&queue, ii]() {
+            for (size_t seq = 0; seq < numEvents; ++seq) {
+                queue.push(createEvent(uint32_t(ii), seq));
+            }
+        });
+    }
+
+    // Don't bail out with the producers running; just record the first
+    // event out of order
+    std::vector<size_t> next(numProducers, 0);
+    std::string outOfOrder;
+    size_t popped = 0;
+    while (popped < numProducers * numEvents) {
+        auto event = queue.pop();
+        if (!event) {
+            // Empty, or a producer is in the middle of a push
+            std::this_thread::yield();
+            continue;
+        }
+        ++popped;
+        if (event->id >= numProducers) {
+            outOfOrder = "unknown producer " + std::to_string(event->id);
+            continue;
+        }
+        const auto expected = std::to_string(next[event->id]);
+        if (outOfOrder.empty() && event->payload != expected) {
+            outOfOrder = "producer " + std::to_string(event->id) +
+                         ": expected " + expected + " got " + event->payload;
+        }
+        ++next[event->id];
+    }
+
+    for (auto& t : producers) {
+        t.join();
+    }
+
+    EXPECT_EQ("", outOfOrder);
+    EXPECT_FALSE(queue.pop());
+    EXPECT_TRUE(queue.empty());
+    for (size_t ii = 0; ii < numProducers; ++ii) {
+        EXPECT_EQ(numEvents, next[ii]) << "producer " << ii;
+    }
+}
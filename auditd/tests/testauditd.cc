@@ -25,6 +25,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
@@ -159,6 +160,13 @@ protected:
     // @returns bool  return true if searchString is found in the audit log,
     //                otherwise return false
     bool existsInAuditLog(const std::string& searchString) {
+        return !findInAuditLog(searchString).empty();
+    }
+
+    // Get the first line of the audit log containing the given string
+    // @param searchString  string to atempt to find in the audit log
+    // @returns the line, or an empty string if searchString isn't found
+    std::string findInAuditLog(const std::string& searchString) {
         // confirm that the audit file exists in the directory.
         assertNumberOfFiles(1);
         auto vec = cb::io::findFilesContaining(testdir, "");
@@ -168,11 +176,30 @@ protected:
         while (std::getline(auditFile, line)) {
             if (line.find(searchString) != std::string::npos) {
                 auditFile.close();
-                return true;
+                return line;
             }
         }
         auditFile.close();
-        return false;
+        return {};
+    }
+
+    // Adds a new event that has the filtering_permitted attribute set according
+    // to the input parameter.
+    // @param filteringPermitted  indicates whether the event being added can
+    //                            be filtered or not
+    void addEvent(bool filteringPermitted) {
+        unique_cJSON_ptr root(cJSON_CreateObject());
+        cJSON_AddNumberToObject(root.get(), "id", 1234);
+        cJSON_AddStringToObject(root.get(), "name", "newEvent");
+        cJSON_AddStringToObject(root.get(), "description", "description");
+        cJSON_AddFalseToObject(root.get(), "sync");
+        cJSON_AddTrueToObject(root.get(), "enabled");
+        if (filteringPermitted) {
+            cJSON_AddTrueToObject(root.get(), "filtering_permitted");
+        } else {
+            cJSON_AddFalseToObject(root.get(), "filtering_permitted");
+        }
+        auditHandle->initialize_event_data_structures(root.get());
     }
 
     MockAuditConfig config;
@@ -214,25 +241,6 @@ protected:
 
         config.public_set_disabled_userids(disabled_userids.get());
     }
-
-    // Adds a new event that has the filtering_permitted attribute set according
-    // to the input parameter.
-    // @param filteringPermitted  indicates whether the event being added can
-    //                            be filtered or not
-    void addEvent(bool filteringPermitted) {
-        unique_cJSON_ptr root(cJSON_CreateObject());
-        cJSON_AddNumberToObject(root.get(), "id", 1234);
-        cJSON_AddStringToObject(root.get(), "name", "newEvent");
-        cJSON_AddStringToObject(root.get(), "description", "description");
-        cJSON_AddFalseToObject(root.get(), "sync");
-        cJSON_AddTrueToObject(root.get(), "enabled");
-        if (filteringPermitted) {
-            cJSON_AddTrueToObject(root.get(), "filtering_permitted");
-        } else {
-            cJSON_AddFalseToObject(root.get(), "filtering_permitted");
-        }
-        auditHandle->initialize_event_data_structures(root.get());
-    }
 };
 
 /**
@@ -327,6 +335,148 @@ TEST_F(AuditDaemonTest, VersionTest) {
             << "Wrong version in the audit log";
 }
 
+/**
+ * Tests of how Event::process() adds the timestamp, id, name and
+ * description to the payload (as text, without parsing it).
+ */
+class AuditDaemonEventTest : public AuditDaemonTest {
+protected:
+    void SetUp() {
+        AuditDaemonTest::SetUp();
+        enable();
+        addEvent(false);
+    }
+
+    // Submit the payload and wait (up to 10 seconds) for the event
+    // containing the marker to appear in the audit log
+    unique_cJSON_ptr putAndWait(const std::string& payload,
+                                const std::string& marker) {
+        put_audit_event(auditHandle, 1234, payload.c_str(), payload.size());
+        std::string line;
+        uint16_t waitIteration = 0;
+        while ((line = findInAuditLog(marker)).empty() &&
+               (waitIteration < 200)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            waitIteration++;
+        }
+        return unique_cJSON_ptr(cJSON_Parse(line.c_str()));
+    }
+
+    // Count the top level attributes with the given key
+    static int countKey(const cJSON* root, const std::string& key) {
+        int ret = 0;
+        for (auto* it = root->child; it != nullptr; it = it->next) {
+            if (key == it->string) {
+                ++ret;
+            }
+        }
+        return ret;
+    }
+
+    // Check that the event carries the attributes added by the daemon
+    static void checkAddedAttributes(const cJSON* event) {
+        ASSERT_NE(nullptr, event);
+        auto* root = const_cast<cJSON*>(event);
+        EXPECT_EQ(1, countKey(root, "id"));
+        EXPECT_EQ(1234, cJSON_GetObjectItem(root, "id")->valueint);
+        EXPECT_EQ(1, countKey(root, "name"));
+        EXPECT_STREQ("newEvent",
+                     cJSON_GetObjectItem(root, "name")->valuestring);
+        EXPECT_EQ(1, countKey(root, "description"));
+        EXPECT_STREQ("description",
+                     cJSON_GetObjectItem(root, "description")->valuestring);
+        EXPECT_EQ(1, countKey(root, "timestamp"));
+    }
+};
+
+TEST_F(AuditDaemonEventTest, AddTimestamp) {
+    auto event = putAndWait(R"({"marker":"add_timestamp"})",
+                            "add_timestamp");
+    checkAddedAttributes(event.get());
+    auto* timestamp = cJSON_GetObjectItem(event.get(), "timestamp");
+    ASSERT_NE(nullptr, timestamp);
+    ASSERT_EQ(cJSON_String, timestamp->type);
+    EXPECT_NE(0, strlen(timestamp->valuestring));
+}
+
+TEST_F(AuditDaemonEventTest, KeepTimestamp) {
+    auto event = putAndWait(
+            R"( { "timestamp" : "test", "marker":"keep_timestamp" } )",
+            "keep_timestamp");
+    checkAddedAttributes(event.get());
+    EXPECT_STREQ("test",
+                 cJSON_GetObjectItem(event.get(), "timestamp")->valuestring);
+}
+
+TEST_F(AuditDaemonEventTest, TimestampInNestedObject) {
+    // Only a top level timestamp counts
+    auto event = putAndWait(
+            R"({"marker":"nested_timestamp",)"
+            R"("real_userid":{"timestamp":"inner","user":"[{\""}})",
+            "nested_timestamp");
+    checkAddedAttributes(event.get());
+    EXPECT_STRNE("inner",
+                 cJSON_GetObjectItem(event.get(), "timestamp")->valuestring);
+    auto* userid = cJSON_GetObjectItem(event.get(), "real_userid");
+    ASSERT_NE(nullptr, userid);
+    EXPECT_STREQ("inner",
+                 cJSON_GetObjectItem(userid, "timestamp")->valuestring);
+    EXPECT_STREQ("[{\"",
+                 cJSON_GetObjectItem(userid, "user")->valuestring);
+}
+
+TEST_F(AuditDaemonEventTest, TimestampInArray) {
+    auto event = putAndWait(
+            R"({"marker":"array_timestamp","list":[{"timestamp":1}]})",
+            "array_timestamp");
+    checkAddedAttributes(event.get());
+}
+
+TEST_F(AuditDaemonEventTest, TimestampInString) {
+    // The key (and even a key-value pair) inside of a string value
+    // doesn't count
+    auto event = putAndWait(
+            R"({"marker":"string_timestamp","a":"timestamp",)"
+            R"("b":"\"timestamp\":\"x\""})",
+            "string_timestamp");
+    checkAddedAttributes(event.get());
+    EXPECT_STREQ("timestamp",
+                 cJSON_GetObjectItem(event.get(), "a")->valuestring);
+    EXPECT_STREQ(R"("timestamp":"x")",
+                 cJSON_GetObjectItem(event.get(), "b")->valuestring);
+}
+
+TEST_F(AuditDaemonEventTest, EmptyPayload) {
+    put_audit_event(auditHandle, 1234, "{}", 2);
+    auto event = putAndWait(R"({"marker":"after_empty"})", "after_empty");
+    checkAddedAttributes(event.get());
+
+    // The empty payload is logged just before the marker, and only
+    // contains the attributes added by the daemon
+    auto empty = findInAuditLog(R"("id":1234)");
+    ASSERT_FALSE(empty.empty());
+    unique_cJSON_ptr json(cJSON_Parse(empty.c_str()));
+    checkAddedAttributes(json.get());
+    EXPECT_EQ(4, cJSON_GetArraySize(json.get()));
+}
+
+TEST_F(AuditDaemonEventTest, RejectInvalidUTF8) {
+    // cJSON used to accept (and copy) invalid UTF-8, but the payload is
+    // now validated with checkUTF8JSON() and such events are dropped
+    const std::string invalid = "{\"marker\":\"invalid_utf8\xff\"}";
+    put_audit_event(auditHandle, 1234, invalid.c_str(), invalid.size());
+    const std::string truncated = R"({"marker":"truncated")";
+    put_audit_event(
+            auditHandle, 1234, truncated.c_str(), truncated.size());
+
+    // The events are processed in order, so once the next one is logged
+    // the invalid ones have been dropped
+    auto event = putAndWait(R"({"marker":"after_invalid"})", "after_invalid");
+    checkAddedAttributes(event.get());
+    EXPECT_FALSE(existsInAuditLog("invalid_utf8"));
+    EXPECT_FALSE(existsInAuditLog("truncated"));
+}
+
 int main(int argc, char** argv) {
     cb::logger::createConsoleLogger();
     ::testing::InitGoogleTest(&argc, argv);
@@ -243,6 +243,32 @@ TEST_F(UserTest, TestNoSha1) {
     EXPECT_NO_THROW(u.getPassword(Mechanism::PLAIN));
 }
 
+TEST_F(UserTest, ScramKeys) {
+    cb::sasl::User u;
+    EXPECT_NO_THROW(u = cb::sasl::UserFactory::create(root.get()));
+    const auto& md = u.getPassword(Mechanism::SCRAM_SHA1);
+    const std::vector<uint8_t> salted(md.getPassword().begin(),
+                                      md.getPassword().end());
+    const std::string clientKeyLabel{"Client Key"};
+    const std::string serverKeyLabel{"Server Key"};
+
+    const auto clientKey = cb::crypto::HMAC(
+            cb::crypto::Algorithm::SHA1,
+            salted,
+            std::vector<uint8_t>(clientKeyLabel.begin(), clientKeyLabel.end()));
+    const auto storedKey =
+            cb::crypto::digest(cb::crypto::Algorithm::SHA1, clientKey);
+    const auto serverKey = cb::crypto::HMAC(
+            cb::crypto::Algorithm::SHA1,
+            salted,
+            std::vector<uint8_t>(serverKeyLabel.begin(), serverKeyLabel.end()));
+
+    EXPECT_EQ(std::string(storedKey.begin(), storedKey.end()),
+              md.getStoredKey());
+    EXPECT_EQ(std::string(serverKey.begin(), serverKey.end()),
+              md.getServerKey());
+}
+
 TEST_F(UserTest, InvalidLabel) {
     cJSON_AddStringToObject(root.get(), "gssapi", "foo");
     EXPECT_THROW(auto u = cb::sasl::UserFactory::create(root.get()),
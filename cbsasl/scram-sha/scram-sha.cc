@@ -495,7 +495,7 @@ cbsasl_error_t ScramShaServerBackend::step(const char* input,
     if (user.isDummy() && cb::sasl::saslauthd::is_configured()) {
         addAttribute(out, 'e', "scram-not-supported-for-ldap-users", false);
     } else {
-        auto serverSignature = getServerSignature();
+        auto serverSignature = generateServerSignature();
         addAttribute(out, 'v', serverSignature, false);
     }
 
@@ -503,31 +503,75 @@ cbsasl_error_t ScramShaServerBackend::step(const char* input,
     (*output) = server_final_message.data();
     (*outputlen) = server_final_message.length();
 
-    std::string clientproof = iter->second;
-    std::string my_clientproof = Couchbase::Base64::encode(getClientProof());
-
-    int fail = cbsasl_secure_compare(clientproof.c_str(), clientproof.length(),
-                                     my_clientproof.c_str(),
-                                     my_clientproof.length()) ^user.isDummy();
+    if (user.isDummy()) {
+        logging::log(conn,
+                     logging::Level::Fail,
+                     "No such user [" + username + "]");
+        return CBSASL_NOUSER;
+    }
 
-    if (fail != 0) {
-        if (user.isDummy()) {
-            logging::log(conn,
-                         logging::Level::Fail,
-                         "No such user [" + username + "]");
-            return CBSASL_NOUSER;
-        } else {
-            logging::log(conn,
-                         logging::Level::Fail,
-                         "Authentication fail for [" + username + "]");
-            return CBSASL_PWERR;
-        }
+    if (!verifyClientProof(iter->second)) {
+        logging::log(conn,
+                     logging::Level::Fail,
+                     "Authentication fail for [" + username + "]");
+        return CBSASL_PWERR;
     }
 
     logging::log(conn, logging::Level::Trace, server_final_message);
     return CBSASL_OK;
 }
 
+/**
+ * Generate the Server Signature from the precomputed ServerKey:
+ *
+ * ServerSignature := HMAC(ServerKey, AuthMessage)
+ */
+std::string ScramShaServerBackend::generateServerSignature() {
+    const auto& serverKey = user.getPassword(mechanism).getServerKey();
+    auto serverSignature = cb::crypto::HMAC(algorithm,
+                                            string2vector(serverKey),
+                                            string2vector(getAuthMessage()));
+
+    return std::string(reinterpret_cast<const char*>(serverSignature.data()),
+                       serverSignature.size());
+}
+
+/**
+ * Verify the Client Proof by using the precomputed StoredKey (so that
+ * we don't need the salted password):
+ *
+ * ClientSignature := HMAC(StoredKey, AuthMessage)
+ * ClientKey       := ClientProof XOR ClientSignature
+ *
+ * and the proof is valid if H(ClientKey) is equal to the StoredKey
+ */
+bool ScramShaServerBackend::verifyClientProof(const std::string& encoded) {
+    std::string proof;
+    try {
+        proof = Couchbase::Base64::decode(encoded);
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    const auto& storedKey = user.getPassword(mechanism).getStoredKey();
+    auto clientKey = cb::crypto::HMAC(algorithm,
+                                      string2vector(storedKey),
+                                      string2vector(getAuthMessage()));
+    if (proof.size() != clientKey.size()) {
+        return false;
+    }
+
+    for (size_t ii = 0; ii < clientKey.size(); ++ii) {
+        clientKey[ii] ^= uint8_t(proof[ii]);
+    }
+
+    const auto digest = cb::crypto::digest(algorithm, clientKey);
+    return cbsasl_secure_compare(reinterpret_cast<const char*>(digest.data()),
+                                 digest.size(),
+                                 storedKey.data(),
+                                 storedKey.size()) == 0;
+}
+
 /********************************************************************
  * Client API
  *******************************************************************/
@@ -139,6 +139,21 @@ public:
     }
 
     cb::sasl::User user;
+
+protected:
+    /**
+     * Generate the server signature by using the ServerKey stored for
+     * the user (instead of deriving it from the salted password)
+     */
+    std::string generateServerSignature();
+
+    /**
+     * Verify the client proof by using the StoredKey stored for the user
+     *
+     * @param encoded the base64 encoded proof provided by the client
+     * @return true if the proof is valid
+     */
+    bool verifyClientProof(const std::string& encoded);
 };
 
 /**
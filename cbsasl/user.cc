@@ -93,17 +93,20 @@ cb::sasl::User cb::sasl::UserFactory::createDummy(const std::string& unm,
     User ret{unm};
 
     std::vector<uint8_t> salt;
-    std::string passwd;
+    cb::crypto::Algorithm algorithm = cb::crypto::Algorithm::MD5;
 
     switch (mech) {
     case Mechanism::SCRAM_SHA512:
         salt.resize(cb::crypto::SHA512_DIGEST_SIZE);
+        algorithm = cb::crypto::Algorithm::SHA512;
         break;
     case Mechanism::SCRAM_SHA256:
         salt.resize(cb::crypto::SHA256_DIGEST_SIZE);
+        algorithm = cb::crypto::Algorithm::SHA256;
         break;
     case Mechanism::SCRAM_SHA1:
         salt.resize(cb::crypto::SHA1_DIGEST_SIZE);
+        algorithm = cb::crypto::Algorithm::SHA1;
         break;
     case Mechanism::PLAIN:
     case Mechanism::UNKNOWN:
@@ -114,11 +117,24 @@ cb::sasl::User cb::sasl::UserFactory::createDummy(const std::string& unm,
         throw std::logic_error("cb::cbsasl::UserFactory::createDummy invalid algorithm");
     }
 
-    // Generate a random password
-    generateSalt(salt, passwd);
-
-    // Generate the secrets by using that random password
-    ret.generateSecrets(mech, passwd);
+    // The authentication of a dummy user always fails, so there is no
+    // point in running PBKDF2 to generate the salted password (it would
+    // only burn CPU for every attempt with an unknown user, and make it
+    // easy to tell them apart from the real users). Just use random
+    // bytes of the same size as the digest.
+    std::string encodedSalt;
+    generateSalt(salt, encodedSalt);
+    std::vector<uint8_t> saltedPassword(salt.size());
+    std::string unused;
+    generateSalt(saltedPassword, unused);
+
+    PasswordMetaData md(std::string(reinterpret_cast<const char*>(
+                                            saltedPassword.data()),
+                                    saltedPassword.size()),
+                        encodedSalt,
+                        IterationCount);
+    md.generateScramKeys(algorithm);
+    ret.password[mech] = md;
 
     return ret;
 }
@@ -148,12 +164,15 @@ cb::sasl::User cb::sasl::UserFactory::create(const cJSON* obj) {
             // skip. we've already processed this
         } else if (label == "sha512") {
             User::PasswordMetaData pd(o);
+            pd.generateScramKeys(cb::crypto::Algorithm::SHA512);
             ret.password[Mechanism::SCRAM_SHA512] = pd;
         } else if (label == "sha256") {
             User::PasswordMetaData pd(o);
+            pd.generateScramKeys(cb::crypto::Algorithm::SHA256);
             ret.password[Mechanism::SCRAM_SHA256] = pd;
         } else if (label == "sha1") {
             User::PasswordMetaData pd(o);
+            pd.generateScramKeys(cb::crypto::Algorithm::SHA1);
             ret.password[Mechanism::SCRAM_SHA1] = pd;
         } else if (label == "plain") {
             User::PasswordMetaData pd(Couchbase::Base64::decode(o->valuestring));
@@ -232,9 +251,40 @@ void cb::sasl::User::generateSecrets(const Mechanism& mech,
     generateSalt(salt, encodedSalt);
     auto digest = cb::crypto::PBKDF2_HMAC(algorithm, passwd, salt, IterationCount);
 
-    password[mech] =
-        PasswordMetaData(std::string((const char*)digest.data(), digest.size()),
-                         encodedSalt, IterationCount);
+    PasswordMetaData md(
+            std::string((const char*)digest.data(), digest.size()),
+            encodedSalt,
+            IterationCount);
+    md.generateScramKeys(algorithm);
+    password[mech] = md;
+}
+
+void cb::sasl::User::PasswordMetaData::generateScramKeys(
+        cb::crypto::Algorithm algorithm) {
+    if (!cb::crypto::isSupported(algorithm)) {
+        // The mechanism won't be offered to the clients
+        return;
+    }
+
+    const std::vector<uint8_t> saltedPassword(password.begin(),
+                                              password.end());
+    const std::string clientKeyLabel{"Client Key"};
+    const std::string serverKeyLabel{"Server Key"};
+
+    const auto clientKey = cb::crypto::HMAC(
+            algorithm,
+            saltedPassword,
+            std::vector<uint8_t>(clientKeyLabel.begin(), clientKeyLabel.end()));
+    const auto storedKey = cb::crypto::digest(algorithm, clientKey);
+    const auto serverKey = cb::crypto::HMAC(
+            algorithm,
+            saltedPassword,
+            std::vector<uint8_t>(serverKeyLabel.begin(), serverKeyLabel.end()));
+
+    stored_key.assign(reinterpret_cast<const char*>(storedKey.data()),
+                      storedKey.size());
+    server_key.assign(reinterpret_cast<const char*>(serverKey.data()),
+                      serverKey.size());
 }
 
 cb::sasl::User::PasswordMetaData::PasswordMetaData(cJSON* obj) {
@@ -94,6 +94,30 @@ public:
             return iteration_count;
         }
 
+        /**
+         * Get the StoredKey used by the server to verify the client
+         * proof in SCRAM (H(HMAC(SaltedPassword, "Client Key")))
+         */
+        const std::string& getStoredKey() const {
+            return stored_key;
+        }
+
+        /**
+         * Get the ServerKey used by the server to generate the server
+         * signature in SCRAM (HMAC(SaltedPassword, "Server Key"))
+         */
+        const std::string& getServerKey() const {
+            return server_key;
+        }
+
+        /**
+         * Derive the StoredKey and ServerKey from the salted password so
+         * that the server don't need to do so for every authentication
+         *
+         * @param algorithm the algorithm used by the SCRAM mechanism
+         */
+        void generateScramKeys(cb::crypto::Algorithm algorithm);
+
     private:
         // Base 64 encoded version of the salt
         std::string salt;
@@ -103,6 +127,10 @@ public:
 
         // The iteration count used for generating the password
         int iteration_count;
+
+        // The SCRAM StoredKey and ServerKey (not part of the JSON)
+        std::string stored_key;
+        std::string server_key;
     };
 
     /**
@@ -80,3 +80,32 @@ int DummyAllocHooks::set_allocator_property(const char* name,
                                             size_t newlen) {
     return 1;
 }
+
+bool DummyAllocHooks::create_arena(unsigned* arena) {
+    return false;
+}
+
+bool DummyAllocHooks::destroy_arena(unsigned arena) {
+    return false;
+}
+
+void* DummyAllocHooks::arena_malloc(unsigned arena, size_t size) {
+    return nullptr;
+}
+
+void DummyAllocHooks::arena_free(void* ptr) {
+    // empty (we never hand out memory from an arena)
+}
+
+bool DummyAllocHooks::get_arena_stats(unsigned arena, allocator_stats* stats) {
+    return false;
+}
+
+bool DummyAllocHooks::get_allocation_utilization(const void* ptr,
+                                                 allocator_utilization* util) {
+    return false;
+}
+
+bool DummyAllocHooks::is_allocation_utilization_supported() {
+    return false;
+}
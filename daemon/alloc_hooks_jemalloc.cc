@@ -208,3 +208,149 @@ int JemallocHooks::set_allocator_property(const char* name,
                                           size_t newlen) {
     return je_mallctl(name, nullptr, 0, newp, newlen);
 }
+
+/* Read the statistic "stats.arenas.<arena>.<name>" into value, leaving it
+ * alone if the statistic doesn't exist in the jemalloc version in use.
+ */
+static int jemalloc_get_arena_stats_prop(unsigned arena,
+                                         const char* name,
+                                         size_t* value) {
+    char property[64];
+    snprintf(property, sizeof(property), "stats.arenas.%u.%s", arena, name);
+    return jemalloc_get_stats_prop(property, value);
+}
+
+bool JemallocHooks::create_arena(unsigned* arena) {
+    size_t size = sizeof(*arena);
+    /* jemalloc 4 called it arenas.extend */
+    if (je_mallctl("arenas.create", arena, &size, NULL, 0) == 0 ||
+        je_mallctl("arenas.extend", arena, &size, NULL, 0) == 0) {
+        return true;
+    }
+    LOG_WARNING("jemalloc_create_arena() - could not create arena");
+    return false;
+}
+
+bool JemallocHooks::destroy_arena(unsigned arena) {
+    char property[64];
+    /* arena.<i>.destroy was introduced in jemalloc 5, fall back to
+     * releasing the dirty pages of the arena if it isn't available.
+     */
+    snprintf(property, sizeof(property), "arena.%u.destroy", arena);
+    if (je_mallctl(property, NULL, 0, NULL, 0) == 0) {
+        return true;
+    }
+    snprintf(property, sizeof(property), "arena.%u.purge", arena);
+    int err = je_mallctl(property, NULL, 0, NULL, 0);
+    if (err != 0) {
+        LOG_WARNING("jemalloc_destroy_arena({}) error {} - could not purge",
+                    arena,
+                    err);
+    }
+    return false;
+}
+
+void* JemallocHooks::arena_malloc(unsigned arena, size_t size) {
+    /* The thread cache is shared by all of the arenas, so bypass it to
+     * make sure that the memory really comes from the requested arena.
+     */
+    return je_mallocx(size, MALLOCX_ARENA(arena) | MALLOCX_TCACHE_NONE);
+}
+
+void JemallocHooks::arena_free(void* ptr) {
+    if (ptr != NULL) {
+        je_dallocx(ptr, MALLOCX_TCACHE_NONE);
+    }
+}
+
+bool JemallocHooks::get_arena_stats(unsigned arena, allocator_stats* stats) {
+    size_t epoch = 1;
+    size_t sz = sizeof(epoch);
+    /* jemalloc can cache its statistics - force a refresh */
+    je_mallctl("epoch", &epoch, &sz, &epoch, sz);
+
+    size_t small = 0;
+    size_t large = 0;
+    size_t huge = 0; /* only exists in jemalloc 4 */
+    if (jemalloc_get_arena_stats_prop(arena, "small.allocated", &small) != 0 ||
+        jemalloc_get_arena_stats_prop(arena, "large.allocated", &large) != 0) {
+        return false;
+    }
+    jemalloc_get_arena_stats_prop(arena, "huge.allocated", &huge);
+    stats->allocated_size = small + large + huge;
+
+    jemalloc_get_arena_stats_prop(arena, "mapped", &stats->heap_size);
+    jemalloc_get_arena_stats_prop(arena, "retained", &stats->retained_size);
+    jemalloc_get_arena_stats_prop(arena, "resident", &stats->resident_size);
+
+    size_t pactive = 0;
+    size_t page = 0;
+    jemalloc_get_arena_stats_prop(arena, "pactive", &pactive);
+    jemalloc_get_stats_prop("arenas.page", &page);
+    const size_t active_bytes = pactive * page;
+    stats->fragmentation_size = active_bytes > stats->allocated_size
+                                        ? active_bytes - stats->allocated_size
+                                        : 0;
+    return true;
+}
+
+/* The MIB of experimental.utilization.query (added in jemalloc 5.2),
+ * translated once as the defragmenter queries every object it visits.
+ */
+struct utilization_query {
+    utilization_query() {
+        supported = je_mallctlnametomib("experimental.utilization.query",
+                                        mib,
+                                        &miblen) == 0;
+    }
+
+    size_t mib[3];
+    size_t miblen = 3;
+    bool supported;
+};
+
+static const utilization_query& get_utilization_query() {
+    static const utilization_query query;
+    return query;
+}
+
+bool JemallocHooks::get_allocation_utilization(const void* ptr,
+                                               allocator_utilization* util) {
+    const auto& query = get_utilization_query();
+    if (!query.supported) {
+        return false;
+    }
+
+    /* The layout of the result of experimental.utilization.query */
+    struct {
+        size_t nfree;
+        size_t nregs;
+        size_t size; /* of the slab (in bytes) */
+        size_t bin_nfree;
+        size_t bin_nregs;
+        void* slabcur_addr;
+    } out;
+    size_t size = sizeof(out);
+    if (je_mallctlbymib(query.mib,
+                        query.miblen,
+                        &out,
+                        &size,
+                        &ptr,
+                        sizeof(ptr)) != 0) {
+        return false;
+    }
+
+    util->slab_free = out.nfree;
+    util->slab_regions = out.nregs;
+    util->bin_free = out.bin_nfree;
+    util->bin_regions = out.bin_nregs;
+    const auto* slabcur = static_cast<const char*>(out.slabcur_addr);
+    util->current_slab = slabcur != NULL &&
+                         static_cast<const char*>(ptr) >= slabcur &&
+                         static_cast<const char*>(ptr) < slabcur + out.size;
+    return true;
+}
+
+bool JemallocHooks::is_allocation_utilization_supported() {
+    return get_utilization_query().supported;
+}
@@ -380,6 +380,14 @@ public:
         Connection::allow_unordered_execution = allow_unordered_execution;
     }
 
+    bool isCompactStatsSupported() const {
+        return compact_stats_support;
+    }
+
+    void setCompactStatsSupported(bool compact_stats_support) {
+        Connection::compact_stats_support = compact_stats_support;
+    }
+
     /**
      * Remap the current error code
      *
@@ -542,6 +550,11 @@ protected:
 
     bool allow_unordered_execution{false};
 
+    /**
+     * Does the client want multiple stats packed into each STAT response?
+     */
+    bool compact_stats_support{false};
+
     std::queue<std::unique_ptr<ServerEvent>> server_events;
 
     /**
@@ -59,7 +59,7 @@ ListenConnection::~ListenConnection() {
 }
 
 void ListenConnection::enable() {
-    if (!registered_in_libevent) {
+    if (!registered_in_libevent && ev) {
         LOG_INFO("{} Listen on {}", getId(), getSockname());
         if (listen(getSocketDescriptor(), backlog) == SOCKET_ERROR) {
             LOG_WARNING("{}: Failed to listen on {}: {}",
@@ -104,6 +104,11 @@ void ListenConnection::disable() {
     }
 }
 
+void ListenConnection::releaseEvent() {
+    disable();
+    ev.reset();
+}
+
 void ListenConnection::runEventLoop(short) {
     auto logger = cb::logger::get();
 
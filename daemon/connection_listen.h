@@ -52,6 +52,26 @@ public:
         return management;
     }
 
+    /**
+     * Get the worker thread accepting clients on this socket, or nullptr
+     * if the clients are accepted by the dispatcher thread (and handed
+     * over to a worker thread).
+     */
+    LIBEVENT_THREAD* getWorkerThread() const {
+        return worker;
+    }
+
+    void setWorkerThread(LIBEVENT_THREAD* worker) {
+        ListenConnection::worker = worker;
+    }
+
+    /**
+     * Stop listening and release the libevent event. Used during shutdown
+     * as the event base of the worker threads is released before the
+     * connection objects.
+     */
+    void releaseEvent();
+
     /**
      * Get the details for this connection to put in the portnumber
      * file so that the test framework may pick up the port numbers
@@ -65,6 +85,9 @@ protected:
     const bool ssl;
     const bool management;
 
+    /// The worker thread owning this socket (SO_REUSEPORT) if any
+    LIBEVENT_THREAD* worker = nullptr;
+
     struct EventDeleter {
         void operator()(struct event* ev) {
             if (ev != nullptr) {
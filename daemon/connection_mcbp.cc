@@ -169,6 +169,32 @@ bool McbpConnection::updateEvent(const short new_flags) {
     return true;
 }
 
+bool McbpConnection::assignEventBase(event_base* new_base) {
+    if (event_assign(&event,
+                     new_base,
+                     socketDescriptor,
+                     ev_flags,
+                     event_handler,
+                     reinterpret_cast<void*>(this)) == -1) {
+        event_assign(&event,
+                     base,
+                     socketDescriptor,
+                     ev_flags,
+                     event_handler,
+                     reinterpret_cast<void*>(this));
+        return false;
+    }
+    base = new_base;
+    return true;
+}
+
+bool McbpConnection::isIdleForMigration() {
+    return getState() == McbpStateMachine::State::read_packet_header &&
+           registered_in_libevent && ev_flags == (EV_READ | EV_PERSIST) &&
+           !ewouldblock && !dcp && getRefcount() == 1 && !read && !write &&
+           server_events.empty() && !ssl.havePendingInputData();
+}
+
 bool McbpConnection::reapplyEventmask() {
     return updateEvent(ev_flags);
 }
@@ -245,6 +271,11 @@ int McbpConnection::sslPreConnection() {
     if (r == 1) {
         ssl.drainBioSendPipe(socketDescriptor);
         ssl.setConnected();
+        if (ssl.isSessionReused()) {
+            stats.ssl_handshakes_resumed++;
+        } else {
+            stats.ssl_handshakes_full++;
+        }
         auto certResult = ssl.getCertUserName();
         bool disconnect = false;
         switch (certResult.first) {
@@ -277,6 +308,12 @@ int McbpConnection::sslPreConnection() {
             }
             return -1;
         }
+
+        // Let the kernel encrypt the responses if possible (the data we
+        // receive is still decrypted by OpenSSL)
+        if (ssl.enableKernelSend(socketDescriptor)) {
+            LOG_DEBUG("{}: Using kernel TLS to send data", getId());
+        }
     } else {
         if (ssl.getError(r) == SSL_ERROR_WANT_READ) {
             ssl.drainBioSendPipe(socketDescriptor);
@@ -343,7 +380,7 @@ int McbpConnection::recv(char* dest, size_t nbytes) {
 
 int McbpConnection::sendmsg(struct msghdr* m) {
     int res = 0;
-    if (ssl.isEnabled()) {
+    if (ssl.isEnabled() && !ssl.isKernelSend()) {
         for (int ii = 0; ii < int(m->msg_iovlen); ++ii) {
             int n = sslWrite(reinterpret_cast<char*>(m->msg_iov[ii].iov_base),
                              m->msg_iov[ii].iov_len);
@@ -409,7 +446,8 @@ McbpConnection::TransmitResult McbpConnection::transmit() {
     if (ssl.isEnabled()) {
         // We use OpenSSL to write data into a buffer before we send it
         // over the wire... Lets go ahead and drain that BIO pipe before
-        // we may do anything else.
+        // we may do anything else. (With kTLS this sends any alerts
+        // OpenSSL generated).
         ssl.drainBioSendPipe(socketDescriptor);
         if (ssl.morePendingOutput()) {
             if (ssl.hasError() || !updateEvent(EV_WRITE | EV_PERSIST)) {
@@ -568,6 +606,11 @@ int McbpConnection::sslRead(char* dest, size_t nbytes) {
             return -1;
         }
         n = ssl.read(dest + ret, (int)(nbytes - ret));
+        if (ssl.isKernelSend()) {
+            // OpenSSL may have replied with an alert (e.g. refusing a
+            // renegotiation) which must be sent through the kernel
+            ssl.drainBioSendPipe(socketDescriptor);
+        }
         if (n > 0) {
             ret += n;
         } else {
@@ -594,6 +637,7 @@ int McbpConnection::sslRead(char* dest, size_t nbytes) {
 
             case SSL_ERROR_ZERO_RETURN:
                 /* The TLS/SSL connection has been closed (cleanly). */
+                ssl.shutdown(socketDescriptor);
                 return 0;
 
             default:
@@ -1058,6 +1102,18 @@ void McbpConnection::signalIfIdle(bool logbusy, int workerthread) {
     }
 }
 
+void McbpConnection::setDCP(bool dcp) {
+    auto* thr = getThread();
+    if (thr != nullptr && McbpConnection::dcp != dcp) {
+        if (dcp) {
+            thr->load.dcp_connections++;
+        } else {
+            thr->load.dcp_connections--;
+        }
+    }
+    McbpConnection::dcp = dcp;
+}
+
 void McbpConnection::setPriority(const Connection::Priority& priority) {
     Connection::setPriority(priority);
     switch (priority) {
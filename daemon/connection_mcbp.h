@@ -124,9 +124,7 @@ public:
         return dcp;
     }
 
-    void setDCP(bool dcp) {
-        McbpConnection::dcp = dcp;
-    }
+    void setDCP(bool dcp);
 
     bool isDcpXattrAware() const {
         return dcpXattrAware;
@@ -236,6 +234,24 @@ public:
         return registered_in_libevent;
     }
 
+    /**
+     * Assign the (unregistered) event structure to another event base.
+     * Used when moving the connection to another worker thread, which
+     * calls registerEvent() once it picks up the connection.
+     *
+     * @return true if success, false otherwise (the event is left
+     *              assigned to the current event base)
+     */
+    bool assignEventBase(event_base* new_base);
+
+    /**
+     * Is the connection idle in a way which allows it to be moved to
+     * another worker thread? It must be waiting for the next command
+     * with nothing buffered, and without any operations pending in the
+     * engine.
+     */
+    bool isIdleForMigration();
+
     short getEventFlags() const {
         return ev_flags;
     }
@@ -166,10 +166,13 @@ void run_event_loop(Connection* c, short which) {
     auto* thread = c->getThread();
     if (thread != nullptr) {
         scheduler_info[thread->index].add(ns);
+        thread->load.busy_ns += ns.count();
     }
 
     if (c->shouldDelete()) {
         release_connection(c);
+    } else {
+        maybe_migrate_connection(*c);
     }
 }
 
@@ -441,6 +444,18 @@ static void release_connection(Connection *c) {
         connections.conns.erase(iter);
     }
 
+    auto* thread = c->getThread();
+    if (thread != nullptr) {
+        thread->load.connections--;
+
+        // The connection may have been closed before the thread it was
+        // moved to got around to register it
+        std::lock_guard<std::mutex> guard(thread->migrated.mutex);
+        auto& migrated = thread->migrated.connections;
+        migrated.erase(std::remove(migrated.begin(), migrated.end(), c),
+                       migrated.end());
+    }
+
     // Finally free it
     conn_destructor(c);
 }
@@ -19,6 +19,7 @@
 #include "buckets.h"
 #include "connection_mcbp.h"
 #include "mcbp.h"
+#include "request_trace_log.h"
 
 #include <mcbp/mcbp.h>
 #include <mcbp/protocol/framebuilder.h>
@@ -477,10 +478,61 @@ void Cookie::maybeLogSlowCommand(
     }
 }
 
+void Cookie::maybeAddToTraceLog(const std::chrono::nanoseconds& elapsed) {
+    using namespace std::chrono;
+    RequestTraceLog::Reason reason;
+
+    const auto threshold = settings.getTracingSlowThreshold();
+    const auto rate = settings.getTracingSampleRate();
+    // Count per thread to avoid all of the threads updating the same
+    // counter for every command
+    static thread_local size_t counter = 0;
+
+    if (threshold.count() != 0 && elapsed >= threshold) {
+        reason = RequestTraceLog::Reason::Slow;
+    } else if (rate != 0 && (++counter % rate) == 0) {
+        reason = RequestTraceLog::Reason::Sampled;
+    } else {
+        return;
+    }
+
+    const auto& header = getHeader();
+    traceLogEntry.reset(new RequestTraceLog::Entry);
+    auto& entry = *traceLogEntry;
+    entry.time = system_clock::now();
+    entry.connectionId = getConnection().getId();
+    try {
+        entry.opcode = to_string(getRequest().getClientOpcode());
+    } catch (const std::exception&) {
+        char opcode_s[16];
+        checked_snprintf(
+                opcode_s, sizeof(opcode_s), "0x%X", header.getOpcode());
+        entry.opcode.assign(opcode_s);
+    }
+    entry.opaque = ntohl(header.getOpaque());
+    entry.duration = duration_cast<microseconds>(elapsed);
+    entry.reason = reason;
+
+    if (connection.getState() == McbpStateMachine::State::send_data) {
+        tracer.begin(cb::tracing::TraceCode::SEND);
+    }
+}
+
+void Cookie::flushTraceLog() {
+    if (!traceLogEntry) {
+        return;
+    }
+    tracer.end(cb::tracing::TraceCode::SEND);
+    traceLogEntry->setTrace(tracer);
+    RequestTraceLog::getInstance().add(std::move(*traceLogEntry));
+    traceLogEntry.reset();
+}
+
 void Cookie::initialize(cb::const_byte_buffer header) {
     reset();
     setPacket(Cookie::PacketContent::Header, header);
     setCas(0);
     start = ProcessClock::now();
     tracer.begin(cb::tracing::TraceCode::REQUEST);
+    tracer.begin(cb::tracing::TraceCode::PARSE);
 }
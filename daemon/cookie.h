@@ -17,6 +17,7 @@
 #pragma once
 
 #include "dynamic_buffer.h"
+#include "request_trace_log.h"
 #include "tracing/tracer.h"
 
 #include <cJSON_utils.h>
@@ -77,6 +78,7 @@ public:
         cas = 0;
         commandContext.reset();
         dynamicBuffer.clear();
+        flushTraceLog();
         tracer.clear();
     }
 
@@ -425,6 +427,24 @@ public:
      */
     void maybeLogSlowCommand(const std::chrono::milliseconds& elapsed) const;
 
+    /**
+     * Add the trace for the current command to the request trace log if
+     * it is selected by sampling or its execution time exceeds the
+     * configured threshold. The entry isn't added to the log until
+     * flushTraceLog() is called, so that the time spent sending the
+     * response is included in the trace.
+     *
+     * @param elapsed the time elapsed while executing the command
+     */
+    void maybeAddToTraceLog(const std::chrono::nanoseconds& elapsed);
+
+    /**
+     * Add the pending entry (if any) created by maybeAddToTraceLog() to
+     * the request trace log. Called once the response is sent (and
+     * when the cookie is reset in case there was no response to send)
+     */
+    void flushTraceLog();
+
     /**
      * Get the start time for this command
      */
@@ -448,6 +468,9 @@ protected:
     bool enableTracing = false;
     cb::tracing::Tracer tracer;
 
+    /// The entry to add to the request trace log once the response is sent
+    std::unique_ptr<RequestTraceLog::Entry> traceLogEntry;
+
     /**
      * The connection object this cookie is bound to
      */
@@ -0,0 +1,433 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "json_validator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JSON_VALIDATOR_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/**
+ * Characters which stop the (fast) scan of string content and need to be
+ * handled individually: the closing quote, an escape, control characters
+ * (which must be escaped) and the start of a multi-byte UTF-8 sequence.
+ */
+inline bool isSpecialStringChar(uint8_t c) {
+    return c == '"' || c == '\\' || c < 0x20 || c >= 0x80;
+}
+
+inline bool isDigit(uint8_t c) {
+    return c >= '0' && c <= '9';
+}
+
+inline bool isHexDigit(uint8_t c) {
+    return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+inline bool isWhitespace(uint8_t c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+struct ScalarScanner {
+    /// @return the first special string character in [p, end), or end.
+    static const uint8_t* scan(const uint8_t* p, const uint8_t* end) {
+        while (p < end && !isSpecialStringChar(*p)) {
+            ++p;
+        }
+        return p;
+    }
+};
+
+#ifdef JSON_VALIDATOR_X86
+// SSE2 is part of the x86-64 baseline so needs no runtime check.
+struct Sse2Scanner {
+    /// @return a bitmask of the special string characters in p[0..15].
+    static int findSpecial(const uint8_t* p) {
+        const __m128i chunk =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // The signed compare against space matches both control characters
+        // and non-ASCII bytes (which are negative).
+        const __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+                _mm_cmplt_epi8(chunk, _mm_set1_epi8(0x20)));
+        return _mm_movemask_epi8(special);
+    }
+
+    static const uint8_t* scan(const uint8_t* p, const uint8_t* end) {
+        while (end - p >= 16) {
+            const int mask = findSpecial(p);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+        return ScalarScanner::scan(p, end);
+    }
+};
+
+// Most strings in typical documents (keys, short values) end within the
+// first 16 bytes, so check those inline with SSE2 and only switch to AVX2
+// (out of line, as it must be compiled for a different target) for longer
+// strings.
+__attribute__((target("avx2"))) const uint8_t* scanAvx2(const uint8_t* p,
+                                                         const uint8_t* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(0x20);
+    while (end - p >= 32) {
+        const __m256i chunk =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i special = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                                _mm256_cmpeq_epi8(chunk, backslash)),
+                _mm256_cmpgt_epi8(space, chunk));
+        const uint32_t mask = _mm256_movemask_epi8(special);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return p;
+}
+
+struct Avx2Scanner {
+    static const uint8_t* scan(const uint8_t* p, const uint8_t* end) {
+        if (end - p >= 16) {
+            const int mask = Sse2Scanner::findSpecial(p);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p = scanAvx2(p + 16, end);
+        }
+        return Sse2Scanner::scan(p, end);
+    }
+};
+#endif
+
+const uint8_t* skipWhitespace(const uint8_t* p, const uint8_t* end) {
+    while (p < end && isWhitespace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * Validate the UTF-8 sequence starting at p (a non-ASCII byte), as per
+ * RFC 3629 (no overlong encodings, surrogates or code points > U+10FFFF).
+ *
+ * @return true (and p advanced past the sequence) if valid
+ */
+bool validateUtf8Sequence(const uint8_t*& p, const uint8_t* end) {
+    const uint8_t c = *p;
+    size_t length;
+    uint8_t min = 0x80;
+    uint8_t max = 0xbf;
+    if (c >= 0xc2 && c <= 0xdf) {
+        length = 2;
+    } else if (c >= 0xe0 && c <= 0xef) {
+        length = 3;
+        if (c == 0xe0) {
+            min = 0xa0;
+        } else if (c == 0xed) {
+            max = 0x9f;
+        }
+    } else if (c >= 0xf0 && c <= 0xf4) {
+        length = 4;
+        if (c == 0xf0) {
+            min = 0x90;
+        } else if (c == 0xf4) {
+            max = 0x8f;
+        }
+    } else {
+        return false;
+    }
+
+    if (size_t(end - p) < length || p[1] < min || p[1] > max) {
+        return false;
+    }
+    for (size_t ii = 2; ii < length; ++ii) {
+        if ((p[ii] & 0xc0) != 0x80) {
+            return false;
+        }
+    }
+    p += length;
+    return true;
+}
+
+/**
+ * Validate a string; p points to the first character after the opening
+ * quote and is advanced past the closing quote.
+ */
+template <class Scanner>
+bool validateString(const uint8_t*& p, const uint8_t* end) {
+    while (true) {
+        p = Scanner::scan(p, end);
+        if (p == end) {
+            return false;
+        }
+
+        switch (*p) {
+        case '"':
+            ++p;
+            return true;
+        case '\\':
+            if (++p == end) {
+                return false;
+            }
+            switch (*p) {
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                ++p;
+                break;
+            case 'u':
+                if (end - p < 5 || !isHexDigit(p[1]) || !isHexDigit(p[2]) ||
+                    !isHexDigit(p[3]) || !isHexDigit(p[4])) {
+                    return false;
+                }
+                p += 5;
+                break;
+            default:
+                return false;
+            }
+            break;
+        default:
+            if (*p < 0x20 || !validateUtf8Sequence(p, end)) {
+                return false;
+            }
+        }
+    }
+}
+
+/// Validate a number; p points to its first character and is advanced past
+/// it.
+bool validateNumber(const uint8_t*& p, const uint8_t* end) {
+    if (*p == '-') {
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+    if (*p == '0') {
+        ++p;
+    } else if (*p >= '1' && *p <= '9') {
+        while (++p < end && isDigit(*p)) {
+        }
+    } else {
+        return false;
+    }
+
+    if (p < end && *p == '.') {
+        if (++p == end || !isDigit(*p)) {
+            return false;
+        }
+        while (++p < end && isDigit(*p)) {
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        if (++p < end && (*p == '+' || *p == '-')) {
+            ++p;
+        }
+        if (p == end || !isDigit(*p)) {
+            return false;
+        }
+        while (++p < end && isDigit(*p)) {
+        }
+    }
+    return true;
+}
+
+bool validateLiteral(const uint8_t*& p,
+                     const uint8_t* end,
+                     const char* literal,
+                     size_t length) {
+    if (size_t(end - p) < length || std::memcmp(p, literal, length) != 0) {
+        return false;
+    }
+    p += length;
+    return true;
+}
+
+template <class Scanner>
+bool validate(const uint8_t* p,
+              const uint8_t* end,
+              std::vector<uint8_t>& stack) {
+    enum class State {
+        // Expecting a value.
+        Value,
+        // Expecting an object member (key).
+        Key,
+        // A value has been completed.
+        AfterValue
+    };
+
+    stack.clear();
+    State state = State::Value;
+    while (true) {
+        p = skipWhitespace(p, end);
+        switch (state) {
+        case State::Value:
+            if (p == end) {
+                return false;
+            }
+            switch (*p) {
+            case '{':
+                p = skipWhitespace(p + 1, end);
+                if (p < end && *p == '}') {
+                    ++p;
+                    state = State::AfterValue;
+                } else {
+                    stack.push_back('{');
+                    state = State::Key;
+                }
+                continue;
+            case '[':
+                p = skipWhitespace(p + 1, end);
+                if (p < end && *p == ']') {
+                    ++p;
+                    state = State::AfterValue;
+                } else {
+                    stack.push_back('[');
+                }
+                continue;
+            case '"':
+                ++p;
+                if (!validateString<Scanner>(p, end)) {
+                    return false;
+                }
+                break;
+            case 't':
+                if (!validateLiteral(p, end, "true", 4)) {
+                    return false;
+                }
+                break;
+            case 'f':
+                if (!validateLiteral(p, end, "false", 5)) {
+                    return false;
+                }
+                break;
+            case 'n':
+                if (!validateLiteral(p, end, "null", 4)) {
+                    return false;
+                }
+                break;
+            default:
+                if (!validateNumber(p, end)) {
+                    return false;
+                }
+            }
+            state = State::AfterValue;
+            continue;
+
+        case State::Key:
+            if (p == end || *p != '"') {
+                return false;
+            }
+            ++p;
+            if (!validateString<Scanner>(p, end)) {
+                return false;
+            }
+            p = skipWhitespace(p, end);
+            if (p == end || *p != ':') {
+                return false;
+            }
+            ++p;
+            state = State::Value;
+            continue;
+
+        case State::AfterValue:
+            if (stack.empty()) {
+                return p == end;
+            }
+            if (p == end) {
+                return false;
+            }
+            if (*p == ',') {
+                ++p;
+                state = stack.back() == '{' ? State::Key : State::Value;
+            } else if (*p == (stack.back() == '{' ? '}' : ']')) {
+                ++p;
+                stack.pop_back();
+            } else {
+                return false;
+            }
+            continue;
+        }
+    }
+}
+
+} // namespace
+
+JsonValidator::JsonValidator() : JsonValidator(getBestIsa()) {
+}
+
+JsonValidator::JsonValidator(Isa isa) : isa(std::min(isa, getBestIsa())) {
+}
+
+JsonValidator::Isa JsonValidator::getBestIsa() {
+#ifdef JSON_VALIDATOR_X86
+    static const Isa best =
+            __builtin_cpu_supports("avx2") ? Isa::AVX2 : Isa::SSE2;
+    return best;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+bool JsonValidator::validate(const uint8_t* data, size_t size) {
+    const auto* end = data + size;
+    switch (isa) {
+#ifdef JSON_VALIDATOR_X86
+    case Isa::AVX2:
+        return ::validate<Avx2Scanner>(data, end, stack);
+    case Isa::SSE2:
+        return ::validate<Sse2Scanner>(data, end, stack);
+#else
+    case Isa::AVX2:
+    case Isa::SSE2:
+#endif
+    case Isa::Scalar:
+        return ::validate<ScalarScanner>(data, end, stack);
+    }
+    throw std::logic_error("JsonValidator::validate: invalid isa");
+}
+
+std::string to_string(JsonValidator::Isa isa) {
+    switch (isa) {
+    case JsonValidator::Isa::Scalar:
+        return "Scalar";
+    case JsonValidator::Isa::SSE2:
+        return "SSE2";
+    case JsonValidator::Isa::AVX2:
+        return "AVX2";
+    }
+    return "Invalid JsonValidator::Isa: " + std::to_string(int(isa));
+}
@@ -0,0 +1,84 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Validator used to detect if a document is JSON (to set the JSON datatype
+ * on the mutation path).
+ *
+ * Accepts the same documents as JSON_checker::Validator (any JSON value,
+ * optionally surrounded by whitespace, encoded as valid UTF-8) but is
+ * considerably faster on typical documents: the bulk of a JSON document is
+ * normally string content, which is scanned a vector register at a time for
+ * the characters which need further inspection (quote, backslash, control
+ * characters and non-ASCII bytes). The widest instruction set supported by
+ * the CPU is selected at runtime; on non-x86 platforms a scalar
+ * implementation is used.
+ *
+ * An instance keeps its scratch space between calls, so it should be
+ * re-used (it is not thread safe; one instance per front-end thread).
+ */
+class JsonValidator {
+public:
+    /// The instruction sets the string scanner is implemented for.
+    enum class Isa { Scalar, SSE2, AVX2 };
+
+    /// Create a validator using the best instruction set available.
+    JsonValidator();
+
+    /**
+     * Create a validator using the given instruction set (or the best
+     * available if the requested one is not supported by this CPU).
+     */
+    explicit JsonValidator(Isa isa);
+
+    /**
+     * Check if the provided data is a valid JSON document
+     *
+     * @param data the data to validate
+     * @param size the number of bytes in data
+     * @return true if data contains valid JSON
+     */
+    bool validate(const uint8_t* data, size_t size);
+
+    bool validate(const std::string& data) {
+        return validate(reinterpret_cast<const uint8_t*>(data.data()),
+                        data.size());
+    }
+
+    /// @return the instruction set this instance uses.
+    Isa getIsa() const {
+        return isa;
+    }
+
+    /// @return the best instruction set supported by this CPU.
+    static Isa getBestIsa();
+
+private:
+    const Isa isa;
+
+    /// The open containers ('{' or '[') at the current parse position.
+    std::vector<uint8_t> stack;
+};
+
+std::string to_string(JsonValidator::Isa isa);
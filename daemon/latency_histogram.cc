@@ -0,0 +1,136 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include "latency_histogram.h"
+
+#include <stdexcept>
+#include <string>
+
+static struct hdr_histogram* createHistogram(int significantFigures) {
+    if (significantFigures < 1 || significantFigures > 5) {
+        throw std::invalid_argument(
+                "LatencyHistogram: significantFigures must be between 1 "
+                "and 5");
+    }
+    struct hdr_histogram* ret = nullptr;
+    if (hdr_init(1, LatencyHistogram::MaxValue, significantFigures, &ret) !=
+        0) {
+        throw std::bad_alloc();
+    }
+    return ret;
+}
+
+LatencyHistogram::LatencyHistogram(int significantFigures)
+    : significantFigures(significantFigures),
+      histogram(createHistogram(significantFigures)) {
+}
+
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& other)
+    : LatencyHistogram(other.significantFigures) {
+    *this += other;
+}
+
+/**
+ * As with TimingHistogram this may miss samples which are added while we
+ * copy, but it's only used when grabbing the stats.
+ */
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& other) {
+    if (this != &other) {
+        std::lock(mutex, other.mutex);
+        std::lock_guard<std::mutex> guard(mutex, std::adopt_lock);
+        std::lock_guard<std::mutex> otherGuard(other.mutex, std::adopt_lock);
+        hdr_reset(histogram.get());
+        hdr_add(histogram.get(), other.histogram.get());
+    }
+    return *this;
+}
+
+LatencyHistogram& LatencyHistogram::operator+=(const LatencyHistogram& other) {
+    if (this == &other) {
+        const LatencyHistogram copy(other);
+        return *this += copy;
+    }
+    std::lock(mutex, other.mutex);
+    std::lock_guard<std::mutex> guard(mutex, std::adopt_lock);
+    std::lock_guard<std::mutex> otherGuard(other.mutex, std::adopt_lock);
+    hdr_add(histogram.get(), other.histogram.get());
+    return *this;
+}
+
+void LatencyHistogram::reset() {
+    std::lock_guard<std::mutex> guard(mutex);
+    hdr_reset(histogram.get());
+}
+
+void LatencyHistogram::add(const std::chrono::nanoseconds nsec) {
+    using namespace std::chrono;
+    auto us = int64_t(duration_cast<microseconds>(nsec).count());
+    if (us < 0) {
+        us = 0;
+    } else if (us > MaxValue) {
+        us = MaxValue;
+    }
+    std::lock_guard<std::mutex> guard(mutex);
+    hdr_record_value(histogram.get(), us);
+}
+
+uint64_t LatencyHistogram::getTotal() const {
+    std::lock_guard<std::mutex> guard(mutex);
+    return uint64_t(histogram->total_count);
+}
+
+uint64_t LatencyHistogram::getValueAtPercentile(double percentile) const {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (histogram->total_count == 0) {
+        return 0;
+    }
+    return uint64_t(hdr_value_at_percentile(histogram.get(), percentile));
+}
+
+void LatencyHistogram::addToJson(cJSON* root) const {
+    static const std::pair<const char*, double> percentiles[] = {
+            {"50", 50.0},
+            {"90", 90.0},
+            {"99", 99.0},
+            {"99.9", 99.9},
+            {"99.99", 99.99},
+            {"100", 100.0}};
+
+    cJSON* obj = cJSON_CreateObject();
+    for (const auto& p : percentiles) {
+        cJSON_AddNumberToObject(
+                obj, p.first, double(getValueAtPercentile(p.second)));
+    }
+    cJSON_AddItemToObject(root, "percentiles", obj);
+
+    cJSON* array = cJSON_CreateArray();
+    std::lock_guard<std::mutex> guard(mutex);
+    struct hdr_iter iter;
+    hdr_iter_recorded_init(&iter, histogram.get());
+    while (hdr_iter_next(&iter)) {
+        const auto lowest =
+                hdr_lowest_equivalent_value(histogram.get(), iter.value);
+        const auto highest =
+                hdr_next_non_equivalent_value(histogram.get(), iter.value) -
+                1;
+        cJSON* bucket = cJSON_CreateArray();
+        cJSON_AddItemToArray(bucket, cJSON_CreateNumber(double(lowest)));
+        cJSON_AddItemToArray(bucket, cJSON_CreateNumber(double(highest)));
+        cJSON_AddItemToArray(bucket, cJSON_CreateNumber(double(iter.count)));
+        cJSON_AddItemToArray(array, bucket);
+    }
+    cJSON_AddItemToObject(root, "log_linear", array);
+}
@@ -0,0 +1,109 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#pragma once
+
+#include <cJSON.h>
+#include <hdr_histogram.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+/**
+ * Records timings (in microseconds) in an HdrHistogram, so that the
+ * relative error of the reported values is the same for all of the
+ * recorded values.
+ *
+ * The precision is given as the number of significant (decimal) figures
+ * the histogram should keep. With the default of 1 every power of two
+ * range is split into 16 buckets, which gives a relative error below
+ * 6.25%. Every extra figure costs ~10x the memory.
+ *
+ * Values above MaxValue (one hour) are recorded as MaxValue.
+ *
+ * hdr_record_value() isn't thread safe, so the histogram is protected by
+ * a mutex. Timings keeps one histogram per opcode and shard to make sure
+ * that the mutex is (mostly) uncontended.
+ */
+class LatencyHistogram {
+public:
+    static const int DefaultSignificantFigures = 1;
+    static const int64_t MaxValue = int64_t(3600) * 1000 * 1000;
+
+    /**
+     * Create a new histogram
+     *
+     * @param significantFigures the precision to keep (between 1 and 5)
+     * @throws std::invalid_argument if significantFigures is out of range
+     */
+    explicit LatencyHistogram(
+            int significantFigures = DefaultSignificantFigures);
+    LatencyHistogram(const LatencyHistogram& other);
+    LatencyHistogram& operator=(const LatencyHistogram& other);
+
+    /**
+     * Add the samples from the other histogram to this histogram. The
+     * histograms may use a different precision.
+     */
+    LatencyHistogram& operator+=(const LatencyHistogram& other);
+
+    void reset();
+
+    void add(const std::chrono::nanoseconds nsec);
+
+    /// Get the total number of samples in the histogram
+    uint64_t getTotal() const;
+
+    int getSignificantFigures() const {
+        return significantFigures;
+    }
+
+    /**
+     * Get the value (in microseconds) which the given percentage of the
+     * samples are less than or equal to.
+     *
+     * @param percentile the requested percentile (0 - 100)
+     * @return the value or 0 if the histogram is empty
+     */
+    uint64_t getValueAtPercentile(double percentile) const;
+
+    /**
+     * Add the histogram to the provided JSON object:
+     *
+     *     "percentiles" : { "50" : 10, "90": 30, "99" : 410, ... }
+     *     "log_linear" : [ [lowest, highest, count], ... ]
+     *
+     * All values are in microseconds, and only the buckets containing
+     * samples are listed in "log_linear".
+     */
+    void addToJson(cJSON* root) const;
+
+protected:
+    struct HdrDeleter {
+        void operator()(struct hdr_histogram* val) {
+            free(val);
+        }
+    };
+
+    using HdrHistogramUniquePtr =
+            std::unique_ptr<struct hdr_histogram, HdrDeleter>;
+
+    const int significantFigures;
+    mutable std::mutex mutex;
+    HdrHistogramUniquePtr histogram;
+};
@@ -241,6 +241,7 @@ void mc_time_clock_tick(void) {
 
     // check on tasks to be made runnable in the future
     executorPool->clockTick();
+    saslExecutorPool->clockTick();
 }
 
 static void mc_gather_timing_samples(void) {
@@ -248,4 +249,6 @@ static void mc_gather_timing_samples(void) {
         bucket.timings.sample(std::chrono::seconds(1));
         return true;
     }, nullptr);
+
+    threads_sample_load();
 }
@@ -22,9 +22,10 @@
 #include "debug_helpers.h"
 #include "runtime.h"
 
+#include <memcached/audit_event_writer.h>
 #include <memcached/audit_interface.h>
-#include <cJSON.h>
 #include <memcached/isotime.h>
+#include <cstring>
 
 static std::atomic_bool audit_enabled{false};
 
@@ -49,6 +50,26 @@ static bool isEnabled(uint32_t id) {
     return true;
 }
 
+/// The source of the real_userid in memcached's audit events
+static const char memcachedSource[] = "memcached";
+
+/**
+ * Check if the event is enabled and not filtered out for the user of the
+ * connection. This is checked before building the payload, so that
+ * auditing some of the users doesn't cost anything for the others.
+ */
+static bool isEnabled(uint32_t id, const Connection& c) {
+    if (!isEnabled(id)) {
+        return false;
+    }
+    const char* user = c.getUsername();
+    return !cb::audit::is_event_filtered(
+            get_audit_handle(),
+            id,
+            {memcachedSource, sizeof(memcachedSource) - 1},
+            {user, std::strlen(user)});
+}
+
 void setEnabled(uint32_t id, bool enable) {
     bool expected = !enable;
 
@@ -75,27 +96,29 @@ void setEnabled(uint32_t id, bool enable) {
  * timestamp, the socket endpoints and the creds. Then each audit event
  * may add event-specific content.
  *
+ * The event is serialised directly into a thread local buffer (which
+ * is reused for all of the events created by the thread) instead of
+ * building a cJSON tree for it.
+ *
  * @param c the connection object
- * @return the cJSON object containing the basic information
+ * @return the writer to add the event-specific content to
  */
-static unique_cJSON_ptr create_memcached_audit_object(const Connection *c) {
-    cJSON *root = cJSON_CreateObject();
-
-    std::string timestamp = ISOTime::generatetimestamp();
-    cJSON_AddStringToObject(root, "timestamp", timestamp.c_str());
-
-    cJSON_AddStringToObject(root, "peername", c->getPeername().c_str());
-    cJSON_AddStringToObject(root, "sockname", c->getSockname().c_str());
-    cJSON *source = cJSON_CreateObject();
-    cJSON_AddStringToObject(source, "source", "memcached");
-    cJSON_AddStringToObject(source, "user", c->getUsername());
-    cJSON_AddItemToObject(root, "real_userid", source);
-
-    return unique_cJSON_ptr(root);
+static cb::audit::EventWriter create_memcached_audit_object(
+        const Connection* c) {
+    static thread_local std::string buffer;
+    cb::audit::EventWriter writer(buffer);
+    writer.add("timestamp", ISOTime::generatetimestamp());
+    writer.add("peername", c->getPeername());
+    writer.add("sockname", c->getSockname());
+    writer.beginObject("real_userid")
+            .add("source", memcachedSource)
+            .add("user", c->getUsername())
+            .endObject();
+    return writer;
 }
 
 /**
- * Convert the JSON object to text and send it to the audit framework
+ * Terminate the event and send it to the audit framework
  *
  * @param c the connection object requesting the call
  * @param id the audit identifier
@@ -104,30 +127,30 @@ static unique_cJSON_ptr create_memcached_audit_object(const Connection *c) {
  */
 static void do_audit(const Connection* c,
                      uint32_t id,
-                     unique_cJSON_ptr& event,
+                     cb::audit::EventWriter& event,
                      const char* warn) {
-    auto text = to_string(event, false);
+    const auto text = event.finish();
     auto status = put_audit_event(get_audit_handle(), id, text.data(),
-                                  text.length());
+                                  text.size());
 
     if (status != AUDIT_SUCCESS) {
-        LOG_WARNING("{}: {}", warn, text);
+        LOG_WARNING("{}: {}", warn, std::string(text.data(), text.size()));
     }
 }
 
 void audit_auth_failure(const Connection *c, const char *reason) {
-    if (!isEnabled(MEMCACHED_AUDIT_AUTHENTICATION_FAILED)) {
+    if (!isEnabled(MEMCACHED_AUDIT_AUTHENTICATION_FAILED, *c)) {
         return;
     }
     auto root = create_memcached_audit_object(c);
-    cJSON_AddStringToObject(root.get(), "reason", reason);
+    root.add("reason", reason);
 
     do_audit(c, MEMCACHED_AUDIT_AUTHENTICATION_FAILED, root,
              "Failed to send AUTH FAILED audit event");
 }
 
 void audit_auth_success(const Connection *c) {
-    if (!isEnabled(MEMCACHED_AUDIT_AUTHENTICATION_SUCCEEDED)) {
+    if (!isEnabled(MEMCACHED_AUDIT_AUTHENTICATION_SUCCEEDED, *c)) {
         return;
     }
     auto root = create_memcached_audit_object(c);
@@ -137,11 +160,11 @@ void audit_auth_success(const Connection *c) {
 
 
 void audit_bucket_flush(const Connection *c, const char *bucket) {
-    if (!isEnabled(MEMCACHED_AUDIT_BUCKET_FLUSH)) {
+    if (!isEnabled(MEMCACHED_AUDIT_BUCKET_FLUSH, *c)) {
         return;
     }
     auto root = create_memcached_audit_object(c);
-    cJSON_AddStringToObject(root.get(), "bucket", bucket);
+    root.add("bucket", bucket);
 
     do_audit(c, MEMCACHED_AUDIT_BUCKET_FLUSH, root,
              "Failed to send BUCKET_FLUSH audit event");
@@ -149,14 +172,14 @@ void audit_bucket_flush(const Connection *c, const char *bucket) {
 
 
 void audit_dcp_open(const Connection *c) {
-    if (!isEnabled(MEMCACHED_AUDIT_OPENED_DCP_CONNECTION)) {
+    if (!isEnabled(MEMCACHED_AUDIT_OPENED_DCP_CONNECTION, *c)) {
         return;
     }
     if (c->isInternal()) {
         LOG_INFO("Open DCP stream with admin credentials");
     } else {
         auto root = create_memcached_audit_object(c);
-        cJSON_AddStringToObject(root.get(), "bucket", getBucketName(c));
+        root.add("bucket", getBucketName(c));
 
         do_audit(c, MEMCACHED_AUDIT_OPENED_DCP_CONNECTION, root,
                  "Failed to send DCP open connection "
@@ -165,11 +188,11 @@ void audit_dcp_open(const Connection *c) {
 }
 
 void audit_set_privilege_debug_mode(const Connection* c, bool enable) {
-    if (!isEnabled(MEMCACHED_AUDIT_PRIVILEGE_DEBUG_CONFIGURED)) {
+    if (!isEnabled(MEMCACHED_AUDIT_PRIVILEGE_DEBUG_CONFIGURED, *c)) {
         return;
     }
     auto root = create_memcached_audit_object(c);
-    cJSON_AddBoolToObject(root.get(), "enable", enable);
+    root.add("enable", enable);
     do_audit(c, MEMCACHED_AUDIT_PRIVILEGE_DEBUG_CONFIGURED, root,
              "Failed to send modifications in privilege debug state "
              "audit event to audit daemon");
@@ -180,24 +203,24 @@ void audit_privilege_debug(const Connection* c,
                            const std::string& bucket,
                            const std::string& privilege,
                            const std::string& context) {
-    if (!isEnabled(MEMCACHED_AUDIT_PRIVILEGE_DEBUG)) {
+    if (!isEnabled(MEMCACHED_AUDIT_PRIVILEGE_DEBUG, *c)) {
         return;
     }
     auto root = create_memcached_audit_object(c);
-    cJSON_AddStringToObject(root.get(), "command", command.c_str());
-    cJSON_AddStringToObject(root.get(), "bucket", bucket.c_str());
-    cJSON_AddStringToObject(root.get(), "privilege", privilege.c_str());
-    cJSON_AddStringToObject(root.get(), "context", context.c_str());
+    root.add("command", command);
+    root.add("bucket", bucket);
+    root.add("privilege", privilege);
+    root.add("context", context);
 
     do_audit(c, MEMCACHED_AUDIT_PRIVILEGE_DEBUG, root,
              "Failed to send privilege debug audit event to audit daemon");
 }
 
 void audit_command_access_failed(const Cookie& cookie) {
-    if (!isEnabled(MEMCACHED_AUDIT_COMMAND_ACCESS_FAILURE)) {
+    const auto& connection = cookie.getConnection();
+    if (!isEnabled(MEMCACHED_AUDIT_COMMAND_ACCESS_FAILURE, connection)) {
         return;
     }
-    const auto& connection = cookie.getConnection();
     auto root = create_memcached_audit_object(&connection);
     char buffer[256];
     memset(buffer, 0, sizeof(buffer));
@@ -211,15 +234,15 @@ void audit_command_access_failed(const Cookie& cookie) {
                            "Access to command is not allowed:",
                            reinterpret_cast<const char*>(packet.data()),
                            packet.size());
-    cJSON_AddStringToObject(root.get(), "packet", buffer);
+    root.add("packet", buffer);
     do_audit(&connection, MEMCACHED_AUDIT_COMMAND_ACCESS_FAILURE, root, buffer);
 }
 
 void audit_invalid_packet(const Cookie& cookie) {
-    if (!isEnabled(MEMCACHED_AUDIT_INVALID_PACKET)) {
+    const auto& connection = cookie.getConnection();
+    if (!isEnabled(MEMCACHED_AUDIT_INVALID_PACKET, connection)) {
         return;
     }
-    const auto& connection = cookie.getConnection();
     auto root = create_memcached_audit_object(&connection);
     char buffer[256];
     memset(buffer, 0, sizeof(buffer));
@@ -233,7 +256,7 @@ void audit_invalid_packet(const Cookie& cookie) {
                            "Invalid Packet:",
                            reinterpret_cast<const char*>(packet.data()),
                            packet.size());
-    cJSON_AddStringToObject(root.get(), "packet", buffer);
+    root.add("packet", buffer);
     do_audit(&connection, MEMCACHED_AUDIT_INVALID_PACKET, root, buffer);
 }
 
@@ -274,15 +297,14 @@ void add(const Cookie& cookie, Operation operation) {
             "cb::audit::document::add: Invalid operation");
     }
 
-    if (!isEnabled(id)) {
+    const auto& connection = cookie.getConnection();
+    if (!isEnabled(id, connection)) {
         return;
     }
 
-    const auto& connection = cookie.getConnection();
     auto root = create_memcached_audit_object(&connection);
-    cJSON_AddStringToObject(root.get(), "bucket", connection.getBucket().name);
-    cJSON_AddStringToObject(
-            root.get(), "key", cookie.getPrintableRequestKey().c_str());
+    root.add("bucket", connection.getBucket().name);
+    root.add("key", cookie.getPrintableRequestKey());
 
     switch (operation) {
     case Operation::Read:
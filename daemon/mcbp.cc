@@ -239,6 +239,8 @@ void mcbp_collect_timings(Cookie& cookie) {
         all_buckets[bucketid].timings.collect(opcode, elapsed_ns);
     }
 
+    cookie.maybeAddToTraceLog(elapsed_ns);
+
     // Log operations taking longer than 0.5s
     const auto elapsed_ms =
             std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_ns);
@@ -738,6 +738,8 @@ static void execute_request_packet(Cookie& cookie,
             return;
         }
 
+        // Everything up to here is the frontend parsing of the command
+        cookie.getTracer().end(cb::tracing::TraceCode::PARSE);
         handlers[opcode](cookie);
         return;
     case cb::rbac::PrivilegeAccess::Stale:
@@ -41,6 +41,7 @@
 #include "runtime.h"
 #include "session_cas.h"
 #include "settings.h"
+#include "ssl_session_cache.h"
 #include "stats.h"
 #include "subdocument.h"
 #include "timings.h"
@@ -127,6 +128,7 @@ std::atomic<bool> service_online;
 static std::atomic<bool> enable_common_ports;
 
 std::unique_ptr<ExecutorPool> executorPool;
+std::unique_ptr<ExecutorPool> saslExecutorPool;
 
 /* Mutex for global stats */
 std::mutex stats_mutex;
@@ -398,6 +400,8 @@ static void stats_init(void) {
     stats.total_conns.reset();
     stats.daemon_conns.reset();
     stats.rejected_conns.reset();
+    stats.ssl_handshakes_full.reset();
+    stats.ssl_handshakes_resumed.reset();
     stats.curr_conns.store(0, std::memory_order_relaxed);
 }
 
@@ -414,6 +418,8 @@ void stats_reset(Cookie& cookie) {
     }
     stats.total_conns.reset();
     stats.rejected_conns.reset();
+    stats.ssl_handshakes_full.reset();
+    stats.ssl_handshakes_resumed.reset();
     threadlocal_stats_reset(cookie.getConnection().getBucket().stats);
     bucket_reset_stats(cookie);
 }
@@ -452,6 +458,13 @@ static void ssl_cipher_list_changed_listener(const std::string&, Settings &s) {
     set_ssl_cipher_list(s.getSslCipherList());
 }
 
+static void ssl_session_changed_listener(const std::string&, Settings& s) {
+    auto& cache = SslSessionCache::getInstance();
+    cache.setCacheSize(s.getSslSessionCacheSize());
+    cache.setTimeout(std::chrono::seconds(s.getSslSessionTimeout()));
+    cache.setTicketsEnabled(s.isSslSessionTicketsEnabled());
+}
+
 static void verbosity_changed_listener(const std::string&, Settings &s) {
     auto logger = cb::logger::get();
     if (logger) {
@@ -534,6 +547,12 @@ static void settings_init(void) {
                                ssl_minimum_protocol_changed_listener);
     settings.addChangeListener("ssl_cipher_list",
                                ssl_cipher_list_changed_listener);
+    settings.addChangeListener("ssl_session_cache_size",
+                               ssl_session_changed_listener);
+    settings.addChangeListener("ssl_session_timeout",
+                               ssl_session_changed_listener);
+    settings.addChangeListener("ssl_session_tickets",
+                               ssl_session_changed_listener);
     settings.addChangeListener("verbosity", verbosity_changed_listener);
     settings.addChangeListener("interfaces", interfaces_changed_listener);
     settings.addChangeListener("saslauthd_socketpath",
@@ -672,12 +691,12 @@ uint64_t get_listen_disabled_num(void) {
 
 static void disable_listen(void) {
     Connection *next;
-    {
-        std::lock_guard<std::mutex> guard(listen_state.mutex);
-        listen_state.disabled = true;
-        listen_state.count = 10;
-        ++listen_state.num_disable;
-    }
+    // Worker threads accepting clients on their own sockets may call
+    // this concurrently, so keep the lock while updating the sockets
+    std::lock_guard<std::mutex> guard(listen_state.mutex);
+    listen_state.disabled = true;
+    listen_state.count = 10;
+    ++listen_state.num_disable;
 
     for (next = listen_conn; next; next = next->getNext()) {
         auto* connection = dynamic_cast<ListenConnection*>(next);
@@ -783,6 +802,15 @@ static void end_trace(gsl::not_null<const void*> void_cookie,
             reinterpret_cast<Cookie*>(const_cast<void*>(void_cookie.get()));
     cookie->getTracer().end(tracecode);
 }
+
+static void add_trace(gsl::not_null<const void*> void_cookie,
+                      cb::tracing::TraceCode tracecode,
+                      ProcessClock::time_point start,
+                      ProcessClock::time_point end) {
+    auto* cookie =
+            reinterpret_cast<Cookie*>(const_cast<void*>(void_cookie.get()));
+    cookie->getTracer().record(tracecode, start, end);
+}
 // End -  Tracing api
 
 static ENGINE_ERROR_CODE pre_link_document(
@@ -899,7 +927,9 @@ bool conn_listening(ListenConnection *c)
         port_conns = ++port_instance->curr_conns;
     }
 
-    if (curr_conns >= settings.getMaxconns() || port_conns >= port_instance->maxconns) {
+    // port_conns includes the new client (but not the listen connections)
+    if (curr_conns >= settings.getMaxconns() ||
+        port_conns > port_instance->maxconns) {
         {
             std::lock_guard<std::mutex> guard(stats_mutex);
             --port_instance->curr_conns;
@@ -928,7 +958,12 @@ bool conn_listening(ListenConnection *c)
         return false;
     }
 
-    dispatch_conn_new(sfd, c->getParentPort());
+    auto* worker = c->getWorkerThread();
+    if (worker == nullptr) {
+        dispatch_conn_new(sfd, c->getParentPort());
+    } else {
+        dispatch_conn_local(sfd, c->getParentPort(), *worker);
+    }
 
     return false;
 }
@@ -1049,6 +1084,12 @@ void listen_event_handler(evutil_socket_t, short which, void *arg) {
     }
 
     if (memcached_shutdown) {
+        if (c->getWorkerThread() != nullptr) {
+            // The worker thread is stopped once its clients are gone;
+            // just stop accepting new ones.
+            c->disable();
+            return;
+        }
         // Someone requested memcached to shut down. The listen thread should
         // be stopped immediately.
         LOG_INFO("Stopping listen thread");
@@ -1070,16 +1111,10 @@ static void dispatch_event_handler(evutil_socket_t fd, short, void *) {
     }
 
     if (nr != -1 && is_listen_disabled()) {
-        bool enable = false;
-        {
-            std::lock_guard<std::mutex> guard(listen_state.mutex);
-            listen_state.count -= nr;
-            if (listen_state.count <= 0) {
-                enable = true;
-                listen_state.disabled = false;
-            }
-        }
-        if (enable) {
+        std::lock_guard<std::mutex> guard(listen_state.mutex);
+        listen_state.count -= nr;
+        if (listen_state.disabled && listen_state.count <= 0) {
+            listen_state.disabled = false;
             Connection *next;
             for (next = listen_conn; next; next = next->getNext()) {
                 auto* connection = dynamic_cast<ListenConnection*>(next);
@@ -1137,7 +1172,17 @@ static void maximize_sndbuf(const SOCKET sfd) {
     LOG_DEBUG("<{} send buffer was {}, now {}", sfd, old_size, last_good);
 }
 
-static SOCKET new_server_socket(struct addrinfo *ai, bool tcp_nodelay) {
+/**
+ * Create a new server socket
+ *
+ * @param ai the address to create the socket for
+ * @param tcp_nodelay should TCP_NODELAY be set on the socket
+ * @param reuseport [in/out] should SO_REUSEPORT be set on the socket;
+ *                  cleared if it isn't supported
+ */
+static SOCKET new_server_socket(struct addrinfo* ai,
+                                bool tcp_nodelay,
+                                bool& reuseport) {
     SOCKET sfd;
 
     sfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
@@ -1177,6 +1222,20 @@ static SOCKET new_server_socket(struct addrinfo *ai, bool tcp_nodelay) {
 #endif
 
     setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, flags_ptr, sizeof(flags));
+    if (reuseport) {
+#ifdef SO_REUSEPORT
+        error = setsockopt(sfd, SOL_SOCKET, SO_REUSEPORT, flags_ptr,
+                           sizeof(flags));
+        if (error != 0) {
+            LOG_WARNING("setsockopt(SO_REUSEPORT): {}", strerror(errno));
+            reuseport = false;
+        }
+#else
+        LOG_WARNING("SO_REUSEPORT is not supported on this platform");
+        reuseport = false;
+#endif
+    }
+
     error = setsockopt(sfd, SOL_SOCKET, SO_KEEPALIVE, flags_ptr,
                        sizeof(flags));
     if (error != 0) {
@@ -1211,7 +1270,10 @@ static SOCKET new_server_socket(struct addrinfo *ai, bool tcp_nodelay) {
  * @param port the port number in use
  * @param family the address family for the port
  */
-static void add_listening_port(const NetworkInterface *interf, in_port_t port, sa_family_t family) {
+static void add_listening_port(const NetworkInterface *interf,
+                               in_port_t port,
+                               sa_family_t family,
+                               bool reuseport) {
     std::lock_guard<std::mutex> guard(stats_mutex);
     auto *descr = get_listening_port_instance(port);
 
@@ -1222,8 +1284,8 @@ static void add_listening_port(const NetworkInterface *interf, in_port_t port, s
                               interf->backlog,
                               interf->management);
 
-        newport.curr_conns = 1;
         newport.maxconns = interf->maxconn;
+        newport.reuseport = reuseport;
 
         if (interf->ssl.key.empty() || interf->ssl.cert.empty()) {
             newport.ssl.enabled = false;
@@ -1248,7 +1310,87 @@ static void add_listening_port(const NetworkInterface *interf, in_port_t port, s
         } else if (family == AF_INET6) {
             descr->ipv6 = true;
         }
-        ++descr->curr_conns;
+    }
+}
+
+/**
+ * Create the listen connection for a bound server socket
+ *
+ * @param sfd the server socket
+ * @param port the port number the socket is bound to
+ * @param family the address family of the socket
+ * @param interf the interface description used to create the socket
+ * @param worker the worker thread accepting clients on the socket, or
+ *               nullptr for the dispatcher thread
+ */
+static void add_listen_connection(SOCKET sfd,
+                                  in_port_t port,
+                                  sa_family_t family,
+                                  const NetworkInterface& interf,
+                                  LIBEVENT_THREAD* worker) {
+    auto* lconn = conn_new_server(sfd, port, family, interf,
+                                  worker ? worker->base : main_base);
+    if (lconn == nullptr) {
+        FATAL_ERROR(EXIT_FAILURE, "Failed to create listening connection");
+    }
+    lconn->setWorkerThread(worker);
+
+    {
+        // Worker threads may be walking the list to disable accepting
+        std::lock_guard<std::mutex> guard(listen_state.mutex);
+        lconn->setNext(listen_conn);
+        listen_conn = lconn;
+    }
+
+    stats.daemon_conns++;
+    stats.curr_conns.fetch_add(1, std::memory_order_relaxed);
+    add_listening_port(&interf, port, family, worker != nullptr);
+}
+
+/**
+ * Give each worker thread its own socket to accept clients on, bound to
+ * the same address with SO_REUSEPORT (so that the kernel spreads the
+ * clients over the sockets).
+ *
+ * @param sfd the first (bound) socket, which is given to the first
+ *            worker thread
+ * @param ai the address the socket is bound to
+ * @param port the port number the socket is bound to (which may have
+ *             been picked by the operating system)
+ * @param interf the interface description used to create the socket
+ */
+static void add_worker_listen_connections(SOCKET sfd,
+                                          struct addrinfo* ai,
+                                          in_port_t port,
+                                          const NetworkInterface& interf) {
+    struct sockaddr_storage addr;
+    memcpy(&addr, ai->ai_addr, ai->ai_addrlen);
+    if (ai->ai_family == AF_INET) {
+        reinterpret_cast<struct sockaddr_in*>(&addr)->sin_port = htons(port);
+    } else if (ai->ai_family == AF_INET6) {
+        reinterpret_cast<struct sockaddr_in6*>(&addr)->sin6_port =
+                htons(port);
+    }
+
+    add_listen_connection(sfd, port, ai->ai_family, interf,
+                          &get_worker_thread(0));
+
+    for (int ii = 1; ii < settings.getNumWorkerThreads(); ++ii) {
+        bool reuseport = true;
+        sfd = new_server_socket(ai, interf.tcp_nodelay, reuseport);
+        if (sfd == INVALID_SOCKET || !reuseport ||
+            bind(sfd,
+                 reinterpret_cast<struct sockaddr*>(&addr),
+                 (socklen_t)ai->ai_addrlen) == SOCKET_ERROR) {
+            // The threads which already got a socket serve the port
+            log_socket_error(EXTENSION_LOG_WARNING,
+                             nullptr,
+                             "Failed to create SO_REUSEPORT socket: %s");
+            safe_close(sfd);
+            return;
+        }
+        add_listen_connection(sfd, port, ai->ai_family, interf,
+                              &get_worker_thread(ii));
     }
 }
 
@@ -1299,7 +1441,9 @@ static int server_socket(const NetworkInterface *interf) {
     }
 
     for (struct addrinfo* next = ai; next; next = next->ai_next) {
-        if ((sfd = new_server_socket(next, interf->tcp_nodelay)) == INVALID_SOCKET) {
+        bool reuseport = interf->reuseport;
+        if ((sfd = new_server_socket(next, interf->tcp_nodelay, reuseport)) ==
+            INVALID_SOCKET) {
             /* getaddrinfo can return "junk" addresses,
              * we make sure at least one works before erroring.
              */
@@ -1337,18 +1481,12 @@ static int server_socket(const NetworkInterface *interf) {
             }
         }
 
-        auto* lconn = conn_new_server(sfd, listenport, next->ai_addr->sa_family,
-                                      *interf, main_base);
-        if (lconn == nullptr) {
-            FATAL_ERROR(EXIT_FAILURE, "Failed to create listening connection");
+        if (reuseport) {
+            add_worker_listen_connections(sfd, next, listenport, *interf);
+        } else {
+            add_listen_connection(sfd, listenport, next->ai_addr->sa_family,
+                                  *interf, nullptr);
         }
-
-        lconn->setNext(listen_conn);
-        listen_conn = lconn;
-
-        stats.daemon_conns++;
-        stats.curr_conns.fetch_add(1, std::memory_order_relaxed);
-        add_listening_port(interf, listenport, next->ai_addr->sa_family);
     }
 
     freeaddrinfo(ai);
@@ -1414,6 +1552,11 @@ static void create_listen_sockets(bool management) {
                                            " illegal objects: " +
                                        to_string(c->toJSON(), false));
             }
+            auto* worker = lc->getWorkerThread();
+            if (worker != nullptr && worker->index != 0) {
+                // Same port as the socket owned by the first worker
+                continue;
+            }
             cJSON_AddItemToArray(array.get(), lc->getDetails().release());
         }
 
@@ -1764,12 +1907,22 @@ SERVER_HANDLE_V1* get_server_api() {
         hooks_api.release_free_memory = AllocHooks::release_free_memory;
         hooks_api.enable_thread_cache = AllocHooks::enable_thread_cache;
         hooks_api.get_allocator_property = AllocHooks::get_allocator_property;
+        hooks_api.create_arena = AllocHooks::create_arena;
+        hooks_api.destroy_arena = AllocHooks::destroy_arena;
+        hooks_api.arena_malloc = AllocHooks::arena_malloc;
+        hooks_api.arena_free = AllocHooks::arena_free;
+        hooks_api.get_arena_stats = AllocHooks::get_arena_stats;
+        hooks_api.get_allocation_utilization =
+                AllocHooks::get_allocation_utilization;
+        hooks_api.is_allocation_utilization_supported =
+                AllocHooks::is_allocation_utilization_supported;
 
         document_api.pre_link = pre_link_document;
         document_api.pre_expiry = document_pre_expiry;
 
         tracing_api.begin_trace = begin_trace;
         tracing_api.end_trace = end_trace;
+        tracing_api.add_trace = add_trace;
 
         rv.interface = 1;
         rv.core = &core_api;
@@ -2539,6 +2692,8 @@ extern "C" int memcached_main(int argc, char **argv) {
     thread_init(settings.getNumWorkerThreads(), main_base, dispatch_event_handler);
 
     executorPool.reset(new ExecutorPool(size_t(settings.getNumWorkerThreads())));
+    saslExecutorPool.reset(
+            new ExecutorPool(size_t(settings.getNumWorkerThreads())));
 
     initializeTracing();
     TRACE_GLOBAL0("memcached", "Started");
@@ -2595,11 +2750,20 @@ extern "C" int memcached_main(int argc, char **argv) {
     logger->info("Shutting down RBAC subsystem");
     cb::rbac::destroy();
 
+    logger->info("Releasing listen sockets");
+    for (auto* c = listen_conn; c != nullptr; c = c->getNext()) {
+        auto* lc = dynamic_cast<ListenConnection*>(c);
+        if (lc != nullptr) {
+            lc->releaseEvent();
+        }
+    }
+
     logger->info("Releasing thread resources");
     threads_cleanup();
 
     logger->info("Shutting down executor pool");
     executorPool.reset();
+    saslExecutorPool.reset();
 
     logger->info("Releasing signal handlers");
     release_signal_handlers();
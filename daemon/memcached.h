@@ -2,6 +2,7 @@
 #ifndef MEMCACHED_H
 #define MEMCACHED_H
 
+#include <atomic>
 #include <functional>
 #include <mutex>
 #include <vector>
@@ -22,10 +23,10 @@
 #include <memcached/engine.h>
 #include <memcached/engine_error.h>
 #include <memcached/extension.h>
-#include <JSON_checker.h>
 
 #include "dynamic_buffer.h"
 #include "executorpool.h"
+#include "json_validator.h"
 #include "log_macros.h"
 #include "settings.h"
 #include "timing_histogram.h"
@@ -70,6 +71,7 @@ enum class ThreadType {
 };
 
 class Connection;
+class McbpConnection;
 struct ConnectionQueueItem;
 
 /**
@@ -160,7 +162,45 @@ struct LIBEVENT_THREAD {
      * Shared validator used by all connections serviced by this thread
      * when they need to validate a JSON document
      */
-    JSON_checker::Validator validator;
+    JsonValidator validator;
+
+    /**
+     * The load of this thread, used by the dispatcher to pick the thread
+     * to serve a new connection and to decide if idle connections should
+     * be moved to another thread. The counters are updated without
+     * holding the thread lock.
+     */
+    struct Load {
+        /// Number of connections served by (or queued for) this thread
+        std::atomic<uint32_t> connections{0};
+        /// Number of the connections used for DCP
+        std::atomic<uint32_t> dcp_connections{0};
+        /// Total time (in ns) spent serving connections
+        std::atomic<uint64_t> busy_ns{0};
+        /// Percentage of the last sample period spent serving connections
+        std::atomic<uint32_t> utilisation{0};
+        /// Number of connections moved to this thread
+        std::atomic<uint64_t> migrated_in{0};
+        /// Number of connections moved away from this thread
+        std::atomic<uint64_t> migrated_out{0};
+        /// Number of idle connections which may be moved to migrate_to
+        std::atomic<uint32_t> migrate_budget{0};
+        /// Index of the thread to move idle connections to
+        std::atomic<int> migrate_to{-1};
+        /// [dispatcher only] busy_ns when the utilisation was last sampled
+        uint64_t sampled_busy_ns = 0;
+    } load;
+
+    /**
+     * Connections moved to this thread by other worker threads, waiting
+     * to be registered with this thread's event base (not owning). This
+     * isn't protected by the thread lock as the thread giving up the
+     * connection already holds its own.
+     */
+    struct {
+        std::mutex mutex;
+        std::vector<McbpConnection*> connections;
+    } migrated;
 };
 
 #define LOCK_THREAD(t) t->mutex.lock();
@@ -207,6 +247,29 @@ void threads_cleanup();
 
 void dispatch_conn_new(SOCKET sfd, int parent_port);
 
+/**
+ * Start serving a client accepted by a worker thread on its own listen
+ * socket (see NetworkInterface::reuseport). Must be called by that thread.
+ */
+void dispatch_conn_local(SOCKET sfd, int parent_port, LIBEVENT_THREAD& thread);
+
+LIBEVENT_THREAD& get_worker_thread(int index);
+
+/**
+ * Move the connection to a less loaded worker thread if the dispatcher
+ * asked for load to be moved off its current thread and the connection
+ * is idle. Must be called by the thread serving the connection, with its
+ * thread lock held.
+ */
+void maybe_migrate_connection(Connection& c);
+
+/**
+ * Sample the utilisation of the worker threads (and, if connection
+ * migration is enabled, decide if load should be moved between them).
+ * Called once a second by the dispatcher thread.
+ */
+void threads_sample_load();
+
 /* Lock wrappers for cache functions that are called from main loop. */
 int is_listen_thread(void);
 
@@ -339,8 +402,17 @@ uint64_t get_listen_disabled_num(void);
  */
 extern std::unique_ptr<ExecutorPool> executorPool;
 
+/**
+ * The executor pool used to run the SASL authentication tasks. The
+ * authentication is CPU intensive, so it use its own pool to avoid
+ * starving the other tasks dispatched to the background threads.
+ */
+extern std::unique_ptr<ExecutorPool> saslExecutorPool;
+
 void iterate_all_connections(std::function<void(Connection&)> callback);
 
+void iterate_thread_load(std::function<void(const LIBEVENT_THREAD&)> callback);
+
 void start_stdin_listener(std::function<void()> function);
 
 #endif
@@ -92,6 +92,16 @@ static void handle_interface_management(NetworkInterface& ifc, cJSON* obj) {
     }
 }
 
+static void handle_interface_reuseport(NetworkInterface& ifc, cJSON* obj) {
+    if (obj->type == cJSON_True) {
+        ifc.reuseport = true;
+    } else if (obj->type == cJSON_False) {
+        ifc.reuseport = false;
+    } else {
+        throw std::invalid_argument(R"("reuseport" must be a boolean value)");
+    }
+}
+
 static void handle_interface_ssl(NetworkInterface& ifc, cJSON* obj) {
     if (obj->type != cJSON_Object) {
         throw std::invalid_argument(R"("ssl" must be an object)");
@@ -165,6 +175,7 @@ NetworkInterface::NetworkInterface(gsl::not_null<const cJSON*> json) {
             {"tcp_nodelay", handle_interface_tcp_nodelay},
             {"ssl", handle_interface_ssl},
             {"management", handle_interface_management},
+            {"reuseport", handle_interface_reuseport},
             {"protocol", handle_interface_protocol},
     };
 
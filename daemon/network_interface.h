@@ -39,4 +39,7 @@ public:
     bool ipv4 = true;
     bool tcp_nodelay = true;
     bool management = false;
+    /// Give each worker thread its own SO_REUSEPORT socket to accept
+    /// clients on, rather than going through the dispatcher thread
+    bool reuseport = false;
 };
@@ -68,6 +68,7 @@ void buildRequestVector(FeatureSet& requested, cb::sized_buffer<const uint16_t>
         case cb::mcbp::Feature::ClustermapChangeNotification:
         case cb::mcbp::Feature::UnorderedExecution:
         case cb::mcbp::Feature::Tracing:
+        case cb::mcbp::Feature::CompactStats:
 
             // This isn't very optimal, but we've only got a handfull of elements ;)
             if (!containsFeature(requested, feature)) {
@@ -94,6 +95,7 @@ void buildRequestVector(FeatureSet& requested, cb::sized_buffer<const uint16_t>
         case cb::mcbp::Feature::Tracing:
         case cb::mcbp::Feature::Duplex:
         case cb::mcbp::Feature::UnorderedExecution:
+        case cb::mcbp::Feature::CompactStats:
             // No other dependency
             break;
 
@@ -174,6 +176,7 @@ void process_hello_packet_executor(Cookie& cookie) {
     connection.setClustermapChangeNotificationSupported(false);
     connection.setTracingEnabled(false);
     connection.setAllowUnorderedExecution(false);
+    connection.setCompactStatsSupported(false);
 
     if (!key.empty()) {
         if (key.front() == '{') {
@@ -281,6 +284,10 @@ void process_hello_packet_executor(Cookie& cookie) {
             }
             break;
 
+        case cb::mcbp::Feature::CompactStats:
+            connection.setCompactStatsSupported(true);
+            added = true;
+            break;
         case cb::mcbp::Feature::Tracing:
             if (settings.isTracingEnabled()) {
                 connection.setTracingEnabled(true);
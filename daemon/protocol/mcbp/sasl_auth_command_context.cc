@@ -48,7 +48,7 @@ ENGINE_ERROR_CODE SaslAuthCommandContext::initial() {
     }
 
     std::lock_guard<std::mutex> guard(task->getMutex());
-    executorPool->schedule(task, true);
+    saslExecutorPool->schedule(task, true);
 
     state = State::ParseAuthTaskResult;
     return ENGINE_EWOULDBLOCK;
@@ -24,6 +24,7 @@
 #include <daemon/debug_helpers.h>
 #include <daemon/mc_time.h>
 #include <daemon/mcbp.h>
+#include <daemon/request_trace_log.h>
 #include <daemon/runtime.h>
 #include <mcbp/protocol/framebuilder.h>
 #include <mcbp/protocol/header.h>
@@ -205,6 +206,8 @@ static ENGINE_ERROR_CODE server_stats(ADD_STAT add_stat_callback,
         add_stat(cookie, add_stat_callback, "cmd_total_ops", total_ops);
         add_stat(cookie, add_stat_callback, "auth_cmds", thread_stats.auth_cmds);
         add_stat(cookie, add_stat_callback, "auth_errors", thread_stats.auth_errors);
+        add_stat(cookie, add_stat_callback, "sasl_auth_queue_depth",
+                 saslExecutorPool->runqSize());
         add_stat(cookie, add_stat_callback, "get_hits", thread_stats.get_hits);
         add_stat(cookie, add_stat_callback, "get_misses", thread_stats.get_misses);
         add_stat(cookie, add_stat_callback, "delete_misses",
@@ -225,6 +228,10 @@ static ENGINE_ERROR_CODE server_stats(ADD_STAT add_stat_callback,
         add_stat(cookie, add_stat_callback, "listen_disabled_num",
                  get_listen_disabled_num());
         add_stat(cookie, add_stat_callback, "rejected_conns", stats.rejected_conns);
+        add_stat(cookie, add_stat_callback, "ssl_handshakes_full",
+                 stats.ssl_handshakes_full);
+        add_stat(cookie, add_stat_callback, "ssl_handshakes_resumed",
+                 stats.ssl_handshakes_resumed);
         add_stat(cookie, add_stat_callback, "threads", settings.getNumWorkerThreads());
         add_stat(cookie, add_stat_callback, "conn_yields", thread_stats.conn_yields);
         add_stat(cookie, add_stat_callback, "rbufs_allocated",
@@ -317,6 +324,9 @@ static void process_stat_settings(ADD_STAT add_stat_callback, Cookie& cookie) {
             checked_snprintf(interface + offset, sizeof(interface) - offset,
                              "-tcp_nodelay");
             add_stat(cookie, add_stat_callback, interface, ifce.tcp_nodelay);
+            checked_snprintf(interface + offset, sizeof(interface) - offset,
+                             "-reuseport");
+            add_stat(cookie, add_stat_callback, interface, ifce.reuseport);
             checked_snprintf(interface + offset, sizeof(interface) - offset,
                              "-management");
             add_stat(cookie, add_stat_callback, interface, ifce.management);
@@ -393,6 +403,32 @@ static void process_stat_settings(ADD_STAT add_stat_callback, Cookie& cookie) {
              add_stat_callback,
              "collections_prototype",
              settings.isCollectionsPrototypeEnabled());
+    add_stat(cookie,
+             add_stat_callback,
+             "connection_migration",
+             settings.isConnectionMigration());
+    add_stat(cookie, add_stat_callback, "ktls_enabled", settings.isKtlsEnabled());
+    add_stat(cookie,
+             add_stat_callback,
+             "ssl_session_cache_size",
+             std::to_string(settings.getSslSessionCacheSize()).c_str());
+    add_stat(cookie,
+             add_stat_callback,
+             "ssl_session_timeout",
+             std::to_string(settings.getSslSessionTimeout()).c_str());
+    add_stat(cookie,
+             add_stat_callback,
+             "ssl_session_tickets",
+             settings.isSslSessionTicketsEnabled());
+    add_stat(cookie,
+             add_stat_callback,
+             "tracing_sample_rate",
+             std::to_string(settings.getTracingSampleRate()).c_str());
+    add_stat(cookie,
+             add_stat_callback,
+             "tracing_slow_threshold",
+             std::to_string(settings.getTracingSlowThreshold().count())
+                     .c_str());
 }
 
 static void append_bin_stats(const char* key,
@@ -420,20 +456,63 @@ static void append_bin_stats(const char* key,
                     builder.getFrame()->getBodylen());
 }
 
+/// Add a STAT response packet with the provided key and value
+static void append_stats_packet(const char* key,
+                                const uint16_t klen,
+                                const char* val,
+                                const uint32_t vlen,
+                                Cookie& cookie) {
+    const size_t needed = vlen + klen + sizeof(protocol_binary_response_header);
+    if (!cookie.growDynamicBuffer(needed)) {
+        return;
+    }
+    append_bin_stats(key, klen, val, vlen, cookie);
+}
+
 static void append_stats(const char* key,
                          const uint16_t klen,
                          const char* val,
                          const uint32_t vlen,
                          gsl::not_null<const void*> void_cookie) {
-    size_t needed;
-
     auto& cookie = *const_cast<Cookie*>(
             reinterpret_cast<const Cookie*>(void_cookie.get()));
-    needed = vlen + klen + sizeof(protocol_binary_response_header);
-    if (!cookie.growDynamicBuffer(needed)) {
+    if (key != nullptr && cookie.getConnection().isCompactStatsSupported()) {
+        auto* context =
+                dynamic_cast<StatsCommandContext*>(cookie.getCommandContext());
+        if (context != nullptr) {
+            context->addCompactStat({key, klen}, {val, vlen});
+            return;
+        }
+    }
+    append_stats_packet(key, klen, val, vlen, cookie);
+}
+
+/// The size of the batches of compact stats to send
+static const size_t CompactStatsBatchSize = 16 * 1024;
+
+void StatsCommandContext::addCompactStat(cb::const_char_buffer key,
+                                         cb::const_char_buffer value) {
+    const uint16_t klen = htons(uint16_t(key.size()));
+    const uint32_t vlen = htonl(uint32_t(value.size()));
+    compactStats.append(reinterpret_cast<const char*>(&klen), sizeof(klen));
+    compactStats.append(reinterpret_cast<const char*>(&vlen), sizeof(vlen));
+    compactStats.append(key.data(), key.size());
+    compactStats.append(value.data(), value.size());
+    if (compactStats.size() >= CompactStatsBatchSize) {
+        sendCompactStats();
+    }
+}
+
+void StatsCommandContext::sendCompactStats() {
+    if (compactStats.empty()) {
         return;
     }
-    append_bin_stats(key, klen, val, vlen, cookie);
+    append_stats_packet(nullptr,
+                        0,
+                        compactStats.data(),
+                        uint32_t(compactStats.size()),
+                        cookie);
+    compactStats.clear();
 }
 
 
@@ -530,6 +609,51 @@ static ENGINE_ERROR_CODE stat_sched_executor(const std::string& arg,
     }
 }
 
+/**
+ * Handler for the <code>stats worker_thread_load</code> used to get the
+ * load of each of the worker threads (which is used to decide which
+ * thread should serve new connections).
+ *
+ * @param arg - should be empty
+ * @param cookie the command context
+ */
+static ENGINE_ERROR_CODE stat_thread_load_executor(const std::string& arg,
+                                                   Cookie& cookie) {
+    if (!arg.empty()) {
+        return ENGINE_EINVAL;
+    }
+
+    iterate_thread_load([&cookie](const LIBEVENT_THREAD& thread) {
+        const auto& load = thread.load;
+        const std::string prefix = "worker_" + std::to_string(thread.index);
+        add_stat(cookie,
+                 &append_stats,
+                 (prefix + ":connections").c_str(),
+                 load.connections.load());
+        add_stat(cookie,
+                 &append_stats,
+                 (prefix + ":dcp_connections").c_str(),
+                 load.dcp_connections.load());
+        add_stat(cookie,
+                 &append_stats,
+                 (prefix + ":busy_ns").c_str(),
+                 load.busy_ns.load());
+        add_stat(cookie,
+                 &append_stats,
+                 (prefix + ":utilisation").c_str(),
+                 load.utilisation.load());
+        add_stat(cookie,
+                 &append_stats,
+                 (prefix + ":migrated_in").c_str(),
+                 load.migrated_in.load());
+        add_stat(cookie,
+                 &append_stats,
+                 (prefix + ":migrated_out").c_str(),
+                 load.migrated_out.load());
+    });
+    return ENGINE_SUCCESS;
+}
+
 /**
  * Handler for the <code>stats settings</code> used to get the current
  * settings.
@@ -747,6 +871,63 @@ static ENGINE_ERROR_CODE stat_responses_json_executor(const std::string& arg,
     }
 }
 
+static ENGINE_ERROR_CODE append_trace_log_entries(
+        const std::vector<RequestTraceLog::Entry>& entries, Cookie& cookie) {
+    try {
+        size_t index = 0;
+        for (const auto& entry : entries) {
+            const auto key = std::to_string(index++);
+            const auto value = to_string(entry.toJSON(), false);
+            append_stats(key.data(),
+                         uint16_t(key.size()),
+                         value.data(),
+                         uint32_t(value.size()),
+                         &cookie);
+        }
+        return ENGINE_SUCCESS;
+    } catch (const std::bad_alloc&) {
+        return ENGINE_ENOMEM;
+    }
+}
+
+/**
+ * Handler for the <code>stats request_traces</code> command used to
+ * retrieve the traces of the most recent sampled and slow requests.
+ * Each trace is returned as a JSON object (oldest first).
+ *
+ * @param arg - should be empty
+ * @param cookie the command context
+ */
+static ENGINE_ERROR_CODE stat_request_traces_executor(const std::string& arg,
+                                                      Cookie& cookie) {
+    if (!arg.empty()) {
+        return ENGINE_EINVAL;
+    }
+
+    return append_trace_log_entries(RequestTraceLog::getInstance().getEntries(),
+                                    cookie);
+}
+
+/**
+ * Handler for the <code>stats slow_requests</code> command used to
+ * retrieve the traces of the most recent requests exceeding the
+ * tracing_slow_threshold, including the time spent in each layer
+ * (see "breakdown" in docs/Tracing.md).
+ *
+ * @param arg - should be empty
+ * @param cookie the command context
+ */
+static ENGINE_ERROR_CODE stat_slow_requests_executor(const std::string& arg,
+                                                     Cookie& cookie) {
+    if (!arg.empty()) {
+        return ENGINE_EINVAL;
+    }
+
+    return append_trace_log_entries(RequestTraceLog::getInstance().getEntries(
+                                            RequestTraceLog::Reason::Slow),
+                                    cookie);
+}
+
 static ENGINE_ERROR_CODE stat_tracing_executor(const std::string& arg,
                                                Cookie& cookie) {
     class MemcachedCallback : public phosphor::StatsCallback {
@@ -817,6 +998,7 @@ ENGINE_ERROR_CODE StatsCommandContext::step() {
     static std::unordered_map<std::string, struct stat_handler> handlers = {
             {"reset", {true, stat_reset_executor}},
             {"worker_thread_info", {false, stat_sched_executor}},
+            {"worker_thread_load", {false, stat_thread_load_executor}},
             {"settings", {false, stat_settings_executor}},
             {"audit", {true, stat_audit_executor}},
             {"bucket_details", {true, stat_bucket_details_executor}},
@@ -826,7 +1008,9 @@ ENGINE_ERROR_CODE StatsCommandContext::step() {
             {"topkeys_json", {false, stat_topkeys_json_executor}},
             {"subdoc_execute", {false, stat_subdoc_execute_executor}},
             {"responses", {false, stat_responses_json_executor}},
-            {"tracing", {true, stat_tracing_executor}}};
+            {"tracing", {true, stat_tracing_executor}},
+            {"request_traces", {true, stat_request_traces_executor}},
+            {"slow_requests", {true, stat_slow_requests_executor}}};
 
     ENGINE_ERROR_CODE ret = ENGINE_SUCCESS;
 
@@ -872,6 +1056,7 @@ ENGINE_ERROR_CODE StatsCommandContext::step() {
     }
 
     if (ret == ENGINE_SUCCESS) {
+        sendCompactStats();
         append_stats(nullptr, 0, nullptr, 0, static_cast<void*>(&cookie));
 
         // We just want to record this once rather than for each packet sent
@@ -31,6 +31,13 @@ public:
         : SteppableCommandContext(cookie), key(cookie.getRequest().getKey()) {
     }
 
+    /**
+     * Add a stat to the current batch of stats for clients which have
+     * enabled compact stats. The batch is sent in a single STAT response
+     * once it is full (or the command completes).
+     */
+    void addCompactStat(cb::const_char_buffer key, cb::const_char_buffer value);
+
 protected:
     /**
      * In most cases we won't be returning EWOULDBLOCK, and there isn't any
@@ -45,9 +52,19 @@ protected:
     ENGINE_ERROR_CODE step() override;
 
 private:
+    /// Send the current batch of compact stats (if any)
+    void sendCompactStats();
 
     /**
      * The key as specified in the input buffer (it may contain a sub command)
      */
     const cb::const_byte_buffer key;
+
+    /**
+     * The stats which haven't been sent yet (for clients which have enabled
+     * compact stats). Each stat is encoded as the key length (16 bits), the
+     * value length (32 bits), both in network byte order, followed by the
+     * key and the value.
+     */
+    std::string compactStats;
 };
@@ -0,0 +1,134 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include "request_trace_log.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+const size_t RequestTraceLog::Capacity;
+
+RequestTraceLog& RequestTraceLog::getInstance() {
+    static RequestTraceLog instance;
+    return instance;
+}
+
+void RequestTraceLog::add(Entry entry) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto& ring = rings[size_t(entry.reason)];
+    if (ring.entries.size() < Capacity) {
+        ring.entries.emplace_back(std::move(entry));
+    } else {
+        ring.entries[ring.next] = std::move(entry);
+        ring.next = (ring.next + 1) % Capacity;
+    }
+}
+
+void RequestTraceLog::appendEntries(std::vector<Entry>& ret,
+                                    Reason reason) const {
+    const auto& ring = rings[size_t(reason)];
+    ret.insert(ret.end(), ring.entries.begin() + ring.next, ring.entries.end());
+    ret.insert(ret.end(),
+               ring.entries.begin(),
+               ring.entries.begin() + ring.next);
+}
+
+std::vector<RequestTraceLog::Entry> RequestTraceLog::getEntries() const {
+    std::vector<Entry> ret;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        appendEntries(ret, Reason::Sampled);
+        appendEntries(ret, Reason::Slow);
+    }
+    std::stable_sort(
+            ret.begin(), ret.end(), [](const Entry& a, const Entry& b) {
+                return a.time < b.time;
+            });
+    return ret;
+}
+
+std::vector<RequestTraceLog::Entry> RequestTraceLog::getEntries(
+        Reason reason) const {
+    std::vector<Entry> ret;
+    std::lock_guard<std::mutex> guard(mutex);
+    appendEntries(ret, reason);
+    return ret;
+}
+
+void RequestTraceLog::clear() {
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto& ring : rings) {
+        ring.entries.clear();
+        ring.next = 0;
+    }
+}
+
+void RequestTraceLog::Entry::setTrace(const cb::tracing::Tracer& tracer) {
+    using cb::tracing::TraceCode;
+    const auto spans = tracer.getDurations();
+    trace = to_string(tracer);
+    breakdown.clear();
+    for (const auto& span : spans) {
+        // The request span covers all of the others, and we don't know
+        // how long the spans which are still open lasted
+        if (span.code == TraceCode::REQUEST ||
+            span.duration == std::chrono::microseconds::max()) {
+            continue;
+        }
+        auto iter = std::find_if(
+                breakdown.begin(),
+                breakdown.end(),
+                [&span](const std::pair<TraceCode, std::chrono::microseconds>&
+                                e) { return e.first == span.code; });
+        if (iter == breakdown.end()) {
+            breakdown.emplace_back(span.code, span.duration);
+        } else {
+            iter->second += span.duration;
+        }
+    }
+}
+
+unique_cJSON_ptr RequestTraceLog::Entry::toJSON() const {
+    unique_cJSON_ptr ret(cJSON_CreateObject());
+    cJSON_AddNumberToObject(ret.get(),
+                            "timestamp",
+                            double(std::chrono::system_clock::to_time_t(time)));
+    cJSON_AddNumberToObject(ret.get(), "connection", connectionId);
+    cJSON_AddStringToObject(ret.get(), "opcode", opcode.c_str());
+    cJSON_AddNumberToObject(ret.get(), "opaque", opaque);
+    cJSON_AddNumberToObject(ret.get(), "duration", double(duration.count()));
+    cJSON_AddStringToObject(ret.get(), "reason", to_string(reason).c_str());
+    cJSON_AddStringToObject(ret.get(), "trace", trace.c_str());
+    cJSON* obj = cJSON_CreateObject();
+    for (const auto& e : breakdown) {
+        cJSON_AddNumberToObject(
+                obj, to_string(e.first).c_str(), double(e.second.count()));
+    }
+    cJSON_AddItemToObject(ret.get(), "breakdown", obj);
+    return ret;
+}
+
+std::string to_string(RequestTraceLog::Reason reason) {
+    switch (reason) {
+    case RequestTraceLog::Reason::Sampled:
+        return "sampled";
+    case RequestTraceLog::Reason::Slow:
+        return "slow";
+    }
+    throw std::invalid_argument(
+            "to_string(RequestTraceLog::Reason): Invalid reason: " +
+            std::to_string(int(reason)));
+}
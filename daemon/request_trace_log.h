@@ -0,0 +1,106 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#pragma once
+
+#include <cJSON_utils.h>
+#include <tracing/tracer.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * The RequestTraceLog keeps the traces of the most recent sampled or
+ * slow requests in ring buffers, so that they may be inspected through
+ * "stats request_traces" (or "stats slow_requests" for just the slow
+ * ones) after the fact.
+ *
+ * Each reason has its own ring buffer so that a high sample rate can't
+ * push the slow requests out of the log.
+ *
+ * Only a small fraction of the requests end up in the log, so a mutex
+ * is used to protect the ring buffers.
+ */
+class RequestTraceLog {
+public:
+    /// The number of traces kept in the log for each reason
+    static const size_t Capacity = 100;
+
+    /// Why the request was added to the log
+    enum class Reason { Sampled, Slow };
+
+    struct Entry {
+        std::chrono::system_clock::time_point time;
+        uint32_t connectionId;
+        std::string opcode;
+        uint32_t opaque;
+        std::chrono::microseconds duration;
+        Reason reason;
+        /// The spans recorded for the request (see to_string(Tracer))
+        std::string trace;
+        /**
+         * The total time spent in each layer (frontend parsing, engine,
+         * hash table lock, bgfetch queue, disk read, response send, ...)
+         * keyed by the trace code of the spans
+         */
+        std::vector<std::pair<cb::tracing::TraceCode,
+                              std::chrono::microseconds>>
+                breakdown;
+
+        /// Set the trace and the breakdown from the provided tracer
+        void setTrace(const cb::tracing::Tracer& tracer);
+
+        unique_cJSON_ptr toJSON() const;
+    };
+
+    static RequestTraceLog& getInstance();
+
+    /**
+     * Add an entry to the log (replacing the oldest entry with the
+     * same reason if full)
+     */
+    void add(Entry entry);
+
+    /// Get all of the entries in the log (oldest first)
+    std::vector<Entry> getEntries() const;
+
+    /// Get the entries added for the given reason (oldest first)
+    std::vector<Entry> getEntries(Reason reason) const;
+
+    void clear();
+
+protected:
+    RequestTraceLog() = default;
+
+    struct Ring {
+        std::vector<Entry> entries;
+        /// The index of the next entry to replace once the ring is full
+        size_t next = 0;
+    };
+
+    void appendEntries(std::vector<Entry>& ret, Reason reason) const;
+
+    mutable std::mutex mutex;
+    /// One ring per Reason
+    std::array<Ring, 2> rings;
+};
+
+std::string to_string(RequestTraceLog::Reason reason);
@@ -235,6 +235,126 @@ static void handle_tracing_enabled(Settings& s, cJSON* obj) {
     }
 }
 
+/**
+ * Handle the "tracing_sample_rate" tag in the settings
+ *
+ *  The value must be a numeric value
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_tracing_sample_rate(Settings& s, cJSON* obj) {
+    if (obj->type != cJSON_Number || obj->valueint < 0) {
+        throw std::invalid_argument(
+                "\"tracing_sample_rate\" must be a positive integer");
+    }
+    s.setTracingSampleRate(obj->valueint);
+}
+
+/**
+ * Handle the "tracing_slow_threshold" tag in the settings
+ *
+ *  The value must be a numeric value
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_tracing_slow_threshold(Settings& s, cJSON* obj) {
+    if (obj->type != cJSON_Number || obj->valueint < 0) {
+        throw std::invalid_argument(
+                "\"tracing_slow_threshold\" must be a positive integer");
+    }
+    s.setTracingSlowThreshold(std::chrono::milliseconds(obj->valueint));
+}
+
+/**
+ * Handle the "connection_migration" tag in the settings
+ *
+ *  The value must be a boolean value
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_connection_migration(Settings& s, cJSON* obj) {
+    if (obj->type == cJSON_True) {
+        s.setConnectionMigration(true);
+    } else if (obj->type == cJSON_False) {
+        s.setConnectionMigration(false);
+    } else {
+        throw std::invalid_argument(
+                "\"connection_migration\" must be a boolean value");
+    }
+}
+
+/**
+ * Handle the "ktls_enabled" tag in the settings
+ *
+ *  The value must be a boolean value
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_ktls_enabled(Settings& s, cJSON* obj) {
+    if (obj->type == cJSON_True) {
+        s.setKtlsEnabled(true);
+    } else if (obj->type == cJSON_False) {
+        s.setKtlsEnabled(false);
+    } else {
+        throw std::invalid_argument("\"ktls_enabled\" must be a boolean value");
+    }
+}
+
+/**
+ * Handle the "ssl_session_cache_size" tag in the settings
+ *
+ *  The value must be a numeric value
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_ssl_session_cache_size(Settings& s, cJSON* obj) {
+    if (obj->type != cJSON_Number || obj->valueint < 0) {
+        throw std::invalid_argument(
+                "\"ssl_session_cache_size\" must be a positive integer");
+    }
+    s.setSslSessionCacheSize(obj->valueint);
+}
+
+/**
+ * Handle the "ssl_session_timeout" tag in the settings
+ *
+ *  The value must be a numeric value
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_ssl_session_timeout(Settings& s, cJSON* obj) {
+    if (obj->type != cJSON_Number || obj->valueint < 0) {
+        throw std::invalid_argument(
+                "\"ssl_session_timeout\" must be a positive integer");
+    }
+    s.setSslSessionTimeout(obj->valueint);
+}
+
+/**
+ * Handle the "ssl_session_tickets" tag in the settings
+ *
+ *  The value must be a boolean value
+ *
+ * @param s the settings object to update
+ * @param obj the object in the configuration
+ */
+static void handle_ssl_session_tickets(Settings& s, cJSON* obj) {
+    if (obj->type == cJSON_True) {
+        s.setSslSessionTicketsEnabled(true);
+    } else if (obj->type == cJSON_False) {
+        s.setSslSessionTicketsEnabled(false);
+    } else {
+        throw std::invalid_argument(
+                "\"ssl_session_tickets\" must be a boolean value");
+    }
+}
+
 /**
  * Handle the "stdin_listener" tag in the settings
  *
@@ -686,7 +806,14 @@ void Settings::reconfigure(const unique_cJSON_ptr& json) {
             {"collections_prototype", handle_collections_prototype},
             {"opcode_attributes_override", handle_opcode_attributes_override},
             {"topkeys_enabled", handle_topkeys_enabled},
-            {"tracing_enabled", handle_tracing_enabled}};
+            {"tracing_enabled", handle_tracing_enabled},
+            {"tracing_sample_rate", handle_tracing_sample_rate},
+            {"tracing_slow_threshold", handle_tracing_slow_threshold},
+            {"connection_migration", handle_connection_migration},
+            {"ktls_enabled", handle_ktls_enabled},
+            {"ssl_session_cache_size", handle_ssl_session_cache_size},
+            {"ssl_session_timeout", handle_ssl_session_timeout},
+            {"ssl_session_tickets", handle_ssl_session_tickets}};
 
     cJSON* obj = json->child;
     while (obj != nullptr) {
@@ -1124,6 +1251,68 @@ void Settings::updateSettings(const Settings& other, bool apply) {
         }
         setTracingEnabled(other.isTracingEnabled());
     }
+
+    if (other.has.tracing_sample_rate) {
+        if (other.getTracingSampleRate() != getTracingSampleRate()) {
+            LOG_INFO("Change tracing sample rate from {} to {}",
+                     getTracingSampleRate(),
+                     other.getTracingSampleRate());
+            setTracingSampleRate(other.getTracingSampleRate());
+        }
+    }
+
+    if (other.has.tracing_slow_threshold) {
+        if (other.getTracingSlowThreshold() != getTracingSlowThreshold()) {
+            LOG_INFO("Change tracing slow threshold from {}ms to {}ms",
+                     getTracingSlowThreshold().count(),
+                     other.getTracingSlowThreshold().count());
+            setTracingSlowThreshold(other.getTracingSlowThreshold());
+        }
+    }
+
+    if (other.has.connection_migration) {
+        if (other.isConnectionMigration() != isConnectionMigration()) {
+            LOG_INFO("{} migration of idle connections",
+                     other.isConnectionMigration() ? "Enable" : "Disable");
+        }
+        setConnectionMigration(other.isConnectionMigration());
+    }
+
+    if (other.has.ktls_enabled) {
+        if (other.isKtlsEnabled() != isKtlsEnabled()) {
+            LOG_INFO("{} kernel TLS offload of new SSL connections",
+                     other.isKtlsEnabled() ? "Enable" : "Disable");
+        }
+        setKtlsEnabled(other.isKtlsEnabled());
+    }
+
+    if (other.has.ssl_session_cache_size) {
+        if (other.getSslSessionCacheSize() != getSslSessionCacheSize()) {
+            LOG_INFO("Change SSL session cache size from {} to {}",
+                     getSslSessionCacheSize(),
+                     other.getSslSessionCacheSize());
+            setSslSessionCacheSize(other.getSslSessionCacheSize());
+        }
+    }
+
+    if (other.has.ssl_session_timeout) {
+        if (other.getSslSessionTimeout() != getSslSessionTimeout()) {
+            LOG_INFO("Change SSL session timeout from {} to {}",
+                     getSslSessionTimeout(),
+                     other.getSslSessionTimeout());
+            setSslSessionTimeout(other.getSslSessionTimeout());
+        }
+    }
+
+    if (other.has.ssl_session_tickets) {
+        if (other.isSslSessionTicketsEnabled() !=
+            isSslSessionTicketsEnabled()) {
+            LOG_INFO("{} SSL session tickets",
+                     other.isSslSessionTicketsEnabled() ? "Enable"
+                                                        : "Disable");
+        }
+        setSslSessionTicketsEnabled(other.isSslSessionTicketsEnabled());
+    }
 }
 
 /**
@@ -30,6 +30,7 @@
 #include <platform/dynamic.h>
 #include <relaxed_atomic.h>
 #include <atomic>
+#include <chrono>
 #include <cstdarg>
 #include <deque>
 #include <map>
@@ -731,6 +732,109 @@ public:
         notify_changed("tracing_enabled");
     }
 
+    /**
+     * Get the rate requests are sampled into the request trace log
+     * (1 in N requests, 0 disables sampling)
+     */
+    size_t getTracingSampleRate() const {
+        return tracing_sample_rate.load(std::memory_order_acquire);
+    }
+
+    void setTracingSampleRate(size_t rate) {
+        Settings::tracing_sample_rate.store(rate, std::memory_order_release);
+        has.tracing_sample_rate = true;
+        notify_changed("tracing_sample_rate");
+    }
+
+    /**
+     * Get the duration a request must exceed to be added to the request
+     * trace log (0 disables the threshold)
+     */
+    std::chrono::milliseconds getTracingSlowThreshold() const {
+        return std::chrono::milliseconds(
+                tracing_slow_threshold.load(std::memory_order_acquire));
+    }
+
+    void setTracingSlowThreshold(std::chrono::milliseconds threshold) {
+        Settings::tracing_slow_threshold.store(threshold.count(),
+                                               std::memory_order_release);
+        has.tracing_slow_threshold = true;
+        notify_changed("tracing_slow_threshold");
+    }
+
+    bool isConnectionMigration() const {
+        return connection_migration.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Set if idle connections may be moved from a busy worker thread to
+     * a less busy one
+     */
+    void setConnectionMigration(bool enabled) {
+        Settings::connection_migration.store(enabled,
+                                             std::memory_order_release);
+        has.connection_migration = true;
+        notify_changed("connection_migration");
+    }
+
+    bool isKtlsEnabled() const {
+        return ktls_enabled.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Set if the encryption of the data sent on SSL connections should be
+     * offloaded to the kernel (where supported)
+     */
+    void setKtlsEnabled(bool enabled) {
+        Settings::ktls_enabled.store(enabled, std::memory_order_release);
+        has.ktls_enabled = true;
+        notify_changed("ktls_enabled");
+    }
+
+    /**
+     * Get the maximum number of SSL sessions kept in the server side
+     * session cache (0 disables the cache)
+     */
+    size_t getSslSessionCacheSize() const {
+        return ssl_session_cache_size.load(std::memory_order_acquire);
+    }
+
+    void setSslSessionCacheSize(size_t size) {
+        Settings::ssl_session_cache_size.store(size,
+                                               std::memory_order_release);
+        has.ssl_session_cache_size = true;
+        notify_changed("ssl_session_cache_size");
+    }
+
+    /**
+     * Get the number of seconds a SSL session may be resumed. The session
+     * ticket key is rotated at the same interval.
+     */
+    size_t getSslSessionTimeout() const {
+        return ssl_session_timeout.load(std::memory_order_acquire);
+    }
+
+    void setSslSessionTimeout(size_t timeout) {
+        Settings::ssl_session_timeout.store(timeout,
+                                            std::memory_order_release);
+        has.ssl_session_timeout = true;
+        notify_changed("ssl_session_timeout");
+    }
+
+    bool isSslSessionTicketsEnabled() const {
+        return ssl_session_tickets.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Set if SSL clients may resume their session by using session tickets
+     */
+    void setSslSessionTicketsEnabled(bool enabled) {
+        Settings::ssl_session_tickets.store(enabled,
+                                            std::memory_order_release);
+        has.ssl_session_tickets = true;
+        notify_changed("ssl_session_tickets");
+    }
+
 protected:
 
     /**
@@ -892,6 +996,42 @@ protected:
      */
     std::atomic_bool tracing_enabled{true};
 
+    /**
+     * Sample 1 in N requests into the request trace log
+     */
+    std::atomic<size_t> tracing_sample_rate{0};
+
+    /**
+     * Add requests taking longer than this number of milliseconds to the
+     * request trace log
+     */
+    std::atomic<int64_t> tracing_slow_threshold{500};
+
+    /**
+     * May idle connections be moved between worker threads or not
+     */
+    std::atomic_bool connection_migration{false};
+
+    /**
+     * Should the kernel encrypt the data sent on SSL connections or not
+     */
+    std::atomic_bool ktls_enabled{true};
+
+    /**
+     * The maximum number of sessions in the SSL session cache
+     */
+    std::atomic<size_t> ssl_session_cache_size{10240};
+
+    /**
+     * The number of seconds a SSL session may be resumed
+     */
+    std::atomic<size_t> ssl_session_timeout{300};
+
+    /**
+     * Should SSL session tickets be used or not
+     */
+    std::atomic_bool ssl_session_tickets{true};
+
     /**
      * Use standard input listener
      */
@@ -937,6 +1077,13 @@ public:
         bool opcode_attributes_override;
         bool topkeys_enabled;
         bool tracing_enabled;
+        bool tracing_sample_rate;
+        bool tracing_slow_threshold;
+        bool connection_migration;
+        bool ktls_enabled;
+        bool ssl_session_cache_size;
+        bool ssl_session_timeout;
+        bool ssl_session_tickets;
         bool stdin_listener;
     } has;
 
@@ -75,6 +75,14 @@ public:
         return connected;
     }
 
+    /**
+     * Was an existing session resumed during the handshake (instead of
+     * performing a full handshake)?
+     */
+    bool isSessionReused() const {
+        return SSL_session_reused(client) == 1;
+    }
+
     /**
      * Set the status of the connected flag
      */
@@ -119,12 +127,35 @@ public:
      */
     void drainBioSendPipe(SOCKET sfd);
 
+    /**
+     * Try to hand the encryption of the data sent on the socket over to
+     * the kernel (kTLS). Must be called once the handshake is complete.
+     *
+     * Only TLS 1.2 with AES-128-GCM is supported, and all of the handshake
+     * data must have been sent. The data received is still decrypted
+     * by OpenSSL. Alerts generated by OpenSSL (close_notify, or refusing
+     * a renegotiation) are sent through the kernel by drainBioSendPipe.
+     *
+     * @param sfd the socket used by the connection
+     * @return true if the kernel encrypts all data written to the socket
+     *         from now on (so plain send calls should be used), false if
+     *         the data must be written through OpenSSL.
+     */
+    bool enableKernelSend(SOCKET sfd);
+
+    /**
+     * Is the data written to the socket encrypted by the kernel?
+     */
+    bool isKernelSend() const {
+        return kernelSend;
+    }
+
     bool moreInputAvailable() const {
         return !inputPipe.empty();
     }
 
     bool morePendingOutput() const {
-        return !outputPipe.empty();
+        return !outputPipe.empty() || !kernelAlerts.empty();
     }
 
     /**
@@ -142,6 +173,14 @@ public:
 
     int write(const void* buf, int num);
 
+    /**
+     * Send a close_notify alert to the client (in reply to the one it
+     * sent us) before the connection is closed.
+     *
+     * @param sfd the socket to write data to
+     */
+    void shutdown(SOCKET sfd);
+
     bool havePendingInputData();
 
     std::pair<cb::x509::Status, std::string> getCertUserName();
@@ -153,9 +192,25 @@ public:
 protected:
     bool drainInputSocketBuf();
 
+    /**
+     * Send the alerts generated by OpenSSL after the kernel took over the
+     * encryption of the data we send.
+     */
+    void drainKernelSendPipe(SOCKET sfd);
+
+    /// SSL message callback which records the alerts OpenSSL sends
+    static void onMessage(int write_p,
+                          int version,
+                          int content_type,
+                          const void* buf,
+                          size_t len,
+                          SSL* ssl,
+                          void* arg);
+
     bool enabled = false;
     bool connected = false;
     bool error = false;
+    bool kernelSend = false;
     BIO* application = nullptr;
     BIO* network = nullptr;
     SSL_CTX* ctx = nullptr;
@@ -167,6 +222,9 @@ protected:
     // The pipe used to buffer data between the SSL library and the socket
     // (data being written)
     cb::Pipe outputPipe;
+    // The alerts (level and description) generated by OpenSSL which have
+    // yet to be sent through the kernel (kernelSend only)
+    std::vector<uint8_t> kernelAlerts;
 
     // Total number of bytes received on the network
     size_t totalRecv = 0;
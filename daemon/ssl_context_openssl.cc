@@ -18,9 +18,24 @@
 
 #include "memcached.h"
 #include "runtime.h"
+#include "ssl_session_cache.h"
 
 #include <utilities/logtags.h>
 
+#ifdef HAVE_KTLS
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <openssl/kdf.h>
+#include <sys/socket.h>
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
 SslContext::~SslContext() {
     if (enabled) {
         disable();
@@ -43,6 +58,12 @@ int SslContext::write(const void* buf, int num) {
     return SSL_write(client, buf, num);
 }
 
+void SslContext::shutdown(SOCKET sfd) {
+    if (SSL_shutdown(client) >= 0) {
+        drainBioSendPipe(sfd);
+    }
+}
+
 bool SslContext::havePendingInputData() {
     if (isEnabled()) {
         // Move any data in the memory buffer over to the ssl pipe
@@ -88,6 +109,12 @@ bool SslContext::enable(const std::string& cert, const std::string& pkey) {
         break;
     }
 
+    // Sessions may only be resumed with the same certificate and client
+    // certificate mode as they were created with
+    SslSessionCache::getInstance().configure(
+            ctx,
+            cert + ":" + std::to_string(int(settings.getClientCertMode())));
+
     enabled = true;
     error = false;
     client = NULL;
@@ -110,6 +137,152 @@ bool SslContext::enable(const std::string& cert, const std::string& pkey) {
     return true;
 }
 
+bool SslContext::enableKernelSend(SOCKET sfd) {
+#ifdef HAVE_KTLS
+    if (!settings.isKtlsEnabled() || kernelSend || !connected ||
+        morePendingOutput() || BIO_ctrl_pending(network) != 0) {
+        return false;
+    }
+
+    const auto* cipher = SSL_get_current_cipher(client);
+    if (SSL_version(client) != TLS1_2_VERSION || cipher == nullptr ||
+        SSL_CIPHER_get_cipher_nid(cipher) != NID_aes_128_gcm) {
+        return false;
+    }
+
+    // Derive the key block the same way as OpenSSL did. The TLS 1.2 PRF
+    // of all of the AES-128-GCM cipher suites use SHA-256, and the key
+    // block is laid out as: client key, server key, client iv, server iv
+    unsigned char master[SSL_MAX_MASTER_KEY_LENGTH];
+    const auto masterlen = SSL_SESSION_get_master_key(
+            SSL_get_session(client), master, sizeof(master));
+    unsigned char seed[2 * SSL3_RANDOM_SIZE];
+    SSL_get_server_random(client, seed, SSL3_RANDOM_SIZE);
+    SSL_get_client_random(client, seed + SSL3_RANDOM_SIZE, SSL3_RANDOM_SIZE);
+
+    const size_t keylen = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+    const size_t saltlen = TLS_CIPHER_AES_GCM_128_SALT_SIZE;
+    unsigned char block[2 * (keylen + saltlen)];
+    size_t blocklen = sizeof(block);
+    auto* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr);
+    const bool derived =
+            pctx != nullptr && EVP_PKEY_derive_init(pctx) > 0 &&
+            EVP_PKEY_CTX_set_tls1_prf_md(pctx, EVP_sha256()) > 0 &&
+            EVP_PKEY_CTX_set1_tls1_prf_secret(pctx, master, int(masterlen)) >
+                    0 &&
+            EVP_PKEY_CTX_add1_tls1_prf_seed(
+                    pctx,
+                    reinterpret_cast<const unsigned char*>("key expansion"),
+                    13) > 0 &&
+            EVP_PKEY_CTX_add1_tls1_prf_seed(pctx, seed, sizeof(seed)) > 0 &&
+            EVP_PKEY_derive(pctx, block, &blocklen) > 0;
+    EVP_PKEY_CTX_free(pctx);
+    OPENSSL_cleanse(master, sizeof(master));
+    if (!derived) {
+        OPENSSL_cleanse(block, sizeof(block));
+        return false;
+    }
+
+    struct tls12_crypto_info_aes_gcm_128 info;
+    memset(&info, 0, sizeof(info));
+    info.info.version = TLS_1_2_VERSION;
+    info.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+    memcpy(info.key, block + keylen, keylen);
+    memcpy(info.salt, block + 2 * keylen + saltlen, saltlen);
+    OPENSSL_cleanse(block, sizeof(block));
+
+    // The server sent its Finished message as the first record with the
+    // new keys, so the next record use sequence number 1. The explicit
+    // part of the nonce only needs to be unique, so use the sequence
+    // number for that as well.
+    info.rec_seq[TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE - 1] = 1;
+    info.iv[TLS_CIPHER_AES_GCM_128_IV_SIZE - 1] = 1;
+
+    const bool enabled =
+            setsockopt(sfd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) == 0 &&
+            setsockopt(sfd, SOL_TLS, TLS_TX, &info, sizeof(info)) == 0;
+    OPENSSL_cleanse(&info, sizeof(info));
+    if (!enabled) {
+        // Without the TLS_TX configured the socket still sends the data
+        // as is, so we may keep on using OpenSSL
+        LOG_DEBUG("Failed to enable kTLS: {}", strerror(errno));
+        return false;
+    }
+
+    // OpenSSL can't write anything to the socket from now on, so refuse
+    // any attempt to renegotiate the session. The only records it may
+    // still generate are alerts, which we pick up in onMessage and send
+    // through the kernel.
+    SSL_set_options(client, SSL_OP_NO_RENEGOTIATION);
+    SSL_set_msg_callback(client, onMessage);
+    SSL_set_msg_callback_arg(client, this);
+    kernelSend = true;
+    return true;
+#else
+    (void)sfd;
+    return false;
+#endif
+}
+
+void SslContext::onMessage(int write_p,
+                           int,
+                           int content_type,
+                           const void* buf,
+                           size_t len,
+                           SSL*,
+                           void* arg) {
+    if (write_p == 1 && content_type == SSL3_RT_ALERT && len == 2) {
+        auto* self = reinterpret_cast<SslContext*>(arg);
+        const auto* alert = reinterpret_cast<const uint8_t*>(buf);
+        self->kernelAlerts.insert(self->kernelAlerts.end(), alert, alert + 2);
+    }
+}
+
+void SslContext::drainKernelSendPipe(SOCKET sfd) {
+#ifdef HAVE_KTLS
+    // The records OpenSSL wrote to the BIO are encrypted with its own copy
+    // of the keys and sequence numbers, which the kernel doesn't use. Throw
+    // them away and send the alerts in them through the kernel instead.
+    char discard[256];
+    while (BIO_read(network, discard, sizeof(discard)) > 0) {
+    }
+
+    while (!kernelAlerts.empty()) {
+        char control[CMSG_SPACE(sizeof(uint8_t))] = {};
+        struct iovec iov;
+        iov.iov_base = kernelAlerts.data();
+        iov.iov_len = 2;
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        auto* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_TLS;
+        cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+        *CMSG_DATA(cmsg) = SSL3_RT_ALERT;
+
+        const auto n = ::sendmsg(sfd, &msg, 0);
+        if (n == 2) {
+            totalSend += n;
+            kernelAlerts.erase(kernelAlerts.begin(), kernelAlerts.begin() + 2);
+        } else {
+            // A short write would leave half an alert in its own record
+            if (n != -1 || !is_blocking(GetLastNetworkError())) {
+                log_socket_error(EXTENSION_LOG_WARNING,
+                                 this,
+                                 "Failed to send TLS alert: %s");
+                error = true;
+            }
+            return;
+        }
+    }
+#else
+    (void)sfd;
+#endif
+}
+
 std::pair<cb::x509::Status, std::string> SslContext::getCertUserName() {
     cb::openssl::unique_x509_ptr cert(SSL_get_peer_certificate(client));
     return settings.lookupUser(cert.get());
@@ -191,6 +364,11 @@ void SslContext::drainBioRecvPipe(SOCKET sfd) {
 }
 
 void SslContext::drainBioSendPipe(SOCKET sfd) {
+    if (kernelSend) {
+        drainKernelSendPipe(sfd);
+        return;
+    }
+
     bool stop;
 
     do {
@@ -262,6 +440,7 @@ cJSON* SslContext::toJSON() const {
     if (enabled) {
         cJSON_AddBoolToObject(obj, "connected", connected);
         cJSON_AddBoolToObject(obj, "error", error);
+        cJSON_AddBoolToObject(obj, "ktls", kernelSend);
         cJSON_AddNumberToObject(obj, "total_recv", totalRecv);
         cJSON_AddNumberToObject(obj, "total_send", totalSend);
     }
@@ -0,0 +1,250 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include "ssl_session_cache.h"
+
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <cstring>
+
+SslSessionCache& SslSessionCache::getInstance() {
+    static SslSessionCache instance;
+    return instance;
+}
+
+void SslSessionCache::configure(SSL_CTX* ctx, const std::string& context) {
+    // The session id context is limited to 32 bytes, so use a digest
+    // of the provided context
+    unsigned char sid_ctx[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(context.data()),
+           context.size(),
+           sid_ctx);
+    SSL_CTX_set_session_id_context(ctx, sid_ctx, sizeof(sid_ctx));
+
+    std::lock_guard<std::mutex> guard(mutex);
+    SSL_CTX_set_timeout(ctx, long(timeout.count()));
+    if (cacheSize == 0) {
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    } else {
+        SSL_CTX_set_session_cache_mode(
+                ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+        // No remove callback is installed as OpenSSL removes the session
+        // of every connection which isn't shut down cleanly (and most
+        // clients just close the socket). Sessions are removed from the
+        // cache when they expire or are evicted.
+        SSL_CTX_sess_set_new_cb(ctx, newSessionCallback);
+        SSL_CTX_sess_set_get_cb(ctx, getSessionCallback);
+    }
+
+    if (ticketsEnabled) {
+        SSL_CTX_set_tlsext_ticket_key_cb(ctx, ticketKeyCallback);
+    } else {
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    }
+}
+
+void SslSessionCache::setCacheSize(size_t size) {
+    std::lock_guard<std::mutex> guard(mutex);
+    cacheSize = size;
+    evict();
+}
+
+void SslSessionCache::setTimeout(std::chrono::seconds value) {
+    std::lock_guard<std::mutex> guard(mutex);
+    timeout = value;
+}
+
+void SslSessionCache::setTicketsEnabled(bool enabled) {
+    std::lock_guard<std::mutex> guard(mutex);
+    ticketsEnabled = enabled;
+}
+
+void SslSessionCache::rotateTicketKeys() {
+    std::lock_guard<std::mutex> guard(mutex);
+    installTicketKey();
+}
+
+void SslSessionCache::clear() {
+    std::lock_guard<std::mutex> guard(mutex);
+    sessions.clear();
+    lru.clear();
+}
+
+size_t SslSessionCache::size() const {
+    std::lock_guard<std::mutex> guard(mutex);
+    return lru.size();
+}
+
+void SslSessionCache::store(SSL_SESSION* session) {
+    unsigned int idlen;
+    const auto* id = SSL_SESSION_get_id(session, &idlen);
+    const int length = i2d_SSL_SESSION(session, nullptr);
+    if (length <= 0 || idlen == 0) {
+        return;
+    }
+
+    Entry entry;
+    entry.id.assign(reinterpret_cast<const char*>(id), idlen);
+    entry.session.resize(length);
+    auto* ptr = entry.session.data();
+    i2d_SSL_SESSION(session, &ptr);
+
+    std::lock_guard<std::mutex> guard(mutex);
+    if (cacheSize == 0) {
+        return;
+    }
+    entry.expiry = std::chrono::steady_clock::now() + timeout;
+
+    auto iter = sessions.find(entry.id);
+    if (iter != sessions.end()) {
+        lru.erase(iter->second);
+        sessions.erase(iter);
+    }
+    lru.emplace_front(std::move(entry));
+    sessions[lru.front().id] = lru.begin();
+    evict();
+}
+
+SSL_SESSION* SslSessionCache::lookup(const unsigned char* id, int length) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto iter = sessions.find(
+            std::string(reinterpret_cast<const char*>(id), length));
+    if (iter == sessions.end()) {
+        return nullptr;
+    }
+
+    auto entry = iter->second;
+    if (entry->expiry < std::chrono::steady_clock::now()) {
+        lru.erase(entry);
+        sessions.erase(iter);
+        return nullptr;
+    }
+
+    lru.splice(lru.begin(), lru, entry);
+    const unsigned char* ptr = entry->session.data();
+    return d2i_SSL_SESSION(nullptr, &ptr, long(entry->session.size()));
+}
+
+void SslSessionCache::evict() {
+    while (lru.size() > cacheSize) {
+        sessions.erase(lru.back().id);
+        lru.pop_back();
+    }
+}
+
+bool SslSessionCache::installTicketKey() {
+    TicketKey next;
+    if (RAND_bytes(next.name, sizeof(next.name)) != 1 ||
+        RAND_bytes(next.aes, sizeof(next.aes)) != 1 ||
+        RAND_bytes(next.hmac, sizeof(next.hmac)) != 1) {
+        OPENSSL_cleanse(&next, sizeof(next));
+        return false;
+    }
+    next.created = std::chrono::steady_clock::now();
+
+    ticketKeys[1] = ticketKeys[0];
+    havePreviousTicketKey = haveTicketKey;
+    ticketKeys[0] = next;
+    haveTicketKey = true;
+    OPENSSL_cleanse(&next, sizeof(next));
+    return true;
+}
+
+bool SslSessionCache::maybeRotateTicketKeys() {
+    if (haveTicketKey &&
+        std::chrono::steady_clock::now() - ticketKeys[0].created < timeout) {
+        return true;
+    }
+
+    // Keep on using the old key (if we have one) if we fail to generate
+    // a new one
+    return installTicketKey() || haveTicketKey;
+}
+
+int SslSessionCache::ticketKey(unsigned char* name,
+                               unsigned char* iv,
+                               EVP_CIPHER_CTX* ectx,
+                               HMAC_CTX* hctx,
+                               int enc) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!maybeRotateTicketKeys()) {
+        return enc ? -1 : 0;
+    }
+
+    if (enc) {
+        const auto& key = ticketKeys[0];
+        if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1) {
+            return -1;
+        }
+        memcpy(name, key.name, sizeof(key.name));
+        if (EVP_EncryptInit_ex(ectx, EVP_aes_256_cbc(), nullptr, key.aes, iv) !=
+                    1 ||
+            HMAC_Init_ex(hctx, key.hmac, sizeof(key.hmac), EVP_sha256(),
+                         nullptr) != 1) {
+            return -1;
+        }
+        return 1;
+    }
+
+    for (int ii = 0; ii < (havePreviousTicketKey ? 2 : 1); ++ii) {
+        const auto& key = ticketKeys[ii];
+        if (memcmp(name, key.name, sizeof(key.name)) == 0) {
+            if (HMAC_Init_ex(hctx, key.hmac, sizeof(key.hmac), EVP_sha256(),
+                             nullptr) != 1 ||
+                EVP_DecryptInit_ex(ectx, EVP_aes_256_cbc(), nullptr, key.aes,
+                                   iv) != 1) {
+                return -1;
+            }
+            // Ask OpenSSL to issue a new ticket (with the current key) if
+            // the ticket was encrypted with the previous key
+            return ii == 0 ? 1 : 2;
+        }
+    }
+
+    // Unknown (or expired) key; perform a full handshake
+    return 0;
+}
+
+int SslSessionCache::newSessionCallback(SSL*, SSL_SESSION* session) {
+    getInstance().store(session);
+    // We don't keep a reference to the session
+    return 0;
+}
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+SSL_SESSION* SslSessionCache::getSessionCallback(SSL*,
+                                                 unsigned char* id,
+                                                 int length,
+                                                 int* copy) {
+#else
+SSL_SESSION* SslSessionCache::getSessionCallback(SSL*,
+                                                 const unsigned char* id,
+                                                 int length,
+                                                 int* copy) {
+#endif
+    // The returned session is a new object owned by OpenSSL
+    *copy = 0;
+    return getInstance().lookup(id, length);
+}
+
+int SslSessionCache::ticketKeyCallback(SSL*,
+                                       unsigned char* name,
+                                       unsigned char* iv,
+                                       EVP_CIPHER_CTX* ectx,
+                                       HMAC_CTX* hctx,
+                                       int enc) {
+    return getInstance().ticketKey(name, iv, ectx, hctx, enc);
+}
@@ -0,0 +1,153 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#pragma once
+
+#include <memcached/openssl.h>
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The SslSessionCache allows clients to resume their TLS session when they
+ * reconnect, so that they don't have to perform a full handshake (with the
+ * expensive public key operations) every time.
+ *
+ * Each connection use its own SSL_CTX (see SslContext), so we can't use
+ * the session cache and ticket keys OpenSSL keeps within the SSL_CTX.
+ * Instead all of the contexts are configured to use this process wide
+ * object for:
+ *
+ *   * Session IDs - The sessions are serialized and kept in a LRU list
+ *                   with a configurable size.
+ *   * Session tickets - The sessions are encrypted with a key shared by all
+ *                       of the connections. The key is replaced once it is
+ *                       older than the session timeout. Tickets encrypted
+ *                       with the previous key are still accepted (and
+ *                       renewed), so no valid ticket gets rejected.
+ */
+class SslSessionCache {
+public:
+    static SslSessionCache& getInstance();
+
+    /**
+     * Configure session resumption for a newly created context. This
+     * must be called before any SSL objects are created from the context.
+     *
+     * @param ctx the context to configure
+     * @param context sessions are only resumed by contexts configured with
+     *                the same context string (it should identify the
+     *                certificate and client certificate settings in use)
+     */
+    void configure(SSL_CTX* ctx, const std::string& context);
+
+    /**
+     * Set the maximum number of sessions in the cache. Setting it to 0
+     * disables the server side cache (tickets may still be used).
+     */
+    void setCacheSize(size_t size);
+
+    /**
+     * Set the number of seconds a session may be resumed. This is also
+     * the interval between each rotation of the ticket key.
+     */
+    void setTimeout(std::chrono::seconds timeout);
+
+    /// Should session tickets be issued (and accepted) or not
+    void setTicketsEnabled(bool enabled);
+
+    /**
+     * Generate a new ticket key. Tickets encrypted with the current key
+     * will still be accepted until the next rotation.
+     */
+    void rotateTicketKeys();
+
+    /// Remove all of the sessions from the cache
+    void clear();
+
+    /// Get the number of sessions in the cache
+    size_t size() const;
+
+protected:
+    SslSessionCache() = default;
+
+    struct TicketKey {
+        unsigned char name[16];
+        unsigned char aes[32];
+        unsigned char hmac[32];
+        std::chrono::steady_clock::time_point created;
+    };
+
+    struct Entry {
+        std::string id;
+        std::vector<uint8_t> session;
+        std::chrono::steady_clock::time_point expiry;
+    };
+
+    void store(SSL_SESSION* session);
+    SSL_SESSION* lookup(const unsigned char* id, int length);
+    int ticketKey(unsigned char* name,
+                  unsigned char* iv,
+                  EVP_CIPHER_CTX* ectx,
+                  HMAC_CTX* hctx,
+                  int enc);
+
+    // The following methods must be called with the mutex held
+
+    /// Rotate the ticket keys if the current key is too old
+    bool maybeRotateTicketKeys();
+    /// Generate a new current ticket key
+    bool installTicketKey();
+    /// Trim the cache to the configured size
+    void evict();
+
+    static int newSessionCallback(SSL* ssl, SSL_SESSION* session);
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    static SSL_SESSION* getSessionCallback(SSL* ssl,
+                                           unsigned char* id,
+                                           int length,
+                                           int* copy);
+#else
+    static SSL_SESSION* getSessionCallback(SSL* ssl,
+                                           const unsigned char* id,
+                                           int length,
+                                           int* copy);
+#endif
+    static int ticketKeyCallback(SSL* ssl,
+                                 unsigned char* name,
+                                 unsigned char* iv,
+                                 EVP_CIPHER_CTX* ectx,
+                                 HMAC_CTX* hctx,
+                                 int enc);
+
+    mutable std::mutex mutex;
+    size_t cacheSize = 10240;
+    std::chrono::seconds timeout{300};
+    bool ticketsEnabled = true;
+
+    /// The sessions, ordered with the most recently used first
+    std::list<Entry> lru;
+    std::unordered_map<std::string, std::list<Entry>::iterator> sessions;
+
+    bool haveTicketKey = false;
+    bool havePreviousTicketKey = false;
+    TicketKey ticketKeys[2];
+};
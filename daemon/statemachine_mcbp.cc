@@ -456,6 +456,7 @@ bool conn_send_data(McbpConnection& connection) {
         // Release all allocated resources
         connection.releaseTempAlloc();
         connection.releaseReservedItems();
+        connection.getCookieObject().flushTraceLog();
 
         // We're done sending the response to the client. Enter the next
         // state in the state machine
@@ -201,13 +201,14 @@ public:
                   int backlog_,
                   bool management_)
         : port(port_),
-          curr_conns(1),
+          curr_conns(0),
           maxconns(0),
           host(host_),
           backlog(backlog_),
           ipv6(false),
           ipv4(false),
           tcp_nodelay(tcp_nodelay_),
+          reuseport(false),
           management(management_) {
     }
 
@@ -218,7 +219,11 @@ public:
      */
     const in_port_t port;
 
-    /** The current number of connections connected to this port */
+    /**
+     * The current number of clients connected to this port (the listen
+     * connections, one per address family and thread accepting clients,
+     * are not included)
+     */
     int curr_conns;
 
     /** The maximum number of connections allowed for this port */
@@ -254,6 +259,8 @@ public:
     bool ipv4;
     /** Should TCP_NODELAY be enabled or not */
     bool tcp_nodelay;
+    /** Do the worker threads accept clients on their own sockets */
+    bool reuseport;
     // You can't change the purpose of a port dynamically (It is only
     // used during startup
     const bool management;
@@ -278,6 +285,12 @@ struct stats {
     /** The number of times I reject a client */
     Couchbase::RelaxedAtomic<uint64_t> rejected_conns;
 
+    /** The number of SSL handshakes which created a new session */
+    Couchbase::RelaxedAtomic<uint64_t> ssl_handshakes_full;
+
+    /** The number of SSL handshakes which resumed an existing session */
+    Couchbase::RelaxedAtomic<uint64_t> ssl_handshakes_resumed;
+
     std::vector<ListeningPort> listening_ports;
 };
 
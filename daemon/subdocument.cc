@@ -668,6 +668,26 @@ subdoc_operate_one_path(SubdocCmdContext& context, SubdocCmdContext::OperationSp
     }
 }
 
+/**
+ * Complete the lookup defined by {spec} from its entry in the path index.
+ */
+static protocol_binary_response_status subdoc_lookup_indexed(
+        SubdocCmdContext::OperationSpec& spec,
+        const SubdocPathIndex::Entry& entry) {
+    switch (entry.status) {
+    case SubdocPathIndex::Status::Success:
+        spec.result.set_matchloc({entry.value.buf, entry.value.len});
+        return PROTOCOL_BINARY_RESPONSE_SUCCESS;
+
+    case SubdocPathIndex::Status::PathEnoent:
+        return PROTOCOL_BINARY_RESPONSE_SUBDOC_PATH_ENOENT;
+
+    case SubdocPathIndex::Status::PathMismatch:
+        return PROTOCOL_BINARY_RESPONSE_SUBDOC_PATH_MISMATCH;
+    }
+    return PROTOCOL_BINARY_RESPONSE_EINTERNAL;
+}
+
 /**
  * Perform the wholedoc (mcbp) operation defined by spec
  */
@@ -698,6 +718,46 @@ static protocol_binary_response_status subdoc_operate_wholedoc(
     }
 }
 
+/**
+ * Copy the document described by the iovecs of {result} into a new
+ * contiguous buffer, and point {doc} at it.
+ *
+ * @param result the result of the mutation which created the document
+ * @param doc updated to refer to the new document
+ * @param temp_buffer where to store the new document. The previous content
+ *                    is freed (it may be the source of some of the iovecs
+ *                    so must not be written to).
+ *
+ * @throws std::bad_alloc if allocation fails
+ */
+static void flatten_newdoc(const Subdoc::Result& result,
+                           cb::const_char_buffer& doc,
+                           std::unique_ptr<char[]>& temp_buffer) {
+    // Determine how much space we now need.
+    size_t new_doc_len = 0;
+    for (auto& loc : result.newdoc()) {
+        new_doc_len += loc.length;
+    }
+
+    // Allocate an extra byte to make sure we can zero term it
+    // (in case we want to use cJSON_Parse() ;-)
+    std::unique_ptr<char[]> temp(new char[new_doc_len + 1]);
+    temp[new_doc_len] = '\0';
+
+    size_t offset = 0;
+    for (auto& loc : result.newdoc()) {
+        std::memcpy(temp.get() + offset, loc.at, loc.length);
+        offset += loc.length;
+    }
+
+    // Copying complete - safe to delete the old temp_doc
+    // (even if it was the source of some of the newdoc
+    // iovecs).
+    temp_buffer.swap(temp);
+    doc.buf = temp_buffer.get();
+    doc.len = new_doc_len;
+}
+
 /**
  * Run through all of the subdoc operations for the current phase on
  * a single 'document' (either the user document, or a XATTR).
@@ -707,8 +767,11 @@ static protocol_binary_response_status subdoc_operate_wholedoc(
  * @param doc_datatype The datatype of the document.
  * @param temp_buffer where to store the data for our temporary buffer
  *                    allocations if we need to change the doc.
- * @param modified set to true upon return if any modifications happened
- *                 to the input document.
+ * @param newdoc set upon return to the result of the last mutation if any
+ *               modifications happened to the input document, else
+ *               nullptr. The modified document is left as the iovecs of
+ *               that result (which may refer to {doc} and {temp_buffer}),
+ *               so the caller can copy it straight to its destination.
  * @return true if we should continue processing this request,
  *         false if we've sent the error packet and should temrinate
  *               execution for this request
@@ -719,17 +782,38 @@ static bool operate_single_doc(SubdocCmdContext& context,
                                 cb::const_char_buffer& doc,
                                 protocol_binary_datatype_t doc_datatype,
                                 std::unique_ptr<char[]>& temp_buffer,
-                                bool& modified) {
-    modified = false;
+                                const Subdoc::Result*& newdoc) {
+    newdoc = nullptr;
     auto& operations = context.getOperations();
 
+    // 1. For multi-path lookups locate all of the paths with a single pass
+    //    over the document. Mutations can't use this as each one changes
+    //    the document (and hence the offsets) for the next.
+    const bool indexed = mcbp::datatype::is_json(doc_datatype) &&
+                         context.build_path_index(doc);
+
     // 2. Perform each of the operations on document.
     for (auto op = operations.begin(); op != operations.end(); op++) {
+        if (newdoc != nullptr) {
+            // The next operation needs the output of the previous one as a
+            // contiguous input region. (Ideally subjson would take an iovec
+            // as input, or all of the multipaths at once.)
+            flatten_newdoc(*newdoc, doc, temp_buffer);
+            newdoc = nullptr;
+        }
+
         switch (op->traits.scope) {
         case CommandScope::SubJSON:
             if (mcbp::datatype::is_json(doc_datatype)) {
                 // Got JSON, perform the operation.
-                op->status = subdoc_operate_one_path(context, *op, doc);
+                const auto* entry =
+                        indexed ? context.path_index.find(op - operations.begin())
+                                : nullptr;
+                if (entry != nullptr) {
+                    op->status = subdoc_lookup_indexed(*op, *entry);
+                } else {
+                    op->status = subdoc_operate_one_path(context, *op, doc);
+                }
             } else {
                 // No good; need to have JSON.
                 op->status = PROTOCOL_BINARY_RESPONSE_SUBDOC_DOC_NOTJSON;
@@ -742,41 +826,7 @@ static bool operate_single_doc(SubdocCmdContext& context,
 
         if (op->status == PROTOCOL_BINARY_RESPONSE_SUCCESS) {
             if (context.traits.is_mutator) {
-                modified = true;
-
-                // Determine how much space we now need.
-                size_t new_doc_len = 0;
-                for (auto& loc : op->result.newdoc()) {
-                    new_doc_len += loc.length;
-                }
-
-                // TODO-PERF: We need to create a contiguous input
-                // region for the next subjson call, from the set of
-                // iovecs in the result. We can't simply write into
-                // the dynamic_buffer, as that may be the underlying
-                // storage for iovecs from the result. Ideally we'd
-                // either permit subjson to take an iovec as input, or
-                // permit subjson to take all the multipaths at once.
-                // For now we make a contiguous region in a temporary
-                // std::vector, and point in_doc at that.
-
-                // Allocate an extra byte to make sure we can zero term it
-                // (in case we want to use cJSON_Parse() ;-)
-                std::unique_ptr<char[]> temp(new char[new_doc_len + 1]);
-                temp[new_doc_len] = '\0';
-
-                size_t offset = 0;
-                for (auto& loc : op->result.newdoc()) {
-                    std::memcpy(temp.get() + offset, loc.at, loc.length);
-                    offset += loc.length;
-                }
-
-                // Copying complete - safe to delete the old temp_doc
-                // (even if it was the source of some of the newdoc
-                // iovecs).
-                temp_buffer.swap(temp);
-                doc.buf = temp_buffer.get();
-                doc.len = new_doc_len;
+                newdoc = &op->result;
             } else { // lookup
                 // nothing to do.
             }
@@ -1058,12 +1108,12 @@ static bool do_xattr_phase(SubdocCmdContext& context) {
     context.generate_macro_padding(document, cb::xattr::macros::CAS);
     context.generate_macro_padding(document, cb::xattr::macros::SEQNO);
 
-    bool modified;
+    const Subdoc::Result* newdoc;
     if (!operate_single_doc(context,
                             document,
                             PROTOCOL_BINARY_DATATYPE_JSON,
                             temp_doc,
-                            modified)) {
+                            newdoc)) {
         // Something failed..
         return false;
     }
@@ -1073,9 +1123,10 @@ static bool do_xattr_phase(SubdocCmdContext& context) {
     }
 
     // We didn't change anything in the document so just drop everything
-    if (!modified) {
+    if (newdoc == nullptr) {
         return true;
     }
+    flatten_newdoc(*newdoc, document, temp_doc);
 
     // Time to rebuild the full document.
     // As a temporary solution we did create a full JSON doc for the
@@ -1124,36 +1175,33 @@ static bool do_body_phase(SubdocCmdContext& context) {
     }
 
     std::unique_ptr<char[]> temp_doc;
-    bool modified;
+    const Subdoc::Result* newdoc;
 
     if (!operate_single_doc(
-                context, document, context.in_datatype, temp_doc, modified)) {
+                context, document, context.in_datatype, temp_doc, newdoc)) {
         return false;
     }
 
-    // We didn't change anything in the document so just drop everything
-    if (!modified) {
+    // We didn't change anything in the document (or one of the mutations
+    // failed) so just drop everything
+    if (newdoc == nullptr ||
+        context.overall_status != PROTOCOL_BINARY_RESPONSE_SUCCESS) {
         return true;
     }
 
-    // There isn't any xattrs associated with the document. We shouldn't
-    // reallocate and move things around but just reuse the temporary
-    // buffer we've already created.
-    if (xattrsize == 0) {
-        context.temp_doc.swap(temp_doc);
-        context.in_doc = { context.temp_doc.get(), document.len };
-        return true;
+    // Rather than building the full document here only to copy it again
+    // into the new item, record where its pieces are (the xattrs followed
+    // by the modified body) and let subdoc_update() copy them directly
+    // into the item. The body may refer to the intermediate document of a
+    // multi-path mutation, so keep that alive too.
+    context.splice_doc.swap(temp_doc);
+    context.out_splice.clear();
+    if (xattrsize != 0) {
+        context.out_splice.emplace_back(context.in_doc.buf, xattrsize);
+    }
+    for (auto& loc : newdoc->newdoc()) {
+        context.out_splice.emplace_back(loc.at, loc.length);
     }
-
-    // Time to rebuild the full document.
-    auto total = xattrsize + document.len;
-    std::unique_ptr<char[]> full_document(new char[total]);;
-
-    memcpy(full_document.get(), context.in_doc.buf, xattrsize);
-    memcpy(full_document.get() + xattrsize, document.buf, document.len);
-
-    context.temp_doc.swap(full_document);
-    context.in_doc = { context.temp_doc.get(), total };
 
     return true;
 }
@@ -1224,7 +1272,15 @@ static ENGINE_ERROR_CODE subdoc_update(SubdocCmdContext& context,
         !(context.no_sys_xattrs && context.do_delete_doc)) {
 
         if (ret == ENGINE_SUCCESS) {
-            context.out_doc_len = context.in_doc.len;
+            if (context.out_splice.empty()) {
+                // The body wasn't modified; only the xattrs (which have
+                // been rebuilt in in_doc).
+                context.out_splice.push_back(context.in_doc);
+            }
+            context.out_doc_len = 0;
+            for (const auto& piece : context.out_splice) {
+                context.out_doc_len += piece.len;
+            }
             DocKey allocate_key(reinterpret_cast<const uint8_t*>(key),
                                 keylen, connection.getDocNamespace());
 
@@ -1285,9 +1341,13 @@ static ENGINE_ERROR_CODE subdoc_update(SubdocCmdContext& context,
             return ENGINE_FAILED;
         }
 
-        // Copy the new document into the item.
+        // Copy the new document into the item, straight from the pieces
+        // the subjson operation(s) produced.
         char* write_ptr = static_cast<char*>(new_doc_info.value[0].iov_base);
-        std::memcpy(write_ptr, context.in_doc.buf, context.in_doc.len);
+        for (const auto& piece : context.out_splice) {
+            std::memcpy(write_ptr, piece.buf, piece.len);
+            write_ptr += piece.len;
+        }
     }
 
     // And finally, store the new document.
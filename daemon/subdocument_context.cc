@@ -69,6 +69,34 @@ uint64_t SubdocCmdContext::getOperationValueBytesTotal() const {
     return result;
 }
 
+bool SubdocCmdContext::build_path_index(cb::const_char_buffer doc) {
+    path_index.clear();
+    if (traits.is_mutator || traits.path != SubdocPath::MULTI ||
+        currentPhase != Phase::Body) {
+        return false;
+    }
+
+    std::vector<cb::const_char_buffer> paths;
+    size_t lookups = 0;
+    for (const auto& op : getOperations()) {
+        if (op.traits.scope == CommandScope::SubJSON &&
+            (op.traits.subdocCommand == Subdoc::Command::GET ||
+             op.traits.subdocCommand == Subdoc::Command::EXISTS)) {
+            paths.push_back(op.path);
+            ++lookups;
+        } else {
+            paths.push_back({});
+        }
+    }
+
+    // A single path is found quicker by subjson, which stops parsing the
+    // document as soon as it has been matched.
+    if (lookups < 2) {
+        return false;
+    }
+    return path_index.build(doc, paths);
+}
+
 template <typename T>
 std::string SubdocCmdContext::macroToString(T macroValue) {
     std::stringstream ss;
@@ -19,6 +19,7 @@
 
 #include "memcached.h"
 
+#include "subdocument_path_index.h"
 #include "subdocument_traits.h"
 #include "xattr/utils.h"
 
@@ -131,6 +132,17 @@ public:
     // Returns the total size of all Operation values (bytes).
     uint64_t getOperationValueBytesTotal() const;
 
+    /**
+     * [Multi-path lookups only] Build {path_index} for the operations of
+     * the current phase over the given document, so all of their paths are
+     * located with a single pass over it rather than one subjson parse per
+     * path.
+     *
+     * @param doc the document the operations will be performed on
+     * @return true if the index was built and should be consulted
+     */
+    bool build_path_index(cb::const_char_buffer doc);
+
     // Cookie this command is associated with.
     Cookie& cookie;
 
@@ -158,6 +170,10 @@ public:
     // as input for the next multi-path mutation.
     std::unique_ptr<char[]> temp_doc;
 
+    // [Multi-path lookups only] The locations of the operations' paths in
+    // the document body. Positions match getOperations(Phase::Body).
+    SubdocPathIndex path_index;
+
     // Temporary buffer used to hold the xattrs in use, as a get request
     // may hold pointers into the repacked xattr buckets
     std::unique_ptr<uint8_t[]> xattr_buffer;
@@ -201,6 +217,16 @@ public:
     uint64_t vbucket_uuid = 0;
     uint64_t sequence_no = 0;
 
+    // [Mutations only] The new document, as the pieces to concatenate: the
+    // unchanged xattrs (in {in_doc}) followed by the iovecs of the last
+    // mutation's result. Empty if the body was not modified (in which case
+    // {in_doc} is the new document).
+    std::vector<cb::const_char_buffer> out_splice;
+
+    // [Mutations only] The intermediate result document of a multi-path
+    // mutation, which {out_splice} may refer to.
+    std::unique_ptr<char[]> splice_doc;
+
     // [Mutations only] Size in bytes of the new item to store into engine.
     // Held in the context so upon success we can update statistics.
     size_t out_doc_len = 0;
@@ -0,0 +1,600 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "subdocument_path_index.h"
+
+#include <cstring>
+
+/**
+ * Recursive descent parser which walks the document once, following all of
+ * the (still unresolved) paths which match the current position.
+ *
+ * Values which no path descends into are skipped, but still validated so
+ * an invalid document is never indexed.
+ */
+class SubdocPathIndex::Parser {
+public:
+    enum class Result {
+        // Keep parsing.
+        Continue,
+        // All paths have been resolved; stop parsing.
+        Done,
+        // The document cannot be indexed.
+        Abort
+    };
+
+    Parser(cb::const_char_buffer doc, std::vector<Path>& paths)
+        : p(doc.buf), end(doc.buf + doc.len), paths(paths) {
+    }
+
+    bool run() {
+        Active active;
+        for (size_t ii = 0; ii < paths.size(); ++ii) {
+            if (paths[ii].indexed) {
+                active.push_back(ii);
+            }
+        }
+        unresolved = active.size();
+
+        switch (parseValue(active, 0, 0)) {
+        case Result::Abort:
+            return false;
+        case Result::Done:
+            return true;
+        case Result::Continue:
+            break;
+        }
+        skipWhitespace();
+        return p == end;
+    }
+
+private:
+    /// The positions (in paths) of the paths being followed.
+    using Active = std::vector<size_t>;
+
+    void resolve(Path& path, Status status, cb::const_char_buffer value = {}) {
+        path.entry = {status, value};
+        path.resolved = true;
+        --unresolved;
+    }
+
+    /**
+     * The result once a value at the given depth has been completely
+     * parsed. After the root value the rest of the document is checked, as
+     * subjson would for the paths which weren't found.
+     */
+    Result completed(size_t depth) const {
+        return unresolved == 0 && depth > 0 ? Result::Done : Result::Continue;
+    }
+
+    Result parseValue(const Active& active, size_t level, size_t depth);
+    Result parseObject(const Active& active, size_t level, size_t depth);
+    Result parseArray(const Active& active, size_t level, size_t depth);
+
+    Result skipValue(size_t depth) {
+        return skip(depth) ? Result::Continue : Result::Abort;
+    }
+
+    bool skip(size_t depth);
+    bool skipString(bool& escaped);
+    bool skipNumber();
+    bool skipLiteral(const char* literal, size_t length);
+
+    void skipWhitespace() {
+        while (p < end &&
+               (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+            ++p;
+        }
+    }
+
+    /// Consume the given character (after any whitespace).
+    bool expect(char c) {
+        skipWhitespace();
+        if (p == end || *p != c) {
+            return false;
+        }
+        ++p;
+        return true;
+    }
+
+    const char* p;
+    const char* const end;
+    std::vector<Path>& paths;
+    size_t unresolved = 0;
+};
+
+SubdocPathIndex::Parser::Result SubdocPathIndex::Parser::parseValue(
+        const Active& active, size_t level, size_t depth) {
+    skipWhitespace();
+    if (p == end) {
+        return Result::Abort;
+    }
+
+    // Split into the paths which end at this value and those which need to
+    // descend into it.
+    Active matched;
+    Active descend;
+    for (auto idx : active) {
+        if (paths[idx].components.size() == level) {
+            matched.push_back(idx);
+        } else {
+            descend.push_back(idx);
+        }
+    }
+
+    const char* start = p;
+    Result result;
+    if (descend.empty()) {
+        result = skipValue(depth);
+    } else if (*p == '{') {
+        result = parseObject(descend, level, depth);
+    } else if (*p == '[') {
+        result = parseArray(descend, level, depth);
+    } else {
+        for (auto idx : descend) {
+            resolve(paths[idx], Status::PathMismatch);
+        }
+        result = skipValue(depth);
+    }
+
+    // Note a path ending here is still unresolved, so Done can only be
+    // returned once the value has been completely parsed.
+    if (result != Result::Continue) {
+        return result;
+    }
+    for (auto idx : matched) {
+        resolve(paths[idx], Status::Success, {start, size_t(p - start)});
+    }
+    return completed(depth);
+}
+
+SubdocPathIndex::Parser::Result SubdocPathIndex::Parser::parseObject(
+        const Active& active, size_t level, size_t depth) {
+    if (depth + 1 >= MaxDepth) {
+        return Result::Abort;
+    }
+    ++p;
+
+    Active keyed;
+    for (auto idx : active) {
+        if (paths[idx].components[level].key.buf == nullptr) {
+            resolve(paths[idx], Status::PathMismatch);
+        } else {
+            keyed.push_back(idx);
+        }
+    }
+    if (unresolved == 0) {
+        return Result::Done;
+    }
+
+    skipWhitespace();
+    if (p < end && *p == '}') {
+        ++p;
+    } else {
+        while (true) {
+            skipWhitespace();
+            if (p == end || *p != '"') {
+                return Result::Abort;
+            }
+            const char* keyStart = p + 1;
+            bool escaped;
+            if (!skipString(escaped)) {
+                return Result::Abort;
+            }
+            const size_t keyLen = size_t(p - 1 - keyStart);
+            if (!expect(':')) {
+                return Result::Abort;
+            }
+
+            Active child;
+            for (auto idx : keyed) {
+                auto& path = paths[idx];
+                if (path.resolved) {
+                    continue;
+                }
+                if (escaped) {
+                    // Don't try to second guess how subjson matches keys
+                    // containing escape sequences.
+                    return Result::Abort;
+                }
+                const auto& key = path.components[level].key;
+                if (key.len == keyLen &&
+                    std::memcmp(key.buf, keyStart, keyLen) == 0) {
+                    child.push_back(idx);
+                }
+            }
+
+            const auto result = child.empty()
+                                        ? skipValue(depth + 1)
+                                        : parseValue(child, level + 1, depth + 1);
+            if (result != Result::Continue) {
+                return result;
+            }
+
+            skipWhitespace();
+            if (p == end) {
+                return Result::Abort;
+            }
+            if (*p == '}') {
+                ++p;
+                break;
+            }
+            if (*p != ',') {
+                return Result::Abort;
+            }
+            ++p;
+        }
+    }
+
+    for (auto idx : keyed) {
+        if (!paths[idx].resolved) {
+            resolve(paths[idx], Status::PathEnoent);
+        }
+    }
+    return completed(depth);
+}
+
+SubdocPathIndex::Parser::Result SubdocPathIndex::Parser::parseArray(
+        const Active& active, size_t level, size_t depth) {
+    if (depth + 1 >= MaxDepth) {
+        return Result::Abort;
+    }
+    ++p;
+
+    Active indexed;
+    Active last;
+    for (auto idx : active) {
+        const auto& component = paths[idx].components[level];
+        if (component.key.buf != nullptr) {
+            resolve(paths[idx], Status::PathMismatch);
+        } else if (component.index == -1) {
+            last.push_back(idx);
+        } else {
+            indexed.push_back(idx);
+        }
+    }
+    if (unresolved == 0) {
+        return Result::Done;
+    }
+
+    int64_t count = 0;
+    const char* lastStart = nullptr;
+    skipWhitespace();
+    if (p < end && *p == ']') {
+        ++p;
+    } else {
+        while (true) {
+            skipWhitespace();
+            lastStart = p;
+
+            Active child;
+            for (auto idx : indexed) {
+                if (!paths[idx].resolved &&
+                    paths[idx].components[level].index == count) {
+                    child.push_back(idx);
+                }
+            }
+
+            const auto result = child.empty()
+                                        ? skipValue(depth + 1)
+                                        : parseValue(child, level + 1, depth + 1);
+            if (result != Result::Continue) {
+                return result;
+            }
+            ++count;
+
+            skipWhitespace();
+            if (p == end) {
+                return Result::Abort;
+            }
+            if (*p == ']') {
+                ++p;
+                break;
+            }
+            if (*p != ',') {
+                return Result::Abort;
+            }
+            ++p;
+        }
+    }
+
+    for (auto idx : indexed) {
+        if (!paths[idx].resolved) {
+            resolve(paths[idx], Status::PathEnoent);
+        }
+    }
+
+    if (!last.empty()) {
+        if (count == 0) {
+            for (auto idx : last) {
+                resolve(paths[idx], Status::PathEnoent);
+            }
+        } else {
+            // The last element is only known once the array has been
+            // parsed; go back and follow the [-1] paths into it.
+            const char* after = p;
+            p = lastStart;
+            const auto result = parseValue(last, level + 1, depth + 1);
+            if (result != Result::Continue) {
+                return result;
+            }
+            p = after;
+        }
+    }
+    return completed(depth);
+}
+
+bool SubdocPathIndex::Parser::skip(size_t depth) {
+    skipWhitespace();
+    if (p == end) {
+        return false;
+    }
+
+    switch (*p) {
+    case '{':
+        if (depth + 1 >= MaxDepth) {
+            return false;
+        }
+        ++p;
+        skipWhitespace();
+        if (p < end && *p == '}') {
+            ++p;
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            bool escaped;
+            if (p == end || *p != '"' || !skipString(escaped) ||
+                !expect(':') || !skip(depth + 1)) {
+                return false;
+            }
+            skipWhitespace();
+            if (p == end) {
+                return false;
+            }
+            if (*p++ == '}') {
+                return true;
+            }
+            if (p[-1] != ',') {
+                return false;
+            }
+        }
+
+    case '[':
+        if (depth + 1 >= MaxDepth) {
+            return false;
+        }
+        ++p;
+        skipWhitespace();
+        if (p < end && *p == ']') {
+            ++p;
+            return true;
+        }
+        while (true) {
+            if (!skip(depth + 1)) {
+                return false;
+            }
+            skipWhitespace();
+            if (p == end) {
+                return false;
+            }
+            if (*p++ == ']') {
+                return true;
+            }
+            if (p[-1] != ',') {
+                return false;
+            }
+        }
+
+    case '"': {
+        bool escaped;
+        return skipString(escaped);
+    }
+    case 't':
+        return skipLiteral("true", 4);
+    case 'f':
+        return skipLiteral("false", 5);
+    case 'n':
+        return skipLiteral("null", 4);
+    default:
+        return skipNumber();
+    }
+}
+
+bool SubdocPathIndex::Parser::skipString(bool& escaped) {
+    escaped = false;
+    ++p;
+    while (p < end) {
+        const auto c = uint8_t(*p++);
+        if (c == '"') {
+            return true;
+        }
+        if (c < 0x20) {
+            return false;
+        }
+        if (c != '\\') {
+            continue;
+        }
+
+        escaped = true;
+        if (p == end) {
+            return false;
+        }
+        switch (*p) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            ++p;
+            break;
+        case 'u':
+            if (end - p < 5) {
+                return false;
+            }
+            for (int ii = 1; ii < 5; ++ii) {
+                const auto h = p[ii];
+                if (!((h >= '0' && h <= '9') || (h >= 'a' && h <= 'f') ||
+                      (h >= 'A' && h <= 'F'))) {
+                    return false;
+                }
+            }
+            p += 5;
+            break;
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+bool SubdocPathIndex::Parser::skipNumber() {
+    auto isDigit = [this]() { return p < end && *p >= '0' && *p <= '9'; };
+    auto skipDigits = [this, &isDigit]() {
+        if (!isDigit()) {
+            return false;
+        }
+        while (isDigit()) {
+            ++p;
+        }
+        return true;
+    };
+
+    if (p < end && *p == '-') {
+        ++p;
+    }
+    if (p < end && *p == '0') {
+        ++p;
+    } else if (!skipDigits()) {
+        return false;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        if (!skipDigits()) {
+            return false;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p < end && (*p == '+' || *p == '-')) {
+            ++p;
+        }
+        if (!skipDigits()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SubdocPathIndex::Parser::skipLiteral(const char* literal, size_t length) {
+    if (size_t(end - p) < length || std::memcmp(p, literal, length) != 0) {
+        return false;
+    }
+    p += length;
+    return true;
+}
+
+bool SubdocPathIndex::parsePath(cb::const_char_buffer path,
+                                std::vector<Component>& components) {
+    components.clear();
+    const char* p = path.buf;
+    const char* const end = path.buf + path.len;
+    while (p < end) {
+        Component component;
+        if (*p == '[') {
+            ++p;
+            const bool negative = p < end && *p == '-';
+            if (negative) {
+                ++p;
+            }
+            const char* digits = p;
+            while (p < end && *p >= '0' && *p <= '9') {
+                component.index = component.index * 10 + (*p - '0');
+                ++p;
+            }
+            const size_t ndigits = size_t(p - digits);
+            if (p == end || *p != ']' || ndigits == 0 || ndigits > 9 ||
+                (ndigits > 1 && *digits == '0')) {
+                return false;
+            }
+            ++p;
+            if (negative) {
+                if (component.index != 1) {
+                    return false;
+                }
+                component.index = -1;
+            }
+        } else {
+            if (!components.empty()) {
+                if (*p != '.') {
+                    return false;
+                }
+                ++p;
+            }
+            const char* key = p;
+            while (p < end && *p != '.' && *p != '[') {
+                // Escaped (backtick quoted) keys, and characters which
+                // would be escaped in the document, are left to subjson.
+                if (*p == '`' || *p == ']' || *p == '"' || *p == '\\' ||
+                    uint8_t(*p) < 0x20) {
+                    return false;
+                }
+                ++p;
+            }
+            if (p == key) {
+                return false;
+            }
+            component.key = {key, size_t(p - key)};
+        }
+
+        components.push_back(component);
+        if (components.size() >= MaxDepth) {
+            return false;
+        }
+    }
+    return !components.empty();
+}
+
+bool SubdocPathIndex::build(cb::const_char_buffer doc,
+                            const std::vector<cb::const_char_buffer>& in) {
+    paths.clear();
+    paths.resize(in.size());
+
+    bool any = false;
+    for (size_t ii = 0; ii < in.size(); ++ii) {
+        if (in[ii].len != 0 && parsePath(in[ii], paths[ii].components)) {
+            paths[ii].indexed = true;
+            any = true;
+        }
+    }
+
+    if (!any || !Parser(doc, paths).run()) {
+        paths.clear();
+        return false;
+    }
+    return true;
+}
+
+const SubdocPathIndex::Entry* SubdocPathIndex::find(size_t idx) const {
+    if (idx < paths.size() && paths[idx].indexed) {
+        return &paths[idx].entry;
+    }
+    return nullptr;
+}
@@ -0,0 +1,103 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <platform/sized_buffer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Index of the locations of a set of paths in a JSON document, built with a
+ * single pass over the document.
+ *
+ * Used for multi-path lookups, which would otherwise have subjson parse
+ * the document (up to the match) once per path. The index gives the same
+ * result as a subjson GET / EXISTS for the paths it supports; anything it
+ * cannot answer identically is left to subjson:
+ *
+ *  - Paths using syntax other than plain keys and array indices (escaped
+ *    keys, negative indices other than [-1]) are not indexed.
+ *  - If the document is not valid JSON, is nested too deeply, or has keys
+ *    containing escape sequences where a path needs to be matched, no paths
+ *    are indexed.
+ *
+ * Parsing stops as soon as all of the paths have been resolved.
+ */
+class SubdocPathIndex {
+public:
+    enum class Status : uint8_t { Success, PathEnoent, PathMismatch };
+
+    /// The result of looking up one path.
+    struct Entry {
+        Status status;
+        /// [Success only] The value at the path, pointing into the document.
+        cb::const_char_buffer value;
+    };
+
+    /**
+     * Build the index for the given paths over a document.
+     *
+     * @param doc the document; must outlive any use of the index
+     * @param paths the paths to locate. Empty paths are ignored (so callers
+     *              can keep the positions aligned with their operations).
+     * @return true if the document was indexed (and find() may be used),
+     *         false if all paths need to be evaluated by subjson.
+     */
+    bool build(cb::const_char_buffer doc,
+               const std::vector<cb::const_char_buffer>& paths);
+
+    /**
+     * @param idx the position of the path in the vector passed to build()
+     * @return the entry for that path, or nullptr if it was not indexed.
+     */
+    const Entry* find(size_t idx) const;
+
+    /// Discard the index.
+    void clear() {
+        paths.clear();
+    }
+
+    /// The maximum nesting of documents (and number of path components)
+    /// which are indexed. Matches the subjson parser's limit.
+    static const size_t MaxDepth = 32;
+
+private:
+    class Parser;
+
+    /// One component of a path; either an object key or an array index.
+    struct Component {
+        /// The key to match, or {nullptr, 0} for an array index.
+        cb::const_char_buffer key;
+        /// The array index to match; -1 for the last element.
+        int64_t index = 0;
+    };
+
+    struct Path {
+        std::vector<Component> components;
+        Entry entry{Status::PathEnoent, {}};
+        bool indexed = false;
+        bool resolved = false;
+    };
+
+    static bool parsePath(cb::const_char_buffer path,
+                          std::vector<Component>& components);
+
+    std::vector<Path> paths;
+};
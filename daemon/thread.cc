@@ -6,6 +6,7 @@
 #include "memcached.h"
 #include "connections.h"
 
+#include <algorithm>
 #include <atomic>
 #include <stdio.h>
 #include <errno.h>
@@ -17,6 +18,7 @@
 #include <fcntl.h>
 #include <platform/cb_malloc.h>
 #include <platform/platform.h>
+#include <platform/processclock.h>
 #include <platform/strerror.h>
 #include <queue>
 #include <memory>
@@ -100,6 +102,12 @@ void iterate_all_connections(std::function<void(Connection&)> callback) {
     }
 }
 
+void iterate_thread_load(std::function<void(const LIBEVENT_THREAD&)> callback) {
+    for (const auto& thr : threads) {
+        callback(thr);
+    }
+}
+
 static bool create_notification_pipe(LIBEVENT_THREAD& me) {
     int j;
 
@@ -253,6 +261,38 @@ static void dispatch_new_connections(LIBEVENT_THREAD& me) {
             LOG_WARNING("Failed to dispatch event for socket {}",
                         long(item->sfd));
             safe_close(item->sfd);
+            me.load.connections--;
+        }
+    }
+}
+
+/*
+ * Start serving the connections other worker threads moved over to this
+ * thread. They're already bound to this thread and its event base, but
+ * not yet registered in libevent.
+ */
+static void adopt_migrated_connections(LIBEVENT_THREAD& me) {
+    std::vector<McbpConnection*> connections;
+    {
+        std::lock_guard<std::mutex> guard(me.migrated.mutex);
+        connections.swap(me.migrated.connections);
+    }
+
+    for (auto* c : connections) {
+        if (c->getSocketDescriptor() == INVALID_SOCKET ||
+            c->isRegisteredInLibevent()) {
+            // Already picked up by signal_idle_clients()
+            continue;
+        }
+
+        if (!c->registerEvent()) {
+            LOG_WARNING(
+                    "{}: Failed to register migrated connection in libevent. "
+                    "Shutting down connection {}",
+                    c->getId(),
+                    c->getDescription());
+            c->setState(McbpStateMachine::State::closing);
+            run_event_loop(c, EV_READ);
         }
     }
 }
@@ -291,6 +331,8 @@ static void thread_libevent_process(evutil_socket_t fd, short which, void *arg)
 
     std::lock_guard<std::mutex> guard(me.mutex);
 
+    adopt_migrated_connections(me);
+
     auto* pending = me.pending_io;
     me.pending_io = nullptr;
     while (pending != nullptr) {
@@ -426,14 +468,53 @@ void notify_io_complete(gsl::not_null<const void*> void_cookie,
 /* Which thread we assigned a connection to most recently. */
 static int last_thread = -1;
 
+/*
+ * A DCP connection typically moves a lot more data than a normal client,
+ * so it counts as this many connections when comparing thread load.
+ */
+static const uint64_t DcpConnectionWeight = 10;
+
+/*
+ * Don't move connections off a thread unless it was busy for at least
+ * this percentage of the last sample period, and at least
+ * MigrationMinImbalance percent busier than the least busy thread.
+ */
+static const uint32_t MigrationMinUtilisation = 75;
+static const uint32_t MigrationMinImbalance = 25;
+
+/*
+ * The load score of a thread; the number of connections it serves
+ * (weighted by type) plus the percentage of the last second it was busy.
+ */
+static uint64_t get_load_score(const LIBEVENT_THREAD& thread) {
+    return thread.load.connections +
+           thread.load.dcp_connections * (DcpConnectionWeight - 1) +
+           thread.load.utilisation;
+}
+
 /*
  * Dispatches a new connection to another thread. This is only ever called
  * from the main thread, or because of an incoming connection.
+ *
+ * The connection is given to the thread with the lowest load score. The
+ * search starts after the thread picked last time, so connections are
+ * still handed out round-robin while the threads are equally loaded.
  */
 void dispatch_conn_new(SOCKET sfd, int parent_port) {
-    int tid = (last_thread + 1) % settings.getNumWorkerThreads();
+    const int nthr = settings.getNumWorkerThreads();
+    int tid = (last_thread + 1) % nthr;
+    uint64_t lowest = get_load_score(threads[tid]);
+    for (int ii = 1; ii < nthr; ++ii) {
+        const int candidate = (last_thread + 1 + ii) % nthr;
+        const auto score = get_load_score(threads[candidate]);
+        if (score < lowest) {
+            lowest = score;
+            tid = candidate;
+        }
+    }
     auto& thread = threads[tid];
     last_thread = tid;
+    thread.load.connections++;
 
     try {
         std::unique_ptr<ConnectionQueueItem> item(
@@ -443,6 +524,7 @@ void dispatch_conn_new(SOCKET sfd, int parent_port) {
         LOG_WARNING("dispatch_conn_new: Failed to dispatch new connection: {}",
                     e.what());
         safe_close(sfd);
+        thread.load.connections--;
         return ;
     }
 
@@ -450,6 +532,123 @@ void dispatch_conn_new(SOCKET sfd, int parent_port) {
     notify_thread(thread);
 }
 
+void dispatch_conn_local(SOCKET sfd, int parent_port, LIBEVENT_THREAD& thread) {
+    thread.load.connections++;
+    if (conn_new(sfd, parent_port, thread.base, &thread) == nullptr) {
+        LOG_WARNING("Failed to dispatch event for socket {}", long(sfd));
+        safe_close(sfd);
+        thread.load.connections--;
+    }
+}
+
+LIBEVENT_THREAD& get_worker_thread(int index) {
+    return threads.at(index);
+}
+
+void maybe_migrate_connection(Connection& c) {
+    auto* thread = c.getThread();
+    if (thread == nullptr || thread->load.migrate_budget == 0 ||
+        thread->deleting_buckets || memcached_shutdown ||
+        !settings.isConnectionMigration()) {
+        return;
+    }
+
+    auto* mcbp = dynamic_cast<McbpConnection*>(&c);
+    if (mcbp == nullptr || !mcbp->isIdleForMigration() ||
+        list_contains(thread->pending_io, &c)) {
+        return;
+    }
+
+    const int to = thread->load.migrate_to;
+    if (to < 0 || to >= nthreads || to == thread->index) {
+        return;
+    }
+
+    // The dispatcher may reset the budget at any time
+    auto budget = thread->load.migrate_budget.load();
+    do {
+        if (budget == 0) {
+            return;
+        }
+    } while (!thread->load.migrate_budget.compare_exchange_weak(budget,
+                                                                budget - 1));
+
+    auto& target = threads[to];
+    if (!mcbp->unregisterEvent()) {
+        return;
+    }
+    if (!mcbp->assignEventBase(target.base)) {
+        LOG_WARNING("{}: Failed to move connection to worker thread {}",
+                    c.getId(),
+                    to);
+        mcbp->registerEvent();
+        return;
+    }
+
+    LOG_DEBUG("{}: Moving idle connection from worker thread {} to {}",
+              c.getId(),
+              thread->index,
+              to);
+
+    thread->load.connections--;
+    thread->load.migrated_out++;
+    target.load.connections++;
+    target.load.migrated_in++;
+    c.setThread(&target);
+
+    {
+        std::lock_guard<std::mutex> guard(target.migrated.mutex);
+        target.migrated.connections.push_back(mcbp);
+    }
+    notify_thread(target);
+}
+
+void threads_sample_load() {
+    static ProcessClock::time_point last_sample;
+    const auto now = ProcessClock::now();
+    const auto elapsed =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now -
+                                                                 last_sample)
+                    .count();
+    last_sample = now;
+    if (elapsed <= 0) {
+        return;
+    }
+
+    LIBEVENT_THREAD* busiest = nullptr;
+    LIBEVENT_THREAD* idlest = nullptr;
+    for (auto& thr : threads) {
+        const uint64_t busy = thr.load.busy_ns;
+        const uint64_t delta = busy - thr.load.sampled_busy_ns;
+        thr.load.sampled_busy_ns = busy;
+        thr.load.utilisation =
+                uint32_t(std::min(uint64_t(100), delta * 100 / elapsed));
+        thr.load.migrate_budget = 0;
+
+        if (busiest == nullptr ||
+            thr.load.utilisation > busiest->load.utilisation) {
+            busiest = &thr;
+        }
+        if (idlest == nullptr ||
+            thr.load.utilisation < idlest->load.utilisation) {
+            idlest = &thr;
+        }
+    }
+
+    if (!settings.isConnectionMigration() || busiest == idlest) {
+        return;
+    }
+
+    // Move (at most) one idle connection per second off the busiest
+    // thread, so a burst of load doesn't bounce connections around.
+    if (busiest->load.utilisation >= MigrationMinUtilisation &&
+        busiest->load.utilisation - idlest->load.utilisation >=
+                MigrationMinImbalance) {
+        busiest->load.migrate_to = idlest->index;
+        busiest->load.migrate_budget = 1;
+    }
+}
+
 /*
  * Returns true if this is the thread that listens for new TCP connections.
  */
@@ -19,12 +19,42 @@
 #include <platform/platform.h>
 #include "timing_histogram.h"
 
+/// Get the shard used by the calling thread
+static size_t getShard() {
+    static std::atomic<size_t> next{0};
+    static thread_local size_t shard = next++ % Timings::NumShards;
+    return shard;
+}
+
 Timings::Timings() {
+    for (auto& shard : hdr_timings) {
+        for (auto& hdr : shard) {
+            hdr.store(nullptr);
+        }
+    }
     reset();
 }
 
+Timings::~Timings() {
+    for (auto& shard : hdr_timings) {
+        for (auto& hdr : shard) {
+            delete hdr.load();
+        }
+    }
+}
+
 Timings& Timings::operator=(const Timings& other) {
     timings = other.timings;
+    for (size_t shard = 0; shard < NumShards; ++shard) {
+        for (int opcode = 0; opcode < MAX_NUM_OPCODES; ++opcode) {
+            auto* hdr = other.hdr_timings[shard][opcode].load();
+            if (hdr != nullptr) {
+                getShardHistogram(shard, uint8_t(opcode)) = *hdr;
+            } else if (hdr_timings[shard][opcode].load() != nullptr) {
+                hdr_timings[shard][opcode].load()->reset();
+            }
+        }
+    }
     interval_latency_lookups = other.interval_latency_lookups;
     interval_latency_mutations = other.interval_latency_mutations;
     return *this;
@@ -35,6 +65,17 @@ void Timings::reset(void) {
         timings[ii].reset();
     }
 
+    // The histograms may be in use by other threads so we can't release
+    // them
+    for (auto& shard : hdr_timings) {
+        for (auto& hdr : shard) {
+            auto* histogram = hdr.load();
+            if (histogram != nullptr) {
+                histogram->reset();
+            }
+        }
+    }
+
     {
         std::lock_guard<std::mutex> lg(lock);
         interval_latency_lookups.reset();
@@ -45,13 +86,45 @@ void Timings::reset(void) {
 void Timings::collect(const uint8_t opcode,
                       const std::chrono::nanoseconds nsec) {
     timings[opcode].add(nsec);
+    getShardHistogram(getShard(), opcode).add(nsec);
     auto& interval = interval_counters[opcode];
     interval.count++;
     interval.duration_ns += nsec.count();
 }
 
+LatencyHistogram& Timings::getShardHistogram(size_t shard, const uint8_t opcode) {
+    auto& slot = hdr_timings[shard][opcode];
+    auto* histogram = slot.load(std::memory_order_acquire);
+    if (histogram == nullptr) {
+        std::unique_ptr<LatencyHistogram> created(new LatencyHistogram());
+        if (slot.compare_exchange_strong(histogram, created.get())) {
+            histogram = created.release();
+        }
+        // else another thread in the same shard beat us to it, and
+        // histogram now contains its histogram
+    }
+    return *histogram;
+}
+
+LatencyHistogram Timings::getLatencyHistogram(const uint8_t opcode) {
+    LatencyHistogram ret;
+    for (const auto& shard : hdr_timings) {
+        const auto* histogram = shard[opcode].load(std::memory_order_acquire);
+        if (histogram != nullptr) {
+            ret += *histogram;
+        }
+    }
+    return ret;
+}
+
 std::string Timings::generate(const uint8_t opcode) {
-    return timings[opcode].to_string();
+    auto json = timings[opcode].to_json();
+    getLatencyHistogram(opcode).addToJson(json.get());
+
+    char* ptr = cJSON_PrintUnformatted(json.get());
+    std::string ret(ptr);
+    cJSON_Free(ptr);
+    return ret;
 }
 
 static const uint8_t timings_mutations[] = {
@@ -18,10 +18,12 @@
 
 #include <platform/platform.h>
 #include <array>
+#include <atomic>
 #include <string>
 #include <mutex>
 #include <cstdint>
 
+#include "latency_histogram.h"
 #include "timing_histogram.h"
 #include "timing_interval.h"
 
@@ -29,10 +31,21 @@
 
 /** Records timings for each memcached opcode. Each opcode has a histogram of
  * times.
+ *
+ * In addition to the fixed buckets in TimingHistogram the timings are
+ * recorded in HdrHistograms (to be able to report percentiles). To avoid
+ * having all of the worker threads contending on the same histogram each
+ * thread records the samples in its own shard, and the shards are merged
+ * when the timings are requested. The histograms are allocated the first
+ * time an opcode is used in a shard.
  */
 class Timings {
 public:
+    /// The number of shards used for the latency histograms
+    static const size_t NumShards = 16;
+
     Timings(void);
+    ~Timings();
     Timings& operator=(const Timings& other);
     Timings(const Timings&) = delete;
 
@@ -40,6 +53,9 @@ public:
     void collect(const uint8_t opcode, const std::chrono::nanoseconds nsec);
     void sample(std::chrono::seconds sample_interval);
     std::string generate(const uint8_t opcode);
+
+    /// Get the latency histogram for the opcode (merged from all shards)
+    LatencyHistogram getLatencyHistogram(const uint8_t opcode);
     uint64_t get_aggregated_mutation_stats();
     uint64_t get_aggregated_retrival_stats();
 
@@ -47,6 +63,10 @@ public:
     cb::sampling::Interval get_interval_lookup_latency();
 
 private:
+    /// Get the latency histogram to use for the opcode in the given
+    /// shard (allocate it if needed)
+    LatencyHistogram& getShardHistogram(size_t shard, const uint8_t opcode);
+
     // This lock is only held by sample() and some blocks within generate().
     // It guards the various IntervalSeries variables which internally
     // contain cb::RingBuffer objects which are not thread safe.
@@ -55,5 +75,8 @@ private:
     cb::sampling::IntervalSeries interval_latency_lookups;
     cb::sampling::IntervalSeries interval_latency_mutations;
     std::array<TimingHistogram, MAX_NUM_OPCODES> timings;
+    std::array<std::array<std::atomic<LatencyHistogram*>, MAX_NUM_OPCODES>,
+               NumShards>
+            hdr_timings;
     std::array<cb::sampling::Interval, MAX_NUM_OPCODES> interval_counters;
 };
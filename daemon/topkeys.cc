@@ -18,6 +18,7 @@
 #include "config.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <sys/types.h>
 #include <stdexcept>
@@ -32,143 +33,208 @@
  *
  * === TopKeys ===
  *
- * The TopKeys class is split into NUM_SHARDS shards, each which owns
- * 1/NUM_SHARDS of the keyspace. This is to allow some level of
- * concurrent access - each shard has a mutex guarding all access.
- * Other than that the TopKeys class is pretty uninteresting - it
- * simply passes on requests to the correct Shard, and when statistics
- * are requested it aggregates information from each shard.
+ * The TopKeys class keeps a Space-Saving summary of the keys for each
+ * front end thread. A thread only ever updates its own summary, so the
+ * front end threads don't contend with each other when updating the
+ * keys (the mutex in the summary is only contended while the stats are
+ * being collected). When statistics are requested the summaries are
+ * merged, and the keys with the highest access counts are reported.
  *
- * === TopKeys::Shard ===
+ * === TopKeys::Summary ===
  *
- * This is where the action happens. Each Shard maintains an ordered
- * list of key names and related statistics, orded by when they were
- * last accessed. There is a fixed number of keys each Shard tracks.
-
- * Given we generally track only a small number of keys per shard (10
- * by default), it's highly likely that any one key access will 'miss'
- * - i.e. not find an existing topkey. Therefore this class is
- * optimized for that case, attempting to minimise memory allocation
- * in steady-state.
+ * Each summary tracks a fixed number of keys (twice the number of keys
+ * reported) for the current and the previous time window of
+ * WINDOW_SIZE seconds. The summary of a window consists of a vector of
+ * the keys and their statistics, a hash index from the key to its
+ * position in the vector, and a min-heap (by access count) of the
+ * positions in the vector:
  *
- * Internally Shard consists of a vector of topkey_t, storing the
- * current max_keys top_keys, and a list of topkey_t pointers, used to
- * main the current most -> least recently used ordering:
-
- * max_keys elements. Each element is a tuple of
- * {hash(key), key, topkey_stats}:
- *
- *
- *       vector<topkey_t>
- *   +----------+-------------+---------------+
- *   | size_t   | std::string | topkey_item_t |
- *   +----------+-------------+---------------+
- *   | <hash 1> | <key 1>     | stats 1       | <--- Node1
- *   | <hash 2> | <key 2>     | stats 2       | <--- Node2
- *   | <hash 3> | <key 3>     | stats 3       | <--- Node3
- *   . ....                                   .
- *   | <hash N> | <key N>     | stats N       | <--- NodeN
- *   +----------------------------------------+
- *
- *   Node3 <---> Node1 <---> ... <---> Node2
- *   ^^^                               ^^^
- *   MRU                               LRU
+ *   unordered_map           vector<Counter>               vector<size_t>
+ *   +-----------+---+       +---------+---------+----+    +-------+
+ *   | <key 1>   | 0 |  -->  | <key 1> | stats 1 | h1 |    | <min> |
+ *   | <key 2>   | 1 |       | <key 2> | stats 2 | h2 |    | ...   |
+ *   . ....          .       . ....                   .    .       .
+ *   | <key N>   | N |       | <key N> | stats N | hN |    | ...   |
+ *   +---------------+       +------------------------+    +-------+
  *
+ * Upon a key 'hit', TopKeys::updateKey() calls Summary::updateKey() for
+ * the calling thread's summary. That looks the key up in the index. If
+ * it is found, then the access count is simply incremented and the
+ * counter is moved down the heap. If it is not found and the summary
+ * is full, the key at the top of the heap (the one with the lowest
+ * access count) is replaced by the incoming key, which inherits the
+ * count of the key it replaced (+1). This over-estimates the count of
+ * the new key by at most the lowest count, but guarantees that every
+ * key accessed more than 1/N of the times within the window is
+ * tracked. Both a hit and a miss cost a hash lookup and O(log N) heap
+ * swaps.
  *
- * Upon a key 'hit', TopKeys::updateKey() is called. That hashes the
- * key, and finds the Shard responsible for that
- * key. TopKeys::Shard::updateKey() is then called.
- *
- * Shard::updateKey() iterates over the vector, searching for a hash
- * match with an existing element, using the actual key string to
- * validate (in case of a hash collision). If it is found, then the
- * stats are simply updated.  If it is not found, then the
- * least-recently-used element is selected as a 'victim' and it's
- * contents is replaced by the incoming key.  Finally the linked-list
- * is updated to move the updated element to the head of the list.
+ * The windows are rotated as the keys are updated, and a window is
+ * no longer reported once it has been over WINDOW_SIZE seconds since it
+ * was replaced as the current window.
  */
 
+const rel_time_t TopKeys::WINDOW_SIZE;
+const size_t TopKeys::KEYS_PER_MKEY;
 
-TopKeys::TopKeys(int mkeys) {
-    for (auto& shard : shards) {
-        shard.setMaxKeys(mkeys);
+TopKeys::TopKeys(int mkeys) : max_keys(size_t(mkeys) * KEYS_PER_MKEY) {
+    summaries.reserve(NUM_SUMMARIES);
+    for (size_t ii = 0; ii < NUM_SUMMARIES; ++ii) {
+        summaries.emplace_back(new Summary(max_keys * 2));
     }
 }
 
 TopKeys::~TopKeys() {
 }
 
-TopKeys::Shard& TopKeys::getShard(size_t key_hash) {
-    /* This is special-cased for 8 */
-    static_assert(NUM_SHARDS == 8,
-                  "Topkeys::getShard() special-cased for SHARDS==8");
-    return shards[key_hash & 0x7];
+TopKeys::Summary& TopKeys::getSummary() {
+    // Give each thread its own summary
+    static std::atomic<size_t> next_index{0};
+    static thread_local size_t index = next_index++;
+    return *summaries[index % NUM_SUMMARIES];
 }
 
-TopKeys::Shard::topkey_t*
-TopKeys::Shard::searchForKey(size_t key_hash,
-                             const cb::const_char_buffer& key) {
-
-    for (auto& topkey : storage) {
-        if (topkey.first.hash == key_hash) {
-            // Double-check with full compare
-            if (topkey.first.key.compare(0, topkey.first.key.size(),
-                                         key.buf, key.len) == 0) {
-                // Match found.
-                return &topkey;
-            }
-        }
-    }
-    return nullptr;
+TopKeys::Summary::Window::Window(size_t capacity) {
+    counters.reserve(capacity);
+    index.reserve(capacity);
+    heap.reserve(capacity);
 }
 
-bool TopKeys::Shard::updateKey(const cb::const_char_buffer& key,
-                               size_t key_hash,
-                               const rel_time_t ct) {
-    try {
-        std::lock_guard<std::mutex> lock(mutex);
+void TopKeys::Summary::Window::clear() {
+    // Keeps the reserved storage
+    index.clear();
+    counters.clear();
+    heap.clear();
+}
 
-        topkey_t* found_key = searchForKey(key_hash, key);
+TopKeys::Summary::Summary(size_t capacity)
+    : capacity(capacity), current(capacity), previous(capacity) {
+}
 
-        if (found_key == NULL) {
-            // Key not found.
-            if (storage.size() == max_keys) {
-                // Re-use the lowest keys' storage.
-                found_key = list.back();
-                found_key->first.hash = key_hash;
-                found_key->first.key.assign(key.buf, key.len);
-                found_key->second = topkey_item_t(ct);
+bool TopKeys::Summary::isExpired(const Window& window,
+                                 rel_time_t current_time) {
+    return current_time >= window.start &&
+           current_time - window.start >= 2 * WINDOW_SIZE;
+}
 
-                // Move back element to the front, shuffling down the
-                // rest.
-                list.splice(list.begin(), list, --list.end());
+void TopKeys::Summary::maybeRotate(rel_time_t operation_time) {
+    if (operation_time < current.start ||
+        operation_time - current.start < WINDOW_SIZE) {
+        return;
+    }
 
-            } else {
-                // add a new element to the storage array.
+    // Reuse the storage of the previous window for the new window (moving
+    // the windows doesn't move the counters the indexes refer to)
+    std::swap(previous, current);
+    if (isExpired(previous, operation_time)) {
+        previous.clear();
+    }
+    current.clear();
+    current.start = operation_time;
+}
 
-                storage.emplace_back(
-                    std::make_pair(KeyId{key_hash,
-                                         std::string(key.buf, key.len)},
-                                   topkey_item_t(ct)));
-                found_key = &storage.back();
+void TopKeys::Summary::swapHeapEntries(size_t a, size_t b) {
+    auto& heap = current.heap;
+    std::swap(heap[a], heap[b]);
+    current.counters[heap[a]].heap_index = a;
+    current.counters[heap[b]].heap_index = b;
+}
 
-                // Insert the new item to the front of the list
-                list.push_front(found_key);
+void TopKeys::Summary::siftDown(size_t heap_index) {
+    const auto& heap = current.heap;
+    const auto count = [this](size_t heap_index) {
+        return current.counters[current.heap[heap_index]].item.ti_access_count;
+    };
+
+    while (true) {
+        auto lowest = heap_index;
+        for (auto child : {2 * heap_index + 1, 2 * heap_index + 2}) {
+            if (child < heap.size() && count(child) < count(lowest)) {
+                lowest = child;
             }
-        } else {
-            // Found - shuffle to the front.
-            auto it = std::find(list.begin(), list.end(),
-                                found_key);
-            list.splice(list.begin(), list, it);
         }
+        if (lowest == heap_index) {
+            return;
+        }
+        swapHeapEntries(heap_index, lowest);
+        heap_index = lowest;
+    }
+}
 
-        // Increment access count.
-        found_key->second.ti_access_count++;
-        return true;
+void TopKeys::Summary::siftUp(size_t heap_index) {
+    const auto count = [this](size_t heap_index) {
+        return current.counters[current.heap[heap_index]].item.ti_access_count;
+    };
 
-    } catch (const std::bad_alloc&) {
-        // Failed to update.
-        return false;
+    while (heap_index > 0) {
+        const auto parent = (heap_index - 1) / 2;
+        if (count(parent) <= count(heap_index)) {
+            return;
+        }
+        swapHeapEntries(heap_index, parent);
+        heap_index = parent;
+    }
+}
+
+void TopKeys::Summary::updateKey(const cb::const_char_buffer& key,
+                                 const rel_time_t ct) {
+    std::lock_guard<std::mutex> lock(mutex);
+    maybeRotate(ct);
+
+    auto iter = current.index.find(key);
+    if (iter != current.index.end()) {
+        auto& counter = current.counters[iter->second];
+        counter.item.ti_access_count++;
+        siftDown(counter.heap_index);
+        return;
+    }
+
+    // Key not found.
+    if (current.counters.size() < capacity) {
+        const auto position = current.counters.size();
+        current.counters.emplace_back(key, ct);
+        auto& counter = current.counters.back();
+        counter.item.ti_access_count = 1;
+        counter.heap_index = current.heap.size();
+        current.heap.push_back(position);
+        current.index.emplace(
+                cb::const_char_buffer(counter.key.data(), counter.key.size()),
+                position);
+        siftUp(counter.heap_index);
+    } else if (capacity > 0) {
+        // Replace the key with the lowest count (the top of the heap)
+        const auto position = current.heap.front();
+        auto& counter = current.counters[position];
+        current.index.erase(
+                cb::const_char_buffer(counter.key.data(), counter.key.size()));
+        counter.key.assign(key.buf, key.len);
+        counter.item.ti_ctime = ct;
+        counter.item.ti_access_count++;
+        current.index.emplace(
+                cb::const_char_buffer(counter.key.data(), counter.key.size()),
+                position);
+        siftDown(0);
+    }
+}
+
+void TopKeys::Summary::collect(
+        std::unordered_map<std::string, topkey_item_t>& keys,
+        rel_time_t current_time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto* window : {&previous, &current}) {
+        if (isExpired(*window, current_time)) {
+            continue;
+        }
+        for (const auto& counter : window->counters) {
+            auto iter = keys.find(counter.key);
+            if (iter == keys.end()) {
+                keys.emplace(counter.key, counter.item);
+            } else {
+                iter->second.ti_access_count += counter.item.ti_access_count;
+                iter->second.ti_ctime =
+                        std::min(iter->second.ti_ctime, counter.item.ti_ctime);
+            }
+        }
     }
 }
 
@@ -181,15 +247,31 @@ void TopKeys::doUpdateKey(const void* key,
 
     try {
         cb::const_char_buffer key_buf(static_cast<const char*>(key), nkey);
-        std::hash<cb::const_char_buffer > hash_fn;
-        const size_t key_hash = hash_fn(key_buf);
-
-        getShard(key_hash).updateKey(key_buf, key_hash, operation_time);
+        getSummary().updateKey(key_buf, operation_time);
     } catch (const std::bad_alloc&) {
         // Failed to increment topkeys, continue...
     }
 }
 
+std::vector<TopKeys::topkey_t> TopKeys::getTopKeys(rel_time_t current_time) {
+    std::unordered_map<std::string, topkey_item_t> keys;
+    for (auto& summary : summaries) {
+        summary->collect(keys, current_time);
+    }
+
+    std::vector<topkey_t> ret(keys.begin(), keys.end());
+    const auto count = std::min(max_keys, ret.size());
+    std::partial_sort(ret.begin(),
+                      ret.begin() + count,
+                      ret.end(),
+                      [](const topkey_t& a, const topkey_t& b) {
+                          return a.second.ti_access_count >
+                                 b.second.ti_access_count;
+                      });
+    ret.erase(ret.begin() + count, ret.end());
+    return ret;
+}
+
 struct tk_context {
     tk_context(const void *c, ADD_STAT a, rel_time_t t, cJSON *arr)
         : cookie(c), add_stat(a), current_time(t), array(arr)
@@ -256,8 +338,12 @@ ENGINE_ERROR_CODE TopKeys::doStats(const void* cookie,
                                    ADD_STAT add_stat) {
     struct tk_context context(cookie, add_stat, current_time, nullptr);
 
-    for (auto& shard : shards) {
-        shard.accept_visitor(tk_iterfunc, &context);
+    try {
+        for (const auto& topkey : getTopKeys(current_time)) {
+            tk_iterfunc(topkey.first, topkey.second, &context);
+        }
+    } catch (const std::bad_alloc&) {
+        return ENGINE_ENOMEM;
     }
 
     return ENGINE_SUCCESS;
@@ -275,22 +361,21 @@ ENGINE_ERROR_CODE TopKeys::doStats(const void* cookie,
  */
 ENGINE_ERROR_CODE TopKeys::do_json_stats(cJSON* object,
                                          rel_time_t current_time) {
+    std::vector<topkey_t> keys;
+    try {
+        keys = getTopKeys(current_time);
+    } catch (const std::bad_alloc&) {
+        return ENGINE_ENOMEM;
+    }
+
     cJSON *topkeys = cJSON_CreateArray();
     struct tk_context context(nullptr, nullptr, current_time, topkeys);
 
     /* Collate the topkeys JSON object */
-    for (auto& shard : shards) {
-        shard.accept_visitor(tk_jsonfunc, &context);
+    for (const auto& topkey : keys) {
+        tk_jsonfunc(topkey.first, topkey.second, &context);
     }
 
     cJSON_AddItemToObject(object, "topkeys", topkeys);
     return ENGINE_SUCCESS;
 }
-
-void TopKeys::Shard::accept_visitor(iterfunc_t visitor_func,
-                                    void* visitor_ctx) {
-    std::lock_guard<std::mutex> lock(mutex);
-    for (const auto key : list) {
-        visitor_func(key->first.key, key->second, visitor_ctx);
-    }
-}
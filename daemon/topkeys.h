@@ -18,22 +18,23 @@
 
 #include "settings.h"
 
-#include <array>
 #include <platform/sized_buffer.h>
 #include <memcached/engine.h>
 #include <cJSON.h>
 
+#include <memory>
 #include <mutex>
-#include <list>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 /*
  * TopKeys
  *
- * Tracks the top N most recently accessed keys. The details are
- * accessible by a stats call, which is used by ns_server to print the
- * top keys list in the GUI.
+ * Tracks the N most frequently accessed keys over the last time window.
+ * The details are accessible by a stats call, which is used by ns_server
+ * to print the top keys list in the GUI.
  */
 
 struct topkey_item_t {
@@ -50,12 +51,18 @@ struct topkey_item_t {
 class TopKeys {
 public:
     /* Constructor.
-     * @param mkeys Number of keys stored in each shard (i.e. up to
-     * mkeys * SHARDS will be tracked).
+     * @param mkeys Number of keys reported is mkeys * KEYS_PER_MKEY
      */
     explicit TopKeys(int mkeys);
     ~TopKeys();
 
+    /// The length (in seconds) of the time window used to track the keys
+    static const rel_time_t WINDOW_SIZE = 60;
+
+    /// The number of keys reported for each of the mkeys (for
+    /// compatibility with the previous implementation which used 8 shards)
+    static const size_t KEYS_PER_MKEY = 8;
+
     void updateKey(const void* key, size_t nkey, rel_time_t operation_time) {
         if (settings.isTopkeysEnabled()) {
             doUpdateKey(key, nkey, operation_time);
@@ -104,79 +111,93 @@ protected:
     ENGINE_ERROR_CODE do_json_stats(cJSON* object, rel_time_t current_time);
 
 private:
-    // Number of shards the keyspace is broken into. Permits some level of
-    // concurrent update (there is one mutex per shard).
-    static const int NUM_SHARDS = 8;
+    // Number of per-thread summaries. Each front end thread updates its
+    // own summary (threads beyond this share the summaries).
+    static const size_t NUM_SUMMARIES = 64;
 
-    class Shard;
+    typedef std::pair<std::string, topkey_item_t> topkey_t;
 
-    Shard& getShard(size_t key_hash);
+    class Summary;
 
-    // One of N Shards which the keyspace has been broken
-    // into.
-    // Responsible for tracking the top {mkeys} within it's keyspace.
-    class Shard {
-    public:
+    Summary& getSummary();
 
-        void setMaxKeys(int mkeys) {
-            max_keys = mkeys;
-            storage.reserve(max_keys);
-            // reallocating storage invalidates the LRU list.
-            list.clear();
-        }
+    // Merge the summaries and return the top keys (most accessed first)
+    std::vector<topkey_t> getTopKeys(rel_time_t current_time);
 
-        // Updates the topkey 'ranking' for the specified key.
-        // If the item does not exist it will be created (with it's creation
-        // time set to operation_time), otherwise the existing item will be
-        // updated.
-        // On success returns true, If insufficient memory to create a
-        // new item, returns false.
-        bool updateKey(const cb::const_char_buffer& key,
-                       size_t key_hash,
-                       rel_time_t operation_time);
+    // A Space-Saving summary of the keys accessed by a single thread.
+    // Tracks up to {capacity} keys for the current and the previous
+    // time window. Any key accessed more than 1/capacity of the times
+    // within a window is guaranteed to be tracked.
+    class Summary {
+    public:
+        explicit Summary(size_t capacity);
 
-        typedef void (*iterfunc_t)(const std::string& key,
-                                   const topkey_item_t& it,
-                                   void *arg);
+        // Updates the access count for the specified key. If the key
+        // isn't tracked it replaces the least accessed key (and inherits
+        // its count, as the Space-Saving algorithm prescribes).
+        void updateKey(const cb::const_char_buffer& key,
+                       rel_time_t operation_time);
 
-        /* For each key in this shard, invoke the given callback function.
-         */
-        void accept_visitor(iterfunc_t visitor_func, void* visitor_ctx);
+        // Add the keys tracked for the windows which haven't expired by
+        // current_time to the provided map
+        void collect(std::unordered_map<std::string, topkey_item_t>& keys,
+                     rel_time_t current_time);
 
     private:
+        struct Counter {
+            Counter(const cb::const_char_buffer& key, rel_time_t ctime)
+                : key(key.buf, key.len), item(ctime) {
+            }
 
-        struct KeyId {
-            size_t hash;
             std::string key;
+            topkey_item_t item;
+            // The position of the counter in Window::heap
+            size_t heap_index = 0;
         };
 
-        // Pair of the key's string and the statistics related to it.
-        typedef std::pair<KeyId, topkey_item_t> topkey_t;
+        struct Window {
+            explicit Window(size_t capacity);
+
+            void clear();
+
+            rel_time_t start = 0;
+            // The counters of the tracked keys. Reserved up front so that
+            // the counters never move (the keys in the index refer to the
+            // strings in the counters).
+            std::vector<Counter> counters;
+            // The position of each tracked key in counters
+            std::unordered_map<cb::const_char_buffer, size_t> index;
+            // Min-heap (by access count) of the positions in counters, so
+            // the least accessed key can be found when the summary is full
+            std::vector<size_t> heap;
+        };
 
-        // An ordered list of topkey_t*, used for LRU.
-        typedef std::list<topkey_t*> key_history_t;
+        // Restore the heap order after the access count of the counter at
+        // the given position in the heap was incremented
+        void siftDown(size_t heap_index);
 
-        // Vector topket_t, used for actual topke storage.
-        typedef std::vector<topkey_t> key_storage_t;
+        // Restore the heap order after a counter with the lowest possible
+        // access count was added at the given position in the heap
+        void siftUp(size_t heap_index);
 
-        // Searches for the given key. If found returns a pointer to the
-        // topkey_t, else returns NULL.
-        topkey_t* searchForKey(size_t hash, const cb::const_char_buffer& key);
+        void swapHeapEntries(size_t a, size_t b);
 
-        // Maxumum numbers of keys to be tracked per shard.
-        unsigned int max_keys;
+        void maybeRotate(rel_time_t operation_time);
 
-        // mutex to serial access to this shard.
-        std::mutex mutex;
+        static bool isExpired(const Window& window, rel_time_t current_time);
 
-        // list of keys, ordered from most-recently used (front) to least recently
-        // used (back).
-        key_history_t list;
+        const size_t capacity;
 
-        // Underlying topkey storage.
-        key_storage_t storage;
+        // Only contended while the stats are being collected (unless
+        // there are more than NUM_SUMMARIES threads)
+        std::mutex mutex;
+
+        Window current;
+        Window previous;
     };
 
-    // array of topkey shards.
-    std::array<Shard, NUM_SHARDS> shards;
+    // Number of keys reported
+    const size_t max_keys;
+
+    std::vector<std::unique_ptr<Summary>> summaries;
 };
@@ -22,6 +22,7 @@
 #include <benchmark/benchmark.h>
 
 #include <platform/sysinfo.h>
+#include <programs/engine_testapp/mock_server.h>
 
 #include "stats.h"
 
@@ -119,6 +120,44 @@ BENCHMARK_DEFINE_F(MemoryAllocationStat, AllocNReadPreciseM)
     }
 }
 
+/**
+ * Get the arena used by the arena benchmarks (created the first time it is
+ * requested, as arenas can't be destroyed while other threads use them).
+ *
+ * @return false if the allocator doesn't support arenas
+ */
+static bool getBenchmarkArena(unsigned& arena) {
+    static unsigned index;
+    static const bool created =
+            get_mock_server_api()->alloc_hooks->create_arena(&index);
+    arena = index;
+    return created;
+}
+
+// The cost of allocating from a bucket arena (bypassing the thread cache)
+// and reading the mem_used of the bucket from the stats of the arena
+// instead of from the allocator hooks.
+BENCHMARK_DEFINE_F(MemoryAllocationStat, ArenaAllocNReadM)
+(benchmark::State& state) {
+    auto* hooks = get_mock_server_api()->alloc_hooks;
+    unsigned arena;
+    if (!getBenchmarkArena(arena)) {
+        state.SkipWithError("The memory allocator doesn't support arenas");
+        return;
+    }
+
+    allocator_stats arenaStats = {};
+    while (state.KeepRunning()) {
+        // range = allocations per read
+        for (int i = 0; i < state.range(0); i++) {
+            hooks->arena_free(hooks->arena_malloc(arena, 128));
+        }
+        for (int j = 0; j < state.range(1); j++) {
+            hooks->get_arena_stats(arena, &arenaStats);
+        }
+    }
+}
+
 // Test covers a range seen from a running cluster (with pillowfight load)
 // The range was discovered by counting calls to memAllocated/deallocated and
 // then logging how many had occurred for each read
@@ -134,6 +173,11 @@ BENCHMARK_REGISTER_F(MemoryAllocationStat, AllocNReadM)
         ->Ranges({{0, 4000}, {128, 4000}});
 
 BENCHMARK_REGISTER_F(MemoryAllocationStat, AllocNReadPreciseM)
+        ->Threads(cb::get_cpu_count() * 4)
+        ->RangeMultiplier(2)
+        ->Ranges({{0, 4000}, {128, 4000}});
+
+BENCHMARK_REGISTER_F(MemoryAllocationStat, ArenaAllocNReadM)
         ->Threads(cb::get_cpu_count() * 4)
         ->RangeMultiplier(2)
         ->Ranges({{0, 4000}, {128, 4000}});
\ No newline at end of file
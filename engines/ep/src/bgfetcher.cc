@@ -26,6 +26,7 @@
 #include "vbucket_bgfetch_item.h"
 
 #include <phosphor/phosphor.h>
+#include <tracing/trace_helpers.h>
 
 #include <algorithm>
 #include <climits>
@@ -80,13 +81,27 @@ size_t BgFetcher::doFetch(VBucket::id_type vbId,
                 .count());
 
     shard->getROUnderlying()->getMulti(vbId, itemsToFetch);
+    const auto readTime = ProcessClock::now();
 
+    auto* serverApi = store->getEPEngine().getServerApi();
     std::vector<bgfetched_item_t> fetchedItems;
     for (const auto& fetch : itemsToFetch) {
         auto& key = fetch.first;
         const vb_bgfetch_item_ctx_t& bg_item_ctx = fetch.second;
 
         for (const auto& itm : bg_item_ctx.bgfetched_list) {
+            // Let the request see how long it waited for the fetcher to
+            // pick it up, and how long the (batched) disk read took
+            TRACE_ADD(serverApi,
+                      itm->cookie,
+                      cb::tracing::TraceCode::BGWAIT,
+                      itm->initTime,
+                      startTime);
+            TRACE_ADD(serverApi,
+                      itm->cookie,
+                      cb::tracing::TraceCode::BGLOAD,
+                      startTime,
+                      readTime);
             // We don't want to transfer ownership of itm here as we clean it
             // up at the end of this method in clearItems()
             fetchedItems.push_back(std::make_pair(key, itm.get()));
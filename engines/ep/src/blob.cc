@@ -23,24 +23,32 @@
 
 Blob* Blob::New(const char* start, const size_t len) {
     size_t total_len = getAllocationSize(len);
-    Blob* t = new (::operator new(total_len)) Blob(start, len);
+    bool fromArena;
+    Blob* t = new (BucketArena::allocate(total_len, fromArena))
+            Blob(start, len);
+    t->arenaAllocated = fromArena;
     return t;
 }
 
 Blob* Blob::New(const size_t len) {
     size_t total_len = getAllocationSize(len);
-    Blob* t = new (::operator new(total_len)) Blob(len);
+    bool fromArena;
+    Blob* t = new (BucketArena::allocate(total_len, fromArena)) Blob(len);
+    t->arenaAllocated = fromArena;
     return t;
 }
 
 Blob* Blob::Copy(const Blob& other) {
-    Blob* t = new (::operator new(Blob::getAllocationSize(other.valueSize())))
+    bool fromArena;
+    Blob* t = new (BucketArena::allocate(
+            Blob::getAllocationSize(other.valueSize()), fromArena))
             Blob(other);
+    t->arenaAllocated = fromArena;
     return t;
 }
 
 Blob::Blob(const char* start, const size_t len)
-    : size(static_cast<uint32_t>(len)), age(0) {
+    : size(static_cast<uint32_t>(len)), arenaAllocated(0), age(0) {
     if (start != NULL) {
         std::memcpy(data, start, len);
 #ifdef VALGRIND
@@ -56,6 +64,7 @@ Blob::Blob(const size_t len) : Blob(nullptr, len) {
 
 Blob::Blob(const Blob& other)
     : size(other.size),
+      arenaAllocated(0),
       // While this is a copy, it is a new allocation therefore reset age.
       age(0) {
     std::memcpy(data, other.data, size);
@@ -20,10 +20,11 @@
 #include "config.h"
 
 #include "atomic.h"
+#include "bucket_arena.h"
 #include "tagged_ptr.h"
 
 /**
- * A blob is a minimal sized storage for data up to 2^32 bytes long.
+ * A blob is a minimal sized storage for data up to 2^31 bytes long.
  */
 class Blob : public RCValue {
 public:
@@ -119,7 +120,11 @@ public:
     class Deleter {
     public:
         void operator()(TaggedPtr<Blob> item) {
-            delete item.get();
+            // The memory was allocated by BucketArena::allocate
+            Blob* blob = item.get();
+            const bool fromArena = blob->arenaAllocated;
+            blob->~Blob();
+            BucketArena::deallocate(blob, fromArena);
         }
     };
 
@@ -144,7 +149,10 @@ protected:
         return sizeof(Blob) + len - sizeof(Blob(0, 0).data);
     }
 
-    const uint32_t size;
+    // The top bit of the size is used to record if the Blob was
+    // allocated from a BucketArena (values are much smaller than 2^31).
+    const uint32_t size : 31;
+    uint32_t arenaAllocated : 1;
 
     // The age of this Blob, in terms of some unspecified units of time.
     uint8_t age;
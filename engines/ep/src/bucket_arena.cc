@@ -0,0 +1,93 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "bucket_arena.h"
+
+#include "ep_engine.h"
+#include "memory_tracker.h"
+#include "objectregistry.h"
+
+#include <cinttypes>
+
+std::atomic<const ALLOCATOR_HOOKS_API*> BucketArena::freeHooks{nullptr};
+
+std::unique_ptr<BucketArena> BucketArena::create(
+        const ALLOCATOR_HOOKS_API& hooks) {
+    unsigned index;
+    if (hooks.create_arena == nullptr || !hooks.create_arena(&index)) {
+        return {};
+    }
+    freeHooks.store(&hooks);
+    return std::unique_ptr<BucketArena>(new BucketArena(hooks, index));
+}
+
+BucketArena::BucketArena(const ALLOCATOR_HOOKS_API& hooks, unsigned index)
+    : hooks(hooks), index(index) {
+}
+
+BucketArena::~BucketArena() {
+    allocator_stats stats = {};
+    if (getStats(stats) && stats.allocated_size == 0) {
+        hooks.destroy_arena(index);
+        return;
+    }
+
+    // We can't tell if something is still referencing memory in the arena
+    // (which is freed later on), so just hand back the pages not in use.
+    LOG(EXTENSION_LOG_WARNING,
+        "BucketArena: not destroying arena %u as %" PRIu64
+        " bytes may still be allocated from it",
+        index,
+        uint64_t(stats.allocated_size));
+    hooks.release_free_memory();
+}
+
+void* BucketArena::allocate(size_t size, bool& fromArena) {
+    auto* engine = ObjectRegistry::getCurrentEngine();
+    const BucketArena* arena = engine ? engine->getArena() : nullptr;
+    if (arena == nullptr) {
+        fromArena = false;
+        return ::operator new(size);
+    }
+
+    void* ret = arena->hooks.arena_malloc(arena->index, size);
+    if (ret == nullptr) {
+        throw std::bad_alloc();
+    }
+    if (MemoryTracker::trackingMemoryAllocations()) {
+        ObjectRegistry::memoryAllocated(arena->hooks.get_allocation_size(ret));
+    }
+    fromArena = true;
+    return ret;
+}
+
+void BucketArena::deallocateFromArena(void* ptr) {
+    // Only memory allocated by arena_malloc gets here, so an arena (and
+    // thus freeHooks) must exist
+    const auto* hooks = freeHooks.load(std::memory_order_relaxed);
+    // The allocation wasn't seen by the new hook, and arena_free doesn't
+    // call the delete hook
+    if (MemoryTracker::trackingMemoryAllocations()) {
+        ObjectRegistry::memoryDeallocated(hooks->get_allocation_size(ptr));
+    }
+    hooks->arena_free(ptr);
+}
+
+bool BucketArena::getStats(allocator_stats& stats) const {
+    return hooks.get_arena_stats != nullptr &&
+           hooks.get_arena_stats(index, &stats);
+}
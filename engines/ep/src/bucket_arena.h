@@ -0,0 +1,109 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <memcached/allocator_hooks.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+
+/**
+ * An allocator arena owned by a single bucket, which the StoredValue and
+ * Blob objects of the bucket are allocated from when bucket_arena_enabled
+ * is set.
+ *
+ * Keeping the objects of each bucket in their own arena means that the
+ * fragmentation of a bucket isn't affected by the other buckets, that the
+ * memory used by the bucket can be read from the arena stats, and that
+ * the memory is released in one go when the bucket is deleted.
+ *
+ * The memory is allocated from the arena of the engine associated with
+ * the calling thread (see ObjectRegistry::getCurrentEngine), or from the
+ * normal heap if the engine doesn't have an arena. The allocator hooks
+ * aren't called for memory allocated from (or freed through) an arena, so
+ * that memory is accounted for here instead.
+ */
+class BucketArena {
+public:
+    /**
+     * Create a new arena
+     *
+     * @return the arena, or nullptr if the allocator doesn't support arenas
+     */
+    static std::unique_ptr<BucketArena> create(
+            const ALLOCATOR_HOOKS_API& hooks);
+
+    /**
+     * Destroys the arena, unless some of the objects allocated from it are
+     * still alive (in which case only the unused memory is released).
+     */
+    ~BucketArena();
+
+    /**
+     * Allocate memory from the arena of the calling thread's engine
+     *
+     * @param size the number of bytes to allocate
+     * @param fromArena set to true if the memory came from an arena, or
+     *                  false if it came from the normal heap. It must be
+     *                  passed back to deallocate() (the objects keep it
+     *                  alongside their other flags).
+     * @throws std::bad_alloc if the memory couldn't be allocated
+     */
+    static void* allocate(size_t size, bool& fromArena);
+
+    /**
+     * Free memory allocated by allocate(). Memory from the normal heap is
+     * freed with operator delete, so only the objects which came from an
+     * arena pay for arena_free.
+     */
+    static void deallocate(void* ptr, bool fromArena) {
+        if (fromArena) {
+            deallocateFromArena(ptr);
+        } else {
+            ::operator delete(ptr);
+        }
+    }
+
+    unsigned getIndex() const {
+        return index;
+    }
+
+    /**
+     * Get the stats of the arena (allocated, heap, resident, retained and
+     * fragmentation size)
+     *
+     * @return false if the stats aren't available
+     */
+    bool getStats(allocator_stats& stats) const;
+
+private:
+    BucketArena(const ALLOCATOR_HOOKS_API& hooks, unsigned index);
+
+    static void deallocateFromArena(void* ptr);
+
+    const ALLOCATOR_HOOKS_API& hooks;
+    const unsigned index;
+
+    /**
+     * The hooks used to free the memory allocated from an arena; set once
+     * the first arena is created. arena_free doesn't need to know which
+     * arena the memory came from.
+     */
+    static std::atomic<const ALLOCATOR_HOOKS_API*> freeHooks;
+};
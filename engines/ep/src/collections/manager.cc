@@ -20,8 +20,12 @@
 #include "collections/manifest.h"
 #include "ep_engine.h"
 #include "kv_bucket.h"
+#include "statwriter.h"
 #include "vbucket.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 Collections::Manager::Manager() {
 }
 
@@ -114,6 +118,61 @@ void Collections::Manager::logAll(KVBucket& bucket) const {
     }
 }
 
+namespace {
+/// The stats of one collection, summed over all of the vbuckets
+struct CollectionStats {
+    uint64_t opsGet = 0;
+    uint64_t opsStore = 0;
+    uint64_t opsDelete = 0;
+    int64_t items = 0;
+    int64_t memUsed = 0;
+};
+} // namespace
+
+void Collections::Manager::addStats(KVBucket& bucket,
+                                    const void* cookie,
+                                    ADD_STAT add_stat) const {
+    std::unordered_map<std::string, CollectionStats> stats;
+    for (int i = 0; i < bucket.getVBuckets().getSize(); i++) {
+        auto vb = bucket.getVBuckets().getBucket(i);
+        if (!vb) {
+            continue;
+        }
+
+        vb->lockCollections().forEachCollection(
+                [&stats](const VB::ManifestEntry& entry) {
+                    auto& collection = stats[entry.getCollectionName()];
+                    collection.opsGet += entry.getOpsGet();
+                    collection.opsStore += entry.getOpsStore();
+                    collection.opsDelete += entry.getOpsDelete();
+                    collection.items += entry.getItemCount();
+                    collection.memUsed += entry.getMemUsed();
+                });
+    }
+
+    for (const auto& collection : stats) {
+        const auto* prefix = collection.first.c_str();
+        const auto& values = collection.second;
+        add_prefixed_stat(prefix, "ops_get", values.opsGet, add_stat, cookie);
+        add_prefixed_stat(
+                prefix, "ops_store", values.opsStore, add_stat, cookie);
+        add_prefixed_stat(
+                prefix, "ops_delete", values.opsDelete, add_stat, cookie);
+        // The counters of a collection which has been deleted and added
+        // back may be briefly negative, while its old items are erased.
+        add_prefixed_stat(prefix,
+                          "items",
+                          uint64_t(std::max(values.items, int64_t(0))),
+                          add_stat,
+                          cookie);
+        add_prefixed_stat(prefix,
+                          "mem_used",
+                          uint64_t(std::max(values.memUsed, int64_t(0))),
+                          add_stat,
+                          cookie);
+    }
+}
+
 void Collections::Manager::dump() const {
     std::cerr << *this;
 }
@@ -81,6 +81,18 @@ public:
      */
     void logAll(KVBucket& bucket) const;
 
+    /**
+     * Add the per-collection stats, summed over all of the vbuckets.
+     *
+     * Each vbucket's manifest entries hold the counters: the operation
+     * counts are maintained by the front-end threads, the item count by
+     * the flusher and the memory used by the HashTable. This just sums
+     * them, so is O(vbuckets * collections).
+     */
+    void addStats(KVBucket& bucket,
+                  const void* cookie,
+                  ADD_STAT add_stat) const;
+
     /**
      * Write to std::cerr this
      */
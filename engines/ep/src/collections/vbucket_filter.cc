@@ -91,6 +91,27 @@ bool Collections::VB::Filter::checkAndUpdate(const Item& item) {
     return allowed;
 }
 
+bool Collections::VB::Filter::allowKey(::DocKey key) const {
+    if (passthrough) {
+        return true;
+    }
+
+    switch (key.getDocNamespace()) {
+    case DocNamespace::DefaultCollection:
+        return defaultAllowed;
+    case DocNamespace::Collections: {
+        if (filter.empty()) {
+            return false;
+        }
+        const auto cKey = Collections::DocKey::make(key, separator);
+        return filter.count(cKey.getCollection()) > 0;
+    }
+    case DocNamespace::System:
+        return true;
+    }
+    return true;
+}
+
 void Collections::VB::Filter::remove(const Item& item) {
     if (passthrough) {
         return;
@@ -81,6 +81,17 @@ public:
      */
     bool checkAndUpdate(const Item& item);
 
+    /**
+     * Could a document with the given key be allowed by the filter? This
+     * lets a backfill skip reading the documents of filtered collections.
+     * System event keys always return true as they must still be passed
+     * to checkAndUpdate.
+     *
+     * @param key the key of a document
+     * @return false if a document with this key would be dropped
+     */
+    bool allowKey(::DocKey key) const;
+
     /**
      * @return if the filter is empty
      */
@@ -27,6 +27,8 @@
 #include <cJSON_utils.h>
 #include <platform/make_unique.h>
 
+#include <cstring>
+
 namespace Collections {
 namespace VB {
 
@@ -180,7 +182,10 @@ ManifestEntry& Manifest::addNewCollectionEntry(Identifier identifier,
     }
     auto m = std::make_unique<ManifestEntry>(identifier, startSeqno, endSeqno);
     auto* newEntry = m.get();
-    map.emplace(m->getCharBuffer(), std::move(m));
+    {
+        std::lock_guard<ShardedRWLock::Writer> wlh(countersLock.writer());
+        map.emplace(m->getCharBuffer(), std::move(m));
+    }
 
     if (newEntry->isDeleting()) {
         trackEndSeqno(endSeqno);
@@ -251,6 +256,7 @@ void Manifest::completeDeletion(::VBucket& vb,
     auto uid = itr->second->getUid();
 
     if (se == SystemEvent::DeleteCollectionHard) {
+        std::lock_guard<ShardedRWLock::Writer> wlh(countersLock.writer());
         map.erase(itr); // wipe out
     }
 
@@ -290,7 +296,11 @@ void Manifest::changeSeparator(::VBucket& vb,
 
         // Change the separator then queue the event so the new separator
         // is recorded in the serialised manifest
-        separator = std::string(newSeparator.data(), newSeparator.size());
+        {
+            std::lock_guard<ShardedRWLock::Writer> wlh(
+                    countersLock.writer());
+            separator = std::string(newSeparator.data(), newSeparator.size());
+        }
 
         // Queue an event so that the manifest is flushed and DCP can
         // replicate the change.
@@ -366,6 +376,72 @@ Manifest::container::const_iterator Manifest::getManifestEntry(
     return map.find(identifier);
 }
 
+ManifestEntry* Manifest::getEntryForCounters(const ::DocKey& key) const {
+    cb::const_char_buffer identifier;
+    switch (key.getDocNamespace()) {
+    case DocNamespace::DefaultCollection:
+        identifier = DefaultCollectionIdentifier;
+        break;
+    case DocNamespace::Collections:
+        identifier = Collections::DocKey::make(key, separator).getCollection();
+        break;
+    case DocNamespace::System:
+        return nullptr;
+    }
+
+    auto itr = map.find(identifier);
+    return itr == map.end() ? nullptr : itr->second.get();
+}
+
+thread_local Manifest::CachedEntry Manifest::cachedEntry = {};
+
+ManifestEntry* Manifest::getCachedEntry(const ::DocKey& key) const {
+    const auto& cached = cachedEntry;
+    if (cached.manifest == this &&
+        cached.docNamespace == key.getDocNamespace() &&
+        cached.keySize == key.size() &&
+        (cached.keyData == key.data() ||
+         std::memcmp(cached.keyData, key.data(), key.size()) == 0)) {
+        return cached.entry;
+    }
+    return nullptr;
+}
+
+void Manifest::updateItemCount(const ::DocKey& key, int64_t delta) const {
+    auto* entry = getCachedEntry(key);
+    if (entry) {
+        entry->updateItemCount(delta);
+        return;
+    }
+
+    std::lock_guard<cb::ReaderLock> rlh(countersLock.reader());
+    entry = getEntryForCounters(key);
+    if (entry) {
+        entry->updateItemCount(delta);
+    }
+}
+
+void Manifest::updateMemUsed(const ::DocKey& key, int64_t delta) const {
+    auto* entry = getCachedEntry(key);
+    if (entry) {
+        entry->updateMemUsed(delta);
+        return;
+    }
+
+    std::lock_guard<cb::ReaderLock> rlh(countersLock.reader());
+    entry = getEntryForCounters(key);
+    if (entry) {
+        entry->updateMemUsed(delta);
+    }
+}
+
+void Manifest::resetItemCounts() const {
+    std::lock_guard<cb::ReaderLock> rlh(countersLock.reader());
+    for (const auto& entry : map) {
+        entry.second->resetItemCount();
+    }
+}
+
 bool Manifest::isLogicallyDeleted(const ::DocKey& key, int64_t seqno) const {
     // Only do the searching/scanning work for keys in the deleted range.
     if (seqno <= greatestEndSeqno) {
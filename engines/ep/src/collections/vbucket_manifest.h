@@ -21,12 +21,14 @@
 #include "collections/collections_types.h"
 #include "collections/manifest.h"
 #include "collections/vbucket_manifest_entry.h"
+#include "sharded_rwlock.h"
 #include "systemevent.h"
 
 #include <platform/non_negative_counter.h>
 #include <platform/rwlock.h>
 #include <platform/sized_buffer.h>
 
+#include <functional>
 #include <mutex>
 #include <unordered_map>
 
@@ -70,8 +72,8 @@ public:
      */
     class ReadHandle {
     public:
-        ReadHandle(const Manifest& m, cb::RWLock& lock)
-            : readLock(lock), manifest(m) {
+        ReadHandle(const Manifest& m, ShardedRWLock& lock)
+            : readLock(lock.reader()), manifest(m) {
         }
 
         ReadHandle(ReadHandle&& rhs)
@@ -148,6 +150,17 @@ public:
             return manifest.exists(collection);
         }
 
+        /**
+         * Call fn for each of the collections in the manifest (including
+         * the collections which are being deleted)
+         */
+        void forEachCollection(
+                std::function<void(const ManifestEntry&)> fn) const {
+            for (const auto& entry : manifest.map) {
+                fn(*entry.second);
+            }
+        }
+
         /**
          * Dump the manifest to std::cerr
          */
@@ -172,6 +185,20 @@ public:
     using container = ::std::unordered_map<cb::const_char_buffer,
                                            std::unique_ptr<ManifestEntry>>;
 
+private:
+    /**
+     * The collection entry which a CachingReadHandle looked up for its key
+     * (see cachedEntry).
+     */
+    struct CachedEntry {
+        const Manifest* manifest;
+        DocNamespace docNamespace;
+        const uint8_t* keyData;
+        size_t keySize;
+        ManifestEntry* entry;
+    };
+
+public:
     /**
      * CachingReadHandle provides a limited set of functions to allow various
      * functional paths in KV-engine to perform collection 'legality' checks
@@ -195,8 +222,37 @@ public:
      */
     class CachingReadHandle : private ReadHandle {
     public:
-        CachingReadHandle(const Manifest& m, cb::RWLock& lock, ::DocKey key)
+        CachingReadHandle(const Manifest& m,
+                          ShardedRWLock& lock,
+                          ::DocKey key)
             : ReadHandle(m, lock), itr(m.getManifestEntry(key)), key(key) {
+            // Let the counters of the entry be updated for our key without
+            // looking it up again, while we hold the read lock
+            if (iteratorValid() &&
+                key.getDocNamespace() != DocNamespace::System) {
+                previous = cachedEntry;
+                cachedEntry = {&m,
+                               key.getDocNamespace(),
+                               key.data(),
+                               key.size(),
+                               itr->second.get()};
+                cached = true;
+            }
+        }
+
+        CachingReadHandle(CachingReadHandle&& rhs)
+            : ReadHandle(std::move(rhs)),
+              itr(rhs.itr),
+              key(rhs.key),
+              previous(rhs.previous),
+              cached(rhs.cached) {
+            rhs.cached = false;
+        }
+
+        ~CachingReadHandle() {
+            if (cached) {
+                cachedEntry = previous;
+            }
         }
 
         /**
@@ -226,6 +282,30 @@ public:
             return manifest.isLogicallyDeleted(itr, seqno);
         }
 
+        /**
+         * Count a successful read/store/delete of the key used in
+         * construction against its collection. These are called on every
+         * front-end operation, so only bump a relaxed counter in the entry
+         * we already looked up.
+         */
+        void incrementOpsGet() const {
+            if (iteratorValid()) {
+                itr->second->incrementOpsGet();
+            }
+        }
+
+        void incrementOpsStore() const {
+            if (iteratorValid()) {
+                itr->second->incrementOpsStore();
+            }
+        }
+
+        void incrementOpsDelete() const {
+            if (iteratorValid()) {
+                itr->second->incrementOpsDelete();
+            }
+        }
+
         /**
          * Dump the manifest to std::cerr
          */
@@ -252,6 +332,13 @@ public:
          * The key used in construction of this handle.
          */
         ::DocKey key;
+
+        /**
+         * The cachedEntry to restore when this handle is destroyed, if it
+         * set cachedEntry (cached).
+         */
+        CachedEntry previous = {};
+        bool cached = false;
     };
 
     /**
@@ -259,8 +346,8 @@ public:
      */
     class WriteHandle {
     public:
-        WriteHandle(Manifest& m, cb::RWLock& lock)
-            : writeLock(lock), manifest(m) {
+        WriteHandle(Manifest& m, ShardedRWLock& lock)
+            : writeLock(lock.writer()), manifest(m) {
         }
 
         WriteHandle(WriteHandle&& rhs)
@@ -353,7 +440,7 @@ public:
         }
 
     private:
-        std::unique_lock<cb::WriterLock> writeLock;
+        std::unique_lock<ShardedRWLock::Writer> writeLock;
         Manifest& manifest;
     };
 
@@ -391,6 +478,28 @@ public:
         return {*this, rwlock};
     }
 
+    /**
+     * Adjust the item count of the collection of the given key. Called
+     * wherever the vbucket's own (on-disk) item count is adjusted.
+     *
+     * Unlike the rest of the Manifest this isn't accessed via a handle, as
+     * it is called with HashTable locks held. If the calling thread holds
+     * a CachingReadHandle for the key, the entry it looked up is updated
+     * directly. Otherwise the entry is looked up under countersLock, which
+     * is never held while taking any other lock.
+     */
+    void updateItemCount(const ::DocKey& key, int64_t delta) const;
+
+    /**
+     * Adjust the memory used by the collection of the given key. Called by
+     * the HashTable whenever the memory used by a StoredValue changes, so
+     * locks as updateItemCount.
+     */
+    void updateMemUsed(const ::DocKey& key, int64_t delta) const;
+
+    /// Reset the item count of every collection to zero.
+    void resetItemCounts() const;
+
     /**
      * Return a std::string containing a JSON representation of a
      * VBucket::Manifest. The input is an Item previously created for an event
@@ -599,6 +708,21 @@ private:
      */
     container::const_iterator getManifestEntry(const ::DocKey& key) const;
 
+    /**
+     * Get the entry whose counters the key's item and memory usage count
+     * against, or nullptr for system keys and unknown collections. Unlike
+     * getManifestEntry this also returns the entry of a collection which is
+     * being deleted. Must be called with countersLock held.
+     */
+    ManifestEntry* getEntryForCounters(const ::DocKey& key) const;
+
+    /**
+     * @return the entry the calling thread's CachingReadHandle looked up,
+     *         if it was created for the given key of this manifest, else
+     *         nullptr.
+     */
+    ManifestEntry* getCachedEntry(const ::DocKey& key) const;
+
 protected:
     /**
      * Add a collection entry to the manifest specifing the revision that it was
@@ -823,9 +947,29 @@ protected:
             nDeletingCollections;
 
     /**
-     * shared lock to allow concurrent readers and safe updates
+     * shared lock to allow concurrent readers and safe updates. Every
+     * front-end operation takes the read lock, so it is sharded to keep the
+     * readers on different threads off each other's cache lines.
+     */
+    mutable ShardedRWLock rwlock;
+
+    /**
+     * Taken (for writing) along with the write lock when map or separator
+     * change, so that the item and memory counters can be updated while
+     * holding only this (for reading) - see updateItemCount. Sharded like
+     * rwlock, as the flusher and the item pager read it for every item.
+     */
+    mutable ShardedRWLock countersLock;
+
+    /**
+     * The entry looked up by the most recent CachingReadHandle the calling
+     * thread created (and still holds), if any. The HashTable updates the
+     * memory used by the key of a front-end operation with its hash bucket
+     * lock held, several times per operation; this saves splitting the key
+     * and looking up the entry each time. Much like ObjectRegistry tracks
+     * which engine a thread allocates memory for.
      */
-    mutable cb::RWLock rwlock;
+    static thread_local CachedEntry cachedEntry;
 
     friend std::ostream& operator<<(std::ostream& os, const Manifest& manifest);
 };
@@ -23,6 +23,7 @@
 
 #include <platform/make_unique.h>
 #include <platform/sized_buffer.h>
+#include <relaxed_atomic.h>
 
 #include <memory>
 
@@ -34,6 +35,8 @@ namespace VB {
  * needs from a vbucket's perspective.
  * - The Collections::Manifest revision
  * - The seqno lifespace of the collection
+ * - Counters of the front-end operations on the collection, and of the
+ *   collection's items and the memory they use
  *
  * Additionally this object is designed for use by Collections::VB::Manifest,
  * this is why the object stores a pointer to a std::string collection name,
@@ -48,7 +51,12 @@ public:
                   identifier.getName().data(), identifier.getName().size())),
           uid(identifier.getUid()),
           startSeqno(-1),
-          endSeqno(-1) {
+          endSeqno(-1),
+          opsGet(0),
+          opsStore(0),
+          opsDelete(0),
+          itemCount(0),
+          memUsed(0) {
         // Setters validate the start/end range is valid
         setStartSeqno(_startSeqno);
         setEndSeqno(_endSeqno);
@@ -59,14 +67,24 @@ public:
                   std::make_unique<std::string>(rhs.collectionName->c_str())),
           uid(rhs.uid),
           startSeqno(rhs.startSeqno),
-          endSeqno(rhs.endSeqno) {
+          endSeqno(rhs.endSeqno),
+          opsGet(rhs.opsGet.load()),
+          opsStore(rhs.opsStore.load()),
+          opsDelete(rhs.opsDelete.load()),
+          itemCount(rhs.itemCount.load()),
+          memUsed(rhs.memUsed.load()) {
     }
 
     ManifestEntry(ManifestEntry&& rhs)
         : collectionName(std::move(rhs.collectionName)),
           uid(rhs.uid),
           startSeqno(rhs.startSeqno),
-          endSeqno(rhs.endSeqno) {
+          endSeqno(rhs.endSeqno),
+          opsGet(rhs.opsGet.load()),
+          opsStore(rhs.opsStore.load()),
+          opsDelete(rhs.opsDelete.load()),
+          itemCount(rhs.itemCount.load()),
+          memUsed(rhs.memUsed.load()) {
     }
 
     ManifestEntry& operator=(ManifestEntry&& rhs) {
@@ -74,6 +92,11 @@ public:
         uid = rhs.uid;
         startSeqno = rhs.startSeqno;
         endSeqno = rhs.endSeqno;
+        opsGet = rhs.opsGet.load();
+        opsStore = rhs.opsStore.load();
+        opsDelete = rhs.opsDelete.load();
+        itemCount = rhs.itemCount.load();
+        memUsed = rhs.memUsed.load();
         return *this;
     }
 
@@ -82,6 +105,11 @@ public:
         uid = rhs.uid;
         startSeqno = rhs.startSeqno;
         endSeqno = rhs.endSeqno;
+        opsGet = rhs.opsGet.load();
+        opsStore = rhs.opsStore.load();
+        opsDelete = rhs.opsDelete.load();
+        itemCount = rhs.itemCount.load();
+        memUsed = rhs.memUsed.load();
         return *this;
     }
 
@@ -192,6 +220,63 @@ public:
         return !isOpen() && isDeleting();
     }
 
+    /**
+     * The operation counters are updated by the front-end threads with relaxed
+     * atomics (no ordering is needed between them), and only summed up when
+     * the collection stats are requested.
+     */
+    void incrementOpsGet() {
+        opsGet++;
+    }
+
+    void incrementOpsStore() {
+        opsStore++;
+    }
+
+    void incrementOpsDelete() {
+        opsDelete++;
+    }
+
+    uint64_t getOpsGet() const {
+        return opsGet;
+    }
+
+    uint64_t getOpsStore() const {
+        return opsStore;
+    }
+
+    uint64_t getOpsDelete() const {
+        return opsDelete;
+    }
+
+    /**
+     * The item count follows the vbucket's on-disk item count (so is
+     * updated by the flusher) and the memory used follows the HashTable's
+     * memory usage. Both are updated without the manifest lock (see
+     * Manifest::updateItemCount and Manifest::updateMemUsed), and can
+     * briefly go negative if a collection is deleted and added back while
+     * its old items are being erased.
+     */
+    void updateItemCount(int64_t delta) {
+        itemCount += delta;
+    }
+
+    void resetItemCount() {
+        itemCount = 0;
+    }
+
+    void updateMemUsed(int64_t delta) {
+        memUsed += delta;
+    }
+
+    int64_t getItemCount() const {
+        return itemCount;
+    }
+
+    int64_t getMemUsed() const {
+        return memUsed;
+    }
+
     /**
      * Inform the collection that all items of the collection up to endSeqno
      * have been deleted.
@@ -247,6 +332,17 @@ private:
      */
     int64_t startSeqno;
     int64_t endSeqno;
+
+    /// Number of successful reads, stores and deletes of the collection's
+    /// documents in this vbucket
+    Couchbase::RelaxedAtomic<uint64_t> opsGet;
+    Couchbase::RelaxedAtomic<uint64_t> opsStore;
+    Couchbase::RelaxedAtomic<uint64_t> opsDelete;
+
+    /// Number of (non-deleted) items of the collection in this vbucket, and
+    /// the memory used by the collection's StoredValues
+    Couchbase::RelaxedAtomic<int64_t> itemCount;
+    Couchbase::RelaxedAtomic<int64_t> memUsed;
 };
 
 std::ostream& operator<<(std::ostream& os, const ManifestEntry& manifestEntry);
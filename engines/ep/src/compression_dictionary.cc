@@ -0,0 +1,206 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "compression_dictionary.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+#ifdef EP_USE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+/**
+ * The live dictionaries, indexed by their id. Readers (decompress) access
+ * this lock-free; registration and removal are serialised by registryMutex.
+ */
+static std::array<std::atomic<const CompressionDictionary*>,
+                  CompressionDictionary::maxDictionaries>
+        registry;
+static std::mutex registryMutex;
+
+#ifdef EP_USE_ZSTD
+
+// The compression level used for all values. Dictionary compression is
+// applied by a background task, so favour ratio over compression speed;
+// decompression speed is largely independent of the level.
+static const int compressionLevel = 3;
+
+struct CCtxDeleter {
+    void operator()(ZSTD_CCtx* ctx) {
+        ZSTD_freeCCtx(ctx);
+    }
+};
+
+struct DCtxDeleter {
+    void operator()(ZSTD_DCtx* ctx) {
+        ZSTD_freeDCtx(ctx);
+    }
+};
+
+// Contexts are expensive to create relative to the cost of compressing a
+// small document, so each thread re-uses its own.
+static ZSTD_CCtx* getCCtx() {
+    static thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> ctx(
+            ZSTD_createCCtx());
+    return ctx.get();
+}
+
+static ZSTD_DCtx* getDCtx() {
+    static thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> ctx(
+            ZSTD_createDCtx());
+    return ctx.get();
+}
+
+CompressionDictionary::CompressionDictionary(std::vector<char> dict)
+    : dictionary(std::move(dict)),
+      cdict(ZSTD_createCDict(
+              dictionary.data(), dictionary.size(), compressionLevel)),
+      ddict(ZSTD_createDDict(dictionary.data(), dictionary.size())) {
+}
+
+CompressionDictionary::~CompressionDictionary() {
+    if (registered) {
+        std::lock_guard<std::mutex> lh(registryMutex);
+        registry[id].store(nullptr);
+    }
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeDDict(ddict);
+}
+
+std::unique_ptr<CompressionDictionary> CompressionDictionary::train(
+        const std::vector<std::string>& samples, size_t maxSize) {
+    std::string buffer;
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    for (const auto& sample : samples) {
+        buffer.append(sample);
+        sizes.push_back(sample.size());
+    }
+
+    std::vector<char> dict(maxSize);
+    const auto size = ZDICT_trainFromBuffer(dict.data(),
+                                            dict.size(),
+                                            buffer.data(),
+                                            sizes.data(),
+                                            unsigned(sizes.size()));
+    if (ZDICT_isError(size)) {
+        return {};
+    }
+    dict.resize(size);
+
+    // Digest the dictionary before picking an id, so a failure doesn't
+    // leave a registered (or locked) slot behind.
+    std::unique_ptr<CompressionDictionary> result(
+            new CompressionDictionary(std::move(dict)));
+    if (!result->cdict || !result->ddict) {
+        return {};
+    }
+
+    std::lock_guard<std::mutex> lh(registryMutex);
+    for (size_t ii = 0; ii < registry.size(); ++ii) {
+        if (registry[ii].load() == nullptr) {
+            result->id = uint8_t(ii);
+            result->registered = true;
+            registry[ii].store(result.get());
+            return result;
+        }
+    }
+    // All ids in use. result was never registered, so destroying it (after
+    // the lock is released) doesn't touch the registry.
+    return {};
+}
+
+bool CompressionDictionary::compress(cb::const_char_buffer input,
+                                     std::vector<char>& output) const {
+    auto* cctx = getCCtx();
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+    // The dictionary is identified by our own (1 byte) id, so omit zstd's
+    // (4 byte) dictionary id from each frame.
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_dictIDFlag, 0);
+    if (ZSTD_isError(ZSTD_CCtx_refCDict(cctx, cdict))) {
+        return false;
+    }
+
+    output.resize(1 + ZSTD_compressBound(input.size()));
+    output[0] = char(id);
+    const auto size = ZSTD_compress2(cctx,
+                                     output.data() + 1,
+                                     output.size() - 1,
+                                     input.data(),
+                                     input.size());
+    if (ZSTD_isError(size)) {
+        return false;
+    }
+    output.resize(1 + size);
+    return true;
+}
+
+bool CompressionDictionary::decompress(cb::const_char_buffer input,
+                                       std::vector<char>& output) {
+    if (input.size() < 1) {
+        return false;
+    }
+    const auto* dict = registry[uint8_t(input[0])].load();
+    if (dict == nullptr) {
+        return false;
+    }
+
+    const char* frame = input.data() + 1;
+    const size_t frameSize = input.size() - 1;
+    const auto size = ZSTD_getFrameContentSize(frame, frameSize);
+    if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR) {
+        return false;
+    }
+
+    output.resize(size);
+    const auto ret = ZSTD_decompress_usingDDict(getDCtx(),
+                                                output.data(),
+                                                output.size(),
+                                                frame,
+                                                frameSize,
+                                                dict->ddict);
+    return !ZSTD_isError(ret) && ret == size;
+}
+
+#else
+
+CompressionDictionary::CompressionDictionary(std::vector<char> dict)
+    : dictionary(std::move(dict)), cdict(nullptr), ddict(nullptr) {
+}
+
+CompressionDictionary::~CompressionDictionary() {
+}
+
+std::unique_ptr<CompressionDictionary> CompressionDictionary::train(
+        const std::vector<std::string>& samples, size_t maxSize) {
+    return {};
+}
+
+bool CompressionDictionary::compress(cb::const_char_buffer input,
+                                     std::vector<char>& output) const {
+    return false;
+}
+
+bool CompressionDictionary::decompress(cb::const_char_buffer input,
+                                       std::vector<char>& output) {
+    return false;
+}
+
+#endif // EP_USE_ZSTD
@@ -0,0 +1,116 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include <platform/sized_buffer.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+/**
+ * A trained (zstd) compression dictionary, used to compress the in-memory
+ * values of a bucket.
+ *
+ * Small documents compress poorly when compressed independently, as each
+ * compressed document has to describe all of its own content. When the
+ * documents of a bucket are similar (e.g. JSON documents sharing the same
+ * field names) a dictionary trained from a sample of them can be shared by
+ * all documents, and only the differences need to be encoded.
+ *
+ * Dictionary compression is an in-memory representation only - there is no
+ * protocol datatype for it - so values compressed with a dictionary must be
+ * decompressed before they leave the HashTable (see
+ * StoredValue::getDecodedValue()).
+ *
+ * Each compressed value is prefixed with the (one byte) id of the dictionary
+ * it was compressed with; live dictionaries are registered in a process-wide
+ * table so any value can be decompressed without needing a reference to its
+ * owning bucket. An id is only re-used once its dictionary is destroyed, so
+ * a dictionary must outlive all values compressed with it: dictionaries are
+ * shared (std::shared_ptr) and each HashTable holding values compressed
+ * with one keeps a reference to it (see HashTable::compressValue()).
+ *
+ * Only available if ep-engine was built with zstd (EP_USE_ZSTD); otherwise
+ * train() never returns a dictionary.
+ */
+class CompressionDictionary {
+public:
+    ~CompressionDictionary();
+
+    /**
+     * Train a new dictionary from the given sample documents.
+     *
+     * @param samples documents representative of the data to be compressed
+     * @param maxSize maximum size in bytes of the dictionary
+     * @return the trained dictionary, or nullptr if a dictionary could not
+     *         be trained (insufficient samples, zstd not available or the
+     *         maximum number of live dictionaries has been reached).
+     */
+    static std::unique_ptr<CompressionDictionary> train(
+            const std::vector<std::string>& samples, size_t maxSize);
+
+    /**
+     * Compress the given data with this dictionary.
+     *
+     * @param input the data to compress
+     * @param output where to store the compressed data
+     * @return true if successful
+     */
+    bool compress(cb::const_char_buffer input, std::vector<char>& output) const;
+
+    /**
+     * Decompress data which was compressed by any live dictionary.
+     *
+     * @param input the output of a previous call to compress()
+     * @param output where to store the decompressed data
+     * @return true if successful
+     */
+    static bool decompress(cb::const_char_buffer input,
+                           std::vector<char>& output);
+
+    /// @return the size in bytes of the dictionary.
+    size_t getSize() const {
+        return dictionary.size();
+    }
+
+    /// Maximum number of dictionaries which can be live at once.
+    static const size_t maxDictionaries = 256;
+
+private:
+    explicit CompressionDictionary(std::vector<char> dictionary);
+
+    // The raw (trained) dictionary.
+    const std::vector<char> dictionary;
+
+    // Id of this dictionary, prefixed to each compressed value. Assigned
+    // by train() when the dictionary is registered.
+    uint8_t id = 0;
+
+    // Is this dictionary in the registry (under id)?
+    bool registered = false;
+
+    // Digested forms of the dictionary for compression / decompression.
+    ZSTD_CDict_s* cdict;
+    ZSTD_DDict_s* ddict;
+};
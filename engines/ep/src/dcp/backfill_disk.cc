@@ -79,6 +79,13 @@ void CacheCallback::callback(CacheLookup& lookup) {
         return;
     }
 
+    // Skip the items of the collections the stream filters out, before
+    // looking them up in memory or reading them from disk.
+    if (!stream_->isKeyAllowed(lookup.getKey())) {
+        setStatus(ENGINE_KEY_EEXISTS);
+        return;
+    }
+
     VBucketPtr vb =
             engine_.getKVBucket()->getVBucket(lookup.getVBucketId());
     if (!vb) {
@@ -297,6 +297,7 @@ ActiveStream::ActiveStream(EventuallyPersistentEngine* e,
     backfillItems.memory = 0;
     backfillItems.disk = 0;
     backfillItems.sent = 0;
+    backfillItems.filtered = 0;
 
     bufferedBackfill.bytes = 0;
     bufferedBackfill.items = 0;
@@ -481,6 +482,18 @@ void ActiveStream::markDiskSnapshot(uint64_t startSeqno, uint64_t endSeqno) {
     notifyStreamReady();
 }
 
+bool ActiveStream::isKeyAllowed(const DocKey& key) {
+    bool allowed;
+    {
+        LockHolder lh(streamMutex);
+        allowed = filter.allowKey(key);
+    }
+    if (!allowed) {
+        backfillItems.filtered++;
+    }
+    return allowed;
+}
+
 bool ActiveStream::backfillReceived(std::unique_ptr<Item> itm,
                                     backfill_source_t backfill_source,
                                     bool force) {
@@ -804,6 +817,9 @@ void ActiveStream::addStats(ADD_STAT add_stat, const void *c) {
         checked_snprintf(buffer, bsize, "%s:stream_%d_backfill_sent",
                          name_.c_str(), vb_);
         add_casted_stat(buffer, backfillItems.sent, add_stat, c);
+        checked_snprintf(buffer, bsize, "%s:stream_%d_backfill_filtered",
+                         name_.c_str(), vb_);
+        add_casted_stat(buffer, backfillItems.filtered, add_stat, c);
         checked_snprintf(buffer, bsize, "%s:stream_%d_memory_phase",
                          name_.c_str(), vb_);
         add_casted_stat(buffer, itemsFromMemoryPhase.load(), add_stat, c);
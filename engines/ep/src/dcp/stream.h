@@ -255,6 +255,15 @@ public:
 
     void markDiskSnapshot(uint64_t startSeqno, uint64_t endSeqno);
 
+    /**
+     * Could an item with the given key be sent on this stream? Called by
+     * the disk backfill before it reads the item, so that the items of
+     * collections which the stream filters out are skipped.
+     *
+     * @return false if the stream's filter would drop the item
+     */
+    bool isKeyAllowed(const DocKey& key);
+
     bool backfillReceived(std::unique_ptr<Item> itm,
                           backfill_source_t backfill_source,
                           bool force);
@@ -370,6 +379,8 @@ protected:
         std::atomic<size_t> memory;
         std::atomic<size_t> disk;
         std::atomic<size_t> sent;
+        // Skipped (without being read) as the filter drops them
+        std::atomic<size_t> filtered;
     } backfillItems;
 
     /* The last sequence number queued from disk or memory and is
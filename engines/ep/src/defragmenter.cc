@@ -19,17 +19,23 @@
 
 #include <phosphor/phosphor.h>
 
+#include "compression_dictionary.h"
 #include "defragmenter_visitor.h"
 #include "ep_engine.h"
 #include "executorpool.h"
 #include "kv_bucket.h"
 #include "stored-value.h"
 
+#include <algorithm>
+
 DefragmenterTask::DefragmenterTask(EventuallyPersistentEngine* e,
                                    EPStats& stats_)
     : GlobalTask(e, TaskId::DefragmenterTask, 0, false),
       stats(stats_),
-      epstore_position(engine->getKVBucket()->startPosition()) {
+      epstore_position(engine->getKVBucket()->startPosition()),
+      passReclaimedBytes(0),
+      dictionaryTrainingFailed(false),
+      utilizationUnsupportedLogged(false) {
 }
 
 bool DefragmenterTask::run(void) {
@@ -40,10 +46,26 @@ bool DefragmenterTask::run(void) {
         // then resume from where we last were, otherwise create a new visitor
         // starting from the beginning.
         if (!prAdapter) {
-            prAdapter = std::make_unique<PauseResumeVBAdapter>(
-                    std::make_unique<DefragmentVisitor>(
-                            getAgeThreshold(), getMaxValueSize(alloc_hooks)));
+            auto visitor = std::make_unique<DefragmentVisitor>(
+                    getAgeThreshold(), getMaxValueSize(alloc_hooks));
+            if (engine->getConfiguration().getDefragmenterPolicy() ==
+                "utilization") {
+                if (alloc_hooks->is_allocation_utilization_supported &&
+                    alloc_hooks->is_allocation_utilization_supported()) {
+                    visitor->setAllocatorHooks(alloc_hooks);
+                } else if (!utilizationUnsupportedLogged) {
+                    LOG(EXTENSION_LOG_NOTICE,
+                        "%s for bucket '%s': the allocator can't report the "
+                        "slab utilization, using the age policy",
+                        to_string(getDescription()).c_str(),
+                        engine->getName().c_str());
+                    utilizationUnsupportedLogged = true;
+                }
+            }
+            prAdapter =
+                    std::make_unique<PauseResumeVBAdapter>(std::move(visitor));
             epstore_position = engine->getKVBucket()->startPosition();
+            passReclaimedBytes = 0;
         }
 
         // Print start status.
@@ -56,9 +78,10 @@ bool DefragmenterTask::run(void) {
             ss << " resuming from " << epstore_position << ", ";
             ss << prAdapter->getHashtablePosition() << ".";
         }
+        const size_t mappedBefore = getMappedBytes();
         ss << " Using chunk_duration=" << getChunkDuration().count() << " ms."
            << " mem_used=" << stats.getEstimatedTotalMemoryUsed()
-           << ", mapped_bytes=" << getMappedBytes();
+           << ", mapped_bytes=" << mappedBefore;
         LOG(EXTENSION_LOG_INFO, "%s", ss.str().c_str());
 
         // Disable thread-caching (as we are about to defragment, and hence don't
@@ -72,6 +95,9 @@ bool DefragmenterTask::run(void) {
         visitor.setDeadline(deadline);
         visitor.clearStats();
         visitor.setCompressionMode(engine->getCompressionMode());
+        visitor.setCompressionDictionary(
+                engine->getKVBucket()->getCompressionDictionary());
+        visitor.setSampleLimit(getDictionarySampleLimit());
 
         // Do it - set off the visitor.
         epstore_position = engine->getKVBucket()->pauseResumeVisit(
@@ -84,12 +110,20 @@ bool DefragmenterTask::run(void) {
         // Update stats
         stats.defragNumMoved.fetch_add(visitor.getDefragCount());
         stats.defragNumVisited.fetch_add(visitor.getVisitedCount());
+        stats.defragNumBytesMoved.fetch_add(visitor.getDefragBytes());
+
+        maybeTrainDictionary(visitor);
 
         // Release any free memory we now have in the allocator back to the OS.
         // TODO: Benchmark this - is it necessary? How much of a slowdown does it
         // add? How much memory does it return?
         alloc_hooks->release_free_memory();
 
+        // The mapped bytes also change with the other work going on, so this
+        // is only an estimate of what the defragmenter gave back.
+        const size_t mappedAfter = getMappedBytes();
+        passReclaimedBytes += int64_t(mappedBefore) - int64_t(mappedAfter);
+
         // Check if the visitor completed a full pass.
         bool completed = (epstore_position ==
                                     engine->getKVBucket()->endPosition());
@@ -99,7 +133,9 @@ bool DefragmenterTask::run(void) {
         ss << to_string(getDescription()) << " for bucket '"
            << engine->getName() << "'";
         if (completed) {
-            ss << " finished.";
+            const auto reclaimed = std::max(passReclaimedBytes, int64_t(0));
+            ss << " finished, reclaimed ~" << reclaimed << " bytes this pass.";
+            stats.defragLastPassReclaimed.store(size_t(reclaimed));
         } else {
             ss << " paused at position " << epstore_position << ".";
         }
@@ -108,9 +144,10 @@ bool DefragmenterTask::run(void) {
                                                                       start);
         ss << " Took " << duration.count() << " us."
            << " moved " << visitor.getDefragCount() << "/"
-           << visitor.getVisitedCount() << " visited documents."
+           << visitor.getVisitedCount() << " visited documents ("
+           << visitor.getDefragBytes() << " bytes)."
            << " mem_used=" << stats.getEstimatedTotalMemoryUsed()
-           << ", mapped_bytes=" << getMappedBytes() << ". Sleeping for "
+           << ", mapped_bytes=" << mappedAfter << ". Sleeping for "
            << getSleepTime() << " seconds.";
         LOG(EXTENSION_LOG_INFO, "%s", ss.str().c_str());
 
@@ -178,7 +215,13 @@ std::chrono::milliseconds DefragmenterTask::getChunkDuration() const {
 size_t DefragmenterTask::getMappedBytes() {
     ALLOCATOR_HOOKS_API* alloc_hooks = engine->getServerApi()->alloc_hooks;
 
+    // Only look at the bucket's own memory if it has an arena
     allocator_stats stats = {0};
+    const auto* arena = engine->getArena();
+    if (arena && arena->getStats(stats)) {
+        return stats.fragmentation_size + stats.allocated_size;
+    }
+
     stats.ext_stats.resize(alloc_hooks->get_extra_stats_size());
     alloc_hooks->get_allocator_stats(&stats);
 
@@ -189,3 +232,45 @@ size_t DefragmenterTask::getMappedBytes() {
 DefragmentVisitor& DefragmenterTask::getDefragVisitor() {
     return dynamic_cast<DefragmentVisitor&>(prAdapter->getHTVisitor());
 }
+
+size_t DefragmenterTask::getDictionarySampleLimit() const {
+    auto& config = engine->getConfiguration();
+    if (!config.isCompressionDictionaryEnabled() || dictionaryTrainingFailed ||
+        engine->getKVBucket()->getCompressionDictionary()) {
+        return 0;
+    }
+    return config.getCompressionDictionarySamples();
+}
+
+void DefragmenterTask::maybeTrainDictionary(DefragmentVisitor& visitor) {
+    const auto limit = getDictionarySampleLimit();
+    if (limit == 0 || visitor.getSampleCount() < limit) {
+        return;
+    }
+
+    const auto start = ProcessClock::now();
+    auto dictionary = CompressionDictionary::train(
+            visitor.takeSamples(),
+            engine->getConfiguration().getCompressionDictionarySize());
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            ProcessClock::now() - start);
+    if (!dictionary) {
+        LOG(EXTENSION_LOG_WARNING,
+            "%s for bucket '%s' failed to train a compression dictionary "
+            "from %" PRIu64 " samples",
+            to_string(getDescription()).c_str(),
+            engine->getName().c_str(),
+            uint64_t(limit));
+        dictionaryTrainingFailed = true;
+        return;
+    }
+
+    LOG(EXTENSION_LOG_NOTICE,
+        "%s for bucket '%s' trained a %" PRIu64
+        " byte compression dictionary in %" PRIu64 " ms",
+        to_string(getDescription()).c_str(),
+        engine->getName().c_str(),
+        uint64_t(dictionary->getSize()),
+        uint64_t(duration.count()));
+    engine->getKVBucket()->setCompressionDictionary(std::move(dictionary));
+}
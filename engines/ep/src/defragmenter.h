@@ -80,12 +80,19 @@ class PauseResumeVBAdapter;
  * number of heuristics to attempt to infer which objects would be
  * suitable candidates:
  *
- * 1. Document age - record when an object was last allocated and
- *    consider documents for defrag when they reach a particular age
+ * 1. Slab utilization - if the allocator can report how many of the
+ *    regions of the slab (run of pages dedicated to a single size class)
+ *    containing an object are in use (defragmenter_policy=utilization),
+ *    only the objects on slabs which are used less than the average slab
+ *    of their size class are moved. Those are the slabs which are most
+ *    likely to be emptied and given back to the OS.
+ *
+ * 2. Document age - otherwise, record when an object was last allocated
+ *    and consider documents for defrag when they reach a particular age
  *    (measured in number of defragmenter sweeps they have existed
  *    for).
  *
- * 2. Document size - Skip documents which are larger than the largest
+ * 3. Document size - Skip documents which are larger than the largest
  *    size class, or are zero-sized.
  *
  * An additional policy consideration is how to locate
@@ -133,18 +140,38 @@ private:
     /// Returns the underlying DefragmentVisitor instance.
     DefragmentVisitor& getDefragVisitor();
 
+    // Number of document samples to collect for training a compression
+    // dictionary; zero if no (further) training should be attempted.
+    size_t getDictionarySampleLimit() const;
+
+    // Train a compression dictionary from the samples collected by the
+    // visitor (once it has collected enough) and hand it to the bucket.
+    void maybeTrainDictionary(DefragmentVisitor& visitor);
+
     /// Reference to EP stats, used to check on mem_used.
     EPStats &stats;
 
     // Opaque marker indicating how far through the epStore we have visited.
     KVBucketIface::Position epstore_position;
 
+    // How many bytes the mapped memory has dropped by during the current
+    // pass (negative if it grew).
+    int64_t passReclaimedBytes;
+
     /**
      * Visitor adapter which supports pausing & resuming (records how far
      * though a VBucket is has got). unique_ptr as we re-create it for each
      * complete pass.
      */
     std::unique_ptr<PauseResumeVBAdapter> prAdapter;
+
+    // Set if training a compression dictionary failed; training is not
+    // re-attempted.
+    bool dictionaryTrainingFailed;
+
+    // Set once we've logged that the allocator can't report the slab
+    // utilization (so defragmenter_policy=utilization uses the age policy).
+    bool utilizationUnsupportedLogged;
 };
 
 #endif /* DEFRAGMENTER_H_ */
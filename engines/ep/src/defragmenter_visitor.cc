@@ -17,6 +17,8 @@
 
 #include "defragmenter_visitor.h"
 
+#include "compression_dictionary.h"
+
 // DegragmentVisitor implementation ///////////////////////////////////////////
 
 DefragmentVisitor::DefragmentVisitor(uint8_t age_threshold_,
@@ -24,8 +26,12 @@ DefragmentVisitor::DefragmentVisitor(uint8_t age_threshold_,
     : max_size_class(max_size_class),
       age_threshold(age_threshold_),
       defrag_count(0),
+      defrag_bytes(0),
       visited_count(0),
-      currentVb(nullptr) {
+      compressMode(BucketCompressionMode::Off),
+      sampleLimit(0),
+      currentVb(nullptr),
+      allocHooks(nullptr) {
 }
 
 DefragmentVisitor::~DefragmentVisitor() {
@@ -40,9 +46,19 @@ bool DefragmentVisitor::visit(const HashTable::HashBucketLock& lh,
     const size_t value_len = v.valuelen();
     bool valueCompressed = false;
 
+    // Sample documents which are candidates for dictionary compression.
+    if (samples.size() < sampleLimit && value_len > 0 && v.isResident() &&
+        !v.isDictionaryCompressed() &&
+        !mcbp::datatype::is_snappy(v.getDatatype()) &&
+        !mcbp::datatype::is_xattr(v.getDatatype())) {
+        samples.emplace_back(v.getValue()->getData(), value_len);
+    }
+
     // Check if the item can be compressed
-    if (!mcbp::datatype::is_snappy(v.getDatatype()) &&
-        compressMode == BucketCompressionMode::Active) {
+    if (compressionDictionary) {
+        currentVb->ht.compressValue(v, compressionDictionary);
+    } else if (!mcbp::datatype::is_snappy(v.getDatatype()) &&
+               compressMode == BucketCompressionMode::Active) {
         currentVb->ht.compressValue(v);
     }
 
@@ -51,15 +67,27 @@ bool DefragmentVisitor::visit(const HashTable::HashBucketLock& lh,
     // supports, so it can be successfully reallocated to a run with other
     // objects of the same size.
     if (!valueCompressed && value_len > 0 && value_len <= max_size_class) {
-        // If sufficiently old and if it looks like nothing else holds a
-        // reference to the blob reallocate, otherwise increment it's age.
+        // If it looks like nothing else holds a reference to the blob, and
+        // it either lives on a sparsely used slab or (if the allocator
+        // can't tell) is sufficiently old, reallocate it. Otherwise
+        // increment it's age.
         // It may be possible to add a reference to the blob without holding
         // any locks, therefore the check is somewhat of an estimate which
         // should be good enough.
-        if (v.getValue()->getAge() >= age_threshold &&
-            v.getValue().refCount() < 2) {
+        allocator_utilization util;
+        bool candidate;
+        if (allocHooks && allocHooks->get_allocation_utilization &&
+            allocHooks->get_allocation_utilization(v.getValue().get().get(),
+                                                   &util)) {
+            candidate = isOnSparseSlab(util);
+        } else {
+            candidate = v.getValue()->getAge() >= age_threshold;
+        }
+
+        if (candidate && v.getValue().refCount() < 2) {
             v.reallocate();
             defrag_count++;
+            defrag_bytes += v.getValue()->getSize();
         } else {
             v.getValue()->incrementAge();
         }
@@ -73,6 +101,7 @@ bool DefragmentVisitor::visit(const HashTable::HashBucketLock& lh,
 
 void DefragmentVisitor::clearStats() {
     defrag_count = 0;
+    defrag_bytes = 0;
     visited_count = 0;
 }
 
@@ -84,11 +113,53 @@ size_t DefragmentVisitor::getVisitedCount() const {
     return visited_count;
 }
 
+size_t DefragmentVisitor::getDefragBytes() const {
+    return defrag_bytes;
+}
+
 void DefragmentVisitor::setCompressionMode(
         const BucketCompressionMode compressionMode) {
     compressMode = compressionMode;
 }
 
+void DefragmentVisitor::setCompressionDictionary(
+        std::shared_ptr<const CompressionDictionary> dictionary) {
+    compressionDictionary = std::move(dictionary);
+}
+
+void DefragmentVisitor::setSampleLimit(size_t limit) {
+    sampleLimit = limit;
+}
+
+void DefragmentVisitor::setAllocatorHooks(ALLOCATOR_HOOKS_API* hooks) {
+    allocHooks = hooks;
+}
+
+bool DefragmentVisitor::isOnSparseSlab(const allocator_utilization& util) {
+    // Large allocations don't live in a slab, and there's no point in
+    // moving objects out of a full slab or the slab new objects go to.
+    if (util.slab_regions <= 1 || util.bin_regions == 0 ||
+        util.slab_free == 0 || util.current_slab) {
+        return false;
+    }
+
+    // The slabs which are used less than the average slab of the size
+    // class are the ones most likely to be emptied (and released).
+    const auto slabUsed = util.slab_regions - util.slab_free;
+    const auto binUsed = util.bin_regions - util.bin_free;
+    return slabUsed * util.bin_regions < binUsed * util.slab_regions;
+}
+
+size_t DefragmentVisitor::getSampleCount() const {
+    return samples.size();
+}
+
+std::vector<std::string> DefragmentVisitor::takeSamples() {
+    std::vector<std::string> result;
+    result.swap(samples);
+    return result;
+}
+
 void DefragmentVisitor::setCurrentVBucket(VBucket& vb) {
     currentVb = &vb;
 }
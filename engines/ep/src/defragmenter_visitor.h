@@ -25,9 +25,13 @@
 #include "vb_visitors.h"
 #include "vbucket.h"
 
+#include <memcached/allocator_hooks.h>
+
 /**
  * Defragmentation visitor - visit all objects in a VBucket, compress the
- * documents and defragment any which have reached the specified age.
+ * documents and defragment any which live on a sparsely used slab (if the
+ * allocator can tell, see setAllocatorHooks) or have reached the specified
+ * age.
  */
 class DefragmentVisitor : public VBucketAwareHTVisitor {
 public:
@@ -41,6 +45,33 @@ public:
     // Set the current bucket compression mode
     void setCompressionMode(const BucketCompressionMode compressionMode);
 
+    // Set the dictionary to compress documents with. If non-null, documents
+    // are compressed with the dictionary irrespective of the compression
+    // mode.
+    void setCompressionDictionary(
+            std::shared_ptr<const CompressionDictionary> dictionary);
+
+    // Set how many document samples to collect for training a compression
+    // dictionary (zero disables sampling).
+    void setSampleLimit(size_t limit);
+
+    // Set the allocator hooks used to check the utilization of the slab
+    // each value lives on; only values on sparsely used slabs are then
+    // moved. If null (or the allocator can't tell) the age of the values
+    // is used instead.
+    void setAllocatorHooks(ALLOCATOR_HOOKS_API* hooks);
+
+    // Returns true if the utilization says the object lives on a slab
+    // which is worth emptying (used less than the average slab of its
+    // size class, and not the slab new objects are allocated from).
+    static bool isOnSparseSlab(const allocator_utilization& util);
+
+    // Returns the number of document samples collected so far.
+    size_t getSampleCount() const;
+
+    // Returns (and removes) the document samples collected so far.
+    std::vector<std::string> takeSamples();
+
     // Implementation of HashTableVisitor interface:
     virtual bool visit(const HashTable::HashBucketLock& lh,
                        StoredValue& v) override;
@@ -54,6 +85,9 @@ public:
     // Returns the number of documents that have been visited.
     size_t getVisitedCount() const;
 
+    // Returns the number of bytes of values that have been moved.
+    size_t getDefragBytes() const;
+
     void setCurrentVBucket(VBucket& vb) override;
 
 private:
@@ -73,12 +107,25 @@ private:
     /* Statistics */
     // Count of how many documents have been defrag'd.
     size_t defrag_count;
+    // Bytes of values which have been moved.
+    size_t defrag_bytes;
     // How many documents have been visited.
     size_t visited_count;
 
     // Current compression mode of the bucket
     BucketCompressionMode compressMode;
 
+    // Dictionary to compress documents with (if any).
+    std::shared_ptr<const CompressionDictionary> compressionDictionary;
+
+    // Document samples collected for training a dictionary, and how many
+    // to collect.
+    std::vector<std::string> samples;
+    size_t sampleLimit;
+
     // The current vbucket that is being processed
     VBucket* currentVb;
+
+    // Allocator hooks to query the slab utilization with (if any).
+    ALLOCATOR_HOOKS_API* allocHooks;
 };
@@ -611,6 +611,7 @@ void EPBucket::flushOneDeleteAll() {
         }
         // Reset disk item count.
         vb->setNumTotalItems(0);
+        vb->resetCollectionItemCounts();
     }
 
     setDeleteAllComplete();
@@ -981,6 +982,7 @@ public:
         // Irrespective of if the in-memory delete succeeded; the document
         // doesn't exist on disk; so decrement the item count.
         vb.decrNumTotalItems();
+        vb.decrCollectionItemCount(key);
     }
 
 private:
@@ -23,6 +23,7 @@
 #include "checkpoint.h"
 #include "collections/manager.h"
 #include "common.h"
+#include "compression_dictionary.h"
 #include "connmap.h"
 #include "dcp/consumer.h"
 #include "dcp/dcpconnmap.h"
@@ -549,6 +550,8 @@ protocol_binary_response_status EventuallyPersistentEngine::setFlushParam(
             getConfiguration().setDefragmenterInterval(v);
         } else if (strcmp(keyz, "defragmenter_age_threshold") == 0) {
             getConfiguration().setDefragmenterAgeThreshold(std::stoull(valz));
+        } else if (strcmp(keyz, "defragmenter_policy") == 0) {
+            getConfiguration().setDefragmenterPolicy(valz);
         } else if (strcmp(keyz, "defragmenter_chunk_duration") == 0) {
             getConfiguration().setDefragmenterChunkDuration(std::stoull(valz));
         } else if (strcmp(keyz, "defragmenter_run") == 0) {
@@ -1970,6 +1973,8 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::initialize(const char* config) {
 
     maxFailoverEntries = configuration.getMaxFailoverEntries();
 
+    initializeArena();
+
     // Start updating the variables from the config!
     VBucket::setMutationMemoryThreshold(
             configuration.getMutationMemThreshold());
@@ -2068,6 +2073,22 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::initialize(const char* config) {
     return ENGINE_SUCCESS;
 }
 
+void EventuallyPersistentEngine::initializeArena() {
+    if (!configuration.isBucketArenaEnabled()) {
+        return;
+    }
+    arena = BucketArena::create(*serverApi->alloc_hooks);
+    if (arena) {
+        LOG(EXTENSION_LOG_NOTICE,
+            "EPEngine::initializeArena: allocating from arena %u",
+            arena->getIndex());
+    } else {
+        LOG(EXTENSION_LOG_WARNING,
+            "EPEngine::initializeArena: bucket_arena_enabled is set but the "
+            "memory allocator doesn't support arenas");
+    }
+}
+
 void EventuallyPersistentEngine::destroy(bool force) {
     stats.forceShutdown = force;
     stats.isShutdown = true;
@@ -2485,8 +2506,12 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::memoryCondition() {
 
 bool EventuallyPersistentEngine::hasMemoryForItemAllocation(
         uint32_t totalItemSize) {
-    return (stats.getEstimatedTotalMemoryUsed() + totalItemSize) <=
-           stats.getMaxDataSize();
+    const auto maxSize = stats.getMaxDataSize();
+    if (totalItemSize > maxSize) {
+        return false;
+    }
+    return stats.getTotalMemoryUsedNear(maxSize - totalItemSize) <=
+           maxSize - totalItemSize;
 }
 
 bool EventuallyPersistentEngine::enableTraffic(bool enable) {
@@ -2772,6 +2797,10 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doEngineStats(const void *cookie,
                     add_stat, cookie);
     add_casted_stat("ep_num_ops_get_meta_on_set_meta",
                     epstats.numOpsGetMetaOnSetWithMeta, add_stat, cookie);
+    add_casted_stat("ep_meta_data_cache_hits",
+                    epstats.metaDataCacheHits, add_stat, cookie);
+    add_casted_stat("ep_meta_data_cache_misses",
+                    epstats.metaDataCacheMisses, add_stat, cookie);
     add_casted_stat("ep_workload_pattern",
                     workload->stringOfWorkLoadPattern(),
                     add_stat, cookie);
@@ -2780,6 +2809,18 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doEngineStats(const void *cookie,
                     add_stat, cookie);
     add_casted_stat("ep_defragmenter_num_moved", epstats.defragNumMoved,
                     add_stat, cookie);
+    add_casted_stat("ep_defragmenter_bytes_moved",
+                    epstats.defragNumBytesMoved,
+                    add_stat,
+                    cookie);
+    add_casted_stat("ep_defragmenter_last_pass_reclaimed",
+                    epstats.defragLastPassReclaimed,
+                    add_stat,
+                    cookie);
+    const auto dictionary = kvBucket->getCompressionDictionary();
+    add_casted_stat("ep_compression_dictionary_bytes",
+                    dictionary ? dictionary->getSize() : 0,
+                    add_stat, cookie);
 
     add_casted_stat("ep_cursor_dropping_lower_threshold",
                     epstats.cursorDroppingLThreshold, add_stat, cookie);
@@ -2990,6 +3031,30 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doMemoryStats(const void *cookie,
         add_casted_stat(it.first.c_str(), it.second, add_stat, cookie);
     }
 
+    allocator_stats arena_stats = {};
+    if (arena && arena->getStats(arena_stats)) {
+        add_casted_stat("ep_arena_allocated_bytes",
+                        arena_stats.allocated_size,
+                        add_stat,
+                        cookie);
+        add_casted_stat("ep_arena_heap_bytes",
+                        arena_stats.heap_size,
+                        add_stat,
+                        cookie);
+        add_casted_stat("ep_arena_resident_bytes",
+                        arena_stats.resident_size,
+                        add_stat,
+                        cookie);
+        add_casted_stat("ep_arena_retained_bytes",
+                        arena_stats.retained_size,
+                        add_stat,
+                        cookie);
+        add_casted_stat("ep_arena_fragmentation_bytes",
+                        arena_stats.fragmentation_size,
+                        add_stat,
+                        cookie);
+    }
+
     return ENGINE_SUCCESS;
 }
 
@@ -3181,26 +3246,39 @@ public:
 };
 
 
-class StatCheckpointTask : public GlobalTask {
+/**
+ * Task which builds the stats of a (potentially large) stat group on a NONIO
+ * thread, so that walking all of the vbuckets or connections doesn't block
+ * the front-end thread. The connection is notified once all of the stats
+ * have been added.
+ */
+class StatsTask : public GlobalTask {
 public:
-    StatCheckpointTask(EventuallyPersistentEngine *e, const void *c,
-            ADD_STAT a) : GlobalTask(e, TaskId::StatCheckpointTask,
-                                     0, false),
-                          ep(e), cookie(c), add_stat(a) { }
+    StatsTask(EventuallyPersistentEngine* e,
+              TaskId id,
+              const void* c,
+              std::string description,
+              std::function<void()> fn)
+        : GlobalTask(e, id, 0, false),
+          ep(e),
+          cookie(c),
+          description(std::move(description)),
+          fn(std::move(fn)) {
+    }
+
     bool run(void) {
-        TRACE_EVENT0("ep-engine/task", "StatsCheckpointTask");
-        StatCheckpointVisitor scv(ep->getKVBucket(), cookie, add_stat);
-        ep->getKVBucket()->visit(scv);
+        TRACE_EVENT0("ep-engine/task", "StatsTask");
+        fn();
         ep->notifyIOComplete(cookie, ENGINE_SUCCESS);
         return false;
     }
 
     cb::const_char_buffer getDescription() {
-        return "checkpoint stats for all vbuckets";
+        return description;
     }
 
     std::chrono::microseconds maxExpectedDuration() {
-        // Task needed to lookup "checkpoint" stats; so the runtime should only
+        // Task needed to build the stats; so the runtime should only
         // affects the particular stat request. However we don't want this to
         // take /too/ long, so set limit of 100ms.
         return std::chrono::milliseconds(100);
@@ -3209,10 +3287,30 @@ public:
 private:
     EventuallyPersistentEngine *ep;
     const void *cookie;
-    ADD_STAT add_stat;
+    const std::string description;
+    const std::function<void()> fn;
 };
 /// @endcond
 
+ENGINE_ERROR_CODE EventuallyPersistentEngine::runStatsTask(
+        const void* cookie,
+        TaskId id,
+        std::string description,
+        std::function<void()> fn) {
+    if (getEngineSpecific(cookie) == nullptr) {
+        ExTask task = std::make_shared<StatsTask>(
+                this, id, cookie, std::move(description), std::move(fn));
+        storeEngineSpecific(cookie, this);
+        ExecutorPool::get()->schedule(task);
+        return ENGINE_EWOULDBLOCK;
+    }
+
+    // Second call after the task notified us; all of the stats have
+    // already been added.
+    storeEngineSpecific(cookie, nullptr);
+    return ENGINE_SUCCESS;
+}
+
 ENGINE_ERROR_CODE EventuallyPersistentEngine::doCheckpointStats(
                                                           const void *cookie,
                                                           ADD_STAT add_stat,
@@ -3220,16 +3318,14 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::doCheckpointStats(
                                                           int nkey) {
 
     if (nkey == 10) {
-        void* es = getEngineSpecific(cookie);
-        if (es == NULL) {
-            ExTask task = std::make_shared<StatCheckpointTask>(
-                    this, cookie, add_stat);
-            ExecutorPool::get()->schedule(task);
-            storeEngineSpecific(cookie, this);
-            return ENGINE_EWOULDBLOCK;
-        } else {
-            storeEngineSpecific(cookie, NULL);
-        }
+        return runStatsTask(cookie,
+                            TaskId::StatCheckpointTask,
+                            "checkpoint stats for all vbuckets",
+                            [this, cookie, add_stat]() {
+                                StatCheckpointVisitor scv(
+                                        kvBucket.get(), cookie, add_stat);
+                                kvBucket->visit(scv);
+                            });
     } else if (nkey > 11) {
         std::string vbid(&stat_key[11], nkey - 11);
         uint16_t vbucket_id(0);
@@ -3845,17 +3941,49 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::getStats(const void* cookie,
     } else if (nkey > 7 && cb_isPrefix(statKey, "dcpagg ")) {
         rv = doConnAggStats(cookie, add_stat, stat_key + 7, nkey - 7);
     } else if (statKey == "dcp") {
-        rv = doDcpStats(cookie, add_stat);
+        rv = runStatsTask(
+                cookie,
+                TaskId::StatsTask,
+                "dcp stats",
+                [this, cookie, add_stat]() { doDcpStats(cookie, add_stat); });
     } else if (statKey == "hash") {
-        rv = doHashStats(cookie, add_stat);
+        rv = runStatsTask(
+                cookie,
+                TaskId::StatsTask,
+                "hash stats for all vbuckets",
+                [this, cookie, add_stat]() { doHashStats(cookie, add_stat); });
     } else if (statKey == "vbucket") {
-        rv = doVBucketStats(cookie, add_stat, stat_key, nkey, false, false);
+        rv = runStatsTask(cookie,
+                          TaskId::StatsTask,
+                          "vbucket stats for all vbuckets",
+                          [this, cookie, add_stat]() {
+                              doVBucketStats(cookie,
+                                             add_stat,
+                                             nullptr,
+                                             0,
+                                             false,
+                                             false);
+                          });
+    } else if (statKey == "vbucket-details") {
+        rv = runStatsTask(cookie,
+                          TaskId::StatsTask,
+                          "vbucket-details stats for all vbuckets",
+                          [this, cookie, add_stat]() {
+                              doVBucketStats(
+                                      cookie, add_stat, nullptr, 0, false, true);
+                          });
     } else if (cb_isPrefix(statKey, "vbucket-details")) {
         rv = doVBucketStats(cookie, add_stat, stat_key, nkey, false, true);
     } else if (cb_isPrefix(statKey, "vbucket-seqno")) {
         rv = doSeqnoStats(cookie, add_stat, stat_key, nkey);
     } else if (statKey == "prev-vbucket") {
-        rv = doVBucketStats(cookie, add_stat, stat_key, nkey, true, false);
+        rv = runStatsTask(cookie,
+                          TaskId::StatsTask,
+                          "prev-vbucket stats for all vbuckets",
+                          [this, cookie, add_stat]() {
+                              doVBucketStats(
+                                      cookie, add_stat, nullptr, 0, true, false);
+                          });
     } else if (cb_isPrefix(statKey, "checkpoint")) {
         rv = doCheckpointStats(cookie, add_stat, stat_key, nkey);
     } else if (statKey == "timings") {
@@ -3938,7 +4066,12 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::getStats(const void* cookie,
         return doWorkloadStats(cookie, add_stat);
     } else if (cb_isPrefix(statKey, "failovers")) {
         if (nkey == 9) {
-            rv = doAllFailoverLogStats(cookie, add_stat);
+            rv = runStatsTask(cookie,
+                              TaskId::StatsTask,
+                              "failover logs for all vbuckets",
+                              [this, cookie, add_stat]() {
+                                  doAllFailoverLogStats(cookie, add_stat);
+                              });
         } else if (statKey.compare(std::string("failovers").length(),
                                    std::string(" ").length(),
                                    " ") == 0) {
@@ -3963,9 +4096,18 @@ ENGINE_ERROR_CODE EventuallyPersistentEngine::getStats(const void* cookie,
         }
     } else if (statKey == "collections" &&
                configuration.isCollectionsPrototypeEnabled()) {
-        // @todo MB-24546 For development, just log everything.
-        kvBucket->getCollectionsManager().logAll(*kvBucket.get());
-        rv = ENGINE_SUCCESS;
+        rv = runStatsTask(cookie,
+                          TaskId::StatsTask,
+                          "collections stats",
+                          [this, cookie, add_stat]() {
+                              auto& manager =
+                                      kvBucket->getCollectionsManager();
+                              // @todo MB-24546 For development, also log
+                              // everything.
+                              manager.logAll(*kvBucket.get());
+                              manager.addStats(
+                                      *kvBucket.get(), cookie, add_stat);
+                          });
     }
 
     return rv;
@@ -20,6 +20,7 @@
 
 #include "config.h"
 
+#include "bucket_arena.h"
 #include "configuration.h"
 #include "connhandler.h"
 #include "stats.h"
@@ -30,6 +31,7 @@
 #include <memcached/engine.h>
 #include <platform/processclock.h>
 
+#include <functional>
 #include <string>
 
 class StoredValue;
@@ -341,6 +343,11 @@ public:
         return kvBucket.get();
     }
 
+    /// @return the arena the bucket's objects are allocated from (if any)
+    const BucketArena* getArena() const {
+        return arena.get();
+    }
+
     DcpConnMap& getDcpConnMap() {
         return *dcpConnMap_;
     }
@@ -541,6 +548,17 @@ protected:
 
     bool enableTraffic(bool enable);
 
+    /**
+     * Build the stats of a stat group on a NONIO thread rather than on the
+     * front-end thread. The first call schedules a task running fn and
+     * returns EWOULDBLOCK; once the task has run the connection is notified
+     * and the second call returns SUCCESS.
+     */
+    ENGINE_ERROR_CODE runStatsTask(const void* cookie,
+                                   TaskId id,
+                                   std::string description,
+                                   std::function<void()> fn);
+
     ENGINE_ERROR_CODE doEngineStats(const void *cookie, ADD_STAT add_stat);
     ENGINE_ERROR_CODE doKlogStats(const void *cookie, ADD_STAT add_stat);
     ENGINE_ERROR_CODE doMemoryStats(const void *cookie, ADD_STAT add_stat);
@@ -649,6 +667,13 @@ protected:
      */
     std::unique_ptr<KVBucket> makeBucket(Configuration& config);
 
+    /**
+     * Create the arena the StoredValues and Blobs of the bucket are
+     * allocated from (if bucket_arena_enabled is set). Must be called
+     * before any objects are stored in the bucket.
+     */
+    void initializeArena();
+
     /**
      * helper method so that some commands can set the datatype of the document.
      *
@@ -745,6 +770,8 @@ protected:
     time_t processExpiryTime(time_t in) const;
 
     SERVER_HANDLE_V1 *serverApi;
+    // Declared before kvBucket so that it outlives the objects in the bucket
+    std::unique_ptr<BucketArena> arena;
     std::unique_ptr<KVBucket> kvBucket;
     WorkLoadPolicy *workload;
     bucket_priority_t workloadPriority;
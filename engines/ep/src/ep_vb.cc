@@ -412,7 +412,7 @@ protocol_binary_response_status EPVBucket::evictKey(const DocKey& key,
     }
 
     if (v->isResident()) {
-        if (ht.unlocked_ejectItem(v, eviction)) {
+        if (ejectStoredValue(v)) {
             *msg = "Ejected.";
 
             // Add key to bloom filter in case of full eviction mode
@@ -430,6 +430,15 @@ protocol_binary_response_status EPVBucket::evictKey(const DocKey& key,
 }
 
 bool EPVBucket::pageOut(const HashTable::HashBucketLock& lh, StoredValue*& v) {
+    return ejectStoredValue(v);
+}
+
+bool EPVBucket::ejectStoredValue(StoredValue*& v) {
+    // Under full eviction the StoredValue (and hence its metadata) is about
+    // to be removed from the HT - retain its metadata in the cache.
+    if (eviction == FULL_EVICTION && v->eligibleForEviction(eviction)) {
+        addToMetaDataCache(*v);
+    }
     return ht.unlocked_ejectItem(v, eviction);
 }
 
@@ -226,9 +226,17 @@ private:
                                     QueueBgFetch queueBgFetch,
                                     const StoredValue& v) override;
 
-    size_t estimateNewMemoryUsage(EPStats& st, const Item& item) override {
-        return st.getEstimatedTotalMemoryUsed() +
-               StoredValue::getRequiredStorage(item);
+    /**
+     * Eject the given StoredValue from the HT according to the vBucket's
+     * eviction policy, recording its metadata in the metadata cache if it
+     * is fully evicted. Assumes that HT bucket lock is grabbed.
+     *
+     * @return true if the StoredValue was ejected
+     */
+    bool ejectStoredValue(StoredValue*& v);
+
+    size_t getRequiredStorage(const Item& item) override {
+        return StoredValue::getRequiredStorage(item);
     }
 
     /**
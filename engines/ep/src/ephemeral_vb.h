@@ -248,9 +248,8 @@ private:
                                     QueueBgFetch queueBgFetch,
                                     const StoredValue& v) override;
 
-    size_t estimateNewMemoryUsage(EPStats& st, const Item& item) override {
-        return st.getEstimatedTotalMemoryUsed() +
-               OrderedStoredValue::getRequiredStorage(item);
+    size_t getRequiredStorage(const Item& item) override {
+        return OrderedStoredValue::getRequiredStorage(item);
     }
 
     /**
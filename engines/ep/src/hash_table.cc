@@ -17,6 +17,7 @@
 
 #include "hash_table.h"
 
+#include "collections/vbucket_manifest.h"
 #include "item.h"
 #include "item_eviction.h" // Needed for ItemEviction::initialFreqCount
 #include "stats.h"
@@ -132,6 +133,12 @@ void HashTable::clear_UNLOCKED(bool deactivate) {
             auto v = std::move(values[i]);
             clearedMemSize += v->size();
             clearedValSize += v->valuelen();
+            // A deactivated HashTable is being destroyed (along with its
+            // owner), so there is nothing left to tell.
+            if (collectionsManifest && !deactivate) {
+                collectionsManifest->updateMemUsed(v->getKey(),
+                                                   -int64_t(v->size()));
+            }
             values[i] = std::move(v->getNext());
         }
     }
@@ -298,6 +305,23 @@ void HashTable::compressValue(StoredValue& v) {
    statsEpilogue(v);
 }
 
+void HashTable::compressValue(
+        StoredValue& v,
+        const std::shared_ptr<const CompressionDictionary>& dictionary) {
+    {
+        std::lock_guard<std::mutex> lh(compressionDictionary.mutex);
+        if (compressionDictionary.dictionary != dictionary) {
+            compressionDictionary.dictionary = dictionary;
+        }
+    }
+
+    statsPrologue(v);
+
+    v.compressValue(*dictionary);
+
+    statsEpilogue(v);
+}
+
 MutationStatus HashTable::unlocked_updateStoredValue(
         const std::unique_lock<std::mutex>& htLock,
         StoredValue& v,
@@ -358,7 +382,7 @@ StoredValue* HashTable::unlocked_addNewStoredValue(const HashBucketLock& hbl,
 void HashTable::statsPrologue(const StoredValue& v) {
     // Decrease all statistics which sv matches.
     reduceMetaDataSize(stats, v.metaDataSize());
-    reduceCacheSize(v.size());
+    reduceCacheSize(v.getKey(), v.size());
 
     if (!v.isResident() && !v.isDeleted() && !v.isTempItem()) {
         decrNumNonResidentItems();
@@ -379,7 +403,7 @@ void HashTable::statsPrologue(const StoredValue& v) {
 void HashTable::statsEpilogue(const StoredValue& v) {
     // After performing updates to sv; increase all statistics which sv matches.
     increaseMetaDataSize(stats, v.metaDataSize());
-    increaseCacheSize(v.size());
+    increaseCacheSize(v.getKey(), v.size());
 
     if (!v.isResident() && !v.isDeleted() && !v.isTempItem()) {
         ++numNonResidentItems;
@@ -728,7 +752,7 @@ bool HashTable::unlocked_ejectItem(StoredValue*& vptr,
     }
     if (policy == VALUE_ONLY) {
         if (vptr->eligibleForEviction(policy)) {
-            reduceCacheSize(vptr->valuelen());
+            reduceCacheSize(vptr->getKey(), vptr->valuelen());
             vptr->ejectValue();
             ++stats.numValueEjects;
             ++numNonResidentItems;
@@ -741,7 +765,7 @@ bool HashTable::unlocked_ejectItem(StoredValue*& vptr,
     } else { // full eviction.
         if (vptr->eligibleForEviction(policy)) {
             reduceMetaDataSize(stats, vptr->metaDataSize());
-            reduceCacheSize(vptr->size());
+            reduceCacheSize(vptr->getKey(), vptr->size());
             int bucket_num = getBucketForHash(vptr->getKey().hash());
 
             // Remove the item from the hash table.
@@ -806,7 +830,7 @@ bool HashTable::unlocked_restoreValue(
         ++numDeletedItems;
     }
 
-    increaseCacheSize(v.getValue()->valueSize());
+    increaseCacheSize(v.getKey(), v.getValue()->valueSize());
     return true;
 }
 
@@ -834,14 +858,20 @@ void HashTable::unlocked_restoreMeta(const std::unique_lock<std::mutex>& htLock,
     }
 }
 
-void HashTable::increaseCacheSize(size_t by) {
+void HashTable::increaseCacheSize(const DocKey& key, size_t by) {
     cacheSize.fetch_add(by);
     memSize.fetch_add(by);
+    if (collectionsManifest) {
+        collectionsManifest->updateMemUsed(key, by);
+    }
 }
 
-void HashTable::reduceCacheSize(size_t by) {
+void HashTable::reduceCacheSize(const DocKey& key, size_t by) {
     cacheSize.fetch_sub(by);
     memSize.fetch_sub(by);
+    if (collectionsManifest) {
+        collectionsManifest->updateMemUsed(key, -int64_t(by));
+    }
 }
 
 void HashTable::increaseMetaDataSize(EPStats& st, size_t by) {
@@ -27,8 +27,14 @@
 
 #include <array>
 #include <functional>
+#include <memory>
 
 class AbstractStoredValueFactory;
+namespace Collections {
+namespace VB {
+class Manifest;
+}
+}
 class HashTableStatVisitor;
 class HashTableVisitor;
 class HashTableDepthVisitor;
@@ -263,6 +269,16 @@ public:
         frequencyCounterSaturated = callbackFunction;
     }
 
+    /**
+     * Sets the collections manifest which the memory used by each
+     * StoredValue is accounted to (see Manifest::updateMemUsed). It is
+     * updated with the hash bucket lock held.
+     * @param - manifest  The manifest of the owning VBucket.
+     */
+    void setCollectionsManifest(const Collections::VB::Manifest* manifest) {
+        collectionsManifest = manifest;
+    }
+
     /**
      * Remove in case of a temporary item
      *
@@ -358,6 +374,18 @@ public:
      */
     void compressValue(StoredValue& v);
 
+    /**
+     * Compress the value in the given StoredValue with the given dictionary.
+     * The HashTable keeps a reference to the dictionary, so values compressed
+     * with it can be decompressed for as long as the HashTable exists.
+     *
+     * @param v StoredValue whose value needs to be compressed
+     * @param dictionary dictionary to compress the value with
+     */
+    void compressValue(
+            StoredValue& v,
+            const std::shared_ptr<const CompressionDictionary>& dictionary);
+
     /**
      * Updates an existing StoredValue in the HT.
      * Assumes that HT bucket lock is grabbed.
@@ -731,6 +759,15 @@ private:
     // identify which hash table entries should be evicted first.
     StatisticalCounter<uint8_t> statisticalCounter;
 
+    // The dictionary which values in this HashTable have been compressed
+    // with (if any). Held so the dictionary - and its id - stay live for as
+    // long as such values may exist, even after the owning bucket has
+    // released it.
+    struct {
+        std::mutex mutex;
+        std::shared_ptr<const CompressionDictionary> dictionary;
+    } compressionDictionary;
+
     // The policy used by the hash table to evict items.  The item pager uses
     // this to determine what eviction policy to apply.
     EvictionPolicy evictionPolicy;
@@ -739,6 +776,10 @@ private:
     // counter becomes saturated.
     std::function<void()> frequencyCounterSaturated;
 
+    // Used to account the memory used by StoredValues to their collection
+    // (if set).
+    const Collections::VB::Manifest* collectionsManifest = nullptr;
+
     int getBucketForHash(int h) {
         return abs(h % static_cast<int>(size));
     }
@@ -792,14 +833,14 @@ private:
     void clear_UNLOCKED(bool deactivate);
 
     /**
-     * Increase the size of the cache
+     * Increase the size of the cache by memory used for the given key
      */
-    void increaseCacheSize(size_t by);
+    void increaseCacheSize(const DocKey& key, size_t by);
 
     /**
-     * Reduce the size of the cache
+     * Reduce the size of the cache by memory used for the given key
      */
-    void reduceCacheSize(size_t by);
+    void reduceCacheSize(const DocKey& key, size_t by);
 
     /**
      * Increase the size of the meta data
@@ -399,7 +399,8 @@ bool ItemPager::run(void) {
     notified.store(false);
 
     KVBucket* kvBucket = engine.getKVBucket();
-    double current = static_cast<double>(stats.getEstimatedTotalMemoryUsed());
+    double current = static_cast<double>(
+            stats.getTotalMemoryUsedNear(stats.mem_high_wat));
     double upper = static_cast<double>(stats.mem_high_wat);
     double lower = static_cast<double>(stats.mem_low_wat);
 
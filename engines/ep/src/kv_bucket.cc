@@ -36,6 +36,7 @@
 #include "checkpoint.h"
 #include "checkpoint_remover.h"
 #include "collections/manager.h"
+#include "compression_dictionary.h"
 #include "conflict_resolution.h"
 #include "connmap.h"
 #include "dcp/dcpconnmap.h"
@@ -608,12 +609,16 @@ ENGINE_ERROR_CODE KVBucket::set(Item& itm,
     }
 
     { // collections read-lock scope
-        auto collectionsRHandle = vb->lockCollections();
-        if (!collectionsRHandle.doesKeyContainValidCollection(itm.getKey())) {
+        auto collectionsRHandle = vb->lockCollections(itm.getKey());
+        if (!collectionsRHandle.valid()) {
             return ENGINE_UNKNOWN_COLLECTION;
         } // now hold collections read access for the duration of the set
 
-        return vb->set(itm, cookie, engine, bgFetchDelay, predicate);
+        auto rv = vb->set(itm, cookie, engine, bgFetchDelay, predicate);
+        if (rv == ENGINE_SUCCESS) {
+            collectionsRHandle.incrementOpsStore();
+        }
+        return rv;
     }
 }
 
@@ -653,7 +658,12 @@ ENGINE_ERROR_CODE KVBucket::add(Item &itm, const void *cookie)
             return ENGINE_UNKNOWN_COLLECTION;
         } // now hold collections read access for the duration of the add
 
-        return vb->add(itm, cookie, engine, bgFetchDelay, collectionsRHandle);
+        auto rv = vb->add(
+                itm, cookie, engine, bgFetchDelay, collectionsRHandle);
+        if (rv == ENGINE_SUCCESS) {
+            collectionsRHandle.incrementOpsStore();
+        }
+        return rv;
     }
 }
 
@@ -685,12 +695,16 @@ ENGINE_ERROR_CODE KVBucket::replace(Item& itm,
             return ENGINE_UNKNOWN_COLLECTION;
         } // now hold collections read access for the duration of the set
 
-        return vb->replace(itm,
-                           cookie,
-                           engine,
-                           bgFetchDelay,
-                           predicate,
-                           collectionsRHandle);
+        auto rv = vb->replace(itm,
+                              cookie,
+                              engine,
+                              bgFetchDelay,
+                              predicate,
+                              collectionsRHandle);
+        if (rv == ENGINE_SUCCESS) {
+            collectionsRHandle.incrementOpsStore();
+        }
+        return rv;
     }
 }
 
@@ -1218,8 +1232,16 @@ void KVBucket::completeBGFetch(const DocKey& key,
                                bool isMeta) {
     TRACE_SCOPE(engine.serverApi, cookie, cb::tracing::TraceCode::BGFETCH);
     ProcessClock::time_point startTime(ProcessClock::now());
+    TRACE_ADD(engine.serverApi,
+              cookie,
+              cb::tracing::TraceCode::BGWAIT,
+              init,
+              startTime);
     // Go find the data
-    GetValue gcb = getROUnderlying(vbucket)->get(key, vbucket, isMeta);
+    GetValue gcb;
+    TRACE_BLOCK(engine.serverApi, cookie, cb::tracing::TraceCode::BGLOAD) {
+        gcb = getROUnderlying(vbucket)->get(key, vbucket, isMeta);
+    }
 
     {
       // Lock to prevent a race condition between a fetch for restore and delete
@@ -1318,13 +1340,17 @@ GetValue KVBucket::getInternal(const DocKey& key,
             return GetValue(NULL, ENGINE_UNKNOWN_COLLECTION);
         }
 
-        return vb->getInternal(cookie,
-                               engine,
-                               bgFetchDelay,
-                               options,
-                               diskDeleteAll,
-                               VBucket::GetKeyOnly::No,
-                               collectionsRHandle);
+        auto gv = vb->getInternal(cookie,
+                                  engine,
+                                  bgFetchDelay,
+                                  options,
+                                  diskDeleteAll,
+                                  VBucket::GetKeyOnly::No,
+                                  collectionsRHandle);
+        if (gv.getStatus() == ENGINE_SUCCESS) {
+            collectionsRHandle.incrementOpsGet();
+        }
+        return gv;
     }
 }
 
@@ -1393,13 +1419,17 @@ ENGINE_ERROR_CODE KVBucket::getMetaData(const DocKey& key,
             return ENGINE_UNKNOWN_COLLECTION;
         }
 
-        return vb->getMetaData(cookie,
-                               engine,
-                               bgFetchDelay,
-                               collectionsRHandle,
-                               metadata,
-                               deleted,
-                               datatype);
+        auto rv = vb->getMetaData(cookie,
+                                  engine,
+                                  bgFetchDelay,
+                                  collectionsRHandle,
+                                  metadata,
+                                  deleted,
+                                  datatype);
+        if (rv == ENGINE_SUCCESS) {
+            collectionsRHandle.incrementOpsGet();
+        }
+        return rv;
     }
 }
 
@@ -1459,6 +1489,9 @@ ENGINE_ERROR_CODE KVBucket::setWithMeta(Item& itm,
                                  genCas,
                                  isReplication,
                                  collectionsRHandle);
+            if (rv == ENGINE_SUCCESS) {
+                collectionsRHandle.incrementOpsStore();
+            }
         }
     }
 
@@ -1496,8 +1529,12 @@ GetValue KVBucket::getAndUpdateTtl(const DocKey& key, uint16_t vbucket,
             return GetValue(NULL, ENGINE_UNKNOWN_COLLECTION);
         }
 
-        return vb->getAndUpdateTtl(
+        auto gv = vb->getAndUpdateTtl(
                 cookie, engine, bgFetchDelay, exptime, collectionsRHandle);
+        if (gv.getStatus() == ENGINE_SUCCESS) {
+            collectionsRHandle.incrementOpsGet();
+        }
+        return gv;
     }
 }
 
@@ -1516,12 +1553,16 @@ GetValue KVBucket::getLocked(const DocKey& key, uint16_t vbucket,
             return GetValue(NULL, ENGINE_UNKNOWN_COLLECTION);
         }
 
-        return vb->getLocked(currentTime,
-                             lockTimeout,
-                             cookie,
-                             engine,
-                             bgFetchDelay,
-                             collectionsRHandle);
+        auto gv = vb->getLocked(currentTime,
+                                lockTimeout,
+                                cookie,
+                                engine,
+                                bgFetchDelay,
+                                collectionsRHandle);
+        if (gv.getStatus() == ENGINE_SUCCESS) {
+            collectionsRHandle.incrementOpsGet();
+        }
+        return gv;
     }
 }
 
@@ -1624,7 +1665,7 @@ std::string KVBucket::validateKey(const DocKey& key, uint16_t vbucket,
         if (diskItem.getFlags() != v->getFlags()) {
             return "flags_mismatch";
         } else if (v->isResident() && memcmp(diskItem.getData(),
-                                             v->getValue()->getData(),
+                                             v->getDecodedValue()->getData(),
                                              diskItem.getNBytes())) {
             return "data_mismatch";
         } else {
@@ -1664,13 +1705,17 @@ ENGINE_ERROR_CODE KVBucket::deleteItem(const DocKey& key,
             return ENGINE_UNKNOWN_COLLECTION;
         }
 
-        return vb->deleteItem(cas,
-                              cookie,
-                              engine,
-                              bgFetchDelay,
-                              itemMeta,
-                              mutInfo,
-                              collectionsRHandle);
+        auto rv = vb->deleteItem(cas,
+                                 cookie,
+                                 engine,
+                                 bgFetchDelay,
+                                 itemMeta,
+                                 mutInfo,
+                                 collectionsRHandle);
+        if (rv == ENGINE_SUCCESS) {
+            collectionsRHandle.incrementOpsDelete();
+        }
+        return rv;
     }
 }
 
@@ -1724,19 +1769,23 @@ ENGINE_ERROR_CODE KVBucket::deleteWithMeta(const DocKey& key,
             return ENGINE_UNKNOWN_COLLECTION;
         }
 
-        return vb->deleteWithMeta(cas,
-                                  seqno,
-                                  cookie,
-                                  engine,
-                                  bgFetchDelay,
-                                  checkConflicts,
-                                  itemMeta,
-                                  backfill,
-                                  genBySeqno,
-                                  generateCas,
-                                  bySeqno,
-                                  isReplication,
-                                  collectionsRHandle);
+        auto rv = vb->deleteWithMeta(cas,
+                                     seqno,
+                                     cookie,
+                                     engine,
+                                     bgFetchDelay,
+                                     checkConflicts,
+                                     itemMeta,
+                                     backfill,
+                                     genBySeqno,
+                                     generateCas,
+                                     bySeqno,
+                                     isReplication,
+                                     collectionsRHandle);
+        if (rv == ENGINE_SUCCESS) {
+            collectionsRHandle.incrementOpsDelete();
+        }
+        return rv;
     }
 }
 
@@ -1746,6 +1795,7 @@ void KVBucket::reset() {
         auto vb = getLockedVBucket(vbid);
         if (vb) {
             vb->ht.clear();
+            vb->clearMetaDataCache();
             vb->checkpointManager->clear(vb->getState());
             vb->resetStats();
             vb->setPersistedSnapshot(0, 0);
@@ -1896,7 +1946,7 @@ bool KVBucket::isMemoryUsageTooHigh() {
 
 // Trigger memory reduction (ItemPager) if we've exceeded high water
 void KVBucket::checkAndMaybeFreeMemory() {
-    if (stats.getEstimatedTotalMemoryUsed() > stats.mem_high_wat) {
+    if (stats.getTotalMemoryUsedNear(stats.mem_high_wat) > stats.mem_high_wat) {
         attemptToFreeMemory();
     }
 }
@@ -2281,6 +2331,11 @@ TaskStatus KVBucket::rollback(uint16_t vbid, uint64_t rollbackSeqno) {
                                         */) {
                 rollbackUnpersistedItems(*vb, result.highSeqno);
                 vb->postProcessRollback(result, prevHighSeqno);
+                // Cached metadata of evicted items may be from after the
+                // rollback point. Only clear it now that the HashTable has
+                // been rolled back too, as the item pager may have evicted
+                // (and cached) rolled back items while we were busy.
+                vb->clearMetaDataCache();
                 engine.getDcpConnMap().closeStreamsDueToRollback(vbid);
                 return TaskStatus::Complete;
             }
@@ -2313,6 +2368,22 @@ void KVBucket::runDefragmenterTask() {
     defragmenterTask->run();
 }
 
+bool KVBucket::setCompressionDictionary(
+        std::unique_ptr<CompressionDictionary> dictionary) {
+    std::lock_guard<std::mutex> lh(compressionDictionary.mutex);
+    if (compressionDictionary.dictionary) {
+        return false;
+    }
+    compressionDictionary.dictionary = std::move(dictionary);
+    return true;
+}
+
+std::shared_ptr<const CompressionDictionary>
+KVBucket::getCompressionDictionary() const {
+    std::lock_guard<std::mutex> lh(compressionDictionary.mutex);
+    return compressionDictionary.dictionary;
+}
+
 void KVBucket::runItemFreqDecayerTask() {
     itemFreqDecayerTask->run();
 }
@@ -2450,6 +2521,7 @@ bool KVBucket::collectionsEraseKey(uint16_t vbid,
             case DocNamespace::DefaultCollection:
             case DocNamespace::Collections:
                 vb->decrNumTotalItems();
+                vb->decrCollectionItemCount(key);
                 break;
             case DocNamespace::System:
                 break;
@@ -30,6 +30,7 @@
 
 #include <deque>
 
+class CompressionDictionary;
 class ReplicationThrottle;
 class VBucketCountVisitor;
 namespace Collections {
@@ -737,6 +738,23 @@ public:
 
     void runDefragmenterTask();
 
+    /**
+     * Set the dictionary used to compress the in-memory values of this
+     * bucket. A dictionary can only be set once, as existing values may
+     * have been compressed with it.
+     *
+     * @return true if the dictionary was set
+     */
+    bool setCompressionDictionary(
+            std::unique_ptr<CompressionDictionary> dictionary);
+
+    /**
+     * @return the dictionary used to compress the in-memory values of this
+     *         bucket, or nullptr if none has been trained yet.
+     */
+    std::shared_ptr<const CompressionDictionary> getCompressionDictionary()
+            const;
+
     /**
      * Invoke the run method of the ItemFreqDecayerTask.  Currently only used
      * for testing purposes.
@@ -991,6 +1009,17 @@ protected:
 
     std::atomic<size_t> maxTtl;
 
+    /**
+     * Dictionary which the in-memory values of this bucket may be compressed
+     * with (trained by the DefragmenterTask). Never replaced once set.
+     * Each HashTable holding values compressed with it also holds a
+     * reference, as a VBucket may outlive the KVBucket.
+     */
+    struct {
+        mutable std::mutex mutex;
+        std::shared_ptr<const CompressionDictionary> dictionary;
+    } compressionDictionary;
+
     friend class KVBucketTest;
 
     DISALLOW_COPY_AND_ASSIGN(KVBucket);
@@ -0,0 +1,105 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "meta_data_cache.h"
+
+#include "murmurhash3.h"
+#include "stored-value.h"
+
+#if __x86_64__ || __ppc64__
+#define MURMURHASH_3 MurmurHash3_x64_128
+#else
+#define MURMURHASH_3 MurmurHash3_x86_128
+#endif
+
+static size_t roundUpToPowerOfTwo(size_t size) {
+    size_t result = 1;
+    while (result < size) {
+        result <<= 1;
+    }
+    return result;
+}
+
+MetaDataCache::MetaDataCache(size_t size)
+    : mask(roundUpToPowerOfTwo(size) - 1), slots(mask + 1), numItems(0) {
+    for (auto& slot : slots) {
+        slot.fingerprint = 0;
+    }
+}
+
+uint64_t MetaDataCache::fingerprint(const DocKey& key) {
+    uint64_t result[2];
+    MURMURHASH_3(
+            key.data(), key.size(), uint32_t(key.getDocNamespace()), result);
+    // Zero is used to mark an unused slot.
+    return result[0] == 0 ? 1 : result[0];
+}
+
+void MetaDataCache::insert(const StoredValue& v) {
+    if (v.isDeleted() || v.isTempItem()) {
+        erase(v.getKey());
+        return;
+    }
+
+    const auto fp = fingerprint(v.getKey());
+    const auto index = getSlot(fp);
+    std::lock_guard<std::mutex> lh(getLock(index));
+    auto& slot = slots[index];
+    if (slot.fingerprint == 0) {
+        ++numItems;
+    }
+    slot.fingerprint = fp;
+    slot.entry.cas = v.getCas();
+    slot.entry.bySeqno = v.getBySeqno();
+    slot.entry.revSeqno = v.getRevSeqno();
+    slot.entry.flags = v.getFlags();
+    slot.entry.exptime = static_cast<uint32_t>(v.getExptime());
+    slot.entry.datatype = v.getDatatype();
+}
+
+boost::optional<MetaDataCache::Entry> MetaDataCache::find(
+        const DocKey& key) const {
+    const auto fp = fingerprint(key);
+    const auto index = getSlot(fp);
+    std::lock_guard<std::mutex> lh(getLock(index));
+    const auto& slot = slots[index];
+    if (slot.fingerprint != fp) {
+        return {};
+    }
+    return slot.entry;
+}
+
+void MetaDataCache::erase(const DocKey& key) {
+    const auto fp = fingerprint(key);
+    const auto index = getSlot(fp);
+    std::lock_guard<std::mutex> lh(getLock(index));
+    auto& slot = slots[index];
+    if (slot.fingerprint == fp) {
+        slot.fingerprint = 0;
+        --numItems;
+    }
+}
+
+void MetaDataCache::clear() {
+    for (size_t index = 0; index < slots.size(); ++index) {
+        std::lock_guard<std::mutex> lh(getLock(index));
+        if (slots[index].fingerprint != 0) {
+            slots[index].fingerprint = 0;
+            --numItems;
+        }
+    }
+}
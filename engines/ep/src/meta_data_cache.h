@@ -0,0 +1,128 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include <boost/optional/optional.hpp>
+#include <memcached/dockey.h>
+#include <memcached/protocol_binary.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+class StoredValue;
+
+/**
+ * A compact, fixed-size cache of the metadata of items which have been
+ * fully evicted from a VBucket's HashTable (item_eviction_policy
+ * full_eviction).
+ *
+ * When a key is evicted under full eviction nothing about it remains in
+ * memory, so a metadata-only lookup (getMeta, add, XDCR conflict resolution)
+ * would normally require a background fetch. This cache retains the metadata
+ * of evicted items so such lookups can be answered without disk I/O.
+ *
+ * The key itself is not stored - entries are identified by a 64-bit
+ * fingerprint of the key - and the cache is direct-mapped; inserting a key
+ * whose slot is already in use replaces the previous occupant.
+ *
+ * The cache only ever holds the metadata of alive (non-deleted) items. It
+ * must be told (via erase()) whenever an item's on-disk metadata may diverge
+ * from what was cached, which is guaranteed while the item has a
+ * StoredValue in the HashTable (the HashTable being authoritative then).
+ */
+class MetaDataCache {
+public:
+    /// The metadata retained for each evicted item.
+    struct Entry {
+        uint64_t cas;
+        int64_t bySeqno;
+        uint64_t revSeqno;
+        uint32_t flags;
+        uint32_t exptime;
+        protocol_binary_datatype_t datatype;
+    };
+
+    /**
+     * @param size number of entries the cache can hold. Rounded up to the
+     *        next power of two.
+     */
+    explicit MetaDataCache(size_t size);
+
+    /**
+     * Record the metadata of the given StoredValue, which is about to be
+     * evicted from the HashTable. If the StoredValue is deleted or is a temp
+     * item any existing entry for its key is removed instead.
+     */
+    void insert(const StoredValue& v);
+
+    /**
+     * Lookup the metadata of the given key.
+     *
+     * @return the cached metadata, or an uninitialised optional if the key
+     *         is not in the cache.
+     */
+    boost::optional<Entry> find(const DocKey& key) const;
+
+    /// Remove any entry for the given key.
+    void erase(const DocKey& key);
+
+    /// Remove all entries.
+    void clear();
+
+    /// @return the number of entries the cache can hold.
+    size_t getCapacity() const {
+        return slots.size();
+    }
+
+    /// @return the number of entries currently in use.
+    size_t getNumItems() const {
+        return numItems;
+    }
+
+    /// @return the memory used by the cache, in bytes.
+    size_t getMemoryUsage() const {
+        return sizeof(*this) + (slots.capacity() * sizeof(Slot));
+    }
+
+private:
+    struct Slot {
+        // Fingerprint of the key occupying the slot, zero if unused.
+        uint64_t fingerprint;
+        Entry entry;
+    };
+
+    /// Compute the (non-zero) fingerprint of the given key.
+    static uint64_t fingerprint(const DocKey& key);
+
+    size_t getSlot(uint64_t fp) const {
+        return fp & mask;
+    }
+
+    std::mutex& getLock(size_t slot) const {
+        return locks[slot % locks.size()];
+    }
+
+    const size_t mask;
+    std::vector<Slot> slots;
+    mutable std::array<std::mutex, 16> locks;
+    std::atomic<size_t> numItems;
+};
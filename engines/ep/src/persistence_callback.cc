@@ -50,6 +50,7 @@ void PersistenceCallback::callback(TransactionContext& txCtx,
                     // Insert in value-only or full eviction mode.
                     ++vbucket.opsCreate;
                     vbucket.incrNumTotalItems();
+                    vbucket.incrCollectionItemCount(queuedItem->getKey());
                     vbucket.incrMetaDataDisk(*queuedItem);
                 } else { // Update in full eviction mode.
                     ++vbucket.opsUpdate;
@@ -0,0 +1,129 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#pragma once
+
+#include <platform/cacheline_padded.h>
+#include <platform/rwlock.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * A reader-writer lock for data which is read by every front-end operation
+ * but rarely changed.
+ *
+ * A cb::RWLock has a single reader count which every reader updates, so at
+ * high operation rates its cache line bounces between all of the cores.
+ * ShardedRWLock is made up of a number of cache line padded cb::RWLocks.
+ * A thread always takes the read lock of the same shard, so readers on
+ * different threads (mostly) don't touch the same cache line. A writer
+ * takes the write lock of every shard.
+ *
+ * As a thread always reads via the same shard, taking the read lock
+ * recursively behaves just as it does with a single cb::RWLock.
+ *
+ *     std::lock_guard<cb::ReaderLock> rlh(lock.reader());
+ *     std::lock_guard<ShardedRWLock::Writer> wlh(lock.writer());
+ */
+class ShardedRWLock {
+public:
+    /**
+     * Locks (and unlocks) the write locks of all of the shards, always in
+     * the same order. Meets the BasicLockable requirements.
+     */
+    class Writer {
+    public:
+        explicit Writer(ShardedRWLock& owner) : owner(owner) {
+        }
+
+        void lock() {
+            for (auto& shard : owner.shards) {
+                shard->writer().lock();
+            }
+        }
+
+        void unlock() {
+            for (auto it = owner.shards.rbegin(); it != owner.shards.rend();
+                 ++it) {
+                (*it)->writer().unlock();
+            }
+        }
+
+    private:
+        ShardedRWLock& owner;
+    };
+
+    /**
+     * @param numShards the number of shards to use (by default one per
+     *        CPU, up to MaxShards)
+     */
+    explicit ShardedRWLock(size_t numShards = getDefaultNumShards())
+        : shards(numShards == 0 ? 1 : numShards), writerLock(*this) {
+    }
+
+    ShardedRWLock(const ShardedRWLock&) = delete;
+    ShardedRWLock& operator=(const ShardedRWLock&) = delete;
+
+    /**
+     * @return the read lock for the calling thread to use. The lock may be
+     *         unlocked by another thread (e.g. a std::unique_lock which has
+     *         been moved), as it is the lock of a given shard.
+     */
+    cb::ReaderLock& reader() {
+        return shards[getThreadIndex() % shards.size()]->reader();
+    }
+
+    size_t getNumShards() const {
+        return shards.size();
+    }
+
+    Writer& writer() {
+        return writerLock;
+    }
+
+private:
+    /**
+     * Every shard uses (at least) a 64 byte cache line, and there are two
+     * of these per vbucket (for the collections manifest and its counters).
+     * With the maximum of 16 shards that is 2 KiB per vbucket, or ~2 MiB
+     * per bucket with 1024 vbuckets, so limit the number of shards.
+     */
+    static const size_t MaxShards = 16;
+
+    static size_t getDefaultNumShards() {
+        const size_t cpus = std::thread::hardware_concurrency();
+        if (cpus == 0) {
+            return 1;
+        }
+        if (cpus > MaxShards) {
+            return MaxShards;
+        }
+        return cpus;
+    }
+
+    /// @return a number which is unique to (and fixed for) the calling thread
+    static size_t getThreadIndex() {
+        static std::atomic<size_t> nextIndex{0};
+        static thread_local size_t index = nextIndex++;
+        return index;
+    }
+
+    std::vector<cb::CachelinePadded<cb::RWLock>> shards;
+    Writer writerLock;
+};
@@ -113,6 +113,8 @@ EPStats::EPStats()
       numOpsSetRetMeta(0),
       numOpsDelRetMeta(0),
       numOpsGetMetaOnSetWithMeta(0),
+      metaDataCacheHits(0),
+      metaDataCacheMisses(0),
       alogRuns(0),
       accessScannerSkips(0),
       alogNumItems(0),
@@ -123,6 +125,8 @@ EPStats::EPStats()
       rollbackCount(0),
       defragNumVisited(0),
       defragNumMoved(0),
+      defragNumBytesMoved(0),
+      defragLastPassReclaimed(0),
       dirtyAgeHisto(),
       diskCommitHisto(),
       timingLog(NULL),
@@ -136,6 +140,8 @@ EPStats::~EPStats() {
     delete timingLog;
 }
 
+const int64_t EPStats::MaxMemUsedMergeThreshold;
+
 void EPStats::setMaxDataSize(size_t size) {
     if (size > 0) {
         maxDataSize.store(size);
@@ -153,7 +159,9 @@ void EPStats::calculateMemUsedMergeThreshold() {
     // elements, i.e. nCpu)
     memUsedMergeThreshold =
             maxDataSize * (memUsedMergeThresholdPercent / 100.0);
-    memUsedMergeThreshold = memUsedMergeThreshold / coreTotalMemory.size();
+    memUsedMergeThreshold = std::min(
+            int64_t(memUsedMergeThreshold / coreTotalMemory.size()),
+            MaxMemUsedMergeThreshold);
 }
 
 void EPStats::memAllocated(size_t sz) {
@@ -211,4 +219,24 @@ size_t EPStats::getPreciseTotalMemoryUsed() {
         return size_t(std::max(int64_t(0), estimatedTotalMemory->load()));
     }
     return currentSize.load() + memOverhead->load();
+}
+
+size_t EPStats::getTotalMemoryUsedNear(size_t threshold) {
+    const auto estimate = getEstimatedTotalMemoryUsed();
+    if (!memoryTrackerEnabled.load()) {
+        // The estimate is precise
+        return estimate;
+    }
+
+    const auto distance =
+            estimate > threshold ? estimate - threshold : threshold - estimate;
+    if (distance > getMaxEstimatedMemoryError()) {
+        return estimate;
+    }
+
+    auto total = estimatedTotalMemory->load();
+    for (auto& core : coreTotalMemory) {
+        total += core->load();
+    }
+    return size_t(std::max(int64_t(0), total));
 }
\ No newline at end of file
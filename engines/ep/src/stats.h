@@ -69,6 +69,25 @@ public:
         return memUsedMergeThreshold.load();
     }
 
+    /**
+     * The upper limit for memUsedMergeThreshold, so that the error of the
+     * estimate stays bounded for large quotas.
+     */
+    static const int64_t MaxMemUsedMergeThreshold = 1024 * 1024;
+
+    /**
+     * @return the maximum amount by which getEstimatedTotalMemoryUsed may
+     * differ from the precise value (each of the core local counters may
+     * hold up to memUsedMergeThreshold which hasn't been merged).
+     */
+    size_t getMaxEstimatedMemoryError() const {
+        if (memoryTrackerEnabled.load()) {
+            return size_t(memUsedMergeThreshold.load()) *
+                   coreTotalMemory.size();
+        }
+        return 0;
+    }
+
     /**
      * @return a estimated memory used. This is an estimate because memory is
      * tracked in a CoreStore container and the estimate value is only updated
@@ -95,6 +114,18 @@ public:
      */
     size_t getPreciseTotalMemoryUsed();
 
+    /**
+     * Get the memory used for a comparison against the given threshold
+     * (the quota or one of the watermarks).
+     *
+     * The estimate is returned unless it's within the maximum error of
+     * the estimate from the threshold (where the error could change the
+     * outcome of the comparison). In that case the core local counters
+     * are added to the estimate (without merging them, as that would
+     * make every core's counter bounce between the cores).
+     */
+    size_t getTotalMemoryUsedNear(size_t threshold);
+
     // account for allocated mem
     void memAllocated(size_t sz);
 
@@ -330,6 +361,12 @@ public:
     Counter  numOpsDelRetMeta;
     //! The number of background get meta ops due to set_with_meta operations
     Counter  numOpsGetMetaOnSetWithMeta;
+    //! The number of evicted items' metadata lookups served by the metadata
+    //! cache
+    Counter metaDataCacheHits;
+    //! The number of evicted items' metadata lookups not found in the
+    //! metadata cache
+    Counter metaDataCacheMisses;
 
     //! The number of times the access scanner runs
     Counter alogRuns;
@@ -359,6 +396,14 @@ public:
      */
     Counter defragNumMoved;
 
+    /** The number of bytes of values moved by the defragmenter task. */
+    Counter defragNumBytesMoved;
+
+    /** Approximately how many bytes the mapped memory dropped by during
+     * the last complete pass of the defragmenter task.
+     */
+    Counter defragLastPassReclaimed;
+
     //! Histogram of queue processing dirty age.
     MicrosecondHistogram dirtyAgeHisto;
 
@@ -468,6 +513,8 @@ public:
         accessScannerSkips.store(0),
         defragNumVisited.store(0),
         defragNumMoved.store(0);
+        defragNumBytesMoved.store(0);
+        defragLastPassReclaimed.store(0);
 
         pendingOpsHisto.reset();
         bgWaitHisto.reset();
@@ -518,7 +565,8 @@ protected:
 
     /**
      * Set memUsedMergeThreshold by calculating a percentage of max_size and
-     * divided by the size of the coreTotalMemory container.
+     * divided by the size of the coreTotalMemory container (capped at
+     * MaxMemUsedMergeThreshold).
      */
     void calculateMemUsedMergeThreshold();
 
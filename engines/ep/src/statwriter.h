@@ -27,6 +27,9 @@
 
 #include <atomic>
 #include <cstring>
+#include <sstream>
+#include <string>
+#include <type_traits>
 
 class EventuallyPersistentEngine;
 
@@ -38,12 +41,32 @@ inline void add_casted_stat(const char *k, const char *v,
     ObjectRegistry::onSwitchThread(e);
 }
 
+/// @cond DETAILS
+// Most stats are integers, and std::to_string is a lot cheaper than a
+// stringstream for them. Single byte integers stream as characters, so
+// they (and everything else) still go via the stringstream.
 template <typename T>
-void add_casted_stat(const char *k, const T &v,
-                            ADD_STAT add_stat, const void *cookie) {
+std::string format_casted_stat(const T& v, std::true_type) {
+    return std::to_string(v);
+}
+
+template <typename T>
+std::string format_casted_stat(const T& v, std::false_type) {
     std::stringstream vals;
     vals << v;
-    add_casted_stat(k, vals.str().c_str(), add_stat, cookie);
+    return vals.str();
+}
+/// @endcond
+
+template <typename T>
+void add_casted_stat(const char *k, const T &v,
+                            ADD_STAT add_stat, const void *cookie) {
+    const auto value = format_casted_stat(
+            v,
+            std::integral_constant<bool,
+                                   std::is_integral<T>::value &&
+                                           (sizeof(T) > 1)>{});
+    add_casted_stat(k, value.c_str(), add_stat, cookie);
 }
 
 inline void add_casted_stat(const char *k, const bool v,
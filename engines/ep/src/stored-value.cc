@@ -19,6 +19,7 @@
 
 #include "stored-value.h"
 
+#include "compression_dictionary.h"
 #include "ep_time.h"
 #include "item.h"
 #include "objectregistry.h"
@@ -142,12 +143,13 @@ uint8_t StoredValue::getNRUValue() const {
 
 void StoredValue::setFreqCounterValue(uint16_t newValue) {
     auto taggedPtr = value.get();
-    taggedPtr.setTag(newValue);
+    taggedPtr.setTag((taggedPtr.getTag() & dictionaryCompressedTag) |
+                     (newValue & ~dictionaryCompressedTag));
     value.reset(taggedPtr);
 }
 
 uint16_t StoredValue::getFreqCounterValue() const {
-    return value.get().getTag();
+    return value.get().getTag() & ~dictionaryCompressedTag;
 }
 
 void StoredValue::restoreValue(const Item& itm) {
@@ -202,7 +204,7 @@ std::unique_ptr<Item> StoredValue::toItem(bool lck, uint16_t vbucket) const {
             std::make_unique<Item>(getKey(),
                                    getFlags(),
                                    getExptime(),
-                                   value,
+                                   getDecodedValue(),
                                    datatype,
                                    lck ? static_cast<uint64_t>(-1) : getCas(),
                                    bySeqno,
@@ -241,17 +243,36 @@ std::unique_ptr<Item> StoredValue::toItemKeyOnly(uint16_t vbucket) const {
 
 void StoredValue::reallocate() {
     // Allocate a new Blob for this stored value; copy the existing Blob to
-    // the new one and free the old.
-    value_t new_val(Blob::Copy(*value));
-    value.reset(new_val);
+    // the new one and free the old. The dictionary compressed marker must
+    // follow the value.
+    const auto tag = value.get().getTag() & dictionaryCompressedTag;
+    value.reset(TaggedPtr<Blob>(Blob::Copy(*value), tag));
+}
+
+value_t StoredValue::getDecodedValue() const {
+    if (!value || !isDictionaryCompressed()) {
+        return value;
+    }
+
+    std::vector<char> inflated;
+    if (!CompressionDictionary::decompress(
+                {value->getData(), value->valueSize()}, inflated)) {
+        throw std::logic_error(
+                "StoredValue::getDecodedValue: failed to decompress value");
+    }
+    return value_t(Blob::New(inflated.data(), inflated.size()));
 }
 
 void StoredValue::Deleter::operator()(StoredValue* val) {
+    // The memory was allocated by BucketArena::allocate (see the
+    // StoredValue factories)
+    const bool fromArena = val->arenaAllocated;
     if (val->isOrdered()) {
-        delete static_cast<OrderedStoredValue*>(val);
+        static_cast<OrderedStoredValue*>(val)->~OrderedStoredValue();
     } else {
-        delete val;
+        val->~StoredValue();
     }
+    BucketArena::deallocate(val, fromArena);
 }
 
 OrderedStoredValue* StoredValue::toOrderedStoredValue() {
@@ -329,6 +350,10 @@ void StoredValue::setValueImpl(const Item& itm) {
 }
 
 bool StoredValue::compressValue() {
+    if (isDictionaryCompressed()) {
+        // Already compressed (in memory) with a dictionary.
+        return true;
+    }
     if (!mcbp::datatype::is_snappy(datatype)) {
         // Attempt compression only if datatype indicates
         // that the value is not compressed already
@@ -353,6 +378,26 @@ bool StoredValue::compressValue() {
     return true;
 }
 
+bool StoredValue::compressValue(const CompressionDictionary& dictionary) {
+    if (!value || !isResident() || isDictionaryCompressed() ||
+        mcbp::datatype::is_snappy(datatype) ||
+        mcbp::datatype::is_xattr(datatype)) {
+        return false;
+    }
+
+    std::vector<char> deflated;
+    if (!dictionary.compress({value->getData(), value->valueSize()},
+                             deflated) ||
+        deflated.size() >= value->valueSize()) {
+        return false;
+    }
+
+    const auto tag = value.get().getTag() | dictionaryCompressedTag;
+    value.reset(TaggedPtr<Blob>(Blob::New(deflated.data(), deflated.size()),
+                                tag));
+    return true;
+}
+
 /**
  * Get an item_info from the StoredValue
  */
@@ -373,7 +418,10 @@ boost::optional<item_info> StoredValue::getItemInfo(uint64_t vbuuid) const {
             isDeleted() ? DocumentState::Deleted : DocumentState::Alive;
     info.nkey = getKey().size();
     info.key = getKey().data();
-    if (getValue()) {
+    // A dictionary compressed value cannot be referenced in place. Only
+    // non-xattr values are dictionary compressed, so the users of item_info
+    // (which only inspect the xattrs) do not need it.
+    if (getValue() && !isDictionaryCompressed()) {
         info.value[0].iov_base = const_cast<char*>(getValue()->getData());
         info.value[0].iov_len = getValue()->valueSize();
     }
@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include "blob.h"
+#include "bucket_arena.h"
 #include "item_pager.h"
 #include "storeddockey.h"
 #include "tagged_ptr.h"
@@ -31,6 +32,7 @@
 
 #include <boost/intrusive/list.hpp>
 
+class CompressionDictionary;
 class Item;
 class OrderedStoredValue;
 
@@ -136,6 +138,25 @@ public:
      */
     bool compressValue();
 
+    /**
+     * Compress the value part of stored value with the given dictionary.
+     * Only resident, non-xattr values which are not already compressed are
+     * considered; the compressed value is only kept if it is smaller than
+     * the original.
+     *
+     * @return true if the value is now dictionary compressed
+     */
+    bool compressValue(const CompressionDictionary& dictionary);
+
+    /**
+     * @return true if the value is held compressed with a
+     *         CompressionDictionary (an in-memory only representation which
+     *         is not reflected in the datatype).
+     */
+    bool isDictionaryCompressed() const {
+        return (value.get().getTag() & dictionaryCompressedTag) != 0;
+    }
+
     // Custom deleter for StoredValue objects.
     struct Deleter {
         void operator()(StoredValue* val);
@@ -238,6 +259,12 @@ public:
         return value;
     }
 
+    /**
+     * Get this item's value in the form indicated by its datatype; i.e.
+     * decompressed if the value is held dictionary compressed.
+     */
+    value_t getDecodedValue() const;
+
     /**
      * Get the expiration time of this item.
      *
@@ -783,6 +810,20 @@ protected:
 
     folly::AtomicBitSet<sizeof(uint8_t)> bits;
 
+    /**
+     * Was the memory of this StoredValue allocated from a BucketArena?
+     * (Set by the factories, and read by the Deleter; it fits in the
+     * padding after `bits`.)
+     */
+    bool arenaAllocated = false;
+
+    /**
+     * The frequency counter only uses the low 8 bits of the value's tag;
+     * the top bit of the tag marks a value compressed with a
+     * CompressionDictionary (there are no spare bits in `bits`).
+     */
+    static constexpr uint16_t dictionaryCompressedTag = 0x8000;
+
     friend std::ostream& operator<<(std::ostream& os, const StoredValue& sv);
 };
 
@@ -73,12 +73,15 @@ public:
                                       StoredValue::UniquePtr next) override {
         // Allocate a buffer to store the StoredValue and any trailing bytes
         // that maybe required.
-        return StoredValue::UniquePtr(
-                new (::operator new(StoredValue::getRequiredStorage(itm)))
-                        StoredValue(itm,
-                                    std::move(next),
-                                    *stats,
-                                    /*isOrdered*/ false));
+        bool fromArena;
+        auto* sv = new (BucketArena::allocate(
+                StoredValue::getRequiredStorage(itm), fromArena))
+                StoredValue(itm,
+                            std::move(next),
+                            *stats,
+                            /*isOrdered*/ false);
+        sv->arenaAllocated = fromArena;
+        return StoredValue::UniquePtr(sv);
     }
 
     StoredValue::UniquePtr copyStoredValue(const StoredValue& other,
@@ -107,10 +110,12 @@ public:
                                       StoredValue::UniquePtr next) override {
         // Allocate a buffer to store the OrderStoredValue and any trailing
         // bytes required for the key.
-        return StoredValue::UniquePtr(
-                new (::operator new(
-                        OrderedStoredValue::getRequiredStorage(itm)))
-                        OrderedStoredValue(itm, std::move(next), *stats));
+        bool fromArena;
+        auto* osv = new (BucketArena::allocate(
+                OrderedStoredValue::getRequiredStorage(itm), fromArena))
+                OrderedStoredValue(itm, std::move(next), *stats);
+        osv->arenaAllocated = fromArena;
+        return StoredValue::UniquePtr(osv);
     }
 
     /**
@@ -120,9 +125,12 @@ public:
                                            StoredValue::UniquePtr next) override {
         // Allocate a buffer to store the copy ofOrderStoredValue and any
         // trailing bytes required for the key.
-        return StoredValue::UniquePtr(
-                new (::operator new(other.getObjectSize()))
-                        OrderedStoredValue(other, std::move(next), *stats));
+        bool fromArena;
+        auto* osv = new (BucketArena::allocate(other.getObjectSize(),
+                                               fromArena))
+                OrderedStoredValue(other, std::move(next), *stats);
+        osv->arenaAllocated = fromArena;
+        return StoredValue::UniquePtr(osv);
     }
 
 private:
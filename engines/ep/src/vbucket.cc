@@ -27,12 +27,15 @@
 #include "failover-table.h"
 #include "flusher.h"
 #include "hash_table.h"
+#include "meta_data_cache.h"
 #include "pre_link_document_context.h"
 #include "statwriter.h"
 #include "stored_value_factories.h"
 #include "vbucket.h"
 #include "vbucketdeletiontask.h"
 
+#include <tracing/trace_helpers.h>
+
 #include <xattr/blob.h>
 #include <xattr/utils.h>
 
@@ -209,10 +212,18 @@ VBucket::VBucket(id_type i,
         conflictResolver.reset(new RevisionSeqnoResolution());
     }
 
+    if (eviction == FULL_EVICTION && config.getMetaDataCacheSize() > 0) {
+        metaDataCache =
+                std::make_unique<MetaDataCache>(config.getMetaDataCacheSize());
+    }
+
+    ht.setCollectionsManifest(&manifest);
+
     backfill.isBackfillPhase = false;
     pendingOpsStart = ProcessClock::time_point();
     stats.memOverhead->fetch_add(sizeof(VBucket)
-                                + ht.memorySize() + sizeof(CheckpointManager));
+                                + ht.memorySize() + sizeof(CheckpointManager)
+                                + getMetaDataCacheMemoryUsage());
     LOG(EXTENSION_LOG_NOTICE,
         "VBucket: created vbucket:%" PRIu16
         " with state:%s "
@@ -246,7 +257,8 @@ VBucket::~VBucket() {
     clearFilter();
 
     stats.memOverhead->fetch_sub(sizeof(VBucket) + ht.memorySize() +
-                                sizeof(CheckpointManager));
+                                sizeof(CheckpointManager) +
+                                getMetaDataCacheMemoryUsage());
 
     LOG(EXTENSION_LOG_NOTICE, "Destroying vbucket %d", id);
 }
@@ -657,6 +669,26 @@ size_t VBucket::getNumOfKeysInFilter() {
     }
 }
 
+void VBucket::addToMetaDataCache(const StoredValue& v) {
+    if (metaDataCache) {
+        metaDataCache->insert(v);
+    }
+}
+
+void VBucket::clearMetaDataCache() {
+    if (metaDataCache) {
+        metaDataCache->clear();
+    }
+}
+
+size_t VBucket::getMetaDataCacheNumItems() const {
+    return metaDataCache ? metaDataCache->getNumItems() : 0;
+}
+
+size_t VBucket::getMetaDataCacheMemoryUsage() const {
+    return metaDataCache ? metaDataCache->getMemoryUsage() : 0;
+}
+
 VBNotifyCtx VBucket::queueDirty(
         StoredValue& v,
         const GenerateBySeqno generateBySeqno,
@@ -700,6 +732,16 @@ VBNotifyCtx VBucket::queueDirty(
     return notifyCtx;
 }
 
+HashTable::HashBucketLock VBucket::getLockedBucket(
+        const DocKey& key,
+        const void* cookie,
+        EventuallyPersistentEngine& engine) {
+    TRACE_SCOPE(engine.getServerApi(),
+                cookie,
+                cb::tracing::TraceCode::HTLOCKWAIT);
+    return ht.getLockedBucket(key);
+}
+
 StoredValue* VBucket::fetchValidValue(HashTable::HashBucketLock& hbl,
                                       const DocKey& key,
                                       WantsDeleted wantsDeleted,
@@ -791,7 +833,7 @@ ENGINE_ERROR_CODE VBucket::set(Item& itm,
                                const int bgFetchDelay,
                                cb::StoreIfPredicate predicate) {
     bool cas_op = (itm.getCas() != 0);
-    auto hbl = ht.getLockedBucket(itm.getKey());
+    auto hbl = getLockedBucket(itm.getKey(), cookie, engine);
     StoredValue* v = ht.unlocked_find(itm.getKey(),
                                       hbl.getBucketNum(),
                                       WantsDeleted::Yes,
@@ -894,7 +936,7 @@ ENGINE_ERROR_CODE VBucket::replace(
         const int bgFetchDelay,
         cb::StoreIfPredicate predicate,
         const Collections::VB::Manifest::CachingReadHandle& readHandle) {
-    auto hbl = ht.getLockedBucket(itm.getKey());
+    auto hbl = getLockedBucket(itm.getKey(), cookie, engine);
     StoredValue* v = ht.unlocked_find(itm.getKey(),
                                       hbl.getBucketNum(),
                                       WantsDeleted::Yes,
@@ -1056,11 +1098,14 @@ ENGINE_ERROR_CODE VBucket::setWithMeta(
         GenerateCas genCas,
         bool isReplication,
         const Collections::VB::Manifest::CachingReadHandle& readHandle) {
-    auto hbl = ht.getLockedBucket(itm.getKey());
+    auto hbl = getLockedBucket(itm.getKey(), cookie, engine);
     StoredValue* v = ht.unlocked_find(itm.getKey(),
                                       hbl.getBucketNum(),
                                       WantsDeleted::Yes,
                                       TrackReference::No);
+    if (!v && checkConflicts == CheckConflicts::Yes) {
+        v = restoreMetaFromCache(hbl, itm.getKey());
+    }
 
     bool maybeKeyExists = true;
 
@@ -1184,7 +1229,7 @@ ENGINE_ERROR_CODE VBucket::deleteItem(
         ItemMetaData* itemMeta,
         mutation_descr_t& mutInfo,
         const Collections::VB::Manifest::CachingReadHandle& readHandle) {
-    auto hbl = ht.getLockedBucket(readHandle.getKey());
+    auto hbl = getLockedBucket(readHandle.getKey(), cookie, engine);
     StoredValue* v = ht.unlocked_find(readHandle.getKey(),
                                       hbl.getBucketNum(),
                                       WantsDeleted::Yes,
@@ -1323,9 +1368,12 @@ ENGINE_ERROR_CODE VBucket::deleteWithMeta(
         bool isReplication,
         const Collections::VB::Manifest::CachingReadHandle& readHandle) {
     const auto& key = readHandle.getKey();
-    auto hbl = ht.getLockedBucket(key);
+    auto hbl = getLockedBucket(key, cookie, engine);
     StoredValue* v = ht.unlocked_find(
             key, hbl.getBucketNum(), WantsDeleted::Yes, TrackReference::No);
+    if (!v && checkConflicts == CheckConflicts::Yes) {
+        v = restoreMetaFromCache(hbl, key);
+    }
 
     if (v && readHandle.isLogicallyDeleted(v->getBySeqno())) {
         return ENGINE_KEY_ENOENT;
@@ -1540,11 +1588,14 @@ ENGINE_ERROR_CODE VBucket::add(
         EventuallyPersistentEngine& engine,
         int bgFetchDelay,
         const Collections::VB::Manifest::CachingReadHandle& readHandle) {
-    auto hbl = ht.getLockedBucket(itm.getKey());
+    auto hbl = getLockedBucket(itm.getKey(), cookie, engine);
     StoredValue* v = ht.unlocked_find(itm.getKey(),
                                       hbl.getBucketNum(),
                                       WantsDeleted::Yes,
                                       TrackReference::No);
+    if (!v) {
+        v = restoreMetaFromCache(hbl, itm.getKey());
+    }
 
     bool maybeKeyExists = true;
     if ((v == nullptr || v->isTempInitialItem()) &&
@@ -1658,7 +1709,7 @@ GetValue VBucket::getAndUpdateTtl(
         int bgFetchDelay,
         time_t exptime,
         const Collections::VB::Manifest::CachingReadHandle& readHandle) {
-    auto hbl = ht.getLockedBucket(readHandle.getKey());
+    auto hbl = getLockedBucket(readHandle.getKey(), cookie, engine);
     StoredValue* v = fetchValidValue(hbl,
                                      readHandle.getKey(),
                                      WantsDeleted::Yes,
@@ -1700,7 +1751,7 @@ GetValue VBucket::getInternal(
     const bool metadataOnly = (options & ALLOW_META_ONLY);
     const bool getDeletedValue = (options & GET_DELETED_VALUE);
     const bool bgFetchRequired = (options & QUEUE_BG_FETCH);
-    auto hbl = ht.getLockedBucket(readHandle.getKey());
+    auto hbl = getLockedBucket(readHandle.getKey(), cookie, engine);
     StoredValue* v = fetchValidValue(hbl,
                                      readHandle.getKey(),
                                      WantsDeleted::Yes,
@@ -1801,11 +1852,14 @@ ENGINE_ERROR_CODE VBucket::getMetaData(
         uint32_t& deleted,
         uint8_t& datatype) {
     deleted = 0;
-    auto hbl = ht.getLockedBucket(readHandle.getKey());
+    auto hbl = getLockedBucket(readHandle.getKey(), cookie, engine);
     StoredValue* v = ht.unlocked_find(readHandle.getKey(),
                                       hbl.getBucketNum(),
                                       WantsDeleted::Yes,
                                       TrackReference::No);
+    if (!v) {
+        v = restoreMetaFromCache(hbl, readHandle.getKey());
+    }
 
     if (v) {
         stats.numOpsGetMeta++;
@@ -1867,7 +1921,7 @@ ENGINE_ERROR_CODE VBucket::getKeyStats(
         struct key_stats& kstats,
         WantsDeleted wantsDeleted,
         const Collections::VB::Manifest::CachingReadHandle& readHandle) {
-    auto hbl = ht.getLockedBucket(readHandle.getKey());
+    auto hbl = getLockedBucket(readHandle.getKey(), cookie, engine);
     StoredValue* v = fetchValidValue(hbl,
                                      readHandle.getKey(),
                                      WantsDeleted::Yes,
@@ -1929,7 +1983,7 @@ GetValue VBucket::getLocked(
         EventuallyPersistentEngine& engine,
         int bgFetchDelay,
         const Collections::VB::Manifest::CachingReadHandle& readHandle) {
-    auto hbl = ht.getLockedBucket(readHandle.getKey());
+    auto hbl = getLockedBucket(readHandle.getKey(), cookie, engine);
     StoredValue* v = fetchValidValue(hbl,
                                      readHandle.getKey(),
                                      WantsDeleted::Yes,
@@ -2012,6 +2066,7 @@ void VBucket::deletedOnDiskCbk(const Item& queuedItem, bool deleted) {
         if (deleted) {
             // Removed an item from disk - decrement the count of total items.
             decrNumTotalItems();
+            decrCollectionItemCount(queuedItem.getKey());
         }
 
         /**
@@ -2067,13 +2122,15 @@ void VBucket::setMutationMemoryThreshold(double memThreshold) {
 bool VBucket::hasMemoryForStoredValue(EPStats& st,
                                       const Item& item,
                                       bool isReplication) {
-    double newSize = static_cast<double>(estimateNewMemoryUsage(st, item));
     double maxSize = static_cast<double>(st.getMaxDataSize());
-    if (isReplication) {
-        return newSize <= (maxSize * st.replicationThrottleThreshold);
-    } else {
-        return newSize <= (maxSize * mutationMemThreshold);
+    const auto limit = static_cast<size_t>(
+            isReplication ? maxSize * st.replicationThrottleThreshold
+                          : maxSize * mutationMemThreshold);
+    const auto required = getRequiredStorage(item);
+    if (required > limit) {
+        return false;
     }
+    return st.getTotalMemoryUsedNear(limit - required) <= limit - required;
 }
 
 void VBucket::_addStats(bool details, ADD_STAT add_stat, const void* c) {
@@ -2108,6 +2165,10 @@ void VBucket::_addStats(bool details, ADD_STAT add_stat, const void* c) {
                 add_stat, c);
         addStat("bloom_filter_size", getFilterSize(), add_stat, c);
         addStat("bloom_filter_key_count", getNumOfKeysInFilter(), add_stat, c);
+        addStat("meta_data_cache_items",
+                getMetaDataCacheNumItems(),
+                add_stat,
+                c);
         addStat("rollback_item_count", getRollbackItemCount(), add_stat, c);
         addStat("hp_vb_req_size", getHighPriorityChkSize(), add_stat, c);
         addStat("might_contain_xattrs", mightContainXattrs(), add_stat, c);
@@ -2449,6 +2510,12 @@ bool VBucket::deleteStoredValue(const HashTable::HashBucketLock& hbl,
         return false;
     }
 
+    // Once removed from the HT the key's metadata may no longer match any
+    // (previously evicted) metadata we have cached for it.
+    if (metaDataCache) {
+        metaDataCache->erase(v.getKey());
+    }
+
     /* StoredValue deleted here. If any other in-memory data structures are
        using the StoredValue intrusively then they must have handled the delete
        by this point */
@@ -2490,6 +2557,39 @@ TempAddStatus VBucket::addTempStoredValue(const HashTable::HashBucketLock& hbl,
     return TempAddStatus::BgFetch;
 }
 
+StoredValue* VBucket::restoreMetaFromCache(const HashTable::HashBucketLock& hbl,
+                                           const DocKey& key) {
+    if (!metaDataCache) {
+        return nullptr;
+    }
+
+    auto cached = metaDataCache->find(key);
+    if (!cached) {
+        ++stats.metaDataCacheMisses;
+        return nullptr;
+    }
+
+    if (addTempStoredValue(hbl, key) != TempAddStatus::BgFetch) {
+        return nullptr;
+    }
+    StoredValue* v = ht.unlocked_find(
+            key, hbl.getBucketNum(), WantsDeleted::Yes, TrackReference::No);
+
+    Item itm(key,
+             cached->flags,
+             cached->exptime,
+             /*data*/ nullptr,
+             /*size*/ 0,
+             cached->datatype,
+             cached->cas,
+             cached->bySeqno,
+             getId(),
+             cached->revSeqno);
+    ht.unlocked_restoreMeta(hbl.getHTLock(), itm, *v);
+    ++stats.metaDataCacheHits;
+    return v;
+}
+
 void VBucket::notifyNewSeqno(const VBNotifyCtx& notifyCtx) {
     if (newSeqnoCb) {
         newSeqnoCb->callback(getId(), notifyCtx);
@@ -2700,6 +2800,9 @@ void VBucket::removeKey(const DocKey& key, int64_t bySeqno) {
             hbl, key, WantsDeleted::No, TrackReference::No, QueueExpired::Yes);
 
     if (v && v->isResident() && v->getBySeqno() == bySeqno) {
+        if (metaDataCache) {
+            metaDataCache->erase(v->getKey());
+        }
         ht.unlocked_del(hbl, v->getKey());
     }
 }
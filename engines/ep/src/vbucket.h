@@ -41,6 +41,7 @@ class CheckpointManager;
 class ConflictResolution;
 class Configuration;
 class ItemMetaData;
+class MetaDataCache;
 class PreLinkDocumentContext;
 class EventuallyPersistentEngine;
 class DCPBackfill;
@@ -370,6 +371,21 @@ public:
      */
     virtual void setNumTotalItems(size_t items) = 0;
 
+    /// Increase the count of items in the collection of the key by 1.
+    void incrCollectionItemCount(const DocKey& key) {
+        manifest.updateItemCount(key, 1);
+    }
+
+    /// Decrease the count of items in the collection of the key by 1.
+    void decrCollectionItemCount(const DocKey& key) {
+        manifest.updateItemCount(key, -1);
+    }
+
+    /// Set the count of items in every collection to zero.
+    void resetCollectionItemCounts() {
+        manifest.resetItemCounts();
+    }
+
     /// Reset all statistics assocated with this vBucket.
     virtual void resetStats();
 
@@ -520,6 +536,15 @@ public:
     size_t getFilterSize();
     size_t getNumOfKeysInFilter();
 
+    /**
+     * Metadata cache operations for vbucket (full eviction only, no-ops if
+     * the cache is not enabled).
+     */
+    void addToMetaDataCache(const StoredValue& v);
+    void clearMetaDataCache();
+    size_t getMetaDataCacheNumItems() const;
+    size_t getMetaDataCacheMemoryUsage() const;
+
     uint64_t nextHLCCas() {
         return hlc.nextHLC();
     }
@@ -1242,6 +1267,15 @@ public:
     };
 
 protected:
+    /**
+     * Lock the hash bucket for the given key, tracing the time spent
+     * waiting for the lock against the cookie (if any).
+     */
+    HashTable::HashBucketLock getLockedBucket(
+            const DocKey& key,
+            const void* cookie,
+            EventuallyPersistentEngine& engine);
+
     /**
      * This function checks for the various states of the value & depending on
      * which the calling function can issue a bgfetch as needed.
@@ -1418,6 +1452,21 @@ protected:
                                      const DocKey& key,
                                      bool isReplication = false);
 
+    /**
+     * Full eviction: if the given key has no StoredValue in the HT but its
+     * metadata is held in the metadata cache, add a metadata-only
+     * StoredValue for it (exactly as a completed metadata bgFetch would).
+     * Assumes that HT bucket lock is grabbed.
+     *
+     * @param hbl Hash table bucket lock that must be held
+     * @param key the key to restore
+     *
+     * @return the restored StoredValue, or nullptr if the metadata cache
+     *         could not supply the key's metadata
+     */
+    StoredValue* restoreMetaFromCache(const HashTable::HashBucketLock& hbl,
+                                      const DocKey& key);
+
     /**
      * Internal wrapper function around the callback to be called when a new
      * seqno is generated in the vbucket
@@ -1685,15 +1734,14 @@ private:
                                              const ItemMetaData& itemMeta);
 
     /**
-     * Estimate the new total memory usage with the allocation of an in-memory
-     * instance for item
+     * Get the memory required for the allocation of an in-memory instance
+     * for item
      *
-     * @param st Reference to epstats
      * @param item Item that is being added
      *
-     * @return new total size for this Bucket once Item is allocated
+     * @return the number of bytes required to store the Item
      */
-    virtual size_t estimateNewMemoryUsage(EPStats& st, const Item& item) = 0;
+    virtual size_t getRequiredStorage(const Item& item) = 0;
 
     /*
      * Call the predicate with item_info from v (none if v is nullptr)
@@ -1724,6 +1772,9 @@ private:
     std::unique_ptr<BloomFilter> bFilter;
     std::unique_ptr<BloomFilter> tempFilter;    // Used during compaction.
 
+    // Metadata of fully evicted items; only created for full eviction.
+    std::unique_ptr<MetaDataCache> metaDataCache;
+
     std::atomic<uint64_t> rollbackItemCount;
 
     HLC hlc;
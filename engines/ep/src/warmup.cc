@@ -604,6 +604,14 @@ void LoadStorageKVPairCallback::callback(GetValue &val) {
                 succeeded = true;
                 break;
             case MutationStatus::NotFound:
+                // Each key is first loaded by the key dump (value eviction)
+                // or the data load (full eviction); count it against its
+                // collection then. Under full eviction only the items which
+                // warmup loads are counted.
+                if (val.isPartial() ||
+                    epstore.getItemEvictionPolicy() == FULL_EVICTION) {
+                    vb->incrCollectionItemCount(i->getKey());
+                }
                 succeeded = true;
                 break;
             default:
@@ -6282,6 +6282,7 @@ static enum test_result test_mb19687_fixed(ENGINE_HANDLE* h,
                         "ep_bfilter_key_count",
                         "ep_bfilter_residency_threshold",
                         "ep_bg_fetch_delay",
+                        "ep_bucket_arena_enabled",
                         "ep_bucket_type",
                         "ep_cache_size",
                         "ep_chk_max_items",
@@ -6291,6 +6292,9 @@ static enum test_result test_mb19687_fixed(ENGINE_HANDLE* h,
                         "ep_collections_max_size",
                         "ep_compaction_exp_mem_threshold",
                         "ep_compaction_write_queue_cap",
+                        "ep_compression_dictionary_enabled",
+                        "ep_compression_dictionary_samples",
+                        "ep_compression_dictionary_size",
                         "ep_compression_mode",
                         "ep_config_file",
                         "ep_conflict_resolution_type",
@@ -6324,6 +6328,7 @@ static enum test_result test_mb19687_fixed(ENGINE_HANDLE* h,
                         "ep_defragmenter_chunk_duration",
                         "ep_defragmenter_enabled",
                         "ep_defragmenter_interval",
+                        "ep_defragmenter_policy",
                         "ep_enable_chk_merge",
                         "ep_exp_pager_enabled",
                         "ep_exp_pager_initial_run_time",
@@ -6356,6 +6361,7 @@ static enum test_result test_mb19687_fixed(ENGINE_HANDLE* h,
                         "ep_mem_high_wat",
                         "ep_mem_low_wat",
                         "ep_mem_used_merge_threshold_percent",
+                        "ep_meta_data_cache_size",
                         "ep_mutation_mem_threshold",
                         "ep_num_auxio_threads",
                         "ep_num_nonio_threads",
@@ -6452,6 +6458,7 @@ static enum test_result test_mb19687_fixed(ENGINE_HANDLE* h,
               "ep_bg_remaining_jobs",
               "ep_blob_num",
               "ep_blob_overhead",
+              "ep_bucket_arena_enabled",
               "ep_bucket_priority",
               "ep_bucket_type",
               "ep_cache_size",
@@ -6464,6 +6471,10 @@ static enum test_result test_mb19687_fixed(ENGINE_HANDLE* h,
               "ep_collections_max_size",
               "ep_compaction_exp_mem_threshold",
               "ep_compaction_write_queue_cap",
+              "ep_compression_dictionary_bytes",
+              "ep_compression_dictionary_enabled",
+              "ep_compression_dictionary_samples",
+              "ep_compression_dictionary_size",
               "ep_compression_mode",
               "ep_config_file",
               "ep_conflict_resolution_type",
@@ -6499,11 +6510,14 @@ static enum test_result test_mb19687_fixed(ENGINE_HANDLE* h,
               "ep_dcp_scan_item_limit",
               "ep_dcp_takeover_max_time",
               "ep_defragmenter_age_threshold",
+              "ep_defragmenter_bytes_moved",
               "ep_defragmenter_chunk_duration",
               "ep_defragmenter_enabled",
               "ep_defragmenter_interval",
+              "ep_defragmenter_last_pass_reclaimed",
               "ep_defragmenter_num_moved",
               "ep_defragmenter_num_visited",
+              "ep_defragmenter_policy",
               "ep_degraded_mode",
               "ep_diskqueue_drain",
               "ep_diskqueue_fill",
@@ -6560,6 +6574,9 @@ static enum test_result test_mb19687_fixed(ENGINE_HANDLE* h,
               "ep_mem_low_wat_percent",
               "ep_mem_tracker_enabled",
               "ep_mem_used_merge_threshold_percent",
+              "ep_meta_data_cache_hits",
+              "ep_meta_data_cache_misses",
+              "ep_meta_data_cache_size",
               "ep_meta_data_disk",
               "ep_meta_data_memory",
               "ep_mutation_mem_threshold",
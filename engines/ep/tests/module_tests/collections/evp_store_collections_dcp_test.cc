@@ -741,6 +741,29 @@ TEST_F(CollectionsFilteredDcpTest, filtering) {
     // 1 create - create of dairy
     // 2 mutations in the dairy collection
     testDcpCreateDelete(1, 0, 2, false);
+
+    // The 3 meat mutations were skipped by the backfill without reading them
+    auto stream = std::dynamic_pointer_cast<ActiveStream>(
+            producer->findStream(vbid));
+    ASSERT_TRUE(stream);
+    static std::string filtered;
+    filtered.clear();
+    stream->addStats(
+            [](const char* key,
+               const uint16_t klen,
+               const char* val,
+               const uint32_t vlen,
+               gsl::not_null<const void*>) {
+                const std::string k(key, klen);
+                const std::string suffix = "_backfill_filtered";
+                if (k.size() > suffix.size() &&
+                    k.compare(k.size() - suffix.size(), suffix.size(), suffix) ==
+                            0) {
+                    filtered.assign(val, vlen);
+                }
+            },
+            cookieP);
+    EXPECT_EQ("3", filtered);
 }
 
 // Check that when filtering is on, we don't send snapshots for fully filtered
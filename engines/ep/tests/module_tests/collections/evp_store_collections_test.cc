@@ -135,6 +135,74 @@ TEST_F(CollectionsTest, collections_basic) {
     EXPECT_EQ(ENGINE_UNKNOWN_COLLECTION, gv.getStatus());
 }
 
+// Test that the front-end operations are counted against the collection of
+// the key, and that the stats sum them up with the items in memory.
+TEST_F(CollectionsTest, collection_stats) {
+    VBucketPtr vb = store->getVBucket(vbid);
+    vb->updateFromManifest({R"({"separator":":",
+                 "collections":[{"name":"$default", "uid":"0"},
+                                {"name":"meat", "uid":"1"}]})"});
+    // Flush the meat create event
+    flush_vbucket_to_disk(vbid, 1);
+
+    store_item(vbid, {"key", DocNamespace::DefaultCollection}, "value");
+    store_item(vbid, {"meat:beef", DocNamespace::Collections}, "value");
+    store_item(vbid, {"meat:pork", DocNamespace::Collections}, "value");
+    flush_vbucket_to_disk(vbid, 3);
+    delete_item(vbid, {"meat:pork", DocNamespace::Collections});
+    flush_vbucket_to_disk(vbid, 1);
+
+    get_options_t options = static_cast<get_options_t>(
+            QUEUE_BG_FETCH | HONOR_STATES | TRACK_REFERENCE | DELETE_TEMP |
+            HIDE_LOCKED_CAS | TRACK_STATISTICS);
+    EXPECT_EQ(ENGINE_SUCCESS,
+              store->get({"meat:beef", DocNamespace::Collections},
+                         vbid,
+                         cookie,
+                         options)
+                      .getStatus());
+    // Failed operations aren't counted
+    EXPECT_EQ(ENGINE_KEY_ENOENT,
+              store->get({"meat:sausage", DocNamespace::Collections},
+                         vbid,
+                         cookie,
+                         options)
+                      .getStatus());
+
+    static std::map<std::string, std::string> stats;
+    auto getStats = [this]() {
+        stats.clear();
+        store->getCollectionsManager().addStats(
+                *store,
+                cookie,
+                [](const char* key,
+                   const uint16_t klen,
+                   const char* val,
+                   const uint32_t vlen,
+                   gsl::not_null<const void*>) {
+                    stats[std::string(key, klen)] = std::string(val, vlen);
+                });
+    };
+    getStats();
+
+    EXPECT_EQ("1", stats["$default:ops_store"]);
+    EXPECT_EQ("0", stats["$default:ops_get"]);
+    EXPECT_EQ("1", stats["$default:items"]);
+    EXPECT_EQ("2", stats["meat:ops_store"]);
+    EXPECT_EQ("1", stats["meat:ops_get"]);
+    EXPECT_EQ("1", stats["meat:ops_delete"]);
+    EXPECT_EQ("1", stats["meat:items"]);
+    EXPECT_NE("0", stats["meat:mem_used"]);
+
+    // Evicting an item reduces the memory used by its collection, but the
+    // item is still counted.
+    const auto memUsed = std::stoull(stats["$default:mem_used"]);
+    evict_key(vbid, {"key", DocNamespace::DefaultCollection});
+    getStats();
+    EXPECT_EQ("1", stats["$default:items"]);
+    EXPECT_LT(std::stoull(stats["$default:mem_used"]), memUsed);
+}
+
 // Test demonstrates issue logged as MB_25344, when we delete a collection
 // and then happen to perform a mutation against a new rev of the collection
 // we may encounter the key which is pending deletion and then fail when we
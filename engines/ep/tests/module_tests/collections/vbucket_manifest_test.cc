@@ -131,6 +131,13 @@ public:
         return greatestEndSeqno >= 0;
     }
 
+    int64_t getMemUsed(const std::string& collection) const {
+        std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
+        auto itr = map.find({collection.data(), collection.size()});
+        expect_true(itr != map.end());
+        return itr->second->getMemUsed();
+    }
+
     bool isNumDeletingCollectionsoCorrect() const {
         std::lock_guard<cb::ReaderLock> readLock(rwlock.reader());
         // If this is zero greatestEnd should not be a seqno
@@ -1038,3 +1045,41 @@ TEST_F(VBucketManifestCachingReadHandle, basic) {
                      reinterpret_cast<const char*>(rh.getKey().data()));
     }
 }
+
+/**
+ * The memory counters are updated through the entry looked up by the
+ * CachingReadHandle the thread holds (for a copy of its key, as the
+ * HashTable passes the StoredValue's key), and by looking up the entry
+ * for any other key.
+ */
+TEST_F(VBucketManifestCachingReadHandle, updateMemUsed) {
+    EXPECT_TRUE(manifest.update(
+            R"({"separator":":","collections":[{"name":"$default","uid":"0"},)"
+            R"(                                 {"name":"vegetable","uid":"1"},)"
+            R"(                                 {"name":"fruit","uid":"2"}]})"));
+
+    const StoredDocKey vegetable("vegetable:v1", DocNamespace::Collections);
+    const StoredDocKey fruit("fruit:f1", DocNamespace::Collections);
+    {
+        auto rh = manifest.active.lock(
+                {"vegetable:v1", DocNamespace::Collections});
+        EXPECT_TRUE(rh.valid());
+        manifest.active.updateMemUsed(vegetable, 10);
+        manifest.active.updateMemUsed(fruit, 5);
+        {
+            // Nested handles restore the previous one when destroyed
+            auto rh2 = manifest.active.lock(fruit);
+            manifest.active.updateMemUsed(fruit, 1);
+            manifest.active.updateMemUsed(vegetable, 1);
+            // The handle is only used for its own manifest
+            manifest.replica.updateMemUsed(fruit, 100);
+        }
+        manifest.active.updateMemUsed(vegetable, 1);
+        manifest.active.updateMemUsed(fruit, 1);
+    }
+    manifest.active.updateMemUsed(vegetable, -2);
+
+    EXPECT_EQ(10, manifest.active.getMemUsed("vegetable"));
+    EXPECT_EQ(7, manifest.active.getMemUsed("fruit"));
+    EXPECT_EQ(100, manifest.replica.getMemUsed("fruit"));
+}
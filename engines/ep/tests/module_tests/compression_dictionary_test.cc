@@ -0,0 +1,178 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Unit tests for the CompressionDictionary class.
+ */
+
+#include "config.h"
+
+#include "compression_dictionary.h"
+#include "hash_table.h"
+#include "stats.h"
+#include "stored_value_factories.h"
+#include "tests/module_tests/test_helpers.h"
+
+#include <gtest/gtest.h>
+
+static std::string makeDocument(int ii) {
+    return "{\"name\": \"user" + std::to_string(ii) +
+           "\", \"email\": \"user" + std::to_string(ii) +
+           "@example.com\", \"country\": \"" +
+           (ii % 2 ? "United Kingdom" : "United States") +
+           "\", \"active\": " + (ii % 3 ? "true" : "false") +
+           ", \"visits\": " + std::to_string(ii * 7) + "}";
+}
+
+static std::vector<std::string> makeSamples(int count) {
+    std::vector<std::string> samples;
+    for (int ii = 0; ii < count; ++ii) {
+        samples.push_back(makeDocument(ii));
+    }
+    return samples;
+}
+
+#ifdef EP_USE_ZSTD
+
+class CompressionDictionaryTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        dictionary = CompressionDictionary::train(makeSamples(2000), 4096);
+        ASSERT_TRUE(dictionary);
+    }
+
+protected:
+    std::unique_ptr<CompressionDictionary> dictionary;
+};
+
+TEST_F(CompressionDictionaryTest, RoundTrip) {
+    EXPECT_LE(dictionary->getSize(), 4096);
+
+    const auto document = makeDocument(12345);
+    std::vector<char> deflated;
+    ASSERT_TRUE(
+            dictionary->compress({document.data(), document.size()}, deflated));
+    EXPECT_LT(deflated.size(), document.size());
+
+    std::vector<char> inflated;
+    ASSERT_TRUE(CompressionDictionary::decompress(
+            {deflated.data(), deflated.size()}, inflated));
+    EXPECT_EQ(document, std::string(inflated.data(), inflated.size()));
+}
+
+// Values compressed with a dictionary which has since been destroyed cannot
+// be decompressed.
+TEST_F(CompressionDictionaryTest, UnknownDictionary) {
+    const auto document = makeDocument(1);
+    std::vector<char> deflated;
+    ASSERT_TRUE(
+            dictionary->compress({document.data(), document.size()}, deflated));
+    dictionary.reset();
+
+    std::vector<char> inflated;
+    EXPECT_FALSE(CompressionDictionary::decompress(
+            {deflated.data(), deflated.size()}, inflated));
+}
+
+TEST_F(CompressionDictionaryTest, StoredValue) {
+    EPStats stats;
+    StoredValueFactory factory(stats);
+    const auto document = makeDocument(42);
+    auto item = make_item(0,
+                          makeStoredDocKey("key"),
+                          document,
+                          0,
+                          PROTOCOL_BINARY_DATATYPE_JSON);
+    auto sv = factory(item, {});
+    sv->setFreqCounterValue(100);
+
+    ASSERT_TRUE(sv->compressValue(*dictionary));
+    EXPECT_TRUE(sv->isDictionaryCompressed());
+    EXPECT_LT(sv->valuelen(), document.size());
+    EXPECT_EQ(PROTOCOL_BINARY_DATATYPE_JSON, sv->getDatatype());
+    EXPECT_EQ(100, sv->getFreqCounterValue());
+
+    // Compressing again is a no-op.
+    EXPECT_FALSE(sv->compressValue(*dictionary));
+
+    // The frequency counter and compressed marker are independent.
+    sv->setFreqCounterValue(5);
+    EXPECT_TRUE(sv->isDictionaryCompressed());
+    EXPECT_EQ(5, sv->getFreqCounterValue());
+
+    // Reallocation (defragmentation) preserves the marker.
+    sv->reallocate();
+    EXPECT_TRUE(sv->isDictionaryCompressed());
+
+    auto decoded = sv->toItem(false, 0);
+    EXPECT_EQ(document,
+              std::string(decoded->getData(), decoded->getNBytes()));
+    EXPECT_EQ(PROTOCOL_BINARY_DATATYPE_JSON, decoded->getDataType());
+}
+
+// Xattr values are never dictionary compressed.
+TEST_F(CompressionDictionaryTest, StoredValueXattr) {
+    EPStats stats;
+    StoredValueFactory factory(stats);
+    auto item = make_item(0,
+                          makeStoredDocKey("key"),
+                          makeDocument(42),
+                          0,
+                          PROTOCOL_BINARY_DATATYPE_XATTR);
+    auto sv = factory(item, {});
+    EXPECT_FALSE(sv->compressValue(*dictionary));
+    EXPECT_FALSE(sv->isDictionaryCompressed());
+}
+
+// A HashTable keeps the dictionary its values were compressed with alive
+// (and its id reserved) after the bucket has released it, so a dictionary
+// trained later (e.g. by another bucket) is never used to decode them.
+TEST_F(CompressionDictionaryTest, HashTableHoldsDictionary) {
+    EPStats stats;
+    HashTable ht(stats,
+                 std::make_unique<StoredValueFactory>(stats),
+                 5,
+                 1,
+                 HashTable::EvictionPolicy::lru2Bit);
+    const auto document = makeDocument(7);
+    const auto key = makeStoredDocKey("key");
+    auto item = make_item(0, key, document, 0, PROTOCOL_BINARY_DATATYPE_JSON);
+    ASSERT_EQ(MutationStatus::WasClean, ht.set(item));
+
+    auto* sv = ht.find(key, TrackReference::No, WantsDeleted::No);
+    ASSERT_TRUE(sv);
+    std::shared_ptr<const CompressionDictionary> shared(std::move(dictionary));
+    ht.compressValue(*sv, shared);
+    ASSERT_TRUE(sv->isDictionaryCompressed());
+
+    // Release the "bucket's" reference and train another dictionary.
+    shared.reset();
+    auto other = CompressionDictionary::train(makeSamples(1000), 4096);
+    ASSERT_TRUE(other);
+
+    auto decoded = sv->toItem(false, 0);
+    EXPECT_EQ(document,
+              std::string(decoded->getData(), decoded->getNBytes()));
+}
+
+#else
+
+TEST(CompressionDictionaryTest, NotAvailable) {
+    EXPECT_FALSE(CompressionDictionary::train(makeSamples(2000), 4096));
+}
+
+#endif // EP_USE_ZSTD
@@ -415,6 +415,35 @@ TEST_P(DefragmenterTest, testCompressionInActiveMode) {
     EXPECT_EQ(itemCount, vbucket->ht.getNumItems());
 }
 
+// Test which objects the utilization policy considers worth moving
+TEST(DefragmentVisitorTest, isOnSparseSlab) {
+    // A quarter used slab in a size class which is half used overall
+    allocator_utilization util = {};
+    util.slab_free = 48;
+    util.slab_regions = 64;
+    util.bin_free = 256;
+    util.bin_regions = 512;
+    EXPECT_TRUE(DefragmentVisitor::isOnSparseSlab(util));
+
+    // Unless it is the slab new objects are allocated from
+    util.current_slab = true;
+    EXPECT_FALSE(DefragmentVisitor::isOnSparseSlab(util));
+    util.current_slab = false;
+
+    // A slab used more than the average of the size class
+    util.slab_free = 8;
+    EXPECT_FALSE(DefragmentVisitor::isOnSparseSlab(util));
+
+    // A full slab
+    util.slab_free = 0;
+    EXPECT_FALSE(DefragmentVisitor::isOnSparseSlab(util));
+
+    // Large allocations don't live in a slab
+    allocator_utilization large = {};
+    large.slab_regions = 1;
+    EXPECT_FALSE(DefragmentVisitor::isOnSparseSlab(large));
+}
+
 INSTANTIATE_TEST_CASE_P(
         FullAndValueEviction,
         DefragmenterTest,
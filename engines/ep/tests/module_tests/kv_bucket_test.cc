@@ -1195,6 +1195,32 @@ TEST_F(StoreIfTest, store_if_basic) {
     EXPECT_EQ(cb::engine_errc::predicate_failed, rv.status);
 }
 
+class BucketArenaTest : public KVBucketTest {
+public:
+    void SetUp() override {
+        config_string += "bucket_arena_enabled=true";
+        KVBucketTest::SetUp();
+        // Have all the objects, activate vBucket zero so we can store data.
+        store->setVBucketState(vbid, vbucket_state_active, false);
+    }
+};
+
+// Test that the values of a bucket with an arena are allocated from it
+TEST_F(BucketArenaTest, ValuesAllocatedFromArena) {
+    const auto* arena = engine->getArena();
+    if (arena == nullptr) {
+        // The memory allocator in use doesn't support arenas
+        return;
+    }
+
+    allocator_stats before = {};
+    ASSERT_TRUE(arena->getStats(before));
+    store_item(vbid, makeStoredDocKey("key"), std::string(4096, 'x'));
+    allocator_stats after = {};
+    ASSERT_TRUE(arena->getStats(after));
+    EXPECT_LE(before.allocated_size + 4096, after.allocated_size);
+}
+
 class ExpiryLimitTest : public KVBucketTest {
 public:
     void SetUp() override {
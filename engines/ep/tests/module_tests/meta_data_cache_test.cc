@@ -0,0 +1,319 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Unit tests for the MetaDataCache class.
+ */
+
+#include "config.h"
+
+#include "evp_store_test.h"
+#include "meta_data_cache.h"
+#include "stats.h"
+#include "stored_value_factories.h"
+#include "tests/mock/mock_synchronous_ep_engine.h"
+#include "tests/module_tests/test_helpers.h"
+#include "vbucket.h"
+
+#include <gtest/gtest.h>
+
+class MetaDataCacheTest : public ::testing::Test {
+public:
+    MetaDataCacheTest() : factory(stats), cache(100) {
+    }
+
+    StoredValue::UniquePtr makeStoredValue(const std::string& key) {
+        auto item = make_item(0, makeStoredDocKey(key), "value");
+        item.setCas(1234);
+        item.setBySeqno(10);
+        item.setRevSeqno(5);
+        return factory(item, {});
+    }
+
+protected:
+    EPStats stats;
+    StoredValueFactory factory;
+    MetaDataCache cache;
+};
+
+// Capacity is rounded up to a power of two.
+TEST_F(MetaDataCacheTest, Capacity) {
+    EXPECT_EQ(128, cache.getCapacity());
+    EXPECT_EQ(0, cache.getNumItems());
+}
+
+TEST_F(MetaDataCacheTest, InsertAndFind) {
+    auto sv = makeStoredValue("key");
+    EXPECT_FALSE(cache.find(sv->getKey()));
+
+    cache.insert(*sv);
+    EXPECT_EQ(1, cache.getNumItems());
+
+    auto entry = cache.find(sv->getKey());
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(sv->getCas(), entry->cas);
+    EXPECT_EQ(sv->getBySeqno(), entry->bySeqno);
+    EXPECT_EQ(sv->getRevSeqno(), entry->revSeqno);
+    EXPECT_EQ(sv->getFlags(), entry->flags);
+    EXPECT_EQ(sv->getExptime(), entry->exptime);
+    EXPECT_EQ(sv->getDatatype(), entry->datatype);
+
+    // Same key in a different namespace must not match.
+    EXPECT_FALSE(cache.find(makeStoredDocKey("key", DocNamespace::System)));
+}
+
+TEST_F(MetaDataCacheTest, Erase) {
+    auto sv = makeStoredValue("key");
+    cache.insert(*sv);
+    cache.erase(sv->getKey());
+    EXPECT_FALSE(cache.find(sv->getKey()));
+    EXPECT_EQ(0, cache.getNumItems());
+
+    // Erasing a missing key is a no-op.
+    cache.erase(sv->getKey());
+    EXPECT_EQ(0, cache.getNumItems());
+}
+
+// Deleted items are never cached; inserting one removes any previous entry.
+TEST_F(MetaDataCacheTest, DeletedNotCached) {
+    auto sv = makeStoredValue("key");
+    cache.insert(*sv);
+    sv->del();
+    cache.insert(*sv);
+    EXPECT_FALSE(cache.find(sv->getKey()));
+    EXPECT_EQ(0, cache.getNumItems());
+}
+
+TEST_F(MetaDataCacheTest, Clear) {
+    std::vector<StoredValue::UniquePtr> values;
+    for (int ii = 0; ii < 10; ++ii) {
+        values.push_back(makeStoredValue("key" + std::to_string(ii)));
+        cache.insert(*values.back());
+    }
+    EXPECT_LT(0, cache.getNumItems());
+
+    cache.clear();
+    EXPECT_EQ(0, cache.getNumItems());
+    for (const auto& sv : values) {
+        EXPECT_FALSE(cache.find(sv->getKey()));
+    }
+}
+
+/**
+ * Tests of the metadata-only operations of a full eviction bucket being
+ * served from its vbuckets' MetaDataCache (instead of a bgFetch) once an
+ * item has been evicted, and of the cache being invalidated.
+ */
+class MetaDataCacheBucketTest : public EPBucketTest {
+protected:
+    void SetUp() override {
+        config_string +=
+                "item_eviction_policy=full_eviction;"
+                "meta_data_cache_size=1024";
+        EPBucketTest::SetUp();
+        store->setVBucketState(vbid, vbucket_state_active, false);
+    }
+
+    /// Store the key, persist it and evict it from the HashTable
+    Item storeAndEvict(const StoredDocKey& key) {
+        auto item = store_item(vbid, key, "value");
+        flush_vbucket_to_disk(vbid);
+        evict_key(vbid, key);
+        return item;
+    }
+
+    size_t getCacheNumItems() {
+        return store->getVBucket(vbid)->getMetaDataCacheNumItems();
+    }
+
+    size_t getHits() {
+        return engine->getEpStats().metaDataCacheHits;
+    }
+
+    const StoredDocKey key = makeStoredDocKey("key");
+};
+
+TEST_F(MetaDataCacheBucketTest, GetMetaAfterEviction) {
+    auto item = storeAndEvict(key);
+    ASSERT_EQ(1, getCacheNumItems());
+
+    ItemMetaData itemMeta;
+    uint32_t deleted = 0;
+    uint8_t datatype = 0;
+    ASSERT_EQ(ENGINE_SUCCESS,
+              store->getMetaData(key, vbid, cookie, itemMeta, deleted,
+                                 datatype));
+    EXPECT_EQ(1, getHits());
+    EXPECT_EQ(item.getCas(), itemMeta.cas);
+    EXPECT_EQ(item.getRevSeqno(), itemMeta.revSeqno);
+    EXPECT_EQ(item.getFlags(), itemMeta.flags);
+    EXPECT_EQ(item.getExptime(), itemMeta.exptime);
+    EXPECT_EQ(0, deleted);
+    EXPECT_EQ(PROTOCOL_BINARY_DATATYPE_JSON, datatype);
+
+    // The restored metadata doesn't make the item resident
+    auto gv = store->get(key, vbid, cookie, QUEUE_BG_FETCH);
+    EXPECT_EQ(ENGINE_EWOULDBLOCK, gv.getStatus());
+}
+
+TEST_F(MetaDataCacheBucketTest, AddAfterEviction) {
+    storeAndEvict(key);
+
+    // The key exists, which is known without a bgFetch
+    auto item = make_item(vbid, key, "new value");
+    EXPECT_EQ(ENGINE_NOT_STORED, store->add(item, cookie));
+    EXPECT_EQ(1, getHits());
+}
+
+TEST_F(MetaDataCacheBucketTest, SetWithMetaAfterEviction) {
+    auto stored = storeAndEvict(key);
+
+    // Same revSeqno but a lower CAS loses the conflict resolution
+    auto item = make_item(vbid, key, "new value");
+    item.setCas(stored.getCas() - 1);
+    item.setRevSeqno(stored.getRevSeqno());
+    uint64_t seqno;
+    EXPECT_EQ(ENGINE_KEY_EEXISTS,
+              store->setWithMeta(item,
+                                 0,
+                                 &seqno,
+                                 cookie,
+                                 {vbucket_state_active},
+                                 CheckConflicts::Yes,
+                                 /*allowExisting*/ true));
+    EXPECT_EQ(1, getHits());
+
+    // A higher revSeqno wins (against the restored metadata)
+    item.setRevSeqno(stored.getRevSeqno() + 1);
+    EXPECT_EQ(ENGINE_SUCCESS,
+              store->setWithMeta(item,
+                                 0,
+                                 &seqno,
+                                 cookie,
+                                 {vbucket_state_active},
+                                 CheckConflicts::Yes,
+                                 /*allowExisting*/ true));
+    EXPECT_EQ(1, getHits());
+}
+
+TEST_F(MetaDataCacheBucketTest, DeleteWithMetaAfterEviction) {
+    auto stored = storeAndEvict(key);
+
+    uint64_t cas = 0;
+    uint64_t seqno = 0;
+    ItemMetaData itemMeta(stored.getCas() - 1,
+                          stored.getRevSeqno(),
+                          stored.getFlags(),
+                          stored.getExptime());
+    EXPECT_EQ(ENGINE_KEY_EEXISTS,
+              store->deleteWithMeta(key,
+                                    cas,
+                                    &seqno,
+                                    vbid,
+                                    cookie,
+                                    {vbucket_state_active},
+                                    CheckConflicts::Yes,
+                                    itemMeta,
+                                    /*backfill*/ false,
+                                    GenerateBySeqno::Yes,
+                                    GenerateCas::No,
+                                    0,
+                                    nullptr,
+                                    /*isReplication*/ false));
+    EXPECT_EQ(1, getHits());
+
+    itemMeta.revSeqno = stored.getRevSeqno() + 1;
+    EXPECT_EQ(ENGINE_SUCCESS,
+              store->deleteWithMeta(key,
+                                    cas,
+                                    &seqno,
+                                    vbid,
+                                    cookie,
+                                    {vbucket_state_active},
+                                    CheckConflicts::Yes,
+                                    itemMeta,
+                                    /*backfill*/ false,
+                                    GenerateBySeqno::Yes,
+                                    GenerateCas::No,
+                                    0,
+                                    nullptr,
+                                    /*isReplication*/ false));
+}
+
+// Once a deletion has been persisted (and the key removed from the
+// HashTable) its old metadata must not be served from the cache.
+TEST_F(MetaDataCacheBucketTest, InvalidatedByDelete) {
+    storeAndEvict(key);
+    ASSERT_EQ(1, getCacheNumItems());
+
+    store_item(vbid, key, "new value");
+    delete_item(vbid, key);
+    flush_vbucket_to_disk(vbid);
+    EXPECT_EQ(0, getCacheNumItems());
+
+    ItemMetaData itemMeta;
+    uint32_t deleted = 0;
+    uint8_t datatype = 0;
+    EXPECT_EQ(ENGINE_EWOULDBLOCK,
+              store->getMetaData(key, vbid, cookie, itemMeta, deleted,
+                                 datatype));
+    EXPECT_EQ(0, getHits());
+
+    runBGFetcherTask();
+    ASSERT_EQ(ENGINE_SUCCESS,
+              store->getMetaData(key, vbid, cookie, itemMeta, deleted,
+                                 datatype));
+    EXPECT_EQ(1, deleted);
+}
+
+// Metadata cached before a rollback may be from after the rollback point,
+// so the cache must be empty once the rollback has completed.
+TEST_F(MetaDataCacheBucketTest, InvalidatedByRollback) {
+    // Enough items that the rollback doesn't reset the whole vbucket
+    for (int ii = 0; ii < 5; ++ii) {
+        store_item(vbid, makeStoredDocKey("dummy" + std::to_string(ii)),
+                   "dummy");
+    }
+    flush_vbucket_to_disk(vbid, 5);
+
+    auto v1 = store_item(vbid, key, "v1");
+    flush_vbucket_to_disk(vbid);
+    auto v2 = storeAndEvict(key);
+    ASSERT_EQ(1, getCacheNumItems());
+
+    store->setVBucketState(vbid, vbucket_state_replica, false);
+    ASSERT_EQ(TaskStatus::Complete, store->rollback(vbid, v1.getBySeqno()));
+    EXPECT_EQ(0, getCacheNumItems());
+
+    // The metadata is now the one of v1 (from the HashTable or disk, but
+    // never v2's from the cache)
+    store->setVBucketState(vbid, vbucket_state_active, false);
+    ItemMetaData itemMeta;
+    uint32_t deleted = 0;
+    uint8_t datatype = 0;
+    auto ret = store->getMetaData(key, vbid, cookie, itemMeta, deleted,
+                                  datatype);
+    if (ret == ENGINE_EWOULDBLOCK) {
+        runBGFetcherTask();
+        ret = store->getMetaData(key, vbid, cookie, itemMeta, deleted,
+                                 datatype);
+    }
+    ASSERT_EQ(ENGINE_SUCCESS, ret);
+    EXPECT_EQ(0, getHits());
+    EXPECT_EQ(v1.getCas(), itemMeta.cas);
+    EXPECT_NE(v2.getCas(), itemMeta.cas);
+}
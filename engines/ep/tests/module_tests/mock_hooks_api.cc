@@ -54,6 +54,10 @@ extern "C" {
     static size_t mock_get_allocation_size(const void*) {
         return 0;
     }
+
+    static bool mock_create_arena(unsigned*) {
+        return false;
+    }
 }
 
 ALLOCATOR_HOOKS_API* getHooksApi(void) {
@@ -65,5 +69,6 @@ ALLOCATOR_HOOKS_API* getHooksApi(void) {
     hooksApi.get_extra_stats_size = mock_get_extra_stats_size;
     hooksApi.get_allocator_stats = mock_get_allocator_stats;
     hooksApi.get_allocation_size = mock_get_allocation_size;
+    hooksApi.create_arena = mock_create_arena;
     return &hooksApi;
 }
@@ -0,0 +1,134 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Unit tests for the ShardedRWLock class.
+ */
+
+#include "config.h"
+
+#include "sharded_rwlock.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ShardedRWLockTest : public ::testing::Test {
+protected:
+    /// Give a blocked thread the chance to (incorrectly) get the lock
+    static void pause() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    ShardedRWLock lock{16};
+};
+
+// A writer holds the write lock of every shard, so readers are excluded
+// whichever shard they use.
+TEST_F(ShardedRWLockTest, WriterExcludesReadersOnAllShards) {
+    ASSERT_EQ(16, lock.getNumShards());
+    std::unique_lock<ShardedRWLock::Writer> writer(lock.writer());
+
+    // Enough threads to cover all of the shards
+    const size_t numReaders = lock.getNumShards() * 2;
+    std::atomic<size_t> entered{0};
+    std::vector<std::thread> readers;
+    for (size_t ii = 0; ii < numReaders; ++ii) {
+        readers.emplace_back([this, &entered]() {
+            std::lock_guard<cb::ReaderLock> rlh(lock.reader());
+            ++entered;
+        });
+    }
+
+    pause();
+    EXPECT_EQ(0, entered);
+
+    writer.unlock();
+    for (auto& t : readers) {
+        t.join();
+    }
+    EXPECT_EQ(numReaders, entered);
+}
+
+// A reader on any one shard excludes the writer.
+TEST_F(ShardedRWLockTest, ReaderExcludesWriter) {
+    std::unique_lock<cb::ReaderLock> reader(lock.reader());
+
+    std::atomic<bool> written{false};
+    std::thread writer([this, &written]() {
+        std::lock_guard<ShardedRWLock::Writer> wlh(lock.writer());
+        written = true;
+    });
+
+    pause();
+    EXPECT_FALSE(written);
+
+    reader.unlock();
+    writer.join();
+    EXPECT_TRUE(written);
+}
+
+// A thread always uses the same shard, so it may take the read lock
+// recursively (as with a single cb::RWLock).
+TEST_F(ShardedRWLockTest, RecursiveRead) {
+    auto& first = lock.reader();
+    EXPECT_EQ(&first, &lock.reader());
+    {
+        std::lock_guard<cb::ReaderLock> outer(lock.reader());
+        std::lock_guard<cb::ReaderLock> inner(lock.reader());
+    }
+
+    // Both of the read locks have been released
+    std::thread writer([this]() {
+        std::lock_guard<ShardedRWLock::Writer> wlh(lock.writer());
+    });
+    writer.join();
+}
+
+// A read lock (such as the one in a Collections ReadHandle) may be moved
+// to another thread, which uses a different shard, and unlocked there. It
+// must release the shard it was taken on.
+TEST_F(ShardedRWLockTest, ReadLockMovedAcrossThreads) {
+    std::unique_lock<cb::ReaderLock> handle;
+    cb::ReaderLock* lockedShard = nullptr;
+    std::thread locker([this, &handle, &lockedShard]() {
+        lockedShard = &lock.reader();
+        handle = std::unique_lock<cb::ReaderLock>(lock.reader());
+    });
+    locker.join();
+    ASSERT_TRUE(handle.owns_lock());
+
+    cb::ReaderLock* unlockerShard = nullptr;
+    std::thread unlocker([this, &handle, &unlockerShard]() {
+        unlockerShard = &lock.reader();
+        auto moved = std::move(handle);
+        moved.unlock();
+    });
+    unlocker.join();
+    EXPECT_NE(lockedShard, unlockerShard);
+    EXPECT_FALSE(handle.owns_lock());
+
+    // The writer can now get every shard
+    std::thread writer([this]() {
+        std::lock_guard<ShardedRWLock::Writer> wlh(lock.writer());
+    });
+    writer.join();
+}
@@ -145,6 +145,37 @@ TEST_F(StatTest, vbucket_takeover_stats_stream_not_active) {
 }
 
 
+// Test that the stats of all vbuckets are built by a NONIO task and not
+// on the calling (front-end) thread.
+TEST_F(StatTest, HashStatsBuiltInBackground) {
+    // The engine-specific handshake needs a real (mock) cookie, so collect
+    // the stats via a static map rather than via the cookie.
+    static std::map<std::string, std::string> vals;
+    vals.clear();
+    auto add_stats = [](const char* key,
+                        const uint16_t klen,
+                        const char* val,
+                        const uint32_t vlen,
+                        gsl::not_null<const void*>) {
+        vals[std::string(key, klen)] = std::string(val, vlen);
+    };
+
+    ENGINE_HANDLE* handle = reinterpret_cast<ENGINE_HANDLE*>(engine.get());
+    ASSERT_EQ(ENGINE_EWOULDBLOCK,
+              engine->get_stats(handle, cookie, {"hash", 4}, add_stats));
+    EXPECT_TRUE(vals.empty());
+
+    auto& lpNonioQ = *task_executor->getLpTaskQ()[NONIO_TASK_IDX];
+    runNextTask(lpNonioQ, "hash stats for all vbuckets");
+    EXPECT_EQ(1, vals.count("vb_" + std::to_string(vbid) + ":state"));
+
+    // Second call after the notification completes the request
+    EXPECT_EQ(ENGINE_SUCCESS,
+              engine->get_stats(handle, cookie, {"hash", 4}, add_stats));
+    EXPECT_EQ(nullptr, engine->getEngineSpecific(cookie));
+}
+
+
 TEST_P(DatatypeStatTest, datatypesInitiallyZero) {
     // Check that the datatype stats initialise to 0
     auto vals = get_stat(nullptr);
@@ -409,4 +440,34 @@ TEST_F(EpStatsTest, memoryAllocated) {
     }
 
     EXPECT_EQ(0, stats.getPreciseTotalMemoryUsed());
+}
+
+TEST_F(EpStatsTest, memUsedMergeThresholdIsCapped) {
+    TestEpStat stats;
+    stats.setMemUsedMergeThresholdPercent(0.5);
+    stats.setMaxDataSize(size_t(1) << 40);
+    EXPECT_EQ(EPStats::MaxMemUsedMergeThreshold,
+              stats.getMemUsedMergeThreshold());
+}
+
+TEST_F(EpStatsTest, totalMemoryUsedNear) {
+    TestEpStat stats;
+    stats.memoryTrackerEnabled = true;
+    stats.setMemUsedMergeThreshold(1000);
+
+    // Not enough to be merged into the estimate
+    stats.memAllocated(500);
+    EXPECT_EQ(0, stats.getEstimatedTotalMemoryUsed());
+
+    // Far away from the threshold the estimate is good enough
+    EXPECT_EQ(0,
+              stats.getTotalMemoryUsedNear(
+                      stats.getMaxEstimatedMemoryError() + 1));
+
+    // Close to the threshold the core local counters are included, but
+    // they're not merged into the estimate
+    EXPECT_EQ(500, stats.getTotalMemoryUsedNear(600));
+    EXPECT_EQ(0, stats.getEstimatedTotalMemoryUsed());
+
+    EXPECT_EQ(500, stats.getPreciseTotalMemoryUsed());
 }
\ No newline at end of file
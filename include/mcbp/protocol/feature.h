@@ -59,6 +59,11 @@ enum class Feature : uint16_t {
      * Tell the server to enable tracing of function calls
      */
     Tracing = 0x0f,
+    /**
+     * Tell the server to pack multiple stats into each of the STAT response
+     * packets (see the description of the Stat command)
+     */
+    CompactStats = 0x10,
 };
 
 } // namespace mcbp
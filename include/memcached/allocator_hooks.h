@@ -49,6 +49,22 @@ typedef struct allocator_stats {
 
 } allocator_stats;
 
+typedef struct allocator_utilization {
+    /* Number of free / total regions in the slab (run of pages dedicated
+       to a single size class) containing the allocation */
+    size_t slab_free;
+    size_t slab_regions;
+
+    /* Number of free / total regions in all of the slabs of the same size
+       class */
+    size_t bin_free;
+    size_t bin_regions;
+
+    /* True if the slab is the one the allocator currently allocates new
+       objects of the size class from */
+    bool current_slab;
+} allocator_utilization;
+
 /**
  * Engine allocator hooks for memory tracking.
  */
@@ -132,6 +148,65 @@ typedef struct engine_allocator_hooks_v1 {
      */
     bool (*get_allocator_property)(const char* name, size_t* value);
 
+    /**
+     * Creates a new arena which memory may be explicitly allocated from
+     * (by arena_malloc), so that the memory used by different users (for
+     * instance buckets) isn't mixed in the same pages.
+     * @param arena destination for the index of the new arena
+     * @return whether the arena was created (false if the allocator in
+     *         use doesn't support arenas)
+     */
+    bool (*create_arena)(unsigned* arena);
+
+    /**
+     * Destroys an arena created by create_arena, releasing all of its
+     * memory back to the OS in one go. The arena must not contain any
+     * allocations which are still in use.
+     * @return whether the arena was destroyed. If the allocator can't
+     *         destroy arenas the unused memory of the arena is released
+     *         and false is returned (the arena may still be used).
+     */
+    bool (*destroy_arena)(unsigned arena);
+
+    /**
+     * Allocates size bytes from the given arena. The new / delete hooks
+     * are NOT called for memory allocated (or freed) through the arena
+     * functions, so the caller has to account for it.
+     * @return the memory or nullptr if the allocation failed
+     */
+    void* (*arena_malloc)(unsigned arena, size_t size);
+
+    /**
+     * Frees memory allocated by the allocator, either from an arena
+     * (arena_malloc) or from the normal heap (without calling the delete
+     * hooks).
+     */
+    void (*arena_free)(void* ptr);
+
+    /**
+     * Obtains the statistics of a single arena (allocated, heap, resident,
+     * retained and fragmentation size; the other fields are left alone).
+     * @return whether the stats could be read
+     */
+    bool (*get_arena_stats)(unsigned arena, allocator_stats* stats);
+
+    /**
+     * Obtains how well used the slab containing the given allocation is,
+     * which tells if it is worth moving the object elsewhere to reduce
+     * fragmentation.
+     * @return whether the utilization could be obtained (false if the
+     *         allocator in use can't tell)
+     */
+    bool (*get_allocation_utilization)(const void* ptr,
+                                       allocator_utilization* util);
+
+    /**
+     * Returns whether the allocator in use can report the utilization of
+     * the slab containing an allocation (get_allocation_utilization
+     * always fails if it can't).
+     */
+    bool (*is_allocation_utilization_supported)(void);
+
 } ALLOCATOR_HOOKS_API;
 
 #ifdef __cplusplus
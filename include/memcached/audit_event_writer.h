@@ -0,0 +1,143 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#pragma once
+
+#include <platform/sized_buffer.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace cb {
+namespace audit {
+
+/**
+ * The EventWriter serialises the JSON payload of an audit event directly
+ * into the provided buffer, without building a cJSON tree for it. The
+ * buffer is meant to be reused (for instance a thread local string), so
+ * that creating an event doesn't allocate memory once the buffer has
+ * grown to fit the events.
+ *
+ * The keys are written as is (they are expected to be string literals
+ * which don't need escaping), and the string values are escaped.
+ *
+ *     EventWriter writer(buffer);
+ *     writer.add("bucket", name).add("key", key);
+ *     auto payload = writer.finish();
+ */
+class EventWriter {
+public:
+    explicit EventWriter(std::string& buffer) : buffer(buffer) {
+        buffer.assign("{");
+    }
+
+    EventWriter& add(const char* key, cb::const_char_buffer value) {
+        addKey(key);
+        appendString(buffer, value);
+        return *this;
+    }
+
+    EventWriter& add(const char* key, const char* value) {
+        return add(key, cb::const_char_buffer{value, std::strlen(value)});
+    }
+
+    EventWriter& add(const char* key, const std::string& value) {
+        return add(key, cb::const_char_buffer{value.data(), value.size()});
+    }
+
+    EventWriter& add(const char* key, bool value) {
+        addKey(key);
+        buffer.append(value ? "true" : "false");
+        return *this;
+    }
+
+    EventWriter& addNumber(const char* key, uint64_t value) {
+        addKey(key);
+        buffer.append(std::to_string(value));
+        return *this;
+    }
+
+    /// Start a nested object, which is terminated by endObject()
+    EventWriter& beginObject(const char* key) {
+        addKey(key);
+        buffer.push_back('{');
+        return *this;
+    }
+
+    EventWriter& endObject() {
+        buffer.push_back('}');
+        return *this;
+    }
+
+    /// Terminate the event and return the payload
+    cb::const_char_buffer finish() {
+        buffer.push_back('}');
+        return {buffer.data(), buffer.size()};
+    }
+
+    /// Append the value to the buffer as a quoted (and escaped) JSON string
+    static void appendString(std::string& buffer,
+                             cb::const_char_buffer value) {
+        static const char hex[] = "0123456789abcdef";
+        buffer.push_back('"');
+        for (size_t ii = 0; ii < value.size(); ++ii) {
+            const char c = value[ii];
+            switch (c) {
+            case '"':
+                buffer.append("\\\"");
+                break;
+            case '\\':
+                buffer.append("\\\\");
+                break;
+            case '\n':
+                buffer.append("\\n");
+                break;
+            case '\r':
+                buffer.append("\\r");
+                break;
+            case '\t':
+                buffer.append("\\t");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    buffer.append("\\u00");
+                    buffer.push_back(hex[(c >> 4) & 0xf]);
+                    buffer.push_back(hex[c & 0xf]);
+                } else {
+                    buffer.push_back(c);
+                }
+            }
+        }
+        buffer.push_back('"');
+    }
+
+protected:
+    void addKey(const char* key) {
+        const char last = buffer.back();
+        if (last != '{') {
+            buffer.push_back(',');
+        }
+        buffer.push_back('"');
+        buffer.append(key);
+        buffer.append("\":");
+    }
+
+    std::string& buffer;
+};
+
+} // namespace audit
+} // namespace cb
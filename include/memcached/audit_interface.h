@@ -19,6 +19,7 @@
 #include <memcached/engine.h>
 #include <memcached/visibility.h>
 #include <platform/platform.h>
+#include <platform/sized_buffer.h>
 
 /**
  * Response codes for audit operations.
@@ -166,5 +167,25 @@ void add_event_state_listener(Audit* handle, EventStateListener listener);
 MEMCACHED_PUBLIC_API
 void notify_all_event_states(Audit* handle);
 
+/**
+ * Check if the event with the given id will be filtered out for the
+ * given user (see "disabled_userids" in the audit configuration), so
+ * that the front-end threads may skip building the payload of the event.
+ *
+ * The check is O(1) and lock-free; it uses a snapshot of the filter which
+ * is republished every time the audit daemon is reconfigured.
+ *
+ * @param handle the audit daemon handle
+ * @param id the event identifier
+ * @param source the domain of the user (the "source" of the real_userid)
+ * @param user the name of the user
+ * @return true if the event would be filtered out by the audit daemon
+ */
+MEMCACHED_PUBLIC_API
+bool is_event_filtered(Audit* handle,
+                       uint32_t id,
+                       cb::const_char_buffer source,
+                       cb::const_char_buffer user);
+
 }
 }
@@ -304,7 +304,7 @@ public:
      * @throws cb::rbac::NoSuchUserException if the user doesn't exist
      */
     std::pair<PrivilegeContext, bool> createInitialContext(
-            const std::string& user, cb::sasl::Domain domain);
+            const std::string& user, cb::sasl::Domain domain) const;
 
     /**
      * The generation for this PrivilegeDatabase (a privilege context must
@@ -318,9 +318,8 @@ protected:
 
 /**
  * Create a new PrivilegeContext for the specified user in the specified
- * bucket.
- *
- * @todo this might starve the writers?
+ * bucket. This doesn't block (or get blocked by) other threads creating
+ * contexts or loading a new privilege database.
  *
  * @param user The name of the user
  * @param bucket The name of the bucket (may be "" if you're not
@@ -349,7 +348,9 @@ std::pair<PrivilegeContext, bool> createInitialContext(const std::string& user,
                                                        cb::sasl::Domain domain);
 
 /**
- * Load the named file and install it as the current privilege database
+ * Load the named file and install it as the current privilege database.
+ * All privilege contexts created from the previous database becomes
+ * stale once the new database is installed.
  *
  * @param filename the name of the new file
  * @throws std::runtime_error
@@ -21,6 +21,7 @@
 #include <memcached/protocol_binary.h>
 #include <memcached/rbac.h>
 #include <memcached/types.h>
+#include <platform/processclock.h>
 
 #include <gsl/gsl>
 
@@ -342,6 +343,14 @@ struct SERVER_TRACING_API {
      */
     void (*end_trace)(gsl::not_null<const void*> cookie,
                       cb::tracing::TraceCode tracecode);
+
+    /**
+     * add a trace which started and completed at the given times
+     */
+    void (*add_trace)(gsl::not_null<const void*> cookie,
+                      cb::tracing::TraceCode tracecode,
+                      ProcessClock::time_point start,
+                      ProcessClock::time_point end);
 };
 
 #ifdef WIN32
@@ -0,0 +1,468 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+
+#include "binary_log.h"
+
+#include <platform/make_unique.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace cb {
+namespace logger {
+namespace binary {
+
+/**
+ * A single producer, single consumer ring buffer of records. Each thread
+ * which logs gets its own ring, so the front-end threads never contend
+ * with each other (or block on the drain thread).
+ */
+class ThreadRing {
+public:
+    /// The size of the ring (must be a power of two)
+    static const size_t Capacity = 64 * 1024;
+
+    /// Copy the record into the ring. Must only be called by the owner
+    bool write(const std::string& record) {
+        const auto h = head.load(std::memory_order_relaxed);
+        const auto t = tail.load(std::memory_order_acquire);
+        if (Capacity - (h - t) < record.size()) {
+            return false;
+        }
+        copyIn(h, record.data(), record.size());
+        head.store(h + record.size(), std::memory_order_release);
+        return true;
+    }
+
+    /// Read the oldest record in the ring. Must only be called by the
+    /// drain thread
+    bool read(std::string& record) {
+        const auto t = tail.load(std::memory_order_relaxed);
+        const auto h = head.load(std::memory_order_acquire);
+        if (h == t) {
+            return false;
+        }
+        uint32_t size;
+        copyOut(t, reinterpret_cast<char*>(&size), sizeof(size));
+        record.resize(size);
+        copyOut(t, &record[0], size);
+        tail.store(t + size, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load() == tail.load();
+    }
+
+    /// Set when the owning thread has terminated
+    std::atomic_bool detached{false};
+
+private:
+    void copyIn(size_t pos, const char* data, size_t size) {
+        const auto offset = pos & (Capacity - 1);
+        const auto first = std::min(size, Capacity - offset);
+        std::memcpy(buffer.get() + offset, data, first);
+        std::memcpy(buffer.get(), data + first, size - first);
+    }
+
+    void copyOut(size_t pos, char* data, size_t size) const {
+        const auto offset = pos & (Capacity - 1);
+        const auto first = std::min(size, Capacity - offset);
+        std::memcpy(data, buffer.get() + offset, first);
+        std::memcpy(data + first, buffer.get(), size - first);
+    }
+
+    std::unique_ptr<char[]> buffer{new char[Capacity]};
+    /// Total number of bytes written (only written by the owner)
+    std::atomic<size_t> head{0};
+    /// Total number of bytes read (only written by the drain thread)
+    std::atomic<size_t> tail{0};
+};
+
+static std::atomic_bool enabled{false};
+
+/// All of the rings which may contain records
+static std::mutex ringsMutex;
+static std::vector<std::shared_ptr<ThreadRing>> rings;
+
+/// Marks the thread's ring as detached when the thread terminates, so that
+/// the drain thread may release it once it is empty
+struct RingHolder {
+    ~RingHolder() {
+        if (ring) {
+            ring->detached = true;
+        }
+    }
+    std::shared_ptr<ThreadRing> ring;
+};
+
+static thread_local RingHolder threadRing;
+static thread_local std::string recordBuffer;
+
+/// The time between each time the drain thread looks at the rings
+static const std::chrono::milliseconds drainInterval{10};
+
+/// The state of the drain thread
+static struct Drainer {
+    ~Drainer() {
+        // Don't leave a joinable thread behind if the logger wasn't shut
+        // down before exit
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            running = false;
+        }
+        cond.notify_all();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    /// Serialises draining the rings (they only allow a single reader)
+    std::mutex drainMutex;
+    std::shared_ptr<spdlog::sinks::sink> sink;
+    spdlog::formatter_ptr formatter;
+    /// Records read from the rings which are to be sorted by time
+    std::vector<std::string> batch;
+    std::vector<std::pair<int64_t, size_t>> order;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool running = false;
+    std::thread thread;
+} drainer;
+
+bool isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+std::string& getRecordBuffer() {
+    return recordBuffer;
+}
+
+bool submit(const std::string& record) {
+    if (!threadRing.ring) {
+        threadRing.ring = std::make_shared<ThreadRing>();
+        std::lock_guard<std::mutex> guard(ringsMutex);
+        rings.push_back(threadRing.ring);
+    }
+    return threadRing.ring->write(record);
+}
+
+namespace {
+struct Arg {
+    ArgType type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        bool b;
+        char c;
+    };
+    fmt::StringRef str{""};
+};
+
+template <typename T>
+T decode(const char*& pos, const char* end) {
+    T ret;
+    if (size_t(end - pos) < sizeof(ret)) {
+        throw std::invalid_argument(
+                "cb::logger::binary::format: truncated record");
+    }
+    std::memcpy(&ret, pos, sizeof(ret));
+    pos += sizeof(ret);
+    return ret;
+}
+} // namespace
+
+static std::vector<Arg> decodeArgs(const RecordHeader& header,
+                                   const char* record) {
+    std::vector<Arg> args(header.nargs);
+    const char* pos = record + sizeof(header) + header.formatSize + 1;
+    const char* end = record + header.size;
+    for (auto& arg : args) {
+        arg.type = ArgType(decode<uint8_t>(pos, end));
+        switch (arg.type) {
+        case ArgType::Int:
+            arg.i = decode<int64_t>(pos, end);
+            break;
+        case ArgType::UInt:
+        case ArgType::Pointer:
+            arg.u = decode<uint64_t>(pos, end);
+            break;
+        case ArgType::Double:
+            arg.d = decode<double>(pos, end);
+            break;
+        case ArgType::Bool:
+            arg.b = decode<uint8_t>(pos, end) != 0;
+            break;
+        case ArgType::Char:
+            arg.c = decode<char>(pos, end);
+            break;
+        case ArgType::String: {
+            const auto size = decode<uint32_t>(pos, end);
+            if (size_t(end - pos) < size) {
+                throw std::invalid_argument(
+                        "cb::logger::binary::format: truncated string");
+            }
+            arg.str = fmt::StringRef(pos, size);
+            pos += size;
+            break;
+        }
+        default:
+            throw std::invalid_argument(
+                    "cb::logger::binary::format: unknown argument type " +
+                    std::to_string(int(arg.type)));
+        }
+    }
+    return args;
+}
+
+static bool isDigit(char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+static void writeArg(fmt::MemoryWriter& out,
+                     const std::string& spec,
+                     const Arg& arg) {
+    switch (arg.type) {
+    case ArgType::Int:
+        out.write(spec, arg.i);
+        return;
+    case ArgType::UInt:
+        out.write(spec, arg.u);
+        return;
+    case ArgType::Double:
+        out.write(spec, arg.d);
+        return;
+    case ArgType::Bool:
+        out.write(spec, arg.b);
+        return;
+    case ArgType::Char:
+        out.write(spec, arg.c);
+        return;
+    case ArgType::String:
+        out.write(spec, arg.str);
+        return;
+    case ArgType::Pointer:
+        out.write(spec, reinterpret_cast<const void*>(uintptr_t(arg.u)));
+        return;
+    }
+}
+
+/**
+ * Format the record the same way as fmt would have formatted the format
+ * string with the original arguments. Each replacement field is formatted
+ * separately, so it may not contain nested replacement fields.
+ */
+static void formatRecord(const char* record, fmt::MemoryWriter& out) {
+    RecordHeader header;
+    std::memcpy(&header, record, sizeof(header));
+    if (header.size < sizeof(header) + header.formatSize + 1 ||
+        record[sizeof(header) + header.formatSize] != '\0') {
+        throw std::invalid_argument(
+                "cb::logger::binary::format: truncated format");
+    }
+    const char* format = record + sizeof(header);
+    if (header.nargs == 0) {
+        // spdlog logs messages without arguments as is
+        out << format;
+        return;
+    }
+
+    const auto args = decodeArgs(header, record);
+    size_t next = 0;
+    std::string spec;
+    const char* pos = format;
+    while (*pos != '\0') {
+        if (*pos == '{' && pos[1] == '{') {
+            out << '{';
+            pos += 2;
+        } else if (*pos == '{') {
+            const char* end = std::strchr(pos, '}');
+            if (end == nullptr) {
+                throw std::invalid_argument(
+                        "cb::logger::binary::format: unmatched '{' in: " +
+                        std::string(format));
+            }
+            ++pos;
+            size_t index = next++;
+            if (pos < end && isDigit(*pos)) {
+                index = 0;
+                while (pos < end && isDigit(*pos)) {
+                    index = index * 10 + (*pos - '0');
+                    ++pos;
+                }
+            }
+            if (index >= args.size()) {
+                throw std::invalid_argument(
+                        "cb::logger::binary::format: argument index out of "
+                        "range in: " +
+                        std::string(format));
+            }
+            spec.assign("{");
+            spec.append(pos, end);
+            spec.push_back('}');
+            writeArg(out, spec, args[index]);
+            pos = end + 1;
+        } else if (*pos == '}') {
+            out << '}';
+            pos += (pos[1] == '}') ? 2 : 1;
+        } else {
+            const char* end = pos;
+            while (*end != '\0' && *end != '{' && *end != '}') {
+                ++end;
+            }
+            out << fmt::StringRef(pos, end - pos);
+            pos = end;
+        }
+    }
+}
+
+void format(const char* record, std::string& out) {
+    fmt::MemoryWriter writer;
+    formatRecord(record, writer);
+    out.append(writer.data(), writer.size());
+}
+
+/// Format the record and send it to the sink. Must hold the drainMutex
+static void emit(const std::string& record) {
+    RecordHeader header;
+    std::memcpy(&header, record.data(), sizeof(header));
+
+    spdlog::details::log_msg msg;
+    msg.level = spdlog::level::level_enum(header.level);
+    msg.time = spdlog::log_clock::time_point(
+            spdlog::log_clock::duration(header.time));
+    try {
+        formatRecord(record.data(), msg.raw);
+    } catch (const std::exception& e) {
+        msg.raw.clear();
+        msg.raw << fmt::StringRef(record.data() + sizeof(header),
+                                  std::min(size_t(header.formatSize),
+                                           record.size() - sizeof(header)))
+                << " [formatting failed: " << e.what()
+                << "]";
+    }
+    drainer.formatter->format(msg);
+    if (drainer.sink->should_log(msg.level)) {
+        drainer.sink->log(msg);
+    }
+}
+
+void drain() {
+    std::lock_guard<std::mutex> guard(drainer.drainMutex);
+    if (!drainer.sink) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<ThreadRing>> current;
+    {
+        std::lock_guard<std::mutex> guard(ringsMutex);
+        // Release the rings of the threads which are gone (no more records
+        // will be added to them)
+        rings.erase(std::remove_if(rings.begin(),
+                                   rings.end(),
+                                   [](const std::shared_ptr<ThreadRing>& r) {
+                                       return r->detached && r->empty();
+                                   }),
+                    rings.end());
+        current = rings;
+    }
+
+    // Collect the records from all of the rings so that they are passed on
+    // to the sink in the order they were logged
+    auto& batch = drainer.batch;
+    auto& order = drainer.order;
+    size_t count = 0;
+    for (auto& ring : current) {
+        while (true) {
+            if (count == batch.size()) {
+                batch.emplace_back();
+            }
+            if (!ring->read(batch[count])) {
+                break;
+            }
+            RecordHeader header;
+            std::memcpy(&header, batch[count].data(), sizeof(header));
+            order.emplace_back(header.time, count);
+            ++count;
+        }
+    }
+
+    std::stable_sort(order.begin(), order.end());
+    for (const auto& entry : order) {
+        emit(batch[entry.second]);
+    }
+    order.clear();
+}
+
+static void run() {
+    std::unique_lock<std::mutex> lock(drainer.mutex);
+    while (drainer.running) {
+        lock.unlock();
+        drain();
+        lock.lock();
+        drainer.cond.wait_for(lock, drainInterval);
+    }
+}
+
+void start(std::shared_ptr<spdlog::sinks::sink> sink,
+           const std::string& log_pattern) {
+    stop();
+
+    {
+        std::lock_guard<std::mutex> guard(drainer.drainMutex);
+        drainer.sink = sink;
+        drainer.formatter = std::make_shared<spdlog::pattern_formatter>(
+                log_pattern, spdlog::pattern_time_type::local);
+    }
+    drainer.running = true;
+    drainer.thread = std::thread(run);
+    enabled = true;
+}
+
+void stop() {
+    enabled = false;
+    {
+        std::lock_guard<std::mutex> guard(drainer.mutex);
+        if (!drainer.running) {
+            return;
+        }
+        drainer.running = false;
+    }
+    drainer.cond.notify_all();
+    drainer.thread.join();
+
+    // Pick up whatever was logged after the last pass
+    drain();
+    std::lock_guard<std::mutex> guard(drainer.drainMutex);
+    drainer.sink.reset();
+    drainer.formatter.reset();
+}
+
+} // namespace binary
+} // namespace logger
+} // namespace cb
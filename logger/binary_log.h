@@ -0,0 +1,262 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Binary logging: instead of formatting the message on the calling thread,
+ * the log macros capture a copy of the format string and of the arguments
+ * into a per-thread ring buffer. A background thread drains the rings,
+ * formats the messages and passes them on to the sinks with the time they
+ * were logged.
+ *
+ * Only messages where all of the arguments are of a type we know how to
+ * capture (numbers, strings and pointers) are deferred; all other messages
+ * (and messages which don't fit in the ring) are formatted on the calling
+ * thread as before.
+ */
+
+#pragma once
+
+#include <logger/visibility.h>
+
+#include <spdlog/common.h>
+#include <spdlog/sinks/sink.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace cb {
+namespace logger {
+namespace binary {
+
+/// The type of each argument in a record (stored in front of its value)
+enum class ArgType : uint8_t { Int, UInt, Double, Bool, Char, String, Pointer };
+
+/**
+ * The layout of a record in the ring. It is followed by the format string
+ * (formatSize characters and a terminating '\0') and the arguments, where
+ * each argument is an ArgType followed by the value (strings are stored as
+ * a uint32_t length followed by the characters).
+ *
+ * The format is copied rather than referenced, as the log macros accept any
+ * char array as the format (a buffer on the stack of the caller may be
+ * gone by the time the record is formatted).
+ */
+struct RecordHeader {
+    /// The size of the record, including the header
+    uint32_t size;
+    uint8_t level;
+    uint8_t nargs;
+    uint16_t reserved;
+    /// The time of the log call (system_clock ticks since the epoch)
+    int64_t time;
+    /// The length of the format string following the header
+    uint32_t formatSize;
+};
+
+/// Can values of type T be captured in a record? (T should be decayed)
+template <typename T>
+struct IsCapturable
+    : std::integral_constant<
+              bool,
+              std::is_arithmetic<T>::value ||
+                      (std::is_pointer<T>::value &&
+                       !std::is_function<
+                               typename std::remove_pointer<T>::type>::value)> {
+};
+
+template <>
+struct IsCapturable<std::string> : std::true_type {};
+
+template <typename... Args>
+struct AllCapturable;
+
+template <>
+struct AllCapturable<> : std::true_type {};
+
+template <typename T, typename... Args>
+struct AllCapturable<T, Args...>
+    : std::integral_constant<
+              bool,
+              IsCapturable<typename std::decay<T>::type>::value &&
+                      AllCapturable<Args...>::value> {};
+
+template <typename T>
+void appendRaw(std::string& buffer, ArgType type, const T& value) {
+    buffer.push_back(char(type));
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void encode(std::string& buffer, bool value) {
+    buffer.push_back(char(ArgType::Bool));
+    buffer.push_back(value ? 1 : 0);
+}
+
+inline void encode(std::string& buffer, char value) {
+    buffer.push_back(char(ArgType::Char));
+    buffer.push_back(value);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                        std::is_signed<T>::value>::type
+encode(std::string& buffer, T value) {
+    appendRaw(buffer, ArgType::Int, int64_t(value));
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                        std::is_unsigned<T>::value>::type
+encode(std::string& buffer, T value) {
+    appendRaw(buffer, ArgType::UInt, uint64_t(value));
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type encode(
+        std::string& buffer, T value) {
+    appendRaw(buffer, ArgType::Double, double(value));
+}
+
+inline void encode(std::string& buffer, const char* value, size_t size) {
+    appendRaw(buffer, ArgType::String, uint32_t(size));
+    buffer.append(value, size);
+}
+
+inline void encode(std::string& buffer, const char* value) {
+    if (value == nullptr) {
+        value = "(null)";
+    }
+    encode(buffer, value, std::strlen(value));
+}
+
+inline void encode(std::string& buffer, const std::string& value) {
+    encode(buffer, value.data(), value.size());
+}
+
+template <typename T>
+typename std::enable_if<!std::is_same<typename std::remove_cv<T>::type,
+                                      char>::value>::type
+encode(std::string& buffer, const T* value) {
+    appendRaw(buffer, ArgType::Pointer, uint64_t(uintptr_t(value)));
+}
+
+/// Is binary logging enabled?
+LOGGER_PUBLIC_API
+bool isEnabled();
+
+/// Get the (thread local) buffer to encode the next record in
+LOGGER_PUBLIC_API
+std::string& getRecordBuffer();
+
+/**
+ * Copy the encoded record into the calling thread's ring
+ *
+ * @return false if the record doesn't fit in the ring (the caller should
+ *         format the message itself)
+ */
+LOGGER_PUBLIC_API
+bool submit(const std::string& record);
+
+template <typename... Args>
+bool capture(std::false_type,
+             spdlog::level::level_enum,
+             const char*,
+             const Args&...) {
+    return false;
+}
+
+template <typename... Args>
+bool capture(std::true_type,
+             spdlog::level::level_enum severity,
+             const char* format,
+             const Args&... args) {
+    if (!isEnabled()) {
+        return false;
+    }
+
+    auto& buffer = getRecordBuffer();
+    buffer.resize(sizeof(RecordHeader));
+    const auto formatSize = std::strlen(format);
+    buffer.append(format, formatSize + 1);
+    int expand[] = {0, (encode(buffer, args), 0)...};
+    (void)expand;
+
+    RecordHeader header;
+    header.size = uint32_t(buffer.size());
+    header.level = uint8_t(severity);
+    header.nargs = uint8_t(sizeof...(Args));
+    header.reserved = 0;
+    header.time = std::chrono::system_clock::now().time_since_epoch().count();
+    header.formatSize = uint32_t(formatSize);
+    std::memcpy(&buffer[0], &header, sizeof(header));
+    return submit(buffer);
+}
+
+/**
+ * Try to capture the log message in a record rather than formatting it.
+ *
+ * @param format the format string (copied into the record)
+ * @return true if the message was captured, false if the caller must
+ *         format it
+ */
+template <typename... Args>
+bool capture(spdlog::level::level_enum severity,
+             const char* format,
+             const Args&... args) {
+    return capture(std::integral_constant<bool,
+                                          AllCapturable<Args...>::value &&
+                                                  (sizeof...(Args) < 256)>{},
+                   severity,
+                   format,
+                   args...);
+}
+
+/**
+ * Format the message in the provided record
+ *
+ * @param record pointer to the record (the header followed by the args)
+ * @param out where to append the formatted message
+ * @throws std::invalid_argument if the record is malformed
+ */
+LOGGER_PUBLIC_API
+void format(const char* record, std::string& out);
+
+/**
+ * Start the thread which drains the rings and passes the formatted
+ * messages to the provided sink, and enable binary logging.
+ *
+ * @param sink where to send the messages
+ * @param log_pattern the pattern to format the messages with
+ */
+LOGGER_PUBLIC_API
+void start(std::shared_ptr<spdlog::sinks::sink> sink,
+           const std::string& log_pattern);
+
+/// Format and send all of the captured messages to the sink
+LOGGER_PUBLIC_API
+void drain();
+
+/// Disable binary logging, drain the rings and stop the thread
+LOGGER_PUBLIC_API
+void stop();
+
+} // namespace binary
+} // namespace logger
+} // namespace cb
@@ -78,6 +78,16 @@ Config::Config(const cJSON& json) {
                     R"(Config: "console" must be a bool)");
         }
     }
+
+    obj = cJSON_GetObjectItem(root, "binary");
+    if (obj != nullptr) {
+        if (obj->type == cJSON_True) {
+            binary = true;
+        } else if (obj->type != cJSON_False) {
+            throw std::invalid_argument(
+                    R"(Config: "binary" must be a bool)");
+        }
+    }
 }
 
 bool Config::operator==(const Config& other) const {
@@ -86,7 +96,8 @@ bool Config::operator==(const Config& other) const {
            (this->sleeptime == other.sleeptime) &&
            (this->cyclesize == other.cyclesize) &&
            (this->unit_test == other.unit_test) &&
-           (this->console == other.console);
+           (this->console == other.console) &&
+           (this->binary == other.binary);
 }
 
 bool Config::operator!=(const Config& other) const {
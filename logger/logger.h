@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <logger/binary_log.h>
 #include <logger/visibility.h>
 
 #include <boost/optional/optional.hpp>
@@ -50,6 +51,9 @@ struct LOGGER_PUBLIC_API Config {
     bool unit_test = false;
     /// Should messages be passed on to the console via stderr
     bool console = true;
+    /// Capture the arguments of the log messages in binary form and
+    /// format the messages on a background thread (see binary_log.h)
+    bool binary = false;
 };
 
 /**
@@ -118,15 +122,39 @@ void flush();
 LOGGER_PUBLIC_API
 void shutdown();
 
+/**
+ * Log a message where the format string is a char array (normally a string
+ * literal). The message is captured in binary form (and formatted later) if
+ * binary logging is enabled and all of the arguments may be captured. The
+ * format is copied into the record, so it may be a buffer on the stack.
+ */
+template <size_t N, typename... Args>
+void log(spdlog::logger& logger,
+         spdlog::level::level_enum severity,
+         const char (&fmt)[N],
+         const Args&... args) {
+    if (!binary::capture(severity, fmt, args...)) {
+        logger.log(severity, fmt, args...);
+    }
+}
+
+/// Log a message where the format isn't a char array
+template <typename... Args>
+void log(spdlog::logger& logger,
+         spdlog::level::level_enum severity,
+         const Args&... args) {
+    logger.log(severity, args...);
+}
+
 } // namespace logger
 } // namespace cb
 
-#define CB_LOG_ENTRY(severity, ...)               \
-    do {                                          \
-        auto _logger_ = cb::logger::get();        \
-        if (severity >= _logger_->level()) {      \
-            _logger_->log(severity, __VA_ARGS__); \
-        }                                         \
+#define CB_LOG_ENTRY(severity, ...)                            \
+    do {                                                       \
+        auto _logger_ = cb::logger::get();                     \
+        if (severity >= _logger_->level()) {                   \
+            cb::logger::log(*_logger_, severity, __VA_ARGS__); \
+        }                                                      \
     } while (false)
 
 #define LOG_TRACE(...) \
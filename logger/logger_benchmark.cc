@@ -20,6 +20,29 @@
 #include <logger/logger.h>
 #include <iostream>
 
+/**
+ * Initialize the async logger without a file backend
+ *
+ * @param binary if the messages should be captured in binary form
+ * @return true if the logger was initialized
+ */
+static bool initializeLogger(bool binary) {
+    cb::logger::Config config{};
+    config.cyclesize = 2048;
+    config.buffersize = 8192;
+    config.sleeptime = 1;
+    config.unit_test = true;
+    config.console = false;
+    config.binary = binary;
+
+    auto init = cb::logger::initialize(config);
+    if (init) {
+        std::cerr << "Failed to initialize logger: " << *init;
+        return false;
+    }
+    return true;
+}
+
 /**
  * Benchmark the cost of grabbing the logger (which means checking
  * for it's existence and copy a shared pointer).
@@ -49,16 +72,7 @@ BENCHMARK(GetLogger)->ThreadRange(1, 8);
  */
 void LogToLoggerWithDisabledLogLevel(benchmark::State& state) {
     if (state.thread_index == 0) {
-        cb::logger::Config config{};
-        config.cyclesize = 2048;
-        config.buffersize = 8192;
-        config.sleeptime = 1;
-        config.unit_test = true;
-        config.console = false;
-
-        auto init = cb::logger::initialize(config);
-        if (init) {
-            std::cerr << "Failed to initialize logger: " << *init;
+        if (!initializeLogger(false)) {
             return;
         }
 
@@ -85,16 +99,7 @@ BENCHMARK(LogToLoggerWithDisabledLogLevel)->ThreadRange(1, 8);
  */
 void LogToLoggerWithEnabledLogLevel(benchmark::State& state) {
     if (state.thread_index == 0) {
-        cb::logger::Config config{};
-        config.cyclesize = 2048;
-        config.buffersize = 8192;
-        config.sleeptime = 1;
-        config.unit_test = true;
-        config.console = false;
-
-        auto init = cb::logger::initialize(config);
-        if (init) {
-            std::cerr << "Failed to initialize logger: " << *init;
+        if (!initializeLogger(false)) {
             return;
         }
 
@@ -112,6 +117,39 @@ void LogToLoggerWithEnabledLogLevel(benchmark::State& state) {
 
 BENCHMARK(LogToLoggerWithEnabledLogLevel)->ThreadRange(1, 8);
 
+/**
+ * Benchmark the per-call cost of logging a message with a few arguments.
+ * With Arg(0) the message is formatted on the calling thread, and with
+ * Arg(1) the arguments are captured in binary form and the message is
+ * formatted by the drain thread. (If the drain thread can't keep up, the
+ * messages which don't fit in the ring are formatted on the calling thread)
+ */
+void LogMessageWithArguments(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        if (!initializeLogger(state.range(0) != 0)) {
+            return;
+        }
+
+        cb::logger::get()->set_level(spdlog::level::level_enum::trace);
+    }
+
+    const std::string key{"a_document_key_of_some_length"};
+    while (state.KeepRunning()) {
+        LOG_TRACE("{}: Mutation for key:{} vbucket:{} seqno:{} cas:{:x}",
+                  "127.0.0.1:46566",
+                  key,
+                  512,
+                  uint64_t(123456789),
+                  uint64_t(0x15a2b3c4d5e6f708));
+    }
+
+    if (state.thread_index == 0) {
+        cb::logger::shutdown();
+    }
+}
+
+BENCHMARK(LogMessageWithArguments)->Arg(0)->Arg(1)->ThreadRange(1, 8);
+
 int main(int argc, char** argv) {
     ::benchmark::Initialize(&argc, argv);
     if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
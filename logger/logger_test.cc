@@ -25,6 +25,10 @@
 #include <platform/memorymap.h>
 #include <valgrind/valgrind.h>
 
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
 class SpdloggerTest : public ::testing::Test {
 protected:
 /*
@@ -51,8 +55,9 @@ protected:
      * Set up the logger
      *
      * @param cyclesize - the size to use before switching file
+     * @param binary - if binary logging should be used
      */
-    void SetUpLogger(size_t cyclesize) {
+    void SetUpLogger(size_t cyclesize, bool binary = false) {
         cb::logger::Config config;
         config.filename = filename;
         config.cyclesize = cyclesize;
@@ -61,6 +66,7 @@ protected:
         config.sleeptime = 0;
         config.unit_test = true;
         config.console = false;
+        config.binary = binary;
 
         const auto ret = cb::logger::initialize(config);
         EXPECT_FALSE(ret) << ret.get();
@@ -410,3 +416,120 @@ TEST_F(DedupeSinkTest, MessageLoggedTwiceWithFlushTest) {
             << "Log contents:" << std::endl
             << getLogContents();
 }
+
+/**
+ * Test class for tests which capture the messages in binary form and
+ * format them on the drain thread
+ */
+class BinaryLogTest : public SpdloggerTest {
+protected:
+    void SetUp() override {
+        RemoveFiles();
+        SetUpLogger(20 * 1024, true);
+    }
+};
+
+TEST_F(BinaryLogTest, FmtStyleFormatting) {
+    const uint32_t value = 0xdeadbeef;
+    const std::string text{"text"};
+    LOG_INFO("BinaryLogFormatting {:x} {} {} {:.2f} {} {}",
+             value,
+             -1,
+             text,
+             1.5,
+             true,
+             'c');
+    cb::logger::shutdown();
+    files = cb::io::findFilesWithPrefix(filename);
+    ASSERT_EQ(1, files.size()) << "We should only have a single logfile";
+    EXPECT_EQ(1,
+              countInFile(files.front(),
+                          "INFO BinaryLogFormatting deadbeef -1 text 1.50 "
+                          "true c"))
+            << "Log contents:" << std::endl
+            << getLogContents();
+}
+
+TEST_F(BinaryLogTest, EscapedBracesAndPositionalArguments) {
+    LOG_INFO("BinaryLogBraces {{{1}}} {0}", "first", "second");
+    LOG_INFO("BinaryLogNoArgs {{}}");
+    cb::logger::shutdown();
+    files = cb::io::findFilesWithPrefix(filename);
+    ASSERT_EQ(1, files.size()) << "We should only have a single logfile";
+    EXPECT_EQ(1, countInFile(files.front(), "BinaryLogBraces {second} first"))
+            << "Log contents:" << std::endl
+            << getLogContents();
+    // spdlog doesn't format messages without arguments
+    EXPECT_EQ(1, countInFile(files.front(), "BinaryLogNoArgs {{}}"))
+            << "Log contents:" << std::endl
+            << getLogContents();
+}
+
+/**
+ * The format is copied when the message is captured, so a format in a
+ * buffer which is gone (or reused) before the message is formatted is
+ * still logged correctly.
+ */
+TEST_F(BinaryLogTest, FormatInStackBuffer) {
+    auto logFromBuffer = [](int value) {
+        char format[64];
+        std::snprintf(format, sizeof(format), "BinaryLogStack%d {}", value);
+        LOG_INFO(format, value);
+        // Overwrite the buffer before it goes out of scope
+        std::memset(format, 'x', sizeof(format) - 1);
+        format[sizeof(format) - 1] = '\0';
+    };
+    for (int ii = 0; ii < 3; ++ii) {
+        logFromBuffer(ii);
+    }
+    cb::logger::shutdown();
+    files = cb::io::findFilesWithPrefix(filename);
+    ASSERT_EQ(1, files.size()) << "We should only have a single logfile";
+    for (int ii = 0; ii < 3; ++ii) {
+        const auto expected = "BinaryLogStack" + std::to_string(ii) + " " +
+                              std::to_string(ii);
+        EXPECT_EQ(1, countInFile(files.front(), expected))
+                << "Log contents:" << std::endl
+                << getLogContents();
+    }
+    EXPECT_EQ(0, countInFile(files.front(), "xxxxxxxx"))
+            << "Log contents:" << std::endl
+            << getLogContents();
+}
+
+/**
+ * The messages logged by a thread must be written even if the thread is
+ * gone before the drain thread gets to them, and the messages should be
+ * written in the order they were logged.
+ */
+TEST_F(BinaryLogTest, MessagesFromTerminatedThread) {
+    std::thread thread([]() {
+        for (int ii = 0; ii < 10; ++ii) {
+            LOG_INFO("BinaryLogThread {}", ii);
+        }
+    });
+    thread.join();
+    cb::logger::flush();
+
+    const auto contents = getLogContents();
+    size_t pos = 0;
+    for (int ii = 0; ii < 10; ++ii) {
+        const auto next =
+                contents.find("BinaryLogThread " + std::to_string(ii), pos);
+        ASSERT_NE(std::string::npos, next) << "Log contents:" << std::endl
+                                           << contents;
+        pos = next;
+    }
+}
+
+/**
+ * Messages with arguments we can't capture are formatted by the calling
+ * thread as before
+ */
+TEST_F(BinaryLogTest, NotCapturable) {
+    struct Opaque {};
+    EXPECT_FALSE(cb::logger::binary::capture(
+            spdlog::level::info, "BinaryLogOpaque {}", Opaque{}));
+    EXPECT_TRUE(cb::logger::binary::capture(
+            spdlog::level::info, "BinaryLogCaptured {}", 1));
+}
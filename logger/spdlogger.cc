@@ -19,6 +19,7 @@
 
 #include "custom_rotating_file_sink.h"
 
+#include "binary_log.h"
 #include "dedupe_sink.h"
 #include "logger.h"
 
@@ -117,6 +118,8 @@ static void log(EXTENSION_LOG_LEVEL mcd_severity,
 
 LOGGER_PUBLIC_API
 void cb::logger::flush() {
+    // Pass the captured messages on to the sinks before flushing them
+    cb::logger::binary::drain();
     if (file_logger) {
         file_logger->flush();
     }
@@ -124,6 +127,7 @@ void cb::logger::flush() {
 
 LOGGER_PUBLIC_API
 void cb::logger::shutdown() {
+    cb::logger::binary::stop();
     flush();
     file_logger.reset();
     spdlog::drop_all();
@@ -152,6 +156,9 @@ boost::optional<std::string> cb::logger::initialize(
         buffersz = 8 * 1024 * 1024; // use an 8MB log buffer
     }
 
+    // Messages captured for the previous logger should go to its sinks
+    cb::logger::binary::stop();
+
     try {
         /* Initialise the loggers.
          *
@@ -193,6 +200,13 @@ boost::optional<std::string> cb::logger::initialize(
                                      spdlog::async_overflow_policy::block_retry,
                                      nullptr,
                                      std::chrono::seconds(sleeptime));
+
+        if (logger_settings.binary) {
+            // The drain thread formats the captured messages and writes
+            // them directly to the sinks (passing them through the async
+            // logger would only add another copy and queue hop)
+            cb::logger::binary::start(sink, log_pattern);
+        }
     } catch (const spdlog::spdlog_ex& ex) {
         std::string msg =
                 std::string{"Log initialization failed: "} + ex.what();
@@ -209,6 +223,7 @@ std::shared_ptr<spdlog::logger> cb::logger::get() {
 }
 
 void cb::logger::createBlackholeLogger() {
+    cb::logger::binary::stop();
     // delete if already exists
     spdlog::drop(logger_name);
 
@@ -220,6 +235,7 @@ void cb::logger::createBlackholeLogger() {
 }
 
 void cb::logger::createConsoleLogger() {
+    cb::logger::binary::stop();
     // delete if already exists
     spdlog::drop(logger_name);
     file_logger = spdlog::stderr_color_mt(logger_name);
@@ -229,6 +245,6 @@ void cb::logger::createConsoleLogger() {
 
 LOGGER_PUBLIC_API
 EXTENSION_LOGGER_DESCRIPTOR& cb::logger::getLoggerDescriptor() {
-    descriptor.log = log;
+    descriptor.log = ::log;
     return descriptor;
 }
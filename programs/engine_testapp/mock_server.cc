@@ -362,6 +362,18 @@ static void end_trace(gsl::not_null<const void*> void_cookie,
     }
     cookie->getTracer().end(tracecode);
 }
+
+static void add_trace(gsl::not_null<const void*> void_cookie,
+                      cb::tracing::TraceCode tracecode,
+                      ProcessClock::time_point start,
+                      ProcessClock::time_point end) {
+    auto* cookie = reinterpret_cast<mock_connstruct*>(
+            const_cast<void*>(void_cookie.get()));
+    if (!cookie->isTracingEnabled()) {
+        return;
+    }
+    cookie->getTracer().record(tracecode, start, end);
+}
 // End -  Tracing api
 
 SERVER_HANDLE_V1 *get_mock_server_api(void)
@@ -420,12 +432,22 @@ SERVER_HANDLE_V1 *get_mock_server_api(void)
       hooks_api.release_free_memory = AllocHooks::release_free_memory;
       hooks_api.enable_thread_cache = AllocHooks::enable_thread_cache;
       hooks_api.get_allocator_property = AllocHooks::get_allocator_property;
+      hooks_api.create_arena = AllocHooks::create_arena;
+      hooks_api.destroy_arena = AllocHooks::destroy_arena;
+      hooks_api.arena_malloc = AllocHooks::arena_malloc;
+      hooks_api.arena_free = AllocHooks::arena_free;
+      hooks_api.get_arena_stats = AllocHooks::get_arena_stats;
+      hooks_api.get_allocation_utilization =
+              AllocHooks::get_allocation_utilization;
+      hooks_api.is_allocation_utilization_supported =
+              AllocHooks::is_allocation_utilization_supported;
 
       document_api.pre_link = mock_pre_link_document;
       document_api.pre_expiry = document_pre_expiry;
 
       tracing_api.begin_trace = begin_trace;
       tracing_api.end_trace = end_trace;
+      tracing_api.add_trace = add_trace;
 
       rv.interface = 1;
       rv.core = &core_api;
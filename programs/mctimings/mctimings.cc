@@ -28,6 +28,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 static uint32_t getValue(cJSON *root, const char *key) {
     cJSON *obj = cJSON_GetObjectItem(root, key);
@@ -64,6 +65,14 @@ struct Bin {
     uint64_t cumulative_count;
 };
 
+// A bin in the log-linear histogram (newer servers), where the limits
+// (in microseconds) are provided by the server
+struct LogLinearBin {
+    uint32_t low;
+    uint32_t high;
+    Bin bin;
+};
+
 class Timings {
 public:
     Timings(cJSON* json) : max(0), ns(Bin()), oldwayout(false) {
@@ -85,6 +94,15 @@ public:
 
         int ii;
 
+        if (!logLinear.empty()) {
+            for (const auto& entry : logLinear) {
+                dump("us", entry.low, entry.high, entry.bin);
+            }
+            std::cout << "Total: " << total << " operations" << std::endl;
+            dumpPercentiles();
+            return;
+        }
+
         dump("ns", 0, 999, ns);
         for (ii = 0; ii < 100; ++ii) {
             dump("us", ii * 10, ((ii + 1) * 10 - 1), us[ii]);
@@ -111,6 +129,17 @@ public:
         std::cout << "Total: " << total << " operations" << std::endl;
     }
 
+    void dumpPercentiles() {
+        if (percentiles.empty()) {
+            return;
+        }
+        std::cout << "Percentiles:" << std::endl;
+        for (const auto& p : percentiles) {
+            std::cout << "    p" << p.first << ": " << p.second << " us"
+                      << std::endl;
+        }
+    }
+
 private:
 
     // Helper function for initialize
@@ -197,6 +226,34 @@ private:
         for (auto &val : wayout) {
             update_max_and_total(max, total, val);
         }
+
+        // Newer servers also provide a log-linear histogram (with a
+        // much better resolution) and the percentiles
+        obj = cJSON_GetObjectItem(root, "log_linear");
+        if (obj != nullptr && obj->type == cJSON_Array) {
+            max = total = 0;
+            for (auto* it = obj->child; it != nullptr; it = it->next) {
+                if (cJSON_GetArraySize(it) != 3) {
+                    throw std::runtime_error(
+                            "Internal error.. invalid \"log_linear\" entry");
+                }
+                LogLinearBin entry;
+                entry.low = uint32_t(cJSON_GetArrayItem(it, 0)->valuedouble);
+                entry.high = uint32_t(cJSON_GetArrayItem(it, 1)->valuedouble);
+                entry.bin.count =
+                        uint32_t(cJSON_GetArrayItem(it, 2)->valuedouble);
+                update_max_and_total(max, total, entry.bin);
+                logLinear.push_back(entry);
+            }
+        }
+
+        obj = cJSON_GetObjectItem(root, "percentiles");
+        if (obj != nullptr && obj->type == cJSON_Object) {
+            for (auto* it = obj->child; it != nullptr; it = it->next) {
+                percentiles.emplace_back(it->string,
+                                         uint64_t(it->valuedouble));
+            }
+        }
     }
 
     void dump(const char *timeunit, uint32_t low, uint32_t high,
@@ -251,6 +308,12 @@ private:
     bool oldwayout;
 
     uint64_t total;
+
+    // The log-linear histogram (empty if the server didn't provide one)
+    std::vector<LogLinearBin> logLinear;
+
+    // The percentiles (in microseconds) provided by the server
+    std::vector<std::pair<std::string, uint64_t>> percentiles;
 };
 
 std::string opcode2string(uint8_t opcode) {
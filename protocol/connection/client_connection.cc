@@ -26,6 +26,7 @@
 #include <platform/strerror.h>
 
 #include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <sstream>
@@ -762,6 +763,33 @@ MutationInfo MemcachedConnection::store(const std::string& id,
     return mutate(doc, vbucket, MutationType::Set);
 }
 
+void MemcachedConnection::decodeCompactStats(
+        cb::const_byte_buffer data, std::map<std::string, std::string>& out) {
+    const auto* pos = data.data();
+    const auto* end = data.data() + data.size();
+    while (pos < end) {
+        uint16_t klen;
+        uint32_t vlen;
+        if (size_t(end - pos) < sizeof(klen) + sizeof(vlen)) {
+            throw std::runtime_error(
+                    "decodeCompactStats: Truncated stat header");
+        }
+        std::memcpy(&klen, pos, sizeof(klen));
+        pos += sizeof(klen);
+        std::memcpy(&vlen, pos, sizeof(vlen));
+        pos += sizeof(vlen);
+        klen = ntohs(klen);
+        vlen = ntohl(vlen);
+        if (size_t(end - pos) < size_t(klen) + vlen) {
+            throw std::runtime_error("decodeCompactStats: Truncated stat");
+        }
+        std::string key(reinterpret_cast<const char*>(pos), klen);
+        pos += klen;
+        out[key].assign(reinterpret_cast<const char*>(pos), vlen);
+        pos += vlen;
+    }
+}
+
 std::map<std::string, std::string> MemcachedConnection::statsMap(
         const std::string& subcommand) {
     BinprotGenericCommand command(PROTOCOL_BINARY_CMD_STAT, subcommand);
@@ -784,6 +812,11 @@ std::map<std::string, std::string> MemcachedConnection::statsMap(
 
         std::string key = response.getKeyString();
 
+        if (key.empty() && hasFeature(cb::mcbp::Feature::CompactStats)) {
+            decodeCompactStats(response.getData(), ret);
+            continue;
+        }
+
         if (key.empty()) {
             key = std::to_string(counter++);
         }
@@ -785,5 +785,15 @@ protected:
      */
     void applyFeatures(const std::string& agent, const Featureset& features);
 
+    /**
+     * Decode the value of a STAT response containing multiple stats (sent
+     * when the CompactStats feature is enabled)
+     *
+     * @param data the value of the response
+     * @param out where to insert the stats
+     */
+    static void decodeCompactStats(cb::const_byte_buffer data,
+                                   std::map<std::string, std::string>& out);
+
     Featureset effective_features;
 };
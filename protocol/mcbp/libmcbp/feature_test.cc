@@ -34,7 +34,8 @@ const std::map<cb::mcbp::Feature, std::string> blueprint = {
          {cb::mcbp::Feature::ClustermapChangeNotification,
           "Clustermap change notification"},
          {cb::mcbp::Feature::UnorderedExecution, "Unordered execution"},
-         {cb::mcbp::Feature::Tracing, "Tracing"}}};
+         {cb::mcbp::Feature::Tracing, "Tracing"},
+         {cb::mcbp::Feature::CompactStats, "Compact stats"}}};
 
 TEST(to_string, LegalValues) {
     for (const auto& entry : blueprint) {
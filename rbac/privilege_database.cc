@@ -19,7 +19,6 @@
 #include <cJSON_utils.h>
 #include <platform/make_unique.h>
 #include <platform/memorymap.h>
-#include <platform/rwlock.h>
 #include <strings.h>
 #include <atomic>
 #include <fstream>
@@ -32,13 +31,34 @@ namespace cb {
 namespace rbac {
 
 // Every time we create a new PrivilegeDatabase we bump the generation.
-// The PrivilegeContext contains the generation number it was generated
-// from so that we can easily detect if the PrivilegeContext is stale.
 static std::atomic<uint32_t> generation{0};
 
-// The read write lock needed when you want to build a context
-cb::RWLock rwlock;
-std::unique_ptr<PrivilegeDatabase> db;
+// The generation of the PrivilegeDatabase currently in use. The
+// PrivilegeContext contains the generation number it was generated
+// from so that we can easily detect if the PrivilegeContext is stale.
+// It is only updated when a new database is published (and not when
+// it is created) so that the connections don't try to rebuild their
+// context from the old database while the new one is being parsed.
+static std::atomic<uint32_t> currentGeneration{0};
+
+// The current database is published RCU-style: readers grab a reference
+// to the current database (without blocking each other or the writer)
+// and use it to build their context. The old database is released when
+// the last reader is done with it.
+static std::shared_ptr<const PrivilegeDatabase> db;
+
+// Serialize the writers (they need to compare the generations)
+static std::mutex dbmutex;
+
+static std::shared_ptr<const PrivilegeDatabase> getDatabase() {
+    return std::atomic_load(&db);
+}
+
+static void publishDatabase(std::shared_ptr<const PrivilegeDatabase> database) {
+    const auto gen = database ? database->generation : 0;
+    std::atomic_store(&db, std::move(database));
+    currentGeneration.store(gen);
+}
 
 UserEntry::UserEntry(const cJSON& root) {
     if (root.string == nullptr) {
@@ -159,7 +179,7 @@ PrivilegeContext PrivilegeDatabase::createContext(
 }
 
 std::pair<PrivilegeContext, bool> PrivilegeDatabase::createInitialContext(
-        const std::string& user, cb::sasl::Domain domain) {
+        const std::string& user, cb::sasl::Domain domain) const {
     const auto& ue = lookup(user);
     if (ue.getDomain() != domain) {
         throw NoSuchUserException(user.c_str());
@@ -168,7 +188,8 @@ std::pair<PrivilegeContext, bool> PrivilegeDatabase::createInitialContext(
 }
 
 PrivilegeAccess PrivilegeContext::check(Privilege privilege) const {
-    if (generation != cb::rbac::generation) {
+    if (generation != cb::rbac::currentGeneration.load(
+                              std::memory_order_acquire)) {
         return PrivilegeAccess::Stale;
     }
 
@@ -242,14 +263,12 @@ void PrivilegeContext::setBucketPrivilegeBits(bool value) {
 
 PrivilegeContext createContext(const std::string& user,
                                const std::string& bucket) {
-    std::lock_guard<cb::ReaderLock> guard(rwlock.reader());
-    return db->createContext(user, bucket);
+    return getDatabase()->createContext(user, bucket);
 }
 
 std::pair<PrivilegeContext, bool> createInitialContext(
         const std::string& user, cb::sasl::Domain domain) {
-    std::lock_guard<cb::ReaderLock> guard(rwlock.reader());
-    return db->createInitialContext(user, domain);
+    return getDatabase()->createInitialContext(user, domain);
 }
 
 void loadPrivilegeDatabase(const std::string& filename) {
@@ -265,23 +284,25 @@ void loadPrivilegeDatabase(const std::string& filename) {
                 "PrivilegeDatabaseManager::load: Failed to parse json");
     }
 
-    auto database = std::make_unique<PrivilegeDatabase>(json.get());
+    auto database = std::make_shared<const PrivilegeDatabase>(json.get());
 
-    std::lock_guard<cb::WriterLock> guard(rwlock.writer());
+    std::lock_guard<std::mutex> guard(dbmutex);
     // Handle race conditions
-    if (db->generation < database->generation) {
-        db.swap(database);
+    if (getDatabase()->generation < database->generation) {
+        publishDatabase(std::move(database));
     }
 }
 
 void initialize() {
     // Create an empty database to avoid having to add checks
     // if it exists or not...
-    db = std::make_unique<PrivilegeDatabase>(nullptr);
+    std::lock_guard<std::mutex> guard(dbmutex);
+    publishDatabase(std::make_shared<const PrivilegeDatabase>(nullptr));
 }
 
 void destroy() {
-    db.reset();
+    std::lock_guard<std::mutex> guard(dbmutex);
+    publishDatabase({});
 }
 
 bool mayAccessBucket(const std::string& user, const std::string& bucket) {
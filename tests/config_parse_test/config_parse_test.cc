@@ -300,6 +300,7 @@ TEST_F(SettingsTest, Interfaces) {
     cJSON_AddStringToObject(obj.get(), "host", "*");
     cJSON_AddStringToObject(obj.get(), "protocol", "memcached");
     cJSON_AddTrueToObject(obj.get(), "management");
+    cJSON_AddTrueToObject(obj.get(), "reuseport");
 
     unique_cJSON_ptr ssl(cJSON_CreateObject());
     cJSON_AddStringToObject(ssl.get(), "key", key_pattern);
@@ -325,6 +326,7 @@ TEST_F(SettingsTest, Interfaces) {
         EXPECT_EQ(10, ifc0.backlog);
         EXPECT_EQ("*", ifc0.host);
         EXPECT_TRUE(ifc0.management);
+        EXPECT_TRUE(ifc0.reuseport);
     } catch (std::exception& exception) {
         FAIL() << exception.what();
     }
@@ -874,6 +876,133 @@ TEST_F(SettingsTest, TracingEnabled) {
     }
 }
 
+TEST_F(SettingsTest, ConnectionMigration) {
+    nonBooleanValuesShouldFail("connection_migration");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddTrueToObject(obj.get(), "connection_migration");
+    try {
+        Settings settings(obj);
+        EXPECT_TRUE(settings.isConnectionMigration());
+        EXPECT_TRUE(settings.has.connection_migration);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+
+    obj.reset(cJSON_CreateObject());
+    cJSON_AddFalseToObject(obj.get(), "connection_migration");
+    try {
+        Settings settings(obj);
+        EXPECT_FALSE(settings.isConnectionMigration());
+        EXPECT_TRUE(settings.has.connection_migration);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+}
+
+TEST_F(SettingsTest, KtlsEnabled) {
+    nonBooleanValuesShouldFail("ktls_enabled");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddTrueToObject(obj.get(), "ktls_enabled");
+    try {
+        Settings settings(obj);
+        EXPECT_TRUE(settings.isKtlsEnabled());
+        EXPECT_TRUE(settings.has.ktls_enabled);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+
+    obj.reset(cJSON_CreateObject());
+    cJSON_AddFalseToObject(obj.get(), "ktls_enabled");
+    try {
+        Settings settings(obj);
+        EXPECT_FALSE(settings.isKtlsEnabled());
+        EXPECT_TRUE(settings.has.ktls_enabled);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+}
+
+TEST_F(SettingsTest, SslSessionCacheSize) {
+    nonNumericValuesShouldFail("ssl_session_cache_size");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "ssl_session_cache_size", 100);
+    try {
+        Settings settings(obj);
+        EXPECT_EQ(100, settings.getSslSessionCacheSize());
+        EXPECT_TRUE(settings.has.ssl_session_cache_size);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+
+    obj.reset(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "ssl_session_cache_size", -1);
+    expectFail(obj);
+}
+
+TEST_F(SettingsTest, SslSessionTimeout) {
+    nonNumericValuesShouldFail("ssl_session_timeout");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "ssl_session_timeout", 3600);
+    try {
+        Settings settings(obj);
+        EXPECT_EQ(3600, settings.getSslSessionTimeout());
+        EXPECT_TRUE(settings.has.ssl_session_timeout);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+}
+
+TEST_F(SettingsTest, SslSessionTickets) {
+    nonBooleanValuesShouldFail("ssl_session_tickets");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddFalseToObject(obj.get(), "ssl_session_tickets");
+    try {
+        Settings settings(obj);
+        EXPECT_FALSE(settings.isSslSessionTicketsEnabled());
+        EXPECT_TRUE(settings.has.ssl_session_tickets);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+}
+
+TEST_F(SettingsTest, TracingSampleRate) {
+    nonNumericValuesShouldFail("tracing_sample_rate");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "tracing_sample_rate", 1000);
+    try {
+        Settings settings(obj);
+        EXPECT_EQ(1000, settings.getTracingSampleRate());
+        EXPECT_TRUE(settings.has.tracing_sample_rate);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+
+    obj.reset(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "tracing_sample_rate", -1);
+    expectFail(obj);
+}
+
+TEST_F(SettingsTest, TracingSlowThreshold) {
+    nonNumericValuesShouldFail("tracing_slow_threshold");
+
+    unique_cJSON_ptr obj(cJSON_CreateObject());
+    cJSON_AddNumberToObject(obj.get(), "tracing_slow_threshold", 100);
+    try {
+        Settings settings(obj);
+        EXPECT_EQ(std::chrono::milliseconds(100),
+                  settings.getTracingSlowThreshold());
+        EXPECT_TRUE(settings.has.tracing_slow_threshold);
+    } catch (std::exception& exception) {
+        FAIL() << exception.what();
+    }
+}
+
 TEST(SettingsUpdateTest, EmptySettingsShouldWork) {
     Settings updated;
     Settings settings;
@@ -1211,6 +1340,18 @@ TEST(SettingsUpdateTest, ConnectionIdleTimeIsDynamic) {
               settings.getConnectionIdleTime());
 }
 
+TEST(SettingsUpdateTest, SslSessionCacheSizeIsDynamic) {
+    Settings updated;
+    Settings settings;
+    auto old = settings.getSslSessionCacheSize();
+    updated.setSslSessionCacheSize(old + 10);
+    EXPECT_NO_THROW(settings.updateSettings(updated, false));
+    EXPECT_EQ(old, settings.getSslSessionCacheSize());
+    EXPECT_NO_THROW(settings.updateSettings(updated));
+    EXPECT_EQ(updated.getSslSessionCacheSize(),
+              settings.getSslSessionCacheSize());
+}
+
 TEST(SettingsUpdateTest, BioDrainBufferSzIsNotDynamic) {
     Settings updated;
     Settings settings;
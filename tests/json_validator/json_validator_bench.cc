@@ -0,0 +1,99 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmark JSON validation (as performed for datatype detection on the
+ * mutation path) - JSON_checker against JsonValidator with each instruction
+ * set - over a range of document sizes.
+ */
+
+#include <JSON_checker.h>
+#include <benchmark/benchmark.h>
+#include <daemon/json_validator.h>
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * Build a JSON document of (at least) the given size, in the shape of a
+ * typical application document: an array of small records.
+ */
+static std::string makeDocument(size_t size) {
+    std::string doc = "{\"type\": \"order\", \"items\": [";
+    for (int ii = 0; doc.size() < size; ++ii) {
+        if (ii > 0) {
+            doc += ", ";
+        }
+        doc += "{\"sku\": \"SKU-" + std::to_string(ii * 7919) +
+               "\", \"description\": \"Replacement part for model " +
+               std::to_string(ii) +
+               ", see the manual for details\", \"quantity\": " +
+               std::to_string(ii % 10 + 1) +
+               ", \"price\": " + std::to_string(ii * 3) +
+               ".99, \"in_stock\": true}";
+    }
+    doc += "]}";
+    return doc;
+}
+
+static void JSONChecker(benchmark::State& state) {
+    const auto doc = makeDocument(state.range(0));
+    const auto* data = reinterpret_cast<const uint8_t*>(doc.data());
+    JSON_checker::Validator validator;
+    while (state.KeepRunning()) {
+        if (!validator.validate(data, doc.size())) {
+            throw std::logic_error("JSONChecker: document is not JSON");
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * doc.size());
+}
+
+static void JsonValidatorIsa(benchmark::State& state, JsonValidator::Isa isa) {
+    const auto doc = makeDocument(state.range(0));
+    const auto* data = reinterpret_cast<const uint8_t*>(doc.data());
+    JsonValidator validator(isa);
+    if (validator.getIsa() != isa) {
+        state.SkipWithError(
+                (to_string(isa) + " not supported by this CPU").c_str());
+        return;
+    }
+    while (state.KeepRunning()) {
+        if (!validator.validate(data, doc.size())) {
+            throw std::logic_error("JsonValidator: document is not JSON");
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * doc.size());
+}
+
+static void JsonValidatorScalar(benchmark::State& state) {
+    JsonValidatorIsa(state, JsonValidator::Isa::Scalar);
+}
+
+static void JsonValidatorSSE2(benchmark::State& state) {
+    JsonValidatorIsa(state, JsonValidator::Isa::SSE2);
+}
+
+static void JsonValidatorAVX2(benchmark::State& state) {
+    JsonValidatorIsa(state, JsonValidator::Isa::AVX2);
+}
+
+BENCHMARK(JSONChecker)->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(JsonValidatorScalar)->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(JsonValidatorSSE2)->RangeMultiplier(4)->Range(256, 16384);
+BENCHMARK(JsonValidatorAVX2)->RangeMultiplier(4)->Range(256, 16384);
+
+BENCHMARK_MAIN();
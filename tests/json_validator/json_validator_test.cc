@@ -0,0 +1,142 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <JSON_checker.h>
+#include <daemon/json_validator.h>
+#include <gtest/gtest.h>
+
+#include <random>
+
+class JsonValidatorTest : public ::testing::TestWithParam<JsonValidator::Isa> {
+protected:
+    bool validate(const std::string& doc) {
+        return validator.validate(doc);
+    }
+
+    JsonValidator validator{GetParam()};
+};
+
+TEST_P(JsonValidatorTest, Values) {
+    EXPECT_TRUE(validate("{}"));
+    EXPECT_TRUE(validate("[]"));
+    EXPECT_TRUE(validate(" { \"a\" : [ 1 , 2 ] , \"b\" : { } } \n"));
+    EXPECT_TRUE(validate("\"string\""));
+    EXPECT_TRUE(validate("true"));
+    EXPECT_TRUE(validate("false"));
+    EXPECT_TRUE(validate("null"));
+    EXPECT_TRUE(validate("[[[[{\"a\":[{}]}]]]]"));
+
+    EXPECT_FALSE(validate(""));
+    EXPECT_FALSE(validate("   "));
+    EXPECT_FALSE(validate("{"));
+    EXPECT_FALSE(validate("[1,]"));
+    EXPECT_FALSE(validate("{\"a\":1,}"));
+    EXPECT_FALSE(validate("{\"a\" 1}"));
+    EXPECT_FALSE(validate("{1:1}"));
+    EXPECT_FALSE(validate("[1}"));
+    EXPECT_FALSE(validate("{} {}"));
+    EXPECT_FALSE(validate("nul"));
+    EXPECT_FALSE(validate("True"));
+    EXPECT_FALSE(validate("'string'"));
+}
+
+TEST_P(JsonValidatorTest, Numbers) {
+    for (const auto* number :
+         {"0", "-0", "1", "-1", "123", "1.5", "-1.5e10", "1E+2", "1e-2"}) {
+        EXPECT_TRUE(validate(number)) << number;
+    }
+    for (const auto* number :
+         {"-", "01", "1.", ".1", "+1", "1e", "1e+", "0x10", "1.e1", "NaN"}) {
+        EXPECT_FALSE(validate(number)) << number;
+    }
+}
+
+TEST_P(JsonValidatorTest, Strings) {
+    EXPECT_TRUE(validate(R"("\" \\ \/ \b \f \n \r \t")"));
+    EXPECT_TRUE(validate(R"("\u0041\uffFF")"));
+    EXPECT_FALSE(validate(R"("\u004")"));
+    EXPECT_FALSE(validate(R"("\u004g")"));
+    EXPECT_FALSE(validate(R"("\x")"));
+    EXPECT_FALSE(validate("\"unterminated"));
+    EXPECT_FALSE(validate(std::string("\"a\0b\"", 5)));
+    EXPECT_FALSE(validate("\"a\nb\""));
+
+    // Check the special characters are found at every offset within (and
+    // across) vector registers.
+    for (size_t ii = 0; ii < 100; ++ii) {
+        const std::string padding(ii, 'x');
+        EXPECT_TRUE(validate("\"" + padding + "\""));
+        EXPECT_TRUE(validate("\"" + padding + "\\\"" + padding + "\""));
+        EXPECT_FALSE(validate("\"" + padding + "\t" + padding + "\""));
+        EXPECT_FALSE(validate("\"" + padding));
+        EXPECT_TRUE(validate("\"" + padding + "\xc3\xa9" + padding + "\""));
+        EXPECT_FALSE(validate("\"" + padding + "\xc3" + padding + "\""));
+    }
+}
+
+TEST_P(JsonValidatorTest, Utf8) {
+    EXPECT_TRUE(validate("\"\xc3\xa9\""));             // U+00E9
+    EXPECT_TRUE(validate("\"\xe4\xb8\xad\""));         // U+4E2D
+    EXPECT_TRUE(validate("\"\xef\xbf\xbf\""));         // U+FFFF
+    EXPECT_TRUE(validate("\"\xf0\x9f\x98\x80\""));     // U+1F600
+    EXPECT_TRUE(validate("\"\xf4\x8f\xbf\xbf\""));     // U+10FFFF
+
+    EXPECT_FALSE(validate("\"\xc0\x80\""));            // overlong
+    EXPECT_FALSE(validate("\"\xe0\x80\x80\""));        // overlong
+    EXPECT_FALSE(validate("\"\xed\xa0\x80\""));        // surrogate
+    EXPECT_FALSE(validate("\"\xf4\x90\x80\x80\""));    // > U+10FFFF
+    EXPECT_FALSE(validate("\"\x80\""));                // continuation
+    EXPECT_FALSE(validate("\"\xe4\xb8\""));            // truncated
+    EXPECT_FALSE(validate("\"\xff\""));
+}
+
+/**
+ * Check the validator agrees with JSON_checker for a set of (random)
+ * documents and random corruptions of them.
+ */
+TEST_P(JsonValidatorTest, MatchesJsonChecker) {
+    std::mt19937 gen(GetParam() == JsonValidator::Isa::Scalar ? 1 : 2);
+    const std::string alphabet =
+            "abc xyz \"\\{}[],:0123456789.eE+-tfnul\t\n\x01\x7f\x80\xc3\xa9";
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    JSON_checker::Validator checker;
+
+    for (int ii = 0; ii < 10000; ++ii) {
+        std::string doc = "{\"key" + std::to_string(ii) +
+                          "\": [1, -2.5e3, true, null, \"" +
+                          std::string(ii % 100, 'v') +
+                          "\", {\"nested\": \"caf\xc3\xa9\"}]}";
+        const int corruptions = ii % 3;
+        for (int jj = 0; jj < corruptions; ++jj) {
+            std::uniform_int_distribution<size_t> pos(0, doc.size() - 1);
+            doc[pos(gen)] = alphabet[pick(gen)];
+        }
+
+        const auto* ptr = reinterpret_cast<const uint8_t*>(doc.data());
+        EXPECT_EQ(checker.validate(ptr, doc.size()), validate(doc)) << doc;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(Isa,
+                        JsonValidatorTest,
+                        ::testing::Values(JsonValidator::Isa::Scalar,
+                                          JsonValidator::Isa::SSE2,
+                                          JsonValidator::Isa::AVX2),
+                        [](const ::testing::TestParamInfo<
+                                JsonValidator::Isa>& info) {
+                            return to_string(info.param);
+                        });
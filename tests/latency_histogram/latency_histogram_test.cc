@@ -0,0 +1,140 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include <cJSON_utils.h>
+#include <daemon/latency_histogram.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using std::chrono::microseconds;
+
+TEST(LatencyHistogramTest, InvalidSignificantFigures) {
+    EXPECT_THROW(LatencyHistogram(0), std::invalid_argument);
+    EXPECT_THROW(LatencyHistogram(6), std::invalid_argument);
+}
+
+TEST(LatencyHistogramTest, Add) {
+    LatencyHistogram histogram;
+    histogram.add(std::chrono::nanoseconds(500));
+    histogram.add(microseconds(400));
+    histogram.add(microseconds(900));
+    // Values above MaxValue are recorded as MaxValue
+    histogram.add(std::chrono::hours(10));
+    EXPECT_EQ(4, histogram.getTotal());
+    EXPECT_EQ(0, histogram.getValueAtPercentile(0));
+    EXPECT_LE(LatencyHistogram::MaxValue,
+              int64_t(histogram.getValueAtPercentile(100)));
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.getValueAtPercentile(99));
+
+    for (int ii = 1; ii <= 1000; ++ii) {
+        histogram.add(microseconds(ii));
+    }
+
+    // With one significant figure the reported value is within 1/16 of
+    // the actual value
+    auto p50 = histogram.getValueAtPercentile(50);
+    EXPECT_LE(500 * 15 / 16, p50);
+    EXPECT_GE(500 * 17 / 16, p50);
+
+    auto p999 = histogram.getValueAtPercentile(99.9);
+    EXPECT_LE(999 * 15 / 16, p999);
+    EXPECT_GE(999 * 17 / 16, p999);
+}
+
+TEST(LatencyHistogramTest, Precision) {
+    LatencyHistogram histogram(3);
+    EXPECT_EQ(3, histogram.getSignificantFigures());
+    for (int ii = 1; ii <= 100000; ++ii) {
+        histogram.add(microseconds(ii));
+    }
+    auto p50 = histogram.getValueAtPercentile(50);
+    EXPECT_LE(49950, p50);
+    EXPECT_GE(50050, p50);
+}
+
+TEST(LatencyHistogramTest, Merge) {
+    LatencyHistogram a;
+    LatencyHistogram b(2);
+    a.add(microseconds(10));
+    b.add(microseconds(10));
+    b.add(microseconds(1000));
+
+    a += b;
+    EXPECT_EQ(3, a.getTotal());
+    EXPECT_EQ(2, b.getTotal());
+
+    LatencyHistogram c(a);
+    EXPECT_EQ(3, c.getTotal());
+    c = b;
+    EXPECT_EQ(2, c.getTotal());
+    c += c;
+    EXPECT_EQ(4, c.getTotal());
+    c.reset();
+    EXPECT_EQ(0, c.getTotal());
+}
+
+TEST(LatencyHistogramTest, ConcurrentAdd) {
+    LatencyHistogram histogram;
+    const int numThreads = 4;
+    const int numSamples = 10000;
+    std::vector<std::thread> threads;
+    for (int ii = 0; ii < numThreads; ++ii) {
+        threads.emplace_back([&histogram, ii]() {
+            for (int jj = 0; jj < numSamples; ++jj) {
+                histogram.add(microseconds(ii * 100 + jj % 100));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(numThreads * numSamples, histogram.getTotal());
+}
+
+TEST(LatencyHistogramTest, Json) {
+    LatencyHistogram histogram;
+    histogram.add(microseconds(10));
+    histogram.add(microseconds(10));
+    histogram.add(microseconds(1000));
+
+    unique_cJSON_ptr json(cJSON_CreateObject());
+    histogram.addToJson(json.get());
+
+    auto* percentiles = cJSON_GetObjectItem(json.get(), "percentiles");
+    ASSERT_NE(nullptr, percentiles);
+    EXPECT_EQ(10, cJSON_GetObjectItem(percentiles, "50")->valueint);
+    EXPECT_LE(1000 * 15 / 16,
+              cJSON_GetObjectItem(percentiles, "99.9")->valueint);
+
+    auto* buckets = cJSON_GetObjectItem(json.get(), "log_linear");
+    ASSERT_NE(nullptr, buckets);
+    ASSERT_EQ(2, cJSON_GetArraySize(buckets));
+    auto* first = cJSON_GetArrayItem(buckets, 0);
+    EXPECT_EQ(10, cJSON_GetArrayItem(first, 0)->valueint);
+    EXPECT_EQ(10, cJSON_GetArrayItem(first, 1)->valueint);
+    EXPECT_EQ(2, cJSON_GetArrayItem(first, 2)->valueint);
+
+    auto* second = cJSON_GetArrayItem(buckets, 1);
+    EXPECT_LE(cJSON_GetArrayItem(second, 0)->valueint, 1000);
+    EXPECT_GE(cJSON_GetArrayItem(second, 1)->valueint, 1000);
+    EXPECT_EQ(1, cJSON_GetArrayItem(second, 2)->valueint);
+}
@@ -18,6 +18,9 @@
 #include <cJSON_utils.h>
 #include <gtest/gtest.h>
 #include <memcached/rbac.h>
+#include <platform/dirutils.h>
+
+#include <fstream>
 
 TEST(PrivilegeDatabaseTest, ParseLegalConfig) {
     unique_cJSON_ptr root(cJSON_CreateObject());
@@ -88,3 +91,36 @@ TEST(PrivilegeDatabaseTest, GenerationCounter) {
     cb::rbac::PrivilegeDatabase db2(nullptr);
     EXPECT_GT(db2.generation, db1.generation);
 }
+
+TEST(PrivilegeDatabaseTest, ContextStaleOnLoad) {
+    const auto filename = cb::io::mktemp("rbac.json.XXXXXX");
+    {
+        std::ofstream file(filename);
+        file << R"({"trond":{"privileges":["Audit"],)"
+             << R"("buckets":{"bucket1":["Read"]}}})";
+    }
+
+    cb::rbac::initialize();
+    cb::rbac::loadPrivilegeDatabase(filename);
+    auto context = cb::rbac::createContext("trond", "bucket1");
+    EXPECT_EQ(cb::rbac::PrivilegeAccess::Ok,
+              context.check(cb::rbac::Privilege::Read));
+    EXPECT_EQ(cb::rbac::PrivilegeAccess::Fail,
+              context.check(cb::rbac::Privilege::Upsert));
+
+    // Creating a new database doesn't invalidate the contexts, it
+    // isn't in use until it is loaded
+    cb::rbac::PrivilegeDatabase db(nullptr);
+    EXPECT_EQ(cb::rbac::PrivilegeAccess::Ok,
+              context.check(cb::rbac::Privilege::Read));
+
+    cb::rbac::loadPrivilegeDatabase(filename);
+    EXPECT_EQ(cb::rbac::PrivilegeAccess::Stale,
+              context.check(cb::rbac::Privilege::Read));
+    context = cb::rbac::createContext("trond", "bucket1");
+    EXPECT_EQ(cb::rbac::PrivilegeAccess::Ok,
+              context.check(cb::rbac::Privilege::Read));
+
+    cb::rbac::destroy();
+    cb::io::rmrf(filename);
+}
@@ -0,0 +1,327 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+
+#include <cJSON_utils.h>
+#include <daemon/connection_mcbp.h>
+#include <daemon/cookie.h>
+#include <daemon/request_trace_log.h>
+#include <daemon/settings.h>
+#include <gtest/gtest.h>
+#include <mcbp/protocol/opcode.h>
+#include <memcached/protocol_binary.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono;
+
+/// A RequestTraceLog which isn't the singleton used by the server
+class MockRequestTraceLog : public RequestTraceLog {
+public:
+    MockRequestTraceLog() = default;
+};
+
+class RequestTraceLogTest : public ::testing::Test {
+protected:
+    RequestTraceLog::Entry makeEntry(RequestTraceLog::Reason reason,
+                                     uint32_t opaque) {
+        RequestTraceLog::Entry entry;
+        // Entries are added in time order
+        entry.time = start + seconds(opaque);
+        entry.connectionId = 1;
+        entry.opcode = "GET";
+        entry.opaque = opaque;
+        entry.duration = microseconds(100);
+        entry.reason = reason;
+        return entry;
+    }
+
+    const system_clock::time_point start = system_clock::now();
+    MockRequestTraceLog log;
+};
+
+TEST_F(RequestTraceLogTest, Empty) {
+    EXPECT_TRUE(log.getEntries().empty());
+    EXPECT_TRUE(log.getEntries(RequestTraceLog::Reason::Sampled).empty());
+    EXPECT_TRUE(log.getEntries(RequestTraceLog::Reason::Slow).empty());
+}
+
+TEST_F(RequestTraceLogTest, OldestFirst) {
+    for (uint32_t ii = 0; ii < 10; ++ii) {
+        log.add(makeEntry(RequestTraceLog::Reason::Sampled, ii));
+    }
+
+    const auto entries = log.getEntries();
+    ASSERT_EQ(10, entries.size());
+    for (uint32_t ii = 0; ii < 10; ++ii) {
+        EXPECT_EQ(ii, entries[ii].opaque);
+    }
+}
+
+TEST_F(RequestTraceLogTest, Wraparound) {
+    // Once the ring is full each new entry replaces the oldest one, and
+    // the entries are still returned oldest first
+    const uint32_t extra = 10;
+    const uint32_t total = uint32_t(RequestTraceLog::Capacity) + extra;
+    for (uint32_t ii = 0; ii < total; ++ii) {
+        log.add(makeEntry(RequestTraceLog::Reason::Sampled, ii));
+    }
+
+    for (const auto& entries :
+         {log.getEntries(), log.getEntries(RequestTraceLog::Reason::Sampled)}) {
+        ASSERT_EQ(RequestTraceLog::Capacity, entries.size());
+        for (size_t ii = 0; ii < entries.size(); ++ii) {
+            EXPECT_EQ(extra + ii, entries[ii].opaque);
+        }
+    }
+}
+
+TEST_F(RequestTraceLogTest, SeparateRings) {
+    // Sampling can't push the slow requests out of the log
+    log.add(makeEntry(RequestTraceLog::Reason::Slow, 0));
+    const uint32_t total = uint32_t(RequestTraceLog::Capacity) + 10;
+    for (uint32_t ii = 1; ii <= total; ++ii) {
+        log.add(makeEntry(RequestTraceLog::Reason::Sampled, ii));
+    }
+
+    const auto slow = log.getEntries(RequestTraceLog::Reason::Slow);
+    ASSERT_EQ(1, slow.size());
+    EXPECT_EQ(0u, slow[0].opaque);
+    EXPECT_EQ(RequestTraceLog::Capacity,
+              log.getEntries(RequestTraceLog::Reason::Sampled).size());
+
+    // All of the entries are returned in time order
+    const auto entries = log.getEntries();
+    ASSERT_EQ(RequestTraceLog::Capacity + 1, entries.size());
+    EXPECT_EQ(RequestTraceLog::Reason::Slow, entries[0].reason);
+    for (size_t ii = 1; ii < entries.size(); ++ii) {
+        EXPECT_EQ(RequestTraceLog::Reason::Sampled, entries[ii].reason);
+        EXPECT_LT(entries[ii - 1].opaque, entries[ii].opaque);
+    }
+}
+
+TEST_F(RequestTraceLogTest, Breakdown) {
+    using cb::tracing::TraceCode;
+    cb::tracing::Tracer tracer;
+    const auto now = ProcessClock::now();
+    auto record = [&tracer, now](TraceCode code, int begin, int duration) {
+        tracer.record(code,
+                      now + microseconds(begin),
+                      now + microseconds(begin + duration));
+    };
+
+    // The request span covers all of the others and an open span has no
+    // duration yet, so neither of them is part of the breakdown
+    tracer.begin(TraceCode::REQUEST);
+    record(TraceCode::PARSE, 0, 10);
+    record(TraceCode::HTLOCKWAIT, 10, 20);
+    record(TraceCode::BGWAIT, 30, 30);
+    record(TraceCode::BGLOAD, 60, 40);
+    // The command is executed again once the background fetch completes
+    record(TraceCode::HTLOCKWAIT, 100, 7);
+    record(TraceCode::GET, 100, 50);
+    record(TraceCode::SEND, 150, 5);
+    tracer.begin(TraceCode::STORE);
+
+    auto entry = makeEntry(RequestTraceLog::Reason::Slow, 0);
+    entry.setTrace(tracer);
+    EXPECT_EQ(to_string(tracer), entry.trace);
+
+    const std::vector<std::pair<TraceCode, microseconds>> expected = {
+            {TraceCode::PARSE, microseconds(10)},
+            {TraceCode::HTLOCKWAIT, microseconds(27)},
+            {TraceCode::BGWAIT, microseconds(30)},
+            {TraceCode::BGLOAD, microseconds(40)},
+            {TraceCode::GET, microseconds(50)},
+            {TraceCode::SEND, microseconds(5)}};
+    EXPECT_EQ(expected, entry.breakdown);
+
+    // The layers add up to the time of the traced request
+    microseconds total(0);
+    for (const auto& layer : entry.breakdown) {
+        total += layer.second;
+    }
+    EXPECT_EQ(microseconds(162), total);
+
+    auto json = entry.toJSON();
+    auto* breakdown = cJSON_GetObjectItem(json.get(), "breakdown");
+    ASSERT_NE(nullptr, breakdown);
+    for (const auto& layer : expected) {
+        auto* obj = cJSON_GetObjectItem(breakdown,
+                                        to_string(layer.first).c_str());
+        ASSERT_NE(nullptr, obj) << to_string(layer.first);
+        EXPECT_EQ(layer.second.count(), obj->valueint);
+    }
+}
+
+TEST_F(RequestTraceLogTest, Clear) {
+    for (uint32_t ii = 0; ii < RequestTraceLog::Capacity + 1; ++ii) {
+        log.add(makeEntry(RequestTraceLog::Reason::Sampled, ii));
+    }
+    log.clear();
+    EXPECT_TRUE(log.getEntries().empty());
+
+    // The ring starts over from the beginning
+    log.add(makeEntry(RequestTraceLog::Reason::Sampled, 42));
+    const auto entries = log.getEntries();
+    ASSERT_EQ(1, entries.size());
+    EXPECT_EQ(42, entries[0].opaque);
+}
+
+/**
+ * Tests for the selection of the requests added to the request trace log
+ * by Cookie::maybeAddToTraceLog (these use the server's log)
+ */
+class CookieTraceLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::memset(request.bytes, 0, sizeof(request.bytes));
+        request.message.header.request.magic = PROTOCOL_BINARY_REQ;
+        request.message.header.request.opcode = PROTOCOL_BINARY_CMD_GET;
+        request.message.header.request.opaque = htonl(0xcafe);
+
+        sampleRate = settings.getTracingSampleRate();
+        slowThreshold = settings.getTracingSlowThreshold();
+        RequestTraceLog::getInstance().clear();
+    }
+
+    void TearDown() override {
+        settings.setTracingSampleRate(sampleRate);
+        settings.setTracingSlowThreshold(slowThreshold);
+        RequestTraceLog::getInstance().clear();
+    }
+
+    /**
+     * Run a request through the cookie which took the given time
+     *
+     * @param trace called to add spans to the request's trace
+     */
+    void runRequest(nanoseconds elapsed,
+                    std::function<void(cb::tracing::Tracer&)> trace = {}) {
+        cookie.initialize({request.bytes, sizeof(request.bytes)});
+        if (trace) {
+            trace(cookie.getTracer());
+        }
+        cookie.maybeAddToTraceLog(elapsed);
+        cookie.flushTraceLog();
+    }
+
+    /**
+     * Create a mock connection which doesn't own a socket and isn't bound
+     * to libevent
+     */
+    class MockConnection : public McbpConnection {
+    public:
+        MockConnection() : McbpConnection() {
+        }
+    };
+
+    MockConnection connection;
+    Cookie cookie{connection};
+    protocol_binary_request_no_extras request;
+    size_t sampleRate;
+    milliseconds slowThreshold;
+};
+
+TEST_F(CookieTraceLogTest, Disabled) {
+    settings.setTracingSampleRate(0);
+    settings.setTracingSlowThreshold(milliseconds(0));
+    runRequest(seconds(10));
+    EXPECT_TRUE(RequestTraceLog::getInstance().getEntries().empty());
+}
+
+TEST_F(CookieTraceLogTest, SampleRate) {
+    settings.setTracingSampleRate(4);
+    settings.setTracingSlowThreshold(milliseconds(0));
+
+    // One in every 4 requests is sampled
+    for (int ii = 0; ii < 8; ++ii) {
+        runRequest(microseconds(10));
+    }
+
+    const auto entries = RequestTraceLog::getInstance().getEntries();
+    ASSERT_EQ(2, entries.size());
+    for (const auto& entry : entries) {
+        EXPECT_EQ(RequestTraceLog::Reason::Sampled, entry.reason);
+        EXPECT_EQ(to_string(cb::mcbp::ClientOpcode::Get), entry.opcode);
+        EXPECT_EQ(0xcafeu, entry.opaque);
+        EXPECT_EQ(connection.getId(), entry.connectionId);
+        EXPECT_EQ(microseconds(10), entry.duration);
+    }
+}
+
+TEST_F(CookieTraceLogTest, SlowThreshold) {
+    settings.setTracingSampleRate(0);
+    settings.setTracingSlowThreshold(milliseconds(100));
+
+    runRequest(milliseconds(99));
+    EXPECT_TRUE(RequestTraceLog::getInstance().getEntries().empty());
+
+    runRequest(milliseconds(100));
+    const auto entries = RequestTraceLog::getInstance().getEntries();
+    ASSERT_EQ(1, entries.size());
+    EXPECT_EQ(RequestTraceLog::Reason::Slow, entries[0].reason);
+    EXPECT_EQ(microseconds(100000), entries[0].duration);
+}
+
+TEST_F(CookieTraceLogTest, SlowIsNotSampled) {
+    // A slow request is logged as slow even if it is picked by sampling
+    settings.setTracingSampleRate(1);
+    settings.setTracingSlowThreshold(milliseconds(100));
+
+    runRequest(milliseconds(200));
+    runRequest(milliseconds(1));
+
+    auto& log = RequestTraceLog::getInstance();
+    const auto slow = log.getEntries(RequestTraceLog::Reason::Slow);
+    ASSERT_EQ(1, slow.size());
+    EXPECT_EQ(microseconds(200000), slow[0].duration);
+    const auto sampled = log.getEntries(RequestTraceLog::Reason::Sampled);
+    ASSERT_EQ(1, sampled.size());
+    EXPECT_EQ(microseconds(1000), sampled[0].duration);
+}
+
+TEST_F(CookieTraceLogTest, SlowBreakdown) {
+    using cb::tracing::TraceCode;
+    settings.setTracingSampleRate(0);
+    settings.setTracingSlowThreshold(milliseconds(100));
+
+    runRequest(milliseconds(200), [](cb::tracing::Tracer& tracer) {
+        const auto now = ProcessClock::now();
+        tracer.end(TraceCode::PARSE);
+        tracer.record(TraceCode::BGWAIT, now, now + milliseconds(120));
+        tracer.record(TraceCode::BGLOAD,
+                      now + milliseconds(120),
+                      now + milliseconds(190));
+    });
+
+    const auto entries = RequestTraceLog::getInstance().getEntries(
+            RequestTraceLog::Reason::Slow);
+    ASSERT_EQ(1, entries.size());
+    const auto& breakdown = entries[0].breakdown;
+    ASSERT_EQ(3, breakdown.size());
+    EXPECT_EQ(TraceCode::PARSE, breakdown[0].first);
+    EXPECT_EQ(TraceCode::BGWAIT, breakdown[1].first);
+    EXPECT_EQ(microseconds(120000), breakdown[1].second);
+    EXPECT_EQ(TraceCode::BGLOAD, breakdown[2].first);
+    EXPECT_EQ(microseconds(70000), breakdown[2].second);
+}
@@ -0,0 +1,186 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include "config.h"
+
+#include <daemon/ssl_session_cache.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+/**
+ * Perform handshakes between an in-memory client and server, where every
+ * server connection use a new SSL_CTX (like memcached does).
+ */
+class SslSessionCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        cache.setCacheSize(100);
+        cache.setTimeout(std::chrono::seconds(300));
+        cache.setTicketsEnabled(true);
+        cache.clear();
+
+        clientCtx = SSL_CTX_new(SSLv23_client_method());
+        ASSERT_NE(nullptr, clientCtx);
+        SSL_CTX_set_session_cache_mode(clientCtx, SSL_SESS_CACHE_CLIENT);
+    }
+
+    void TearDown() override {
+        if (session != nullptr) {
+            SSL_SESSION_free(session);
+        }
+        SSL_CTX_free(clientCtx);
+    }
+
+    /**
+     * Connect to a new server context and try to resume the previous
+     * session (if any)
+     *
+     * @param tls the protocol version to use
+     * @param context the context string to configure the server with
+     * @return true if the session was resumed
+     */
+    bool connect(int tls = TLS1_2_VERSION,
+                 const std::string& context = "test") {
+        const std::string dir = SOURCE_ROOT "/tests/cert/";
+        auto* serverCtx = SSL_CTX_new(SSLv23_server_method());
+        EXPECT_EQ(1,
+                  SSL_CTX_use_certificate_chain_file(
+                          serverCtx, (dir + "testapp.cert").c_str()));
+        EXPECT_EQ(1,
+                  SSL_CTX_use_PrivateKey_file(serverCtx,
+                                              (dir + "testapp.pem").c_str(),
+                                              SSL_FILETYPE_PEM));
+        cache.configure(serverCtx, context);
+
+        auto* server = SSL_new(serverCtx);
+        auto* client = SSL_new(clientCtx);
+        SSL_set_min_proto_version(client, tls);
+        SSL_set_max_proto_version(client, tls);
+        if (session != nullptr) {
+            SSL_set_session(client, session);
+        }
+
+        BIO* serverBio;
+        BIO* clientBio;
+        BIO_new_bio_pair(&serverBio, 0, &clientBio, 0);
+        SSL_set_bio(server, serverBio, serverBio);
+        SSL_set_bio(client, clientBio, clientBio);
+        SSL_set_accept_state(server);
+        SSL_set_connect_state(client);
+
+        for (int ii = 0; ii < 10; ++ii) {
+            SSL_do_handshake(client);
+            SSL_do_handshake(server);
+        }
+        EXPECT_TRUE(SSL_is_init_finished(server));
+        EXPECT_TRUE(SSL_is_init_finished(client));
+
+        // TLS 1.3 sends the tickets after the handshake
+        char byte = 0;
+        SSL_write(server, &byte, 1);
+        SSL_read(client, &byte, 1);
+
+        const bool reused = SSL_session_reused(server);
+        if (session != nullptr) {
+            SSL_SESSION_free(session);
+        }
+        session = SSL_get1_session(client);
+
+        // OpenSSL won't resume the session on the client unless it was
+        // shut down cleanly (the server don't care)
+        SSL_shutdown(client);
+        SSL_free(client);
+        SSL_free(server);
+        SSL_CTX_free(serverCtx);
+        return reused;
+    }
+
+    SslSessionCache& cache = SslSessionCache::getInstance();
+    SSL_CTX* clientCtx = nullptr;
+    SSL_SESSION* session = nullptr;
+};
+
+TEST_F(SslSessionCacheTest, SessionId) {
+    cache.setTicketsEnabled(false);
+    EXPECT_FALSE(connect());
+    EXPECT_EQ(1, cache.size());
+    EXPECT_TRUE(connect());
+
+    cache.clear();
+    EXPECT_FALSE(connect());
+    EXPECT_TRUE(connect());
+}
+
+TEST_F(SslSessionCacheTest, SessionIdCacheSize) {
+    cache.setTicketsEnabled(false);
+    EXPECT_FALSE(connect());
+    cache.setCacheSize(0);
+    EXPECT_EQ(0, cache.size());
+    EXPECT_FALSE(connect());
+}
+
+TEST_F(SslSessionCacheTest, Ticket) {
+    cache.setCacheSize(0);
+    EXPECT_FALSE(connect());
+    EXPECT_TRUE(connect());
+    EXPECT_EQ(0, cache.size());
+}
+
+#ifdef TLS1_3_VERSION
+TEST_F(SslSessionCacheTest, TicketTls13) {
+    cache.setCacheSize(0);
+    EXPECT_FALSE(connect(TLS1_3_VERSION));
+    EXPECT_TRUE(connect(TLS1_3_VERSION));
+}
+#endif
+
+TEST_F(SslSessionCacheTest, TicketKeyRotation) {
+    cache.setCacheSize(0);
+    EXPECT_FALSE(connect());
+
+    // A ticket encrypted with the previous key is accepted and renewed
+    cache.rotateTicketKeys();
+    EXPECT_TRUE(connect());
+    cache.rotateTicketKeys();
+    EXPECT_TRUE(connect());
+
+    // ... but not if it is older than that
+    cache.rotateTicketKeys();
+    cache.rotateTicketKeys();
+    EXPECT_FALSE(connect());
+}
+
+TEST_F(SslSessionCacheTest, TicketsDisabled) {
+    cache.setCacheSize(0);
+    cache.setTicketsEnabled(false);
+    EXPECT_FALSE(connect());
+    EXPECT_FALSE(connect());
+}
+
+TEST_F(SslSessionCacheTest, Timeout) {
+    cache.setTicketsEnabled(false);
+    cache.setTimeout(std::chrono::seconds(0));
+    EXPECT_FALSE(connect());
+    EXPECT_FALSE(connect());
+}
+
+TEST_F(SslSessionCacheTest, Context) {
+    EXPECT_FALSE(connect(TLS1_2_VERSION, "a"));
+    EXPECT_FALSE(connect(TLS1_2_VERSION, "b"));
+    EXPECT_TRUE(connect(TLS1_2_VERSION, "b"));
+}
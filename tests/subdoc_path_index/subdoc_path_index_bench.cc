@@ -0,0 +1,94 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmark a multi-path lookup of a number of paths spread through a ~50KB
+ * document - one subjson GET per path against building a SubdocPathIndex.
+ */
+
+#include <benchmark/benchmark.h>
+#include <daemon/subdocument_path_index.h>
+#include <subdoc/operations.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static std::string makeDocument() {
+    std::string doc = "{";
+    for (int ii = 0; doc.size() < 50 * 1024; ++ii) {
+        doc += "\"field" + std::to_string(ii) + "\": {\"id\": " +
+               std::to_string(ii) +
+               ", \"description\": \"Some text describing field " +
+               std::to_string(ii) + "\", \"values\": [1, 2, 3, 4]}, ";
+    }
+    doc += "\"last\": true}";
+    return doc;
+}
+
+/// Paths spread evenly through the document.
+static std::vector<std::string> makePaths(int count) {
+    std::vector<std::string> paths;
+    for (int ii = 0; ii < count; ++ii) {
+        paths.push_back("field" + std::to_string(ii * 300 / count) +
+                        ".values[2]");
+    }
+    return paths;
+}
+
+static void SubjsonPerPath(benchmark::State& state) {
+    const auto doc = makeDocument();
+    const auto paths = makePaths(state.range(0));
+    Subdoc::Operation op;
+    Subdoc::Result result;
+    while (state.KeepRunning()) {
+        for (const auto& path : paths) {
+            op.clear();
+            op.set_result_buf(&result);
+            op.set_code(Subdoc::Command::GET);
+            op.set_doc(doc.data(), doc.size());
+            if (op.op_exec(path.data(), path.size()) !=
+                Subdoc::Error::SUCCESS) {
+                throw std::logic_error("SubjsonPerPath: lookup failed");
+            }
+            benchmark::DoNotOptimize(result.matchloc());
+        }
+    }
+}
+
+static void PathIndex(benchmark::State& state) {
+    const auto doc = makeDocument();
+    const auto paths = makePaths(state.range(0));
+    std::vector<cb::const_char_buffer> buffers;
+    for (const auto& path : paths) {
+        buffers.push_back({path.data(), path.size()});
+    }
+    SubdocPathIndex index;
+    while (state.KeepRunning()) {
+        if (!index.build({doc.data(), doc.size()}, buffers)) {
+            throw std::logic_error("PathIndex: failed to build index");
+        }
+        for (size_t ii = 0; ii < paths.size(); ++ii) {
+            benchmark::DoNotOptimize(index.find(ii));
+        }
+    }
+}
+
+BENCHMARK(SubjsonPerPath)->Arg(1)->Arg(4)->Arg(16);
+BENCHMARK(PathIndex)->Arg(1)->Arg(4)->Arg(16);
+
+BENCHMARK_MAIN();
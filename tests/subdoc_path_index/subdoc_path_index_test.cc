@@ -0,0 +1,199 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+#include <daemon/subdocument_path_index.h>
+#include <gtest/gtest.h>
+#include <subdoc/operations.h>
+
+using Status = SubdocPathIndex::Status;
+
+class SubdocPathIndexTest : public ::testing::Test {
+protected:
+    bool build(const std::vector<std::string>& in) {
+        paths.clear();
+        for (const auto& path : in) {
+            paths.push_back({path.data(), path.size()});
+        }
+        return index.build({doc.data(), doc.size()}, paths);
+    }
+
+    void expectValue(size_t idx, const std::string& value) {
+        const auto* entry = index.find(idx);
+        ASSERT_NE(nullptr, entry) << idx;
+        EXPECT_EQ(Status::Success, entry->status) << idx;
+        EXPECT_EQ(value, std::string(entry->value.buf, entry->value.len))
+                << idx;
+    }
+
+    void expectStatus(size_t idx, Status status) {
+        const auto* entry = index.find(idx);
+        ASSERT_NE(nullptr, entry) << idx;
+        EXPECT_EQ(status, entry->status) << idx;
+    }
+
+    std::string doc = R"({"a": {"b": [1, "two", {"c": null}]}, "d" : true,
+                          "e": {"f": -1.5e3, "g": []}, "a": 0})";
+    std::vector<cb::const_char_buffer> paths;
+    SubdocPathIndex index;
+};
+
+TEST_F(SubdocPathIndexTest, Lookups) {
+    ASSERT_TRUE(build({"a",
+                       "a.b[0]",
+                       "a.b[1]",
+                       "a.b[-1].c",
+                       "d",
+                       "e.f",
+                       "e.g",
+                       "a.b[3]",
+                       "a.x",
+                       "x",
+                       "e.g[-1]",
+                       "d.x",
+                       "a[0]",
+                       "a.b.c",
+                       "e.f[-1]"}));
+
+    expectValue(0, R"({"b": [1, "two", {"c": null}]})");
+    expectValue(1, "1");
+    expectValue(2, R"("two")");
+    expectValue(3, "null");
+    expectValue(4, "true");
+    expectValue(5, "-1.5e3");
+    expectValue(6, "[]");
+
+    expectStatus(7, Status::PathEnoent);
+    expectStatus(8, Status::PathEnoent);
+    expectStatus(9, Status::PathEnoent);
+    expectStatus(10, Status::PathEnoent);
+
+    expectStatus(11, Status::PathMismatch);
+    expectStatus(12, Status::PathMismatch);
+    expectStatus(13, Status::PathMismatch);
+    expectStatus(14, Status::PathMismatch);
+}
+
+// Paths using syntax which isn't supported are left to subjson.
+TEST_F(SubdocPathIndexTest, UnsupportedPaths) {
+    ASSERT_TRUE(build(
+            {"", "`a`", "a.b[-2]", "a.b[01]", "a..b", ".a", "a.", "a[0", "d"}));
+    for (size_t ii = 0; ii < paths.size() - 1; ++ii) {
+        EXPECT_EQ(nullptr, index.find(ii))
+                << std::string(paths[ii].buf, paths[ii].len);
+    }
+    expectValue(paths.size() - 1, "true");
+    EXPECT_EQ(nullptr, index.find(paths.size()));
+
+    EXPECT_FALSE(build({"", "`a`"}));
+}
+
+TEST_F(SubdocPathIndexTest, InvalidDocument) {
+    doc = R"({"a": 1, "b": [1,], "c": 3})";
+    EXPECT_FALSE(build({"a", "c"}));
+    EXPECT_EQ(nullptr, index.find(0));
+
+    doc = R"({"a": 1, "b": 2)";
+    EXPECT_FALSE(build({"a", "c"}));
+
+    doc = R"({"a": 1} {})";
+    EXPECT_FALSE(build({"a", "c"}));
+
+    doc = "";
+    EXPECT_FALSE(build({"a", "c"}));
+
+    // Like subjson, parsing stops once the paths have been found.
+    doc = R"({"a": 1, "b": 2, "c": [})";
+    EXPECT_TRUE(build({"a", "b"}));
+}
+
+// Keys containing escape sequences can't be matched.
+TEST_F(SubdocPathIndexTest, EscapedKeys) {
+    doc = R"({"k\n": 1, "ab": 2, "c": 3})";
+    EXPECT_FALSE(build({"ab", "c"}));
+
+    // ... but are fine where no path needs to match them.
+    doc = R"({"x": {"k\n": 1}, "ab": 2, "c": 3})";
+    EXPECT_TRUE(build({"ab", "c"}));
+    expectValue(0, "2");
+    expectValue(1, "3");
+}
+
+TEST_F(SubdocPathIndexTest, TooDeep) {
+    doc = std::string(SubdocPathIndex::MaxDepth, '[') +
+          std::string(SubdocPathIndex::MaxDepth, ']');
+    EXPECT_FALSE(build({"[0]", "[1]"}));
+
+    doc = std::string(SubdocPathIndex::MaxDepth - 1, '[') +
+          std::string(SubdocPathIndex::MaxDepth - 1, ']');
+    EXPECT_TRUE(build({"[0]", "[1]"}));
+}
+
+/**
+ * Check the index gives the same results as subjson for a variety of
+ * paths.
+ */
+TEST_F(SubdocPathIndexTest, MatchesSubjson) {
+    doc = R"({"name": "alice", "tags": ["a", "b", {"x": [1, 2]}],
+              "address": {"street": "1 Main St", "zip": 12345,
+                          "geo": {"lat": 1.5, "lon": -2.25}},
+              "empty": {}, "list": [], "flag": false, "n": null,
+              "nested": [[1, [2, [3]]], {"a": {"b": {"c": "deep"}}}]})";
+    const std::vector<std::string> candidates = {
+            "name",           "tags",          "tags[0]",
+            "tags[2].x[1]",   "tags[-1]",      "tags[-1].x[-1]",
+            "tags[3]",        "tags.x",        "address.street",
+            "address.geo",    "address.geo.lat", "address.zip.x",
+            "address[0]",     "empty",         "empty.x",
+            "empty[0]",       "list[0]",       "list[-1]",
+            "flag",           "n",             "n.x",
+            "nested[0][1][1][0]", "nested[1].a.b.c", "nested[-1].a.b",
+            "missing",        "missing.x",     "name[0]"};
+
+    std::vector<std::string> in(candidates.begin(), candidates.end());
+    ASSERT_TRUE(build(in));
+
+    Subdoc::Operation op;
+    for (size_t ii = 0; ii < candidates.size(); ++ii) {
+        const auto& path = candidates[ii];
+        Subdoc::Result result;
+        op.clear();
+        op.set_result_buf(&result);
+        op.set_code(Subdoc::Command::GET);
+        op.set_doc(doc.data(), doc.size());
+        const auto rv = op.op_exec(path.data(), path.size());
+
+        const auto* entry = index.find(ii);
+        ASSERT_NE(nullptr, entry) << path;
+        switch (rv) {
+        case Subdoc::Error::SUCCESS:
+            EXPECT_EQ(Status::Success, entry->status) << path;
+            EXPECT_EQ(std::string(result.matchloc().at,
+                                  result.matchloc().length),
+                      std::string(entry->value.buf, entry->value.len))
+                    << path;
+            break;
+        case Subdoc::Error::PATH_ENOENT:
+            EXPECT_EQ(Status::PathEnoent, entry->status) << path;
+            break;
+        case Subdoc::Error::PATH_MISMATCH:
+            EXPECT_EQ(Status::PathMismatch, entry->status) << path;
+            break;
+        default:
+            ADD_FAILURE() << "Unexpected subjson result for " << path;
+        }
+    }
+}
@@ -0,0 +1,220 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+#include "testapp.h"
+
+#include <memcached/openssl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * Tests for the kernel TLS (kTLS) offload of the data the server sends on
+ * SSL connections.
+ *
+ * The client is a plain OpenSSL client on a blocking socket, so it decrypts
+ * the records exactly as the kernel encrypted them. The tests negotiate
+ * TLS 1.2 with AES-128-GCM (the only session the server offloads). If the
+ * kernel doesn't support kTLS the server keeps on using OpenSSL, and the
+ * tests which depend on kTLS return early.
+ */
+class KtlsTest : public TestappTest {
+protected:
+    void SetUp() override {
+        TestappTest::SetUp();
+
+        sfd = create_connect_plain_socket(ssl_port);
+        ASSERT_NE(INVALID_SOCKET, sfd);
+
+        // Fail rather than hang if the server never sends what we expect
+        struct timeval tv = {10, 0};
+        ASSERT_EQ(0,
+                  setsockopt(sfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)));
+
+        context = SSL_CTX_new(SSLv23_client_method());
+        ASSERT_NE(nullptr, context);
+        ASSERT_EQ(1, SSL_CTX_set_max_proto_version(context, TLS1_2_VERSION));
+        ASSERT_EQ(1,
+                  SSL_CTX_set_cipher_list(context,
+                                          "ECDHE-RSA-AES128-GCM-SHA256:"
+                                          "AES128-GCM-SHA256"));
+        client = SSL_new(context);
+        ASSERT_NE(nullptr, client);
+        ASSERT_EQ(1, SSL_set_fd(client, int(sfd)));
+        ASSERT_EQ(1, SSL_connect(client));
+    }
+
+    void TearDown() override {
+        if (client != nullptr) {
+            SSL_free(client);
+        }
+        if (context != nullptr) {
+            SSL_CTX_free(context);
+        }
+        if (sfd != INVALID_SOCKET) {
+            closesocket(sfd);
+        }
+        TestappTest::TearDown();
+    }
+
+    void sendCommand(uint8_t opcode, const std::string& key) {
+        char buffer[1024];
+        const auto len = mcbp_raw_command(buffer,
+                                          sizeof(buffer),
+                                          opcode,
+                                          key.data(),
+                                          key.size(),
+                                          nullptr,
+                                          0);
+        ASSERT_EQ(int(len), SSL_write(client, buffer, int(len)));
+    }
+
+    void readBytes(char* dest, size_t nbytes) {
+        size_t offset = 0;
+        while (offset < nbytes) {
+            const auto n =
+                    SSL_read(client, dest + offset, int(nbytes - offset));
+            ASSERT_LT(0, n) << "SSL_read failed: "
+                            << SSL_get_error(client, n);
+            offset += n;
+        }
+    }
+
+    /**
+     * Read a response from the server and verify its opcode and status
+     *
+     * @return the value in the response
+     */
+    std::string readResponse(uint8_t opcode) {
+        protocol_binary_response_header header;
+        readBytes(reinterpret_cast<char*>(header.bytes), sizeof(header.bytes));
+        EXPECT_EQ(PROTOCOL_BINARY_RES, header.response.magic);
+        EXPECT_EQ(opcode, header.response.opcode);
+        EXPECT_EQ(PROTOCOL_BINARY_RESPONSE_SUCCESS,
+                  ntohs(header.response.status));
+
+        std::vector<char> body(ntohl(header.response.bodylen));
+        readBytes(body.data(), body.size());
+        const size_t offset =
+                header.response.extlen + ntohs(header.response.keylen);
+        if (offset > body.size()) {
+            ADD_FAILURE() << "Invalid response body";
+            return {};
+        }
+        return {body.data() + offset, body.size() - offset};
+    }
+
+    /**
+     * Does the server use kTLS to send data on our connection?
+     */
+    bool isKernelSend() {
+        struct sockaddr_storage addr;
+        socklen_t addrlen = sizeof(addr);
+        if (getsockname(sfd, reinterpret_cast<sockaddr*>(&addr), &addrlen) !=
+            0) {
+            ADD_FAILURE() << "getsockname failed: " << strerror(errno);
+            return false;
+        }
+        const auto port =
+                ntohs(reinterpret_cast<sockaddr_in*>(&addr)->sin_port);
+        const auto peername = "127.0.0.1:" + std::to_string(port);
+
+        auto stats = getAdminConnection().stats("connections");
+        for (auto* it = stats.get()->child; it != nullptr; it = it->next) {
+            unique_cJSON_ptr json(cJSON_Parse(it->valuestring));
+            auto* peer = cJSON_GetObjectItem(json.get(), "peername");
+            if (peer == nullptr || peername != peer->valuestring) {
+                continue;
+            }
+            auto* ssl = cJSON_GetObjectItem(json.get(), "ssl");
+            auto* ktls =
+                    ssl == nullptr ? nullptr : cJSON_GetObjectItem(ssl, "ktls");
+            if (ktls == nullptr || ktls->type != cJSON_True) {
+                std::cerr << "Note: the kernel doesn't support kTLS; the "
+                             "server used OpenSSL to encrypt the data"
+                          << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        ADD_FAILURE() << "Connection " << peername
+                      << " not found in stats: " << to_string(stats);
+        return false;
+    }
+
+    SSL_CTX* context = nullptr;
+    SSL* client = nullptr;
+    SOCKET sfd = INVALID_SOCKET;
+};
+
+/**
+ * Verify that the client can read a batch of pipelined responses, and
+ * a value which spans many TLS records.
+ */
+TEST_F(KtlsTest, ReadResponses) {
+    const std::string value(512 * 1024, 'x');
+    getConnection().store(name, 0, value);
+
+    for (int ii = 0; ii < 10; ++ii) {
+        sendCommand(PROTOCOL_BINARY_CMD_NOOP, {});
+    }
+    sendCommand(PROTOCOL_BINARY_CMD_GET, name);
+
+    for (int ii = 0; ii < 10; ++ii) {
+        readResponse(PROTOCOL_BINARY_CMD_NOOP);
+    }
+    EXPECT_EQ(value, readResponse(PROTOCOL_BINARY_CMD_GET));
+
+    isKernelSend();
+}
+
+/**
+ * Verify that the server replies to our close_notify with its own
+ * (which OpenSSL generates, but the kernel must encrypt) before it
+ * closes the connection.
+ */
+TEST_F(KtlsTest, CleanShutdown) {
+    sendCommand(PROTOCOL_BINARY_CMD_NOOP, {});
+    readResponse(PROTOCOL_BINARY_CMD_NOOP);
+    isKernelSend();
+
+    // The first call sends our close_notify, the second one waits for the
+    // close_notify from the server
+    ASSERT_EQ(0, SSL_shutdown(client));
+    ASSERT_EQ(1, SSL_shutdown(client));
+
+    char byte;
+    EXPECT_EQ(0, ::recv(sfd, &byte, 1, 0));
+}
+
+/**
+ * The server refuses to renegotiate the session once the kernel encrypts
+ * the data, and the no_renegotiation alert must reach the client.
+ */
+TEST_F(KtlsTest, RenegotiationRefused) {
+    sendCommand(PROTOCOL_BINARY_CMD_NOOP, {});
+    readResponse(PROTOCOL_BINARY_CMD_NOOP);
+    if (!isKernelSend()) {
+        return;
+    }
+
+    ASSERT_EQ(1, SSL_renegotiate(client));
+    EXPECT_GT(0, SSL_do_handshake(client));
+    EXPECT_EQ(SSL_R_NO_RENEGOTIATION, ERR_GET_REASON(ERR_peek_last_error()));
+}
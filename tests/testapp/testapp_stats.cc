@@ -35,6 +35,26 @@ TEST_P(StatsTest, TestDefaultStats) {
     EXPECT_NE(nullptr, cJSON_GetObjectItem(stats.get(), "pid"));
 }
 
+/**
+ * With compact stats enabled the server packs multiple stats into each
+ * response; the client should end up with the same set of stats.
+ */
+TEST_P(StatsTest, TestCompactStats) {
+    MemcachedConnection& conn = getConnection();
+    const auto plain = conn.statsMap("");
+
+    conn.setFeature(cb::mcbp::Feature::CompactStats, true);
+    const auto compact = conn.statsMap("");
+    conn.setFeature(cb::mcbp::Feature::CompactStats, false);
+
+    ASSERT_EQ(plain.size(), compact.size());
+    for (const auto& entry : plain) {
+        EXPECT_NE(compact.end(), compact.find(entry.first))
+                << "Missing stat: " << entry.first;
+    }
+    EXPECT_EQ(plain.at("pid"), compact.at("pid"));
+}
+
 TEST_P(StatsTest, TestGetMeta) {
     MemcachedConnection& conn = getConnection();
 
@@ -26,12 +26,18 @@
  *
  * - Dict: As per Array, except start with an empty dictionary and add
  *         K/V pairs of the form <num>: value_<num>.
+ *
+ * - LargeDoc: Append a 20 byte element to arrays of 1KB up to 1MB, and
+ *             record the appends per second for each size.
  */
 
 #include "testapp_subdoc_common.h"
 
 #include "../utilities/subdoc_encoder.h"
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <unordered_map>
 #include <valgrind/valgrind.h>
 
@@ -62,9 +68,63 @@ protected:
 
     void subdoc_perf_test_dict(protocol_binary_command cmd, size_t iterations);
 
+    /**
+     * Measure the throughput of appending a small element to documents
+     * of 1KB up to 1MB, using the given function to perform the append.
+     * The appends per second at each size are recorded as test properties
+     * (e.g. "appends_per_sec_1024"), so the XML output can be compared
+     * between the subdoc and fulldoc variants and between builds.
+     *
+     * @param append Function called with the document (before the
+     *               element is appended) and the element to append.
+     */
+    void subdoc_perf_test_large_append(
+            std::function<void(std::string&, const std::string&)> append);
+
     size_t iterations;
 };
 
+/* Build an array document of (at most) the given size, made up of
+ * elements like the ones appended by the large append tests.
+ */
+static std::string subdoc_create_feed(size_t size,
+                                      const std::string& element) {
+    std::string feed("[");
+    while (feed.size() + 2 * (element.size() + 1) <= size) {
+        feed.append(element);
+        feed.push_back(',');
+    }
+    feed.append(element);
+    feed.push_back(']');
+    return feed;
+}
+
+void SubdocPerfTest::subdoc_perf_test_large_append(
+        std::function<void(std::string&, const std::string&)> append) {
+    // A 20 byte element, as typically appended to an activity feed
+    const std::string element("\"event_0123456789ab\"");
+    // Appending to a large document is much more expensive than the other
+    // operations, so use fewer iterations.
+    const size_t appends = std::max(iterations / 25, size_t(1));
+
+    for (size_t size = 1024; size <= 1024 * 1024; size *= 4) {
+        std::string feed(subdoc_create_feed(size, element));
+        store_object("feed", feed, /*compress*/ false);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < appends; i++) {
+            append(feed, element);
+        }
+        const auto duration = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start);
+
+        ::testing::Test::RecordProperty(
+                "appends_per_sec_" + std::to_string(size),
+                int(appends / duration.count()));
+        delete_object("feed");
+    }
+}
+
 
 /* Create a JSON document consisting of a flat array of N elements, using
  * the specified opcode.
@@ -97,6 +157,19 @@ TEST_P(SubdocPerfTest, Array_PushLast) {
                            iterations);
 }
 
+// Append an element to documents from 1KB to 1MB; this goes through the
+// server's subdoc_update / out_splice path for each append.
+TEST_P(SubdocPerfTest, Array_PushLast_LargeDoc) {
+    subdoc_perf_test_large_append(
+            [this](std::string& feed, const std::string& element) {
+                EXPECT_TRUE(subdoc_verify_cmd(BinprotSubdocCommand(
+                        PROTOCOL_BINARY_CMD_SUBDOC_ARRAY_PUSH_LAST,
+                        "feed",
+                        "",
+                        element)));
+            });
+}
+
 TEST_P(SubdocPerfTest, Array_AddUnique) {
     subdoc_perf_test_array(PROTOCOL_BINARY_CMD_SUBDOC_ARRAY_ADD_UNIQUE,
                            iterations);
@@ -455,6 +528,18 @@ TEST_P(SubdocPerfTest, Array_PushLast_Fulldoc) {
     delete_object("list");
 }
 
+// Fulldoc sibling of Array_PushLast_LargeDoc: append the element locally
+// and SET the whole document.
+TEST_P(SubdocPerfTest, Array_PushLast_LargeDoc_Fulldoc) {
+    subdoc_perf_test_large_append(
+            [](std::string& feed, const std::string& element) {
+                feed.back() = ',';
+                feed.append(element);
+                feed.push_back(']');
+                store_object("feed", feed, /*compress*/ false);
+            });
+}
+
 TEST_P(SubdocPerfTest, Dict_Add_Fulldoc) {
     store_object("dict", "{}");
 
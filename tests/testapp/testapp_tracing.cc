@@ -16,7 +16,10 @@
  */
 
 #include <platform/processclock.h>
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "testapp.h"
 
@@ -31,6 +34,29 @@ public:
         reconfigure(memcached_cfg);
     }
 
+    void setTracingSettingOnServer(const char* name, int value) {
+        cJSON_DeleteItemFromObject(memcached_cfg.get(), name);
+        cJSON_AddNumberToObject(memcached_cfg.get(), name, value);
+        reconfigure(memcached_cfg);
+    }
+
+    /// Get the opcodes of the entries returned by the given stat group
+    std::vector<std::string> getTraceLogOpcodes(const std::string& group) {
+        std::vector<std::string> ret;
+        auto stats = getAdminConnection().stats(group);
+        for (auto* it = stats->child; it != nullptr; it = it->next) {
+            unique_cJSON_ptr entry(cJSON_Parse(it->valuestring));
+            if (!entry) {
+                ADD_FAILURE() << "Invalid entry: " << it->valuestring;
+                continue;
+            }
+            EXPECT_NE(nullptr, cJSON_GetObjectItem(entry.get(), "trace"));
+            ret.emplace_back(
+                    cJSON_GetObjectItem(entry.get(), "opcode")->valuestring);
+        }
+        return ret;
+    }
+
     void SetUp() override {
         TestappTest::SetUp();
         document.info.cas = mcbp::cas::Wildcard;
@@ -104,3 +130,70 @@ TEST_F(TracingTest, FailOnFeatureRequestWhenDisabledOnServer) {
     EXPECT_THROW(conn.setFeature(cb::mcbp::Feature::Tracing, true),
                  std::runtime_error);
 }
+
+TEST_F(TracingTest, RequestTraces) {
+    // Add every request to the request trace log
+    setTracingSettingOnServer("tracing_sample_rate", 1);
+
+    MemcachedConnection& conn = getConnection();
+    conn.mutate(document, 0, MutationType::Set);
+    conn.get(name, 0);
+
+    const auto opcodes = getTraceLogOpcodes("request_traces");
+    setTracingSettingOnServer("tracing_sample_rate", 0);
+
+    EXPECT_NE(opcodes.end(), std::find(opcodes.begin(), opcodes.end(), "SET"));
+    EXPECT_NE(opcodes.end(), std::find(opcodes.begin(), opcodes.end(), "GET"));
+}
+
+TEST_F(TracingTest, SlowRequests) {
+    // Sample every request, but make sure none of ours is considered slow
+    setTracingSettingOnServer("tracing_sample_rate", 1);
+    setTracingSettingOnServer("tracing_slow_threshold", 60000);
+
+    MemcachedConnection& conn = getConnection();
+    conn.mutate(document, 0, MutationType::Set);
+
+    size_t slow = 0;
+    auto stats = getAdminConnection().stats("slow_requests");
+    for (auto* it = stats->child; it != nullptr; it = it->next) {
+        unique_cJSON_ptr entry(cJSON_Parse(it->valuestring));
+        ASSERT_TRUE(entry) << "Invalid entry: " << it->valuestring;
+        auto* reason = cJSON_GetObjectItem(entry.get(), "reason");
+        ASSERT_NE(nullptr, reason);
+        EXPECT_STREQ("slow", reason->valuestring);
+        EXPECT_NE(nullptr, cJSON_GetObjectItem(entry.get(), "breakdown"));
+        ++slow;
+    }
+
+    // The slow requests are kept apart from the sampled ones, but
+    // request_traces returns both
+    size_t sampled = 0;
+    size_t all_slow = 0;
+    stats = getAdminConnection().stats("request_traces");
+    for (auto* it = stats->child; it != nullptr; it = it->next) {
+        unique_cJSON_ptr entry(cJSON_Parse(it->valuestring));
+        ASSERT_TRUE(entry) << "Invalid entry: " << it->valuestring;
+        std::string reason =
+                cJSON_GetObjectItem(entry.get(), "reason")->valuestring;
+        if (reason == "slow") {
+            ++all_slow;
+        } else {
+            EXPECT_EQ("sampled", reason);
+            ++sampled;
+        }
+    }
+    EXPECT_EQ(slow, all_slow);
+    EXPECT_LT(0, sampled);
+
+    // slow_requests doesn't take an argument
+    try {
+        getAdminConnection().stats("slow_requests foo");
+        ADD_FAILURE() << "stats slow_requests foo should fail";
+    } catch (ConnectionError& error) {
+        EXPECT_TRUE(error.isInvalidArguments());
+    }
+
+    setTracingSettingOnServer("tracing_sample_rate", 0);
+    setTracingSettingOnServer("tracing_slow_threshold", 500);
+}
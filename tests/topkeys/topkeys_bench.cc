@@ -16,8 +16,11 @@
  */
 #include "daemon/topkeys.h"
 
+#include <cJSON_utils.h>
 #include <gtest/gtest.h>
+#include <map>
 #include <memory>
+#include <random>
 
 
 class TopKeysTest : public ::testing::Test {
@@ -58,3 +61,72 @@ TEST_F(TopKeysTest, Basic) {
     topkeys->stats(&count, 0, dump_key);
     EXPECT_EQ(80, count);
 }
+
+/// Get the access count for the key from the JSON stats (-1 if missing)
+static int getAccessCount(TopKeys& topkeys,
+                          const std::string& key,
+                          rel_time_t current_time) {
+    unique_cJSON_ptr json(cJSON_CreateObject());
+    topkeys.json_stats(json.get(), current_time);
+    auto* array = cJSON_GetObjectItem(json.get(), "topkeys");
+    for (auto* obj = array->child; obj != nullptr; obj = obj->next) {
+        if (key == cJSON_GetObjectItem(obj, "key")->valuestring) {
+            return cJSON_GetObjectItem(obj, "access_count")->valueint;
+        }
+    }
+    return -1;
+}
+
+TEST_F(TopKeysTest, HeavyHitter) {
+    // A hot key among a lot more keys than we're able to track is
+    // still reported with the correct count
+    const std::string hot = "hot_key";
+    for (int jj = 0; jj < 10000; jj++) {
+        const auto key = "cold_key_" + std::to_string(jj);
+        topkeys->updateKey(key.c_str(), key.size(), 0);
+        topkeys->updateKey(hot.c_str(), hot.size(), 0);
+    }
+
+    EXPECT_EQ(10000, getAccessCount(*topkeys, hot, 0));
+}
+
+TEST_F(TopKeysTest, SpaceSavingBound) {
+    // Every key accessed more than 1/capacity of the times is reported,
+    // and its count is over-estimated by at most total/capacity
+    topkeys.reset(new TopKeys(1));
+    const int capacity = 2 * TopKeys::KEYS_PER_MKEY;
+    const int total = 5000;
+
+    std::mt19937 rng(0);
+    std::map<std::string, int> accesses;
+    for (int jj = 0; jj < total; jj++) {
+        // A quarter of the accesses go to three hot keys
+        const auto key = (rng() % 4 == 0)
+                                 ? "hot_key_" + std::to_string(rng() % 3)
+                                 : "cold_key_" + std::to_string(rng() % 500);
+        accesses[key]++;
+        topkeys->updateKey(key.c_str(), key.size(), 0);
+    }
+
+    for (const auto& access : accesses) {
+        if (access.second > total / capacity) {
+            const auto count = getAccessCount(*topkeys, access.first, 0);
+            EXPECT_LE(access.second, count) << access.first;
+            EXPECT_GE(access.second + total / capacity, count)
+                    << access.first;
+        }
+    }
+}
+
+TEST_F(TopKeysTest, Window) {
+    const std::string key = "topkey_window";
+    topkeys->updateKey(key.c_str(), key.size(), 0);
+    EXPECT_EQ(1, getAccessCount(*topkeys, key, TopKeys::WINDOW_SIZE));
+
+    // The key is reported until the window after the one it was
+    // accessed in ends
+    topkeys->updateKey(key.c_str(), key.size(), TopKeys::WINDOW_SIZE);
+    EXPECT_EQ(2, getAccessCount(*topkeys, key, TopKeys::WINDOW_SIZE));
+    EXPECT_EQ(1, getAccessCount(*topkeys, key, 2 * TopKeys::WINDOW_SIZE));
+    EXPECT_EQ(-1, getAccessCount(*topkeys, key, 3 * TopKeys::WINDOW_SIZE));
+}
@@ -0,0 +1,76 @@
+/* -*- Mode: C++; tab-width: 4; c-basic-offset: 4; indent-tabs-mode: nil -*- */
+/*
+ *     Copyright 2018 Couchbase, Inc.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ */
+
+/*
+ * Benchmark the TopKeys update path. Each front end thread updates its own
+ * summary, so the throughput (items_per_second) should scale with the
+ * number of threads.
+ */
+
+#include "daemon/topkeys.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::unique_ptr<TopKeys> topkeys;
+
+static std::vector<std::string> makeKeys(int thread, int count) {
+    std::vector<std::string> keys;
+    for (int ii = 0; ii < count; ii++) {
+        keys.emplace_back("topkey_" + std::to_string(thread) + "_" +
+                          std::to_string(ii));
+    }
+    return keys;
+}
+
+/**
+ * Update a set of keys per thread (state.range(0) of them) and a key
+ * shared by all of the threads. With 100 keys every update hits a key
+ * which is already tracked; with 10000 keys (more than a summary tracks)
+ * most of the updates replace the least accessed key.
+ */
+static void TopKeysUpdate(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        settings.setTopkeysEnabled(true);
+        topkeys.reset(new TopKeys(10));
+    }
+    const std::string hot = "hot_key";
+    const auto keys = makeKeys(state.thread_index, int(state.range(0)));
+
+    size_t ii = 0;
+    while (state.KeepRunning()) {
+        const auto& key = keys[ii++ % keys.size()];
+        topkeys->updateKey(key.c_str(), key.size(), 0);
+        topkeys->updateKey(hot.c_str(), hot.size(), 0);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+
+    if (state.thread_index == 0) {
+        topkeys.reset();
+    }
+}
+
+BENCHMARK(TopKeysUpdate)
+        ->Arg(100)
+        ->Arg(10000)
+        ->ThreadRange(1, 8)
+        ->UseRealTime();
+
+BENCHMARK_MAIN();
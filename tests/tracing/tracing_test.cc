@@ -50,6 +50,56 @@ TEST_F(TracingTest, Basic) {
     EXPECT_GE(tracer.getTotalMicros().count(), 10000);
 }
 
+TEST_F(TracingTest, MaxSpans) {
+    using cb::tracing::Tracer;
+    for (size_t ii = 0; ii < Tracer::MaxSpans; ++ii) {
+        EXPECT_EQ(ii, tracer.begin(cb::tracing::TraceCode::GET));
+    }
+
+    // Spans beyond the capacity are dropped
+    EXPECT_EQ(Tracer::invalidSpanId(),
+              tracer.begin(cb::tracing::TraceCode::STORE));
+    EXPECT_FALSE(tracer.end(Tracer::invalidSpanId()));
+    EXPECT_FALSE(tracer.end(cb::tracing::TraceCode::STORE));
+    EXPECT_EQ(Tracer::MaxSpans, tracer.getDurations().size());
+
+    tracer.clear();
+    EXPECT_TRUE(tracer.getDurations().empty());
+    EXPECT_EQ(0, tracer.begin(cb::tracing::TraceCode::REQUEST));
+}
+
+TEST_F(TracingTest, EndMostRecentOpenSpan) {
+    using cb::tracing::TraceCode;
+    // A command executed twice (EWOULDBLOCK) traces the same code twice
+    EXPECT_EQ(0, tracer.begin(TraceCode::GET));
+    EXPECT_TRUE(tracer.end(TraceCode::GET));
+    EXPECT_EQ(1, tracer.begin(TraceCode::GET));
+    EXPECT_TRUE(tracer.end(TraceCode::GET));
+
+    const auto spans = tracer.getDurations();
+    ASSERT_EQ(2, spans.size());
+    EXPECT_NE(std::chrono::microseconds::max(), spans[0].duration);
+    EXPECT_NE(std::chrono::microseconds::max(), spans[1].duration);
+
+    // All of the spans are closed
+    EXPECT_FALSE(tracer.end(TraceCode::GET));
+}
+
+TEST_F(TracingTest, Record) {
+    using cb::tracing::TraceCode;
+    const auto start = ProcessClock::now();
+    const auto end = start + std::chrono::milliseconds(5);
+    EXPECT_EQ(0, tracer.record(TraceCode::BGWAIT, start, end));
+
+    const auto spans = tracer.getDurations();
+    ASSERT_EQ(1, spans.size());
+    EXPECT_EQ(TraceCode::BGWAIT, spans[0].code);
+    EXPECT_EQ(std::chrono::microseconds(5000), spans[0].duration);
+
+    // The span is already complete
+    EXPECT_FALSE(tracer.end(TraceCode::BGWAIT));
+}
+
 TEST_F(TracingTest, ErrorRate) {
     uint64_t micros_list[] = {5,
                               11,
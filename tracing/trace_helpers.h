@@ -99,6 +99,19 @@ protected:
  */
 #define TRACE_SCOPE(api, ck, code) ScopedTracer __st__##__LINE__(api, ck, code)
 
+/**
+ * Trace something which can't be traced as a scope (like the time spent
+ * waiting in a queue) by adding a span with the given start and end
+ * Usage:
+ *     TRACE_ADD(api, cookie, code, queuedTime, ProcessClock::now());
+ */
+#define TRACE_ADD(api, ck, code, start, end)                         \
+    do {                                                             \
+        if ((api) && (ck)) {                                         \
+            (api)->tracing->add_trace((ck), (code), (start), (end)); \
+        }                                                            \
+    } while (false)
+
 #else
 /**
  * if DISABLE_SESSION_TRACING is set
@@ -106,5 +119,6 @@ protected:
  */
 #define TRACE_SCOPE(api, ck, code)
 #define TRACE_BLOCK(api, ck, code)
+#define TRACE_ADD(api, ck, code, start, end)
 
 #endif
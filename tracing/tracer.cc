@@ -30,49 +30,75 @@ std::chrono::microseconds to_micros(const ProcessClock::time_point tp) {
 namespace cb {
 namespace tracing {
 
+const std::size_t Tracer::MaxSpans;
+
 Tracer::SpanId Tracer::invalidSpanId() {
     return std::numeric_limits<SpanId>::max();
 }
 
 Tracer::SpanId Tracer::begin(const TraceCode tracecode) {
-    std::lock_guard<std::mutex> lock(spanMutex);
-    auto t = to_micros(ProcessClock::now());
-    vecSpans.push_back(Span(tracecode, t));
-    return vecSpans.size() - 1;
+    if (numSpans.load(std::memory_order_relaxed) >= MaxSpans) {
+        return invalidSpanId();
+    }
+
+    const auto spanId = numSpans.fetch_add(1, std::memory_order_acq_rel);
+    if (spanId >= MaxSpans) {
+        // Someone else grabbed the last slot
+        return invalidSpanId();
+    }
+    spans[spanId] = Span(tracecode, to_micros(ProcessClock::now()));
+    return spanId;
+}
+
+Tracer::SpanId Tracer::record(const TraceCode tracecode,
+                              const ProcessClock::time_point start,
+                              const ProcessClock::time_point end) {
+    if (numSpans.load(std::memory_order_relaxed) >= MaxSpans) {
+        return invalidSpanId();
+    }
+
+    const auto spanId = numSpans.fetch_add(1, std::memory_order_acq_rel);
+    if (spanId >= MaxSpans) {
+        return invalidSpanId();
+    }
+    spans[spanId] =
+            Span(tracecode, to_micros(start), to_micros(end) - to_micros(start));
+    return spanId;
 }
 
 bool Tracer::end(SpanId spanId) {
-    std::lock_guard<std::mutex> lock(spanMutex);
-    if (spanId >= vecSpans.size())
+    if (spanId >= size()) {
         return false;
-    auto& span = vecSpans[spanId];
+    }
+    auto& span = spans[spanId];
     span.duration = to_micros(ProcessClock::now()) - span.start;
     return true;
 }
 
 bool Tracer::end(const TraceCode tracecode) {
-    SpanId spanId = 0;
-    {
-        std::lock_guard<std::mutex> lock(spanMutex);
-        for (const auto& span : vecSpans) {
-            if (span.code == tracecode) {
-                break;
-            }
-            spanId++;
+    // A command may be executed multiple times (if the engine returns
+    // EWOULDBLOCK) so look for the most recent span which is still open
+    auto spanId = size();
+    while (spanId > 0) {
+        --spanId;
+        const auto& span = spans[spanId];
+        if (span.code == tracecode &&
+            span.duration == std::chrono::microseconds::max()) {
+            return end(spanId);
         }
     }
-    return end(spanId);
+    return false;
 }
 
-const std::vector<Span>& Tracer::getDurations() const {
-    return vecSpans;
+std::vector<Span> Tracer::getDurations() const {
+    return std::vector<Span>(spans.begin(), spans.begin() + size());
 }
 
 std::chrono::microseconds Tracer::getTotalMicros() const {
-    if (vecSpans.empty()) {
+    if (size() == 0) {
         return std::chrono::microseconds(0);
     }
-    const auto& top = vecSpans[0];
+    const auto& top = spans[0];
     if (top.duration == std::chrono::microseconds::max()) {
         return to_micros(ProcessClock::now()) - top.start;
     }
@@ -90,7 +116,7 @@ uint16_t Tracer::getEncodedMicros() const {
 }
 
 void Tracer::clear() {
-    vecSpans.clear();
+    numSpans.store(0, std::memory_order_release);
 }
 
 } // end namespace tracing
@@ -103,7 +129,7 @@ MEMCACHED_PUBLIC_API std::ostream& operator<<(
 
 MEMCACHED_PUBLIC_API std::string to_string(const cb::tracing::Tracer& tracer,
                                            bool raw) {
-    const auto& vecSpans = tracer.getDurations();
+    const auto vecSpans = tracer.getDurations();
     std::ostringstream os;
     auto size = vecSpans.size();
     for (const auto& span : vecSpans) {
@@ -132,6 +158,10 @@ MEMCACHED_PUBLIC_API std::string to_string(
         return "allocate";
     case TraceCode::BGFETCH:
         return "bg.fetch";
+    case TraceCode::BGLOAD:
+        return "bg.load";
+    case TraceCode::BGWAIT:
+        return "bg.wait";
     case TraceCode::COMPRESS:
         return "compress";
     case TraceCode::FLUSH:
@@ -148,14 +178,20 @@ MEMCACHED_PUBLIC_API std::string to_string(
         return "get.meta";
     case TraceCode::GETSTATS:
         return "get.stats";
+    case TraceCode::HTLOCKWAIT:
+        return "ht.lock.wait";
     case TraceCode::ITEMDELETE:
         return "item.delete";
     case TraceCode::LOCK:
         return "lock";
     case TraceCode::OBSERVE:
         return "observe";
+    case TraceCode::PARSE:
+        return "parse";
     case TraceCode::REMOVE:
         return "remove";
+    case TraceCode::SEND:
+        return "send";
     case TraceCode::SETITEMINFO:
         return "set.item.info";
     case TraceCode::SETWITHMETA:
@@ -16,9 +16,10 @@
  */
 #pragma once
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
-#include <mutex>
 #include <ostream>
 #include <stdexcept>
 #include <string>
@@ -49,6 +50,9 @@ namespace tracing {
 
 class MEMCACHED_PUBLIC_CLASS Span {
 public:
+    Span() : Span(TraceCode::REQUEST, std::chrono::microseconds(0)) {
+    }
+
     Span(TraceCode code,
          std::chrono::microseconds start,
          std::chrono::microseconds duration = std::chrono::microseconds::max())
@@ -60,21 +64,41 @@ public:
 };
 
 /**
- * Tracer maintains an ordered vector of tracepoints
+ * Tracer maintains an ordered list of tracepoints
  * with name:time(micros)
+ *
+ * The spans are kept in a fixed size array (spans beyond the capacity
+ * are dropped) so that tracing doesn't need to allocate memory or
+ * grab any locks. Spans may be added from multiple threads at the
+ * same time (the engine may trace a background fetch), but the spans
+ * must not be read or cleared while they're being added.
  */
 class MEMCACHED_PUBLIC_CLASS Tracer {
 public:
     using SpanId = std::size_t;
 
+    /// The maximum number of spans recorded for a single request
+    static const std::size_t MaxSpans = 32;
+
     static SpanId invalidSpanId();
 
     SpanId begin(const TraceCode tracecode);
     bool end(SpanId spanId);
+
+    /// End the most recent span with the given code which is still open
     bool end(const TraceCode tracecode);
 
+    /**
+     * Add a span which has already completed. Used for the spans which
+     * can't be traced as a scope (like the time a background fetch
+     * spent queued)
+     */
+    SpanId record(const TraceCode tracecode,
+                  const ProcessClock::time_point start,
+                  const ProcessClock::time_point end);
+
     // get the tracepoints as ordered durations
-    const std::vector<Span>& getDurations() const;
+    std::vector<Span> getDurations() const;
 
     std::chrono::microseconds getTotalMicros() const;
 
@@ -100,8 +124,15 @@ public:
                                     bool raw);
 
 protected:
-    std::vector<Span> vecSpans;
-    std::mutex spanMutex;
+    /// Get the number of spans in use
+    std::size_t size() const {
+        return std::min(numSpans.load(std::memory_order_acquire), MaxSpans);
+    }
+
+    std::array<Span, MaxSpans> spans;
+    /// The number of spans reserved (may exceed MaxSpans if we've
+    /// dropped spans)
+    std::atomic<std::size_t> numSpans{0};
 };
 
 struct MEMCACHED_PUBLIC_CLASS Traceable {
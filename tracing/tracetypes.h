@@ -28,6 +28,8 @@ enum class TraceCode {
 
     ALLOCATE,
     BGFETCH,
+    BGLOAD,
+    BGWAIT,
     COMPRESS,
     FLUSH,
     GAT,
@@ -36,10 +38,13 @@ enum class TraceCode {
     GETLOCKED,
     GETMETA,
     GETSTATS,
+    HTLOCKWAIT,
     ITEMDELETE,
     LOCK,
     OBSERVE,
+    PARSE,
     REMOVE,
+    SEND,
     SETITEMINFO,
     SETWITHMETA,
     STORE,